@@ -5,7 +5,7 @@
  * including itself. The images are deflated one per module and
  * inflated on first use, so a program pays for what it imports.
  *
- * 42 modules, 802705 bytes of images, 414513 bytes packed.
+ * 42 modules, 812682 bytes of images, 418281 bytes packed.
  * Regenerate with `make reseed`.
  */
 
@@ -26,48 +26,48 @@ typedef struct {
 } SeedSource;
 
 static const SeedSource kSources[] = {
-    {"jaithon/ast.jai", 0, 19597, 39544},
-    {"jaithon/ast_encode.jai", 19597, 13646, 28409},
-    {"jaithon/ast_unparse.jai", 33243, 16552, 33529},
-    {"jaithon/compile/check/assign.jai", 49795, 3094, 6164},
-    {"jaithon/compile/check/checker.jai", 52889, 12625, 22337},
-    {"jaithon/compile/check/ctx.jai", 65514, 13648, 26699},
-    {"jaithon/compile/check/decl.jai", 79162, 18579, 33779},
-    {"jaithon/compile/check/expr.jai", 97741, 23960, 44141},
-    {"jaithon/compile/check/fold.jai", 121701, 8660, 18707},
-    {"jaithon/compile/check/kinds.jai", 130361, 1118, 1793},
-    {"jaithon/compile/check/modsig.jai", 131479, 6690, 11905},
-    {"jaithon/compile/check/nominal.jai", 138169, 2219, 4353},
-    {"jaithon/compile/check/operator.jai", 140388, 3382, 7237},
-    {"jaithon/compile/check/predicate.jai", 143770, 1666, 3388},
-    {"jaithon/compile/check/relate.jai", 145436, 1322, 2177},
-    {"jaithon/compile/check/render.jai", 146758, 2197, 3863},
-    {"jaithon/compile/check/stmt.jai", 148955, 21614, 39354},
-    {"jaithon/compile/check/substitute.jai", 170569, 1613, 2738},
-    {"jaithon/compile/check/suggest.jai", 172182, 1569, 2527},
-    {"jaithon/compile/check/ty.jai", 173751, 1842, 3375},
-    {"jaithon/compile/check/union.jai", 175593, 1570, 2521},
-    {"jaithon/compile/check/universe.jai", 177163, 2322, 4005},
-    {"jaithon/compile/diag.jai", 179485, 2536, 4434},
-    {"jaithon/compile/emit.jai", 182021, 44172, 91008},
-    {"jaithon/compile/jaic.jai", 226193, 18358, 33407},
-    {"jaithon/compile/lexer.jai", 244551, 18640, 36646},
-    {"jaithon/compile/mod.jai", 263191, 5811, 9442},
-    {"jaithon/compile/opt/chunk.jai", 269002, 11586, 20868},
-    {"jaithon/compile/opt/coalesce.jai", 280588, 3154, 5119},
-    {"jaithon/compile/opt/dead.jai", 283742, 390, 508},
-    {"jaithon/compile/opt/fuse.jai", 284132, 5388, 11927},
-    {"jaithon/compile/opt/hoist.jai", 289520, 4650, 7520},
-    {"jaithon/compile/opt/mod.jai", 294170, 1397, 2105},
-    {"jaithon/compile/opt/peephole.jai", 295567, 5374, 10228},
-    {"jaithon/compile/parser.jai", 300941, 41751, 89517},
-    {"jaithon/compile/repl.jai", 342692, 3862, 6486},
-    {"jaithon/compile/resolve.jai", 346554, 21113, 39894},
-    {"jaithon/compile/symbol.jai", 367667, 3713, 6448},
-    {"jaithon/compile/token.jai", 371380, 7207, 15680},
-    {"std/json.jai", 378587, 13807, 25646},
-    {"std/math.jai", 392394, 9514, 20028},
-    {"std/str.jai", 401908, 12605, 23249},
+    {"jaithon/ast.jai", 0, 19410, 40587},
+    {"jaithon/ast_encode.jai", 19410, 13043, 27255},
+    {"jaithon/ast_unparse.jai", 32453, 16018, 32514},
+    {"jaithon/compile/check/assign.jai", 48471, 2975, 6004},
+    {"jaithon/compile/check/checker.jai", 51446, 12596, 22915},
+    {"jaithon/compile/check/ctx.jai", 64042, 13489, 26473},
+    {"jaithon/compile/check/decl.jai", 77531, 18577, 33775},
+    {"jaithon/compile/check/expr.jai", 96108, 23588, 43390},
+    {"jaithon/compile/check/fold.jai", 119696, 8324, 18407},
+    {"jaithon/compile/check/kinds.jai", 128020, 1119, 1793},
+    {"jaithon/compile/check/modsig.jai", 129139, 6669, 11876},
+    {"jaithon/compile/check/nominal.jai", 135808, 2223, 4353},
+    {"jaithon/compile/check/operator.jai", 138031, 3058, 6647},
+    {"jaithon/compile/check/predicate.jai", 141089, 1543, 3554},
+    {"jaithon/compile/check/relate.jai", 142632, 1321, 2177},
+    {"jaithon/compile/check/render.jai", 143953, 2190, 3904},
+    {"jaithon/compile/check/stmt.jai", 146143, 21382, 39589},
+    {"jaithon/compile/check/substitute.jai", 167525, 1614, 2738},
+    {"jaithon/compile/check/suggest.jai", 169139, 1572, 2527},
+    {"jaithon/compile/check/ty.jai", 170711, 1842, 3375},
+    {"jaithon/compile/check/union.jai", 172553, 1571, 2521},
+    {"jaithon/compile/check/universe.jai", 174124, 2321, 4005},
+    {"jaithon/compile/diag.jai", 176445, 2518, 4382},
+    {"jaithon/compile/emit.jai", 178963, 50737, 104290},
+    {"jaithon/compile/jaic.jai", 229700, 18469, 33669},
+    {"jaithon/compile/lexer.jai", 248169, 18148, 36144},
+    {"jaithon/compile/mod.jai", 266317, 5810, 9442},
+    {"jaithon/compile/opt/chunk.jai", 272127, 13241, 23768},
+    {"jaithon/compile/opt/coalesce.jai", 285368, 3155, 5119},
+    {"jaithon/compile/opt/dead.jai", 288523, 401, 508},
+    {"jaithon/compile/opt/fuse.jai", 288924, 5389, 11927},
+    {"jaithon/compile/opt/hoist.jai", 294313, 4733, 7639},
+    {"jaithon/compile/opt/mod.jai", 299046, 1398, 2105},
+    {"jaithon/compile/opt/peephole.jai", 300444, 5375, 10228},
+    {"jaithon/compile/parser.jai", 305819, 41444, 89174},
+    {"jaithon/compile/repl.jai", 347263, 3843, 6410},
+    {"jaithon/compile/resolve.jai", 351106, 20689, 39092},
+    {"jaithon/compile/symbol.jai", 371795, 3716, 6448},
+    {"jaithon/compile/token.jai", 375511, 6838, 13023},
+    {"std/json.jai", 382349, 13808, 25654},
+    {"std/math.jai", 396157, 9516, 20028},
+    {"std/str.jai", 405673, 12608, 23253},
 };
 
 #define JAI_SEED_N (sizeof kSources / sizeof kSources[0])
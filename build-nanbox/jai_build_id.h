@@ -0,0 +1,2 @@
+/* generated by the Makefile; see the .jaic cache key note */
+#define JAI_BUILD_ID 0x4205d04fu
@@ -0,0 +1,163 @@
+#!/usr/bin/env python3
+"""Generate the tail-call-threaded interpreter from runLoop in src/vm/vm.c.
+
+    gen_tailcall.py src/vm/vm.c build/vm_tailcall.inc
+
+`make INTERP=tailcall` builds the interpreter as one C function per opcode,
+each ending in a tail call through a table to the next one, instead of one
+3,000-line function dispatching by computed goto. The handlers are not written
+twice. runLoop stays the only source of truth and this script cuts it apart:
+every `VM_CASE(OP_X):` and `VM_GENERIC_CASE(OP_X):` starts a function
+`TC_OP_X`, and so do the two shared tails, `opReturn:` and `vmThrow:`.
+
+Nothing in a handler body is rewritten. The macros do the work, redefined for
+this build in vm.c under JAI_INTERP_TAILCALL:
+
+  * the loop's locals -- frame, ip, stackTop, slots, constants -- become the
+    parameters every handler takes and passes on, so they stay in argument
+    registers across the whole chain;
+  * VM_NEXT() is `goto tcNext`, and tcNext is at the END of each function,
+    outside every block, so no local is in scope at the dispatch. Without
+    musttail that is what lets GCC prove the sibling call safe: it refuses one
+    while an address-taken local could still be live;
+  * a `goto` to anything that is not in the same function -- vmThrow,
+    opReturn, a generic handler's G_ label -- lands on a stub here that tail
+    calls the function of that name, handing over instStart through the
+    TcState when the target cannot recompute it.
+
+Every handler also ends in a tail call to the handler after it, which is what
+a case that falls through used to do; for every case that ends in a jump it is
+unreachable.
+"""
+
+import re
+import sys
+
+CASE = re.compile(r'^    VM_(?:GENERIC_)?CASE\((\w+)\):(.*)$')
+LABEL = re.compile(r'^    (\w+):(\s*\{.*)$')
+TABLE = re.compile(r'^\s*\[(\w+)\]\s*=\s*&&L_(\w+),')
+
+# Targets a handler can reach by `goto` without the name appearing in its text:
+# these macros expand to `goto G_##name` (vm.c, "Quickening").
+DEQUICKENING = re.compile(
+    r'\b(?:VM_DEQUICKEN|QUICK_INT_ARITH|QUICK_FLOAT_ARITH|QUICK_INT_CMP|'
+    r'QUICK_FLOAT_CMP)\((\w+)')
+GOTO = re.compile(r'\bgoto\s+(\w+)\s*;')
+
+# Entered other than by dispatch, so instStart does not sit just before ip.
+RESUMED = {'opReturn', 'vmThrow'}
+
+
+def fail(message):
+    sys.stderr.write('gen_tailcall: %s\n' % message)
+    sys.exit(1)
+
+
+def find(lines, pattern, start=0):
+    for i in range(start, len(lines)):
+        if re.search(pattern, lines[i]):
+            return i
+    fail('no line matches %r in runLoop' % pattern)
+
+
+def split(lines, first, last):
+    """Cut lines[first:last] into (name, line number, text) segments."""
+    segments = []
+    skipping = False
+    for i in range(first, last):
+        line = lines[i]
+        if line.startswith('#if !JAI_COMPUTED_GOTO'):
+            skipping = True       # the switch build's `default:`
+            continue
+        if skipping:
+            if line.startswith('#endif'):
+                skipping = False
+            continue
+        m = CASE.match(line) or LABEL.match(line)
+        if m:
+            segments.append([m.group(1), i + 1, [m.group(2) + '\n']])
+        elif segments:
+            segments[-1][2].append(line)
+        elif line.strip() and not line.strip().startswith(('/*', '*')):
+            fail('code before the first case at line %d' % (i + 1))
+    return segments
+
+
+def main(argv):
+    if len(argv) != 3:
+        fail('usage: gen_tailcall.py VM_C OUTPUT')
+    source, output = argv[1], argv[2]
+    with open(source) as f:
+        lines = f.readlines()
+
+    start = find(lines, r'^static JaiRunResult runLoop\(int baseFrameCount\) \{')
+    dispatch = find(lines, r'^\s*VM_DISPATCH\(\) \{', start)
+    dispatchEnd = find(lines, r'^    \}\s*/\* VM_DISPATCH \*/', dispatch)
+    throwAt = find(lines, r'^vmThrow: \{', dispatchEnd)
+    end = find(lines, r'^\}', throwAt)
+
+    table = []
+    for line in lines[start:dispatch]:
+        m = TABLE.match(line)
+        if m:
+            if m.group(1) != m.group(2):
+                fail('dispatch table maps %s to L_%s' % m.groups())
+            table.append(m.group(1))
+    if not table:
+        fail('no dispatch table in runLoop')
+
+    segments = split(lines, dispatch + 1, dispatchEnd)
+    # vmThrow is one braced block at column 0; reindent its opening line.
+    segments.append(['vmThrow', throwAt + 1,
+                     [' {\n'] + lines[throwAt + 1:end]])
+
+    names = [s[0] for s in segments]
+    if len(set(names)) != len(names):
+        fail('a case label appears twice')
+    missing = [op for op in table if op not in names]
+    if missing:
+        fail('no handler for %s' % ', '.join(missing))
+
+    out = []
+    out.append('/* Generated by scripts/gen_tailcall.py from runLoop in %s.\n'
+               ' * Do not edit: change runLoop, and this follows. */\n\n'
+               % source)
+    for name in names:
+        out.append('static JaiRunResult TC_%s(TC_PARAMS);\n' % name)
+    out.append('\nstatic JaiRunResult (*const tcHandlers[])(TC_PARAMS) = {\n')
+    for op in table:
+        out.append('    [%s] = TC_%s,\n' % (op, op))
+    out.append('};\n_Static_assert(sizeof(tcHandlers) / sizeof(tcHandlers[0]) '
+               '== OP_COUNT,\n               "tail-call table is out of sync '
+               'with enum OpCode");\n')
+
+    for index, (name, lineno, body) in enumerate(segments):
+        text = ''.join(body)
+        targets = set(GOTO.findall(text))
+        targets |= {'G_' + t for t in DEQUICKENING.findall(text)}
+        targets -= {'vmThrow', 'tcNext'}
+        # A jump to its own generic label is a jump to its own start.
+        local = {name, 'G_' + name}
+        out.append('\nstatic JaiRunResult TC_%s(TC_PARAMS) {\n' % name)
+        out.append('    TC_RESUME();\n' if name in RESUMED
+                   else '    TC_ENTER();\n')
+        out.append('#line %d "%s"\n' % (lineno, source))
+        out.append('    ' + text.lstrip(' '))
+        out.append('#line %d "%s"\n' % (lineno, source))
+        if index + 1 < len(segments) and name != 'vmThrow':
+            out.append('    TC_JUMP(TC_%s);\n' % segments[index + 1][0])
+        for target in sorted(targets):
+            callee = target[2:] if target.startswith('G_') else target
+            if callee not in names:
+                fail('%s jumps to %s, which is not a handler' % (name, target))
+            if target in local:
+                fail('%s jumps to itself' % name)
+            out.append('%s:\n    TC_JUMP(TC_%s);\n' % (target, callee))
+        out.append('    TC_EXIT();\n}\n')
+
+    with open(output, 'w') as f:
+        f.write(''.join(out))
+
+
+if __name__ == '__main__':
+    main(sys.argv)
@@ -179,6 +179,9 @@ def run_target(path):
                     stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL)
 
     env["JAI_JIT_WHY"] = "1"
+    # Compiled where it is hot, not on the background thread: a body still
+    # queued when the run ends would read as one that never compiled.
+    env["JAITHON_JIT_SYNC"] = "1"
     proc = subprocess.run(cmd, cwd=ROOT, env=env,
                            stdout=subprocess.PIPE, stderr=subprocess.PIPE,
                            text=True)
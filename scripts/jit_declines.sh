@@ -13,7 +13,7 @@ census() {
         "$JAITHON" run "$f" >/dev/null 2>&1
     done
     for f in "$ROOT"/tests/bench/*/*.jai; do
-        JAI_JIT_WHY=1 "$JAITHON" run "$f" 2>&1 >/dev/null
+        JAI_JIT_WHY=1 JAITHON_JIT_SYNC=1 "$JAITHON" run "$f" 2>&1 >/dev/null
     done \
       | grep -E 'declined at|stopped' \
       | sed 's/\[jit\] //' \
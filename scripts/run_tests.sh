@@ -120,6 +120,28 @@ if [[ -x "$ROOT/tests/vm/cache_corrupt.sh" ]]; then
     done <<< "$corrupt_output"
 fi
 
+if [[ -x "$ROOT/tests/vm/jit_warm.sh" ]]; then
+    warm_output="$(JAITHON="$JAITHON" "$ROOT/tests/vm/jit_warm.sh" 2>&1)"
+    while IFS= read -r line; do
+        case "$line" in
+            "ok "*)   name="jit_warm: ${line#ok }"
+                      matches_filter "$name" && record_pass "$name" 0 ;;
+            "FAIL "*) record_fail "jit_warm: ${line#FAIL }" "" ;;
+        esac
+    done <<< "$warm_output"
+fi
+
+if [[ -x "$ROOT/tests/vm/jit_perf.sh" ]]; then
+    perf_output="$(JAITHON="$JAITHON" "$ROOT/tests/vm/jit_perf.sh" 2>&1)"
+    while IFS= read -r line; do
+        case "$line" in
+            "ok "*)   name="jit_perf: ${line#ok }"
+                      matches_filter "$name" && record_pass "$name" 0 ;;
+            "FAIL "*) record_fail "jit_perf: ${line#FAIL }" "" ;;
+        esac
+    done <<< "$perf_output"
+fi
+
 # ---------------------------------------------------------------- 2. golden
 printf '%sGolden tests%s\n' "$BOLD" "$RESET"
 
@@ -0,0 +1,117 @@
+#!/usr/bin/env bash
+# The INTERP=tailcall interpreter, checked and timed against ./jaithon.
+#
+#   scripts/tailcall_check.sh            build, check, time tests/bench
+#   RUNS=5 BENCH_LEVEL=hard scripts/tailcall_check.sh
+#
+# Three things, in order, and the first two are gates:
+#
+#   1. every TC_ handler leaves by a jump. A dispatch GCC emitted as a call
+#      grows the C stack by a frame per instruction executed, which is a crash
+#      a few million instructions in, not a slowdown;
+#   2. every golden prints its .expected on the tail-call build, with the JIT
+#      off so that the interpreter runs all of it and with it on;
+#   3. tests/bench, best of RUNS with JAITHON_NO_JIT=1, goto against tailcall.
+#      The JIT is off because it is the interpreter that differs between the
+#      two binaries, and a compiled loop would hide it.
+set -uo pipefail
+
+ROOT="$(cd "$(dirname "${BASH_SOURCE[0]}")/.." && pwd)"
+BIN="$ROOT/jaithon-tailcall"
+BASE="$ROOT/jaithon"
+RUNS=${RUNS:-3}
+
+export JAITHON_PATH="$ROOT/lib"
+export BENCH_LEVEL="${BENCH_LEVEL:-medium}"
+
+make -C "$ROOT" -j8 INTERP=tailcall BUILD_ROOT=build-tailcall \
+     TARGET=jaithon-tailcall >/dev/null || exit 1
+[ -x "$BASE" ] || make -C "$ROOT" -j8 >/dev/null || exit 1
+
+fail=0
+
+# --- 1. dispatch is a jump ---------------------------------------------------
+# The table is the one thing only a dispatch indexes, so a `call` through it is
+# exactly a dispatch that did not become a sibling call. LTO may rename the
+# static symbols (TC_OP_ADD.lto_priv.0), which the patterns allow for.
+table=$(nm "$BIN" | awk '$3 ~ /^tcHandlers/ {print $1; exit}')
+if [ -z "$table" ]; then
+    echo "FAIL dispatch: no tcHandlers symbol in $BIN"
+    fail=1
+else
+    table=$(printf '%x' "0x$table")
+    report=$(objdump -d --no-show-raw-insn "$BIN" | awk -v table="$table" '
+        /^[0-9a-f]+ <(TC_|tcTraced)/ { inside = 1; handlers++; next }
+        /^[0-9a-f]+ </        { inside = 0; next }
+        inside && /\tcall/ && (index($0, "0x" table "(") || /<TC_/) {
+            bad++; print "  " $0
+        }
+        inside && /\tjmp/ && (index($0, "0x" table "(") || /<TC_/) { jumps++ }
+        END { printf "handlers %d jumps %d calls %d\n", handlers, jumps, bad + 0 }')
+    summary=$(printf '%s\n' "$report" | tail -1)
+    handlers=$(printf '%s\n' "$summary" | awk '{print $2}')
+    calls=$(printf '%s\n' "$summary" | awk '{print $6}')
+    if [ "${handlers:-0}" -eq 0 ]; then
+        echo "FAIL dispatch: no TC_ handlers in $BIN -- were they inlined away?"
+        fail=1
+    elif [ "$calls" -ne 0 ]; then
+        printf '%s\n' "$report" | sed '$d'
+        echo "FAIL dispatch: $summary"
+        fail=1
+    else
+        echo "ok dispatch: $summary"
+    fi
+fi
+
+# --- 2. goldens ----------------------------------------------------------------
+passed=0
+for src in "$ROOT"/tests/golden/*.jai; do
+    expected="${src%.jai}.expected"
+    [ -f "$expected" ] || continue
+    name=$(basename "$src" .jai)
+    for mode in NO_JIT JIT; do
+        if [ "$mode" = NO_JIT ]; then
+            actual=$(JAITHON_NO_JIT=1 "$BIN" run "$src" 2>/dev/null)
+        else
+            actual=$("$BIN" run "$src" 2>/dev/null)
+        fi
+        if [ $? -ne 0 ] || [ "$actual" != "$(cat "$expected")" ]; then
+            echo "FAIL golden $name ($mode)"
+            fail=1
+        else
+            passed=$((passed + 1))
+        fi
+    done
+done
+echo "ok goldens: $passed runs"
+[ $fail -eq 0 ] || exit $fail
+
+# --- 3. tests/bench ------------------------------------------------------------
+best_ms() {
+    local best=999999999 i start end t
+    for ((i = 0; i < RUNS; i++)); do
+        start=$(date +%s%N)
+        JAITHON_NO_JIT=1 "$@" >/dev/null 2>&1 || { echo "-"; return; }
+        end=$(date +%s%N)
+        t=$(( (end - start) / 1000000 ))
+        [ "$t" -lt "$best" ] && best=$t
+    done
+    echo "$best"
+}
+
+printf '\n%-16s %9s %9s %7s   (BENCH_LEVEL=%s, best of %d, no JIT)\n' \
+       bench goto tailcall ratio "$BENCH_LEVEL" "$RUNS"
+for dir in "$ROOT"/tests/bench/*/; do
+    name=$(basename "$dir")
+    src="$dir$name.jai"
+    [ -f "$src" ] || continue
+    a=$(best_ms "$BASE" run "$src")
+    b=$(best_ms "$BIN" run "$src")
+    if [ "$a" = "-" ] || [ "$b" = "-" ]; then
+        printf '%-16s %9s %9s %7s\n' "$name" "$a" "$b" "-"
+        continue
+    fi
+    printf '%-16s %7sms %7sms %7s\n' "$name" "$a" "$b" \
+           "$(awk -v a="$a" -v b="$b" 'BEGIN { printf "%.2f", b / (a ? a : 1) }')"
+done
+exit 0
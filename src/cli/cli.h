@@ -39,7 +39,9 @@ typedef struct {
     bool  fmtCheck;
     bool  jsonOutput;
     int   threads;
+    int   maxDepth;     /* 0 = JAI_DEFAULT_MAX_DEPTH */
     bool  noGpu;
+    bool  jitSync;
 
     const char **toolArgs;
     int          toolArgCount;
@@ -176,6 +176,18 @@ static bool parseThreads(const char *text, JaiCliOptions *out) {
     return true;
 }
 
+static bool parseMaxDepth(const char *text, JaiCliOptions *out) {
+    char *end = NULL;
+    long value = strtol(text, &end, 10);
+    if (end == text || *end != '\0' || value < JAI_MIN_DEPTH || value > JAI_MAX_DEPTH) {
+        cliError("--max-depth expects a frame count between %d and %d, got `%s`",
+                 JAI_MIN_DEPTH, JAI_MAX_DEPTH, text);
+        return false;
+    }
+    out->maxDepth = (int)value;
+    return true;
+}
+
 static bool parseEmit(const char *text, ParseState *st) {
     if (strcmp(text, "ast") == 0) {
         st->out->command = CMD_AST;
@@ -250,6 +262,7 @@ static bool parseOption(int argc, char **argv, int *i, ParseState *st) {
     if (strcmp(arg, "--json") == 0)        { out->jsonOutput = true; return true; }
     if (strcmp(arg, "--check") == 0)       { out->fmtCheck = true;   return true; }
     if (strcmp(arg, "--no-gpu") == 0)      { out->noGpu = true;      return true; }
+    if (strcmp(arg, "--jit-sync") == 0)    { out->jitSync = true;    return true; }
     if (strcmp(arg, "--strict") == 0)      { gStrict = true;         return true; }
     if (strcmp(arg, "--no-cache") == 0) {
         out->run.useCache = false;
@@ -261,6 +274,10 @@ static bool parseOption(int argc, char **argv, int *i, ParseState *st) {
         if (value == NULL) value = takeValue(argc, argv, i, "--threads");
         return value != NULL && parseThreads(value, out);
     }
+    if (optionIs(arg, "--max-depth", 11, &value)) {
+        if (value == NULL) value = takeValue(argc, argv, i, "--max-depth");
+        return value != NULL && parseMaxDepth(value, out);
+    }
     if (optionIs(arg, "--front", 7, &value)) {
         if (value == NULL) value = takeValue(argc, argv, i, "--front");
         if (value == NULL) return false;
@@ -43,7 +43,11 @@ void jaiCliPrintUsage(FILE *out) {
         "      --time                 print elapsed wall time\n"
         "      --stats                print VM, inline-cache and GC statistics\n"
         "      --threads=N            worker threads for std.thread\n"
+        "      --max-depth=N          interpreted call frames before RecursionError\n"
+        "                             (default 100000; the stack grows as needed)\n"
         "      --no-gpu               disable GPU acceleration\n"
+        "      --jit-sync             compile hot code before running it, not\n"
+        "                             in the background (deterministic)\n"
         "      --emit=ast|bc|tokens   compile and dump the given form\n"
         "      --json                 machine-readable output where supported\n"
         "      --color=auto|always|never\n"
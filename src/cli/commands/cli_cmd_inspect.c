@@ -37,9 +37,10 @@ static void disassembleTree(FILE *out, const ObjFunction *fn, int depth) {
                 (unsigned)fn->exceptionCount);
         for (uint16_t i = 0; i < fn->exceptionCount; i++) {
             const ExceptionEntry *e = &fn->exceptions[i];
-            fprintf(out, ";   [%04u,%04u) -> %04u  type=", e->start, e->end,
-                    e->handler);
-            if (e->typeConst == UINT32_MAX) fputs("any\n", out);
+            fprintf(out, ";   [%04u,%04u) -> %04u  depth=%u  type=", e->start,
+                    e->end, e->handler, e->depth);
+            if (e->typeConst == JAI_HANDLER_CATCH_ALL) fputs("any\n", out);
+            else if (e->typeConst == JAI_HANDLER_FINALLY) fputs("finally\n", out);
             else fprintf(out, "K%u\n", e->typeConst);
         }
     }
@@ -170,6 +170,8 @@ static void exportEnvironmentFlags(const JaiCliOptions *opts)
     }
     if (opts->noGpu)
         (void)setenv("JAITHON_NO_GPU", "1", 1);
+    if (opts->jitSync)
+        (void)setenv("JAITHON_JIT_SYNC", "1", 1);
     if (gStrict)
         (void)setenv("JAITHON_STRICT", "1", 1);
     if (opts->noPrelude)
@@ -212,6 +214,7 @@ int main(int argc, char **argv)
     vm.gcStressEvery = opts.gcStressEvery;
     vm.releaseMode = opts.run.codegen.stripAsserts;
     vm.optLevel = opts.run.codegen.optLevel;
+    vm.maxDepth = opts.maxDepth;
 
     exportEnvironmentFlags(&opts);
     jaiVMInit();
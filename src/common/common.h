@@ -42,7 +42,7 @@
 #define JAI_VERSION_PATCH 0
 #define JAI_VERSION_STRING "3.2.0"
 
-#define JAI_COMPILER_VERSION 26u
+#define JAI_COMPILER_VERSION 31u
 #define JAI_SEED_MIN_VERSION 18u
 
 _Static_assert(JAI_SEED_MIN_VERSION <= JAI_COMPILER_VERSION,
@@ -53,8 +53,13 @@ _Static_assert(JAI_SEED_MIN_VERSION <= JAI_COMPILER_VERSION,
 /* Limits                                                              */
 /* ------------------------------------------------------------------ */
 
-#define JAI_FRAMES_MAX      1024
-#define JAI_STACK_MAX       (JAI_FRAMES_MAX * 64)
+/* Call depth. The value stack and frame array are reserved for the limit and
+ * committed as calls reach into them (vm.c, "Stack reservation"), so a high
+ * limit costs address space, not memory. --max-depth overrides the default. */
+#define JAI_DEFAULT_MAX_DEPTH 100000
+#define JAI_MIN_DEPTH         64
+#define JAI_MAX_DEPTH         10000000
+#define JAI_SLOTS_PER_FRAME   64      /* value-stack slots reserved per frame */
 #define JAI_MAX_LOCALS      65535
 #define JAI_MAX_UPVALUES    255
 #define JAI_MAX_ARGS        255
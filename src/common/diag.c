@@ -799,6 +799,64 @@ bool jaiDiagFlush(JaiDiagBag *bag, FILE *out) {
     return hadErrors;
 }
 
+/* Consecutive copies of one frame a traceback prints before summarising the
+ * rest of the run in one line. Runaway recursion is a single frame repeated
+ * to the depth limit, which --max-depth lets reach the hundreds of thousands. */
+#define JAI_TRACEBACK_REPEATS 3
+
+static bool sameFrame(const JaiFrameInfo *a, const JaiFrameInfo *b) {
+    if (a->span.file != b->span.file || a->span.start != b->span.start) return false;
+    if (a->functionName != b->functionName &&
+        (a->functionName == NULL || b->functionName == NULL ||
+         strcmp(a->functionName, b->functionName) != 0)) return false;
+    return a->modulePath == b->modulePath ||
+           (a->modulePath != NULL && b->modulePath != NULL &&
+            strcmp(a->modulePath, b->modulePath) == 0);
+}
+
+static void printFrame(FILE *out, const JaiFrameInfo *fr, const char *blue,
+                       const char *reset) {
+    const char *name = fr->functionName != NULL ? fr->functionName : "<module>";
+    const char *path = fr->modulePath;
+    int line = 0;
+
+    JaiSourceFile *sf = jaiSpanValid(fr->span) ? jaiSourceGet(fr->span.file) : NULL;
+    if (sf != NULL) {
+        int col = 0;
+        jaiSourceLineCol(sf->id, fr->span.start, &line, &col);
+        if (path == NULL) path = sf->path;
+    }
+    if (path == NULL) path = "<native>";
+
+    if (line > 0) {
+        fprintf(out, "  %sFile \"%s\", line %d, in %s%s\n", blue, path, line,
+                name, reset);
+    } else {
+        fprintf(out, "  %sFile \"%s\", in %s%s\n", blue, path, name, reset);
+    }
+
+    if (sf == NULL) return;
+    size_t len = 0;
+    const char *text = jaiSourceLineText(sf->id, fr->span.start, &len, NULL);
+    if (text == NULL) return;
+    size_t s = 0;
+    while (s < len && (text[s] == ' ' || text[s] == '\t')) s++;
+    if (s < len) {
+        fputs("    ", out);
+        writeExpanded(out, text + s, len - s);
+        fputc('\n', out);
+    }
+}
+
+/* `run` counts the copies after the first; those past the printed ones are
+ * reported, not shown. */
+static void printElided(FILE *out, int run) {
+    if (run < JAI_TRACEBACK_REPEATS) return;
+    int more = run - JAI_TRACEBACK_REPEATS + 1;
+    fprintf(out, "  [Previous frame repeated %d more time%s]\n", more,
+            more == 1 ? "" : "s");
+}
+
 void jaiPrintTraceback(FILE *out, const JaiFrameInfo *frames, int count,
                        const char *excType, const char *excMessage, bool color) {
     if (out == NULL) return;
@@ -810,39 +868,17 @@ void jaiPrintTraceback(FILE *out, const JaiFrameInfo *frames, int count,
 
     if (frames != NULL && count > 0) {
         fprintf(out, "%sTraceback (most recent call last):%s\n", bold, reset);
+        int run = 0;
         for (int i = 0; i < count; i++) {
-            const JaiFrameInfo *fr = &frames[i];
-            const char *name = fr->functionName != NULL ? fr->functionName : "<module>";
-            const char *path = fr->modulePath;
-            int line = 0;
-
-            JaiSourceFile *sf = jaiSpanValid(fr->span) ? jaiSourceGet(fr->span.file) : NULL;
-            if (sf != NULL) {
-                int col = 0;
-                jaiSourceLineCol(sf->id, fr->span.start, &line, &col);
-                if (path == NULL) path = sf->path;
-            }
-            if (path == NULL) path = "<native>";
-
-            if (line > 0) {
-                fprintf(out, "  %sFile \"%s\", line %d, in %s%s\n", blue, path, line,
-                        name, reset);
+            if (i > 0 && sameFrame(&frames[i], &frames[i - 1])) {
+                if (++run >= JAI_TRACEBACK_REPEATS) continue;
             } else {
-                fprintf(out, "  %sFile \"%s\", in %s%s\n", blue, path, name, reset);
-            }
-
-            if (sf == NULL) continue;
-            size_t len = 0;
-            const char *text = jaiSourceLineText(sf->id, fr->span.start, &len, NULL);
-            if (text == NULL) continue;
-            size_t s = 0;
-            while (s < len && (text[s] == ' ' || text[s] == '\t')) s++;
-            if (s < len) {
-                fputs("    ", out);
-                writeExpanded(out, text + s, len - s);
-                fputc('\n', out);
+                printElided(out, run);
+                run = 0;
             }
+            printFrame(out, &frames[i], blue, reset);
         }
+        printElided(out, run);
     }
 
     const char *type = (excType != NULL && excType[0] != '\0') ? excType : "Error";
@@ -38,6 +38,9 @@ static bool nGcStats(int argc, Value *args, Value *out) {
     jaiIODictPut(stats, "min_heap", INT_VAL(gc != NULL ? (int64_t)gc->minHeap : 0));
     jaiIODictPut(stats, "grow_factor", FLOAT_VAL(gc != NULL ? gc->growFactor : 0.0));
     jaiIODictPut(stats, "collections", INT_VAL(gc != NULL ? (int64_t)gc->collections : 0));
+    jaiIODictPut(stats, "minor_collections",
+            INT_VAL(gc != NULL ? (int64_t)gc->minorCollections : 0));
+    jaiIODictPut(stats, "promoted", INT_VAL(gc != NULL ? (int64_t)gc->promoted : 0));
     jaiIODictPut(stats, "total_freed", INT_VAL(gc != NULL ? (int64_t)gc->totalFreed : 0));
     jaiIODictPut(stats, "pause_seconds",
             FLOAT_VAL(gc != NULL ? gc->totalPauseSeconds : 0.0));
@@ -3,6 +3,7 @@
 #include "runtime/runtime.h"
 
 #include "vm/gc.h"
+#include "vm/jit/jit.h"
 #include "vm/bytecode/serialize.h"
 
 /* The binding eval() compiles into and then removes. It is not of the form
@@ -53,6 +54,7 @@ static ObjFunction *compileFragment(const char *source, size_t length,
         return NULL;
     }
     fn->module = module;
+    jaiGCBarrier((Obj *)fn, OBJ_VAL(module));
     return fn;
 }
 
@@ -123,7 +125,9 @@ static bool nReflectEval(int argc, Value *args, Value *out) {
     Value value = NULL_VAL;
     if (module != NULL) {
         (void)jaiModuleGet(module, slot, &value);
+        jaiJitHold();   /* a compile may be probing this table */
         if (jaiTableDelete(&module->globals, OBJ_VAL(slot))) module->version++;
+        jaiJitRelease();
     }
     *out = value;
     return true;
@@ -1074,6 +1074,7 @@ static bool primListSet(int argc, Value *args, Value *out) {
     if (!jaiSeqIndexArg(args[1], 2, "list_set", list->count, &at)) return false;
     list->items[at] = args[2];
     jaiListTouch(list);
+    jaiGCBarrier((Obj *)list, args[2]);
     *out = NULL_VAL;
     return true;
 }
@@ -89,6 +89,7 @@ static bool nGuiWindowOpen(int argc, Value *args, Value *out) {
         jaiListPush(gKeepAlive, OBJ_VAL(pixels));
     } else {
         gKeepAlive->items[slot] = OBJ_VAL(pixels);
+        jaiGCBarrier((Obj *)gKeepAlive, OBJ_VAL(pixels));
     }
     jaiGCPopRoot();
 
@@ -19,7 +19,9 @@ static Value fieldAt(ObjInstance *inst, uint16_t slot) {
 }
 
 static void setFieldAt(ObjInstance *inst, uint16_t slot, Value v) {
-    if (slot < inst->fieldCount) inst->fields[slot] = v;
+    if (slot >= inst->fieldCount) return;
+    inst->fields[slot] = v;
+    jaiGCBarrier((Obj *)inst, v);
 }
 
 static const char *classNameOf(const ObjInstance *inst) {
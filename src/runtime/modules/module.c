@@ -62,6 +62,7 @@
 
 #include "common/diag.h"
 #include "vm/bytecode/serialize.h"
+#include "vm/gc.h"
 
 CodegenOptions jaiCodegenDefaults(void) {
     CodegenOptions opts;
@@ -293,6 +294,15 @@ static bool maybeWarmFor(const char *path) {
     return true;
 }
 
+/* Every way a module body arrives ends here, so the compiled tier's record of
+ * it (jit_warm.c) is read and written under the same options as the .jaic. */
+static ObjFunction *withWarmStart(ObjFunction *body, const char *path,
+                                  uint64_t hash) {
+    const JaiRunOptions *opts = options();
+    jaiJitWarmAttach(path, body, hash, opts->useCache, opts->writeCache);
+    return body;
+}
+
 static ObjFunction *loadModuleBody(ObjModule *module, const char *path) {
     size_t length = 0;
     char *text = jaiReadFile(path, &length);
@@ -331,7 +341,7 @@ static ObjFunction *loadModuleBody(ObjModule *module, const char *path) {
             jaiCacheReadFree(cacheData, cacheLen);
             if (cached != NULL) {
                 if (traceLoads()) fprintf(stderr, "load cache   %s\n", path);
-                return cached;
+                return withWarmStart(cached, path, hash);
             }
             /* Stale, corrupt, or from another compiler: recompile silently. */
         }
@@ -350,7 +360,7 @@ static ObjFunction *loadModuleBody(ObjModule *module, const char *path) {
                                                        module, hash);
             if (fromSeed != NULL) {
                 if (traceLoads()) fprintf(stderr, "load seed    %s\n", path);
-                return fromSeed;
+                return withWarmStart(fromSeed, path, hash);
             }
         }
     }
@@ -374,6 +384,7 @@ static ObjFunction *loadModuleBody(ObjModule *module, const char *path) {
         if (module->name != NULL) {
             body->name = module->name;
             body->qualifiedName = module->name;
+            jaiGCBarrier((Obj *)body, OBJ_VAL(module->name));
         }
     } else {
         /* One front end remains and the branch above is the one that runs it.
@@ -387,7 +398,7 @@ static ObjFunction *loadModuleBody(ObjModule *module, const char *path) {
         (void)jaiCacheStore(path, module, body, hash, flags);   /* best effort */
         jaiPopRoot();
     }
-    return body;
+    return withWarmStart(body, path, hash);
 }
 
 /* ------------------------------------------------------------------ */
@@ -476,8 +487,10 @@ static bool runModuleBody(ObjModule *module, ObjFunction *body) {
     }
 
     body->module = module;
+    jaiGCBarrier((Obj *)body, OBJ_VAL(module));
     ObjClosure *closure = jaiClosureNew(body);
     module->body = closure;
+    jaiGCBarrier((Obj *)module, OBJ_VAL(closure));
 
     Value ignored = NULL_VAL;
     if (!jaiCallValue(OBJ_VAL(closure), 0, NULL, &ignored)) {
@@ -963,7 +976,7 @@ static ObjFunction *selfHostedModuleBody(ObjModule *module, const char *path) {
             jaiCacheReadFree(cacheData, cacheLen);
             if (cached != NULL) {
                 if (traceLoads()) fprintf(stderr, "load cache   %s\n", path);
-                return cached;
+                return withWarmStart(cached, path, hash);
             }
             /* Stale, corrupt, or from the other front end: compile it. */
         }
@@ -979,7 +992,7 @@ static ObjFunction *selfHostedModuleBody(ObjModule *module, const char *path) {
         (void)jaiCacheStore(path, module, body, hash, flags);   /* best effort */
         jaiPopRoot();
     }
-    return body;
+    return withWarmStart(body, path, hash);
 }
 
 int jaiRunFile(const char *path, const JaiRunOptions *opts, int argc,
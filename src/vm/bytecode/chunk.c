@@ -194,25 +194,69 @@
     X(OP_MATCH_RANGE_POP,      9, -1)                                         \
     X(OP_MATCH_SEQ_POP,        4, -1)                                         \
     /* `GET_LOCAL; <int k>; MUL` fused (§3.3) */                             \
-    X(OP_MUL_INT_CONST,        4, +1)
+    X(OP_MUL_INT_CONST,        4, +1)                                         \
+    /* a literal match's arms in one dispatch (§3.9) */                       \
+    X(OP_SWITCH,               5, -1)                                          \
+    X(OP_CALL_KW_IC,           6, SE_VAR)                                      \
+    /* a variadic parameter read in place (§3.5) */                           \
+    X(OP_REST_GET,             2,  0)                                          \
+    X(OP_CALL_REST,            3, SE_VAR)
 
 #define X_NAME(op, operands, effect)     #op,
 #define X_OPERANDS(op, operands, effect) (int8_t)(operands),
 #define X_EFFECT(op, operands, effect)   (int32_t)(effect),
 
-static const char *const kOpNames[]  = { JAI_OPCODES(X_NAME) };
+/* X(quick, generic) -- order must match enum OpCode from OP_QUICK_FIRST. Kept
+ * out of JAI_OPCODES on purpose: that table is the wire format, and
+ * emit.jai's copy of it must not learn opcodes no compiler may emit. A quick
+ * form has its generic form's operands and stack effect by definition, so it
+ * carries no columns of its own. */
+#define JAI_QUICK_OPCODES(X)                                                   \
+    X(OP_ADD_II,                 OP_ADD)                                       \
+    X(OP_ADD_FF,                 OP_ADD)                                       \
+    X(OP_SUB_II,                 OP_SUB)                                       \
+    X(OP_SUB_FF,                 OP_SUB)                                       \
+    X(OP_MUL_II,                 OP_MUL)                                       \
+    X(OP_MUL_FF,                 OP_MUL)                                       \
+    X(OP_DIV_II,                 OP_DIV)                                       \
+    X(OP_DIV_FF,                 OP_DIV)                                       \
+    X(OP_LT_II,                  OP_LT)                                        \
+    X(OP_LT_FF,                  OP_LT)                                        \
+    X(OP_LE_II,                  OP_LE)                                        \
+    X(OP_LE_FF,                  OP_LE)                                        \
+    X(OP_GT_II,                  OP_GT)                                        \
+    X(OP_GT_FF,                  OP_GT)                                        \
+    X(OP_GE_II,                  OP_GE)                                        \
+    X(OP_GE_FF,                  OP_GE)                                        \
+    X(OP_GET_INDEX_LIST_INT,     OP_GET_INDEX)                                 \
+    X(OP_SET_INDEX_LIST_INT,     OP_SET_INDEX)                                 \
+    X(OP_JUMP_IF_CMP_FALSE_FF,   OP_JUMP_IF_CMP_FALSE)                         \
+    X(OP_JUMP_IF_CMP_LOCAL_K_FF, OP_JUMP_IF_CMP_LOCAL_K)
+
+#define X_QUICK_NAME(quick, generic)    #quick,
+#define X_QUICK_GENERIC(quick, generic) (uint8_t)(generic),
+
+static const char *const kOpNames[]  = {
+    JAI_OPCODES(X_NAME) JAI_QUICK_OPCODES(X_QUICK_NAME)
+};
 static const int8_t      kOpOperands[] = { JAI_OPCODES(X_OPERANDS) };
 static const int32_t     kOpEffects[]  = { JAI_OPCODES(X_EFFECT) };
 
+const uint8_t jaiQuickGeneric[OP_COUNT - OP_QUICK_FIRST] = {
+    JAI_QUICK_OPCODES(X_QUICK_GENERIC)
+};
+
 #undef X_NAME
 #undef X_OPERANDS
 #undef X_EFFECT
+#undef X_QUICK_NAME
+#undef X_QUICK_GENERIC
 
 _Static_assert(sizeof(kOpNames) / sizeof(kOpNames[0]) == OP_COUNT,
                "opcode name table is out of sync with enum OpCode");
-_Static_assert(sizeof(kOpOperands) / sizeof(kOpOperands[0]) == OP_COUNT,
+_Static_assert(sizeof(kOpOperands) / sizeof(kOpOperands[0]) == OP_QUICK_FIRST,
                "operand size table is out of sync with enum OpCode");
-_Static_assert(sizeof(kOpEffects) / sizeof(kOpEffects[0]) == OP_COUNT,
+_Static_assert(sizeof(kOpEffects) / sizeof(kOpEffects[0]) == OP_QUICK_FIRST,
                "stack effect table is out of sync with enum OpCode");
 
 /* Bytes of the OP_CLOSURE header (the u24 constant index) and of one trailing
@@ -227,15 +271,15 @@ const char *jaiOpName(OpCode op) {
 }
 
 int jaiOpOperandSize(OpCode op) {
-    return opInRange(op) ? kOpOperands[op] : 0;
+    return opInRange(op) ? kOpOperands[jaiOpGeneric((uint8_t)op)] : 0;
 }
 
 int jaiOpStackEffect(OpCode op) {
-    return opInRange(op) ? kOpEffects[op] : SE_VAR;
+    return opInRange(op) ? kOpEffects[jaiOpGeneric((uint8_t)op)] : SE_VAR;
 }
 
 int jaiOpCacheOperand(OpCode op) {
-    switch (op) {
+    switch ((OpCode)jaiOpGeneric((uint8_t)op)) {
     case OP_GET_GLOBAL:
     case OP_SET_GLOBAL:
     case OP_GET_FIELD:
@@ -247,6 +291,8 @@ int jaiOpCacheOperand(OpCode op) {
         return 5;   /* after the u16 slot and the u24 name */
     case OP_FORMAT:
         return 7;   /* after the u8 count, the u24 mask and the u24 name */
+    case OP_CALL_KW_IC:
+        return 4;   /* after the u8 count and the u24 name tuple */
     default:
         return -1;
     }
@@ -709,6 +755,202 @@ void jaiChunkSpanAt(const Chunk *chunk, int codeOffset, uint32_t *start,
     if (end != NULL) *end = e;
 }
 
+void jaiChunkCopyGeneric(const Chunk *chunk, uint8_t *out) {
+    if (chunk->count <= 0) return;
+    memcpy(out, chunk->code, (size_t)chunk->count);
+    int offset = 0;
+    while (offset < chunk->count) {
+        uint8_t op = out[offset];
+        if (op >= OP_QUICK_FIRST && op < OP_COUNT) {
+            out[offset] = jaiQuickGeneric[op - OP_QUICK_FIRST];
+        }
+        int size = jaiOpOperandSize((OpCode)op);
+        if (op == OP_CLOSURE) {
+            /* Only a chunk that could never have run has anything else here,
+             * and such a chunk has nothing quickened past this point. */
+            if (offset + 1 + CLOSURE_HEADER_BYTES > chunk->count) return;
+            uint32_t index = jaiReadU24(out + offset + 1);
+            if (index >= (uint32_t)chunk->constants.count ||
+                !IS_FUNCTION(chunk->constants.data[index])) {
+                return;
+            }
+            size = CLOSURE_HEADER_BYTES +
+                   CLOSURE_UPVALUE_BYTES *
+                       (int)AS_FUNCTION(chunk->constants.data[index])->upvalueCount;
+        }
+        offset += 1 + size;
+    }
+}
+
+/* ------------------------------------------------------------------ */
+/* OP_SWITCH tables                                                     */
+/* ------------------------------------------------------------------ */
+
+/* Header words before a DENSE table's jumps or a HASH table's displacements. */
+#define SWITCH_HEADER 2
+
+static bool isPow2(int64_t x) { return x > 0 && (x & (x - 1)) == 0; }
+
+/* The slot of a key hashing to `h` in a HASH table of `r` buckets and `m`
+ * slots. The bucket comes from the high half, the slot from rehashing with
+ * the bucket's displacement, so keys sharing a bucket share a `d` but not,
+ * once the compiler has found the right `d`, a slot. emit.jai's
+ * `_switch_slot` is the same function and has to stay so. */
+static uint32_t switchSlot(const ObjTuple *t, uint32_t r, uint32_t m,
+                           uint64_t h) {
+    int64_t d = AS_INT(t->items[SWITCH_HEADER + ((h >> 32) & (r - 1))]);
+    return (uint32_t)(jaiHashU64(h ^ (uint64_t)d) & (m - 1));
+}
+
+static uint32_t switchBuckets(const ObjTuple *t) {
+    return (uint32_t)AS_INT(t->items[1]);
+}
+
+static uint32_t switchSlots(const ObjTuple *t) {
+    return (t->count - SWITCH_HEADER - switchBuckets(t)) / 2;
+}
+
+static bool switchKeyHash(Value key, uint64_t *h) {
+    if (IS_INT(key)) {
+        *h = jaiHashU64((uint64_t)AS_INT(key));
+        return true;
+    }
+    if (IS_STRING(key)) {
+        *h = jaiStringHash(AS_STRING(key));
+        return true;
+    }
+    return false;
+}
+
+bool jaiSwitchCheck(Value table, int after, int codeCount) {
+    if (!IS_TUPLE(table)) return false;
+    const ObjTuple *t = AS_TUPLE(table);
+    if (t->count < SWITCH_HEADER + 1) return false;
+    for (uint32_t i = 0; i < t->count; i++) {
+        if (!IS_INT(t->items[i]) && !IS_STRING(t->items[i]) &&
+            !IS_NULL(t->items[i])) {
+            return false;
+        }
+    }
+    if (!IS_INT(t->items[0]) || !IS_INT(t->items[1])) return false;
+    int64_t reach = (int64_t)codeCount - after;
+
+    if (AS_INT(t->items[0]) == JAI_SWITCH_DENSE) {
+        int64_t lo = AS_INT(t->items[1]);
+        int64_t n = (int64_t)t->count - SWITCH_HEADER;
+        if (lo > INT64_MAX - (n - 1)) return false;
+        for (uint32_t i = SWITCH_HEADER; i < t->count; i++) {
+            Value rel = t->items[i];
+            if (!IS_INT(rel) || AS_INT(rel) < -1 || AS_INT(rel) >= reach) {
+                return false;
+            }
+        }
+        return true;
+    }
+    if (AS_INT(t->items[0]) != JAI_SWITCH_HASH) return false;
+
+    int64_t r = AS_INT(t->items[1]);
+    if (!isPow2(r) || r > (int64_t)t->count - SWITCH_HEADER - 2) return false;
+    int64_t rest = (int64_t)t->count - SWITCH_HEADER - r;
+    if (rest % 2 != 0 || !isPow2(rest / 2)) return false;
+    for (int64_t i = 0; i < r; i++) {
+        if (!IS_INT(t->items[SWITCH_HEADER + i])) return false;
+    }
+    uint32_t m = (uint32_t)(rest / 2);
+    int kind = -1;   /* 0 int keys, 1 string keys */
+    for (uint32_t slot = 0; slot < m; slot++) {
+        const Value *entry = &t->items[SWITCH_HEADER + r + 2 * slot];
+        if (!IS_INT(entry[1])) return false;
+        int64_t rel = AS_INT(entry[1]);
+        uint64_t h;
+        if (IS_NULL(entry[0])) {
+            if (rel != -1) return false;
+            continue;
+        }
+        if (!switchKeyHash(entry[0], &h)) return false;
+        int keyKind = IS_STRING(entry[0]) ? 1 : 0;
+        if (kind >= 0 && keyKind != kind) return false;
+        kind = keyKind;
+        if (rel < 0 || rel >= reach) return false;
+        if (switchSlot(t, (uint32_t)r, m, h) != slot) return false;
+    }
+    return true;
+}
+
+int jaiSwitchSize(Value table) {
+    const ObjTuple *t = AS_TUPLE(table);
+    if (AS_INT(t->items[0]) == JAI_SWITCH_DENSE) {
+        return (int)t->count - SWITCH_HEADER;
+    }
+    return (int)switchSlots(t);
+}
+
+bool jaiSwitchCaseAt(Value table, int i, JaiSwitchCase *out) {
+    const ObjTuple *t = AS_TUPLE(table);
+    out->isString = false;
+    out->strKey = NULL;
+    if (AS_INT(t->items[0]) == JAI_SWITCH_DENSE) {
+        out->intKey = AS_INT(t->items[1]) + i;
+        out->rel = (int32_t)AS_INT(t->items[SWITCH_HEADER + i]);
+        return out->rel >= 0;
+    }
+    const Value *entry =
+        &t->items[SWITCH_HEADER + switchBuckets(t) + 2 * (uint32_t)i];
+    if (IS_NULL(entry[0])) return false;
+    if (IS_STRING(entry[0])) {
+        out->isString = true;
+        out->strKey = AS_STRING(entry[0]);
+        out->intKey = 0;
+    } else {
+        out->intKey = AS_INT(entry[0]);
+    }
+    out->rel = (int32_t)AS_INT(entry[1]);
+    return true;
+}
+
+int32_t jaiSwitchFind(Value table, Value subject, bool *slow) {
+    const ObjTuple *t = AS_TUPLE(table);
+    *slow = false;
+
+    /* A float equal to an int matches it, as MATCH_CONST's jaiValuesEqual
+     * would have said; any other float matches nothing. */
+    bool isInt = true;
+    int64_t key = 0;
+    if (IS_INT(subject)) {
+        key = AS_INT(subject);
+    } else if (IS_FLOAT(subject)) {
+        double f = AS_FLOAT(subject);
+        if (!(f >= -9223372036854775808.0 && f < 9223372036854775808.0) ||
+            (double)(int64_t)f != f) {
+            return -1;
+        }
+        key = (int64_t)f;
+    } else if (IS_STRING(subject)) {
+        isInt = false;
+    } else {
+        *slow = IS_OBJ(subject) && OBJ_TYPE(subject) == OBJ_INSTANCE;
+        return -1;
+    }
+
+    if (AS_INT(t->items[0]) == JAI_SWITCH_DENSE) {
+        if (!isInt) return -1;
+        uint64_t index = (uint64_t)key - (uint64_t)AS_INT(t->items[1]);
+        if (index >= (uint64_t)(t->count - SWITCH_HEADER)) return -1;
+        return (int32_t)AS_INT(t->items[SWITCH_HEADER + index]);
+    }
+
+    uint32_t r = switchBuckets(t), m = switchSlots(t);
+    uint64_t h = isInt ? jaiHashU64((uint64_t)key)
+                       : jaiStringHash(AS_STRING(subject));
+    const Value *entry =
+        &t->items[SWITCH_HEADER + r + 2 * switchSlot(t, r, m, h)];
+    bool hit = isInt ? IS_INT(entry[0]) && AS_INT(entry[0]) == key
+                     : IS_STRING(entry[0]) &&
+                           jaiStringEquals(AS_STRING(entry[0]),
+                                           AS_STRING(subject));
+    return hit ? (int32_t)AS_INT(entry[1]) : -1;
+}
+
 /* ------------------------------------------------------------------ */
 /* Disassembly                                                          */
 /* ------------------------------------------------------------------ */
@@ -778,7 +1020,7 @@ static void printPrefix(FILE *out, const Chunk *chunk, int offset,
         jaiChunkSpanAt(chunk, offset, &s, &e);
         snprintf(line, sizeof line, "%u..%u", (unsigned)s, (unsigned)e);
         fprintf(out, "%04d  %-16s  ", offset, line);
-        fprintf(out, pad ? "%-23s" : "%s", name);
+        fprintf(out, pad ? "%-22s " : "%s", name);
         return;
     }
 
@@ -791,7 +1033,7 @@ static void printPrefix(FILE *out, const Chunk *chunk, int offset,
         snprintf(line, sizeof line, "%4d", here);
     }
     fprintf(out, "%04d  %s  ", offset, line);
-    fprintf(out, pad ? "%-23s" : "%s", name);
+    fprintf(out, pad ? "%-22s " : "%s", name);
 }
 
 /* Jump operands are relative to the byte after the whole instruction, so the
@@ -848,6 +1090,41 @@ static int disassembleClosure(FILE *out, const Chunk *chunk, int offset) {
     return next;
 }
 
+/* The table's arms one per line under the instruction, in table order: key
+ * order for DENSE, slot order for HASH. */
+static void disassembleSwitch(FILE *out, const Chunk *chunk, int offset,
+                              int next) {
+    const uint8_t *a = chunk->code + offset + 1;
+    uint32_t k = jaiReadU24(a);
+    int16_t j = jaiReadI16(a + 3);
+    char operands[32];
+    snprintf(operands, sizeof operands, "%u %+d", (unsigned)k, (int)j);
+    fprintf(out, "%-18s ; ", operands);
+    if (k >= (uint32_t)chunk->constants.count ||
+        !jaiSwitchCheck(chunk->constants.data[k], next, chunk->count)) {
+        fprintf(out, "<malformed table>, default -> %04d\n", next + (int)j);
+        return;
+    }
+    Value table = chunk->constants.data[k];
+    int size = jaiSwitchSize(table), arms = 0;
+    JaiSwitchCase c;
+    for (int i = 0; i < size; i++) arms += jaiSwitchCaseAt(table, i, &c);
+    fprintf(out, "%s, %d key%s, default -> %04d\n",
+            AS_INT(AS_TUPLE(table)->items[0]) == JAI_SWITCH_DENSE ? "dense"
+                                                                  : "hash",
+            arms, arms == 1 ? "" : "s", next + (int)j);
+    for (int i = 0; i < size; i++) {
+        if (!jaiSwitchCaseAt(table, i, &c)) continue;
+        if (c.isString) {
+            fprintf(out, "%04d  %4s  %-23s \"%.*s\" -> %04d\n", offset, "|",
+                    "|", (int)c.strKey->length, c.strKey->chars, next + c.rel);
+        } else {
+            fprintf(out, "%04d  %4s  %-23s %lld -> %04d\n", offset, "|", "|",
+                    (long long)c.intKey, next + c.rel);
+        }
+    }
+}
+
 int jaiDisassembleInstruction(FILE *out, const Chunk *chunk, int offset) {
     if (out == NULL || chunk == NULL) return offset + 1;
     if (offset < 0 || offset >= chunk->count) return offset + 1;
@@ -879,7 +1156,9 @@ int jaiDisassembleInstruction(FILE *out, const Chunk *chunk, int offset) {
     operands[0] = '\0';
     note[0] = '\0';
 
-    switch (op) {
+    /* A quickened form prints under its own name with its generic form's
+     * operands, so a trace shows which sites the interpreter specialised. */
+    switch ((OpCode)jaiOpGeneric(raw)) {
     /* --- u24 constant index --- */
     case OP_CONST:
     case OP_DEF_GLOBAL:
@@ -980,7 +1259,7 @@ int jaiDisassembleInstruction(FILE *out, const Chunk *chunk, int offset) {
         return next;
     }
 
-    /* --- u8 argc + u24 keyword-name tuple --- */
+    /* --- u8 argc + u24 keyword-name tuple (+ u16 cache) --- */
     case OP_CALL_KW: {
         unsigned argc = a[0];
         uint32_t k = jaiReadU24(a + 1);
@@ -990,6 +1269,18 @@ int jaiDisassembleInstruction(FILE *out, const Chunk *chunk, int offset) {
         emitConstOperands(out, chunk, operands, k, suffix);
         return next;
     }
+    case OP_CALL_KW_IC: {
+        unsigned argc = a[0];
+        uint32_t k = jaiReadU24(a + 1);
+        uint16_t cache = jaiReadU16(a + 4);
+        char suffix[48];
+        snprintf(operands, sizeof operands, "%u %u c%u", argc, (unsigned)k,
+                 (unsigned)cache);
+        snprintf(suffix, sizeof suffix, "  %u positional, cache %u", argc,
+                 (unsigned)cache);
+        emitConstOperands(out, chunk, operands, k, suffix);
+        return next;
+    }
 
     /* --- u24 constant + u8 tag + u8 argc --- */
     case OP_ENUM_NEW: {
@@ -1045,6 +1336,11 @@ int jaiDisassembleInstruction(FILE *out, const Chunk *chunk, int offset) {
         return next;
     }
 
+    /* --- u24 table + i16 default, then one line per arm --- */
+    case OP_SWITCH:
+        disassembleSwitch(out, chunk, offset, next);
+        return next;
+
     /* --- u24 lo, u24 hi, u8 inclusive, i16 jump --- */
     case OP_MATCH_RANGE: {
         uint32_t lo = jaiReadU24(a), hi = jaiReadU24(a + 3);
@@ -1127,6 +1423,22 @@ int jaiDisassembleInstruction(FILE *out, const Chunk *chunk, int offset) {
         break;
     }
 
+    /* --- u16 variadic slot, and the arguments it counts --- */
+    case OP_REST_GET: {
+        unsigned slot = (unsigned)jaiReadU16(a);
+        snprintf(operands, sizeof operands, "%u", slot);
+        snprintf(note, sizeof note, "argument viewed by slot %u", slot);
+        break;
+    }
+    case OP_CALL_REST: {
+        unsigned argc = a[0];
+        unsigned slot = (unsigned)jaiReadU16(a + 1);
+        snprintf(operands, sizeof operands, "%u %u", argc, slot);
+        snprintf(note, sizeof note, "%u arg%s + those viewed by slot %u", argc,
+                 argc == 1 ? "" : "s", slot);
+        break;
+    }
+
     case OP_POPN: {
         snprintf(operands, sizeof operands, "%u", (unsigned)a[0]);
         snprintf(note, sizeof note, "pop %u", (unsigned)a[0]);
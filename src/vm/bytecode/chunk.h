@@ -306,9 +306,75 @@ typedef enum {
      * same-type-in-same-type-out template the way ADD/SUB/MUL do.) */
     OP_MUL_INT_CONST,        /* u16 S, i16 */
 
+    /* A whole literal `match` in one dispatch (§3.9): pops the subject and
+     * jumps to the arm whose key equals it, or to J when none does. Never
+     * falls through. K is a tuple constant describing the keys, in one of
+     * two layouts (see jaiSwitchCheck); every jump it holds is, like J,
+     * relative to the end of this instruction. Emitted by the match
+     * compiler in place of a MATCH_CONST_POP chain once a match has enough
+     * int, string or enum-tag keys for the chain's linear cost to show. */
+    OP_SWITCH,               /* u24 K(table), i16 J */
+
+    /* OP_CALL_KW with an inline cache (§3.5): the same call, but the site
+     * remembers which parameter each of its keyword names landed on, keyed by
+     * the callee function, so a repeat call permutes the window instead of
+     * matching names. OP_CALL_KW stays for images written before it. */
+    OP_CALL_KW_IC,           /* u8 A, u24 K, u16 C */
+
+    /* A variadic parameter read only by index, `for`, `.len()` or a spread
+     * (§3.5, FN_REST_VIEW) is never packed into a list: the call leaves its
+     * arguments on the stack just above the frame's window and slot S, the
+     * variadic slot, holds how many there are. REST_GET replaces the int
+     * index on top with one of them, a negative index counting from the end
+     * as a list's does; CALL_REST is CALL_SPREAD with them as the spread. */
+    OP_REST_GET,             /* u16 S */
+    OP_CALL_REST,            /* u8 A, u16 S */
+
+    /* Quickened forms. Never emitted, never in a .jaic, never
+     * seen by the verifier on load: the interpreter rewrites a generic
+     * instruction into one of these in place once the site has shown the
+     * same operand kinds often enough, and rewrites it back the first time
+     * that stops being true. Each has exactly its generic form's operands
+     * and stack effect; jaiOpGeneric names that form, and every reader of
+     * live bytecode other than the dispatch loop folds through it. */
+    OP_ADD_II,
+    OP_ADD_FF,
+    OP_SUB_II,
+    OP_SUB_FF,
+    OP_MUL_II,
+    OP_MUL_FF,
+    OP_DIV_II,
+    OP_DIV_FF,
+    OP_LT_II,
+    OP_LT_FF,
+    OP_LE_II,
+    OP_LE_FF,
+    OP_GT_II,
+    OP_GT_FF,
+    OP_GE_II,
+    OP_GE_FF,
+    OP_GET_INDEX_LIST_INT,
+    OP_SET_INDEX_LIST_INT,
+    OP_JUMP_IF_CMP_FALSE_FF,
+    OP_JUMP_IF_CMP_LOCAL_K_FF,
+
     OP_COUNT
 } OpCode;
 
+/* The first quickened opcode; everything below it is the wire format. */
+#define OP_QUICK_FIRST OP_ADD_II
+
+extern const uint8_t jaiQuickGeneric[OP_COUNT - OP_QUICK_FIRST];
+
+/* The generic opcode `op` was quickened from, or `op` itself when it is not a
+ * quickened form. Out-of-range bytes come back unchanged for the caller's own
+ * range check to reject. */
+JAI_INLINE uint8_t jaiOpGeneric(uint8_t op) {
+    return op >= OP_QUICK_FIRST && op < OP_COUNT
+               ? jaiQuickGeneric[op - OP_QUICK_FIRST]
+               : op;
+}
+
 /* Length in bytes of the operands following `op` (not counting the opcode
  * byte). OP_CLOSURE is variable-length; callers must special-case it. */
 int  jaiOpOperandSize(OpCode op);
@@ -365,9 +431,14 @@ int    jaiLtv1Count(const uint8_t *stream, size_t len);
 /* code generator hands out slots with jaiChunkAddCache.                   */
 /* ------------------------------------------------------------------ */
 
-typedef enum { IC_EMPTY = 0, IC_MONO, IC_POLY, IC_MEGA } ICState;
+/* IC_VTABLE is IC_MEGA for an OP_INVOKE whose method a trait declares: the
+ * last way stops being a way and holds the trait (cached) and the method's
+ * index in its numbering (payload), and every receiver that implements the
+ * trait is answered from its class's TraitVTable. See icGoMegamorphic. */
+typedef enum { IC_EMPTY = 0, IC_MONO, IC_POLY, IC_MEGA, IC_VTABLE } ICState;
 
 #define JAI_IC_WAYS 4
+#define JAI_IC_VTABLE_WAY (JAI_IC_WAYS - 1)
 
 /* What an OP_INVOKE site was observed to RETURN, one byte per way. Only ever a
  * PREDICTION -- the tag guard emitted alongside it is what makes it sound, so a
@@ -489,6 +560,53 @@ uint32_t jaiChunkAddConstant(Chunk *chunk, Value v);
 /* Source span covering the instruction at `codeOffset`. */
 void     jaiChunkSpanAt(const Chunk *chunk, int codeOffset, uint32_t *start,
                         uint32_t *end);
+/* The chunk's code as it was emitted: `out` (chunk->count bytes) gets a copy
+ * with every quickened opcode folded back to its generic form. Walks by
+ * instruction, since an operand byte may equal any opcode. What the .jaic
+ * writer and the warm-start hash see, so neither depends on what ran. */
+void     jaiChunkCopyGeneric(const Chunk *chunk, uint8_t *out);
+
+/* ------------------------------------------------------------------ */
+/* OP_SWITCH tables                                                     */
+/* ------------------------------------------------------------------ */
+
+/* The table is a tuple constant. Every `rel` in it is a jump relative to the
+ * end of the OP_SWITCH, or -1 for "no arm: take the instruction's own J".
+ *
+ *   (0, lo, rel_0, ..., rel_{n-1})
+ *       DENSE: int keys lo..lo+n-1, looked up by subtraction.
+ *   (1, r, d_0, ..., d_{r-1}, key_0, rel_0, ..., key_{m-1}, rel_{m-1})
+ *       HASH: a perfect hash over int or string keys (not both). r and m are
+ *       powers of two; a key's slot is jaiSwitchSlot of its jaiValueHash and
+ *       the displacement of its bucket. An unused slot is (null, -1).
+ *
+ * The compiler builds the hash by trying displacements per bucket until no
+ * two keys share a slot, so a lookup is two array reads and one compare
+ * whatever the number of arms. */
+#define JAI_SWITCH_DENSE 0
+#define JAI_SWITCH_HASH  1
+
+typedef struct {
+    bool       isString;
+    int64_t    intKey;
+    ObjString *strKey;
+    int32_t    rel;
+} JaiSwitchCase;
+
+/* Whether `table` is a well-formed OP_SWITCH table for an instruction ending
+ * at `after` in a chunk of `codeCount` bytes: the layout above, every key in
+ * the slot its hash names, every jump forward and inside the chunk. The
+ * loader refuses an image that fails this, so the interpreter never has to
+ * bounds-check a table. */
+bool    jaiSwitchCheck(Value table, int after, int codeCount);
+/* Entries to pass to jaiSwitchCaseAt: n for DENSE, m for HASH. */
+int     jaiSwitchSize(Value table);
+/* Entry `i`, or false when it names no arm (a -1 or an unused slot). */
+bool    jaiSwitchCaseAt(Value table, int i, JaiSwitchCase *out);
+/* The jump for `subject`: its arm's rel, or -1 for the default. Sets *slow
+ * instead when the subject is an instance whose own __eq__ has to decide;
+ * the caller then compares it against every case in arm order. */
+int32_t jaiSwitchFind(Value table, Value subject, bool *slow);
 
 /* Operands are little-endian by construction. Read as one unaligned load
  * (both arm64 and x86-64 permit it) instead of byte-assembled, this costs one
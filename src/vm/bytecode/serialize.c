@@ -104,6 +104,11 @@ typedef enum {
 #define JAID_SUFFIX      ".jaid"
 #define JAID_HEADER      16u   /* magic 4, version 2, reserved 2, srcHash 8 */
 
+/* What the compiled tier learned last run (vm/jit/jit_warm.c), beside the
+ * image under the same stem. Its own format and its own checks; this file
+ * only says where it lives and clears it with the rest. */
+#define JAIJ_SUFFIX      ".jaij"
+
 /* A function record has no name when its nameIndex is this sentinel; §5 has no
  * other way to say "unnamed", and index 0 is a perfectly good constant. */
 #define JAIC_NO_NAME     UINT32_MAX
@@ -118,12 +123,14 @@ typedef enum {
 /* On-disk sizes of the fixed-width records, used to bound counts against the
  * bytes actually left in the buffer before anything is allocated. */
 #define JAIC_LINE_ENTRY   12u   /* u32 offset, u32 span, u32 spanEnd */
-#define JAIC_EXC_ENTRY    16u   /* u32 start, end, handler, typeConst */
+#define JAIC_EXC_ENTRY    20u   /* u32 start, end, handler, typeConst, depth */
+#define JAIC_EXC_ENTRY_V14 16u   /* the same without depth */
 #define JAIC_U32_ENTRY     4u
 
 /* Flag bits an ObjFunction may carry. Anything else is a newer compiler's
  * output that this reader would silently misinterpret. */
-#define JAIC_KNOWN_FN_FLAGS ((uint32_t)0xFFu | (uint32_t)FN_INIT | (uint32_t)FN_TRACE | (uint32_t)FN_GPU_KERNEL)
+#define JAIC_KNOWN_FN_FLAGS ((uint32_t)0xFFu | (uint32_t)FN_INIT | (uint32_t)FN_TRACE | (uint32_t)FN_GPU_KERNEL | \
+                             (uint32_t)FN_SITE_CLOSURE | (uint32_t)FN_REST_VIEW)
 
 /* ------------------------------------------------------------------ */
 /* Reading: bounds-checked cursor                                       */
@@ -563,8 +570,12 @@ static bool writeFunction(JaiBuf *b, JaiBuf *sidecar, StrTab *st,
         jaiBufWriteU16(b, fn->maxSlots);
         jaiBufWriteU16(b, fn->upvalueCount);
 
+        /* The code as emitted, not as it ran: a function that has been
+         * executed may hold quickened opcodes, and those never go to disk. */
         jaiBufWriteU32(b, (uint32_t)fn->chunk.count);
-        jaiBufAppend(b, fn->chunk.code, (size_t)fn->chunk.count);
+        jaiBufReserve(b, (size_t)fn->chunk.count);
+        jaiChunkCopyGeneric(&fn->chunk, b->data + b->count);
+        b->count += (size_t)fn->chunk.count;
 
         jaiBufWriteU32(b, constCount);
         jaiBufAppend(b, constants.data, constants.count);
@@ -594,6 +605,7 @@ static bool writeFunction(JaiBuf *b, JaiBuf *sidecar, StrTab *st,
             jaiBufWriteU32(b, e->end);
             jaiBufWriteU32(b, e->handler);
             jaiBufWriteU32(b, e->typeConst);
+            jaiBufWriteU32(b, e->depth);
         }
 
         jaiBufWriteU16(b, fn->defaultCount);
@@ -915,7 +927,7 @@ static bool rebuildCaches(Chunk *chunk) {
 
     for (int off = 0; off < chunk->count;) {
         uint8_t raw = chunk->code[off];
-        if (raw >= OP_COUNT) return false;
+        if (raw >= OP_QUICK_FIRST) return false;   /* quick forms are never written */
         OpCode op = (OpCode)raw;
 
         int size = jaiOpOperandSize(op);
@@ -929,6 +941,18 @@ static bool rebuildCaches(Chunk *chunk) {
         }
         if (size < 0 || off > chunk->count - 1 - size) return false;
 
+        /* OP_SWITCH indexes its table without bounds checks; a table the
+         * checksum vouches for but no compiler of ours would write is refused
+         * here, once, instead. */
+        if (op == OP_SWITCH) {
+            uint32_t k = jaiReadU24(chunk->code + off + 1);
+            if (k >= (uint32_t)chunk->constants.count ||
+                !jaiSwitchCheck(chunk->constants.data[k], off + 1 + size,
+                                chunk->count)) {
+                return false;
+            }
+        }
+
         int cacheAt = jaiOpCacheOperand(op);
         if (cacheAt >= 0) {
             long idx = (long)jaiReadU16(chunk->code + off + 1 + cacheAt);
@@ -1028,7 +1052,11 @@ static ObjFunction *readFunction(Cursor *c, ObjModule *module, int depth) {
 
     {
         uint16_t excCount = curU16(c);
-        if (c->bad || !curFits(c, excCount, JAIC_EXC_ENTRY)) goto fail;
+        bool hasDepth = c->version >= JAIC_VERSION_EXCDEPTH;
+        if (c->bad || !curFits(c, excCount, hasDepth ? JAIC_EXC_ENTRY
+                                                     : JAIC_EXC_ENTRY_V14)) {
+            goto fail;
+        }
         if (excCount > 0) {
             fn->exceptions = JAI_ALLOC(ExceptionEntry, excCount);
             fn->exceptionCount = excCount;
@@ -1037,6 +1065,7 @@ static ObjFunction *readFunction(Cursor *c, ObjModule *module, int depth) {
                 fn->exceptions[i].end = curU32(c);
                 fn->exceptions[i].handler = curU32(c);
                 fn->exceptions[i].typeConst = curU32(c);
+                fn->exceptions[i].depth = hasDepth ? curU32(c) : 0u;
             }
             if (c->bad) goto fail;
         }
@@ -1102,10 +1131,15 @@ static ObjFunction *readFunction(Cursor *c, ObjModule *module, int depth) {
             e->handler >= (uint32_t)fn->chunk.count) {
             goto fail;
         }
-        if (e->typeConst != UINT32_MAX &&
+        if (e->typeConst != JAI_HANDLER_CATCH_ALL &&
+            e->typeConst != JAI_HANDLER_FINALLY &&
             e->typeConst >= (uint32_t)fn->chunk.constants.count) {
             goto fail;
         }
+        /* The handler resumes `depth` entries above the window; the window
+         * reserves the emitter's whole operand stack, so nothing deeper is
+         * real. */
+        if (e->depth > fn->maxSlots) goto fail;
     }
     for (uint8_t i = 0; i < fn->defaultCount; i++) {
         if (fn->defaultOffsets[i] >= (uint32_t)fn->chunk.count) goto fail;
@@ -1396,6 +1430,7 @@ static ObjFunction *deserializeWithSidecar(const uint8_t *data, size_t size,
         for (uint32_t i = 0; i < exportCount; i++) {
             ObjString *name = poolString(&modulePool, exportIndices[i]);
             (void)jaiTableSetInterned(&module->exports, name, BOOL_VAL(true));
+            jaiGCBarrier((Obj *)module, OBJ_VAL(name));
         }
     }
 
@@ -1460,6 +1495,18 @@ void jaiCachePathFor(const char *sourcePath, char *out, size_t outSize) {
     jaiPathJoin(out, outSize, cacheDir, file);
 }
 
+void jaiWarmPathFor(const char *sourcePath, char *out, size_t outSize) {
+    if (out == NULL || outSize == 0) return;
+    jaiCachePathFor(sourcePath, out, outSize);
+    size_t len = strlen(out);
+    size_t extLen = strlen(JAIC_SUFFIX);
+    if (len <= extLen || memcmp(out + len - extLen, JAIC_SUFFIX, extLen) != 0) {
+        out[0] = '\0';
+        return;
+    }
+    memcpy(out + len - extLen, JAIJ_SUFFIX, extLen);
+}
+
 /* "…/util.jaic" -> "…/util.jaid". False when it does not fit. */
 static bool sidecarPathFor(const char *cachePath, char *out, size_t outSize) {
     size_t len = strlen(cachePath);
@@ -1631,7 +1678,9 @@ static void clearCacheDir(const char *dir) {
     for (struct dirent *e = readdir(d); e != NULL; e = readdir(d)) {
         if (strcmp(e->d_name, ".") == 0 || strcmp(e->d_name, "..") == 0) continue;
         if (!hasSuffix(e->d_name, JAIC_SUFFIX) &&
-            strstr(e->d_name, JAIC_SUFFIX ".tmp") == NULL) {
+            strstr(e->d_name, JAIC_SUFFIX ".tmp") == NULL &&
+            !hasSuffix(e->d_name, JAIJ_SUFFIX) &&
+            strstr(e->d_name, JAIJ_SUFFIX ".tmp") == NULL) {
             continue;
         }
 
@@ -14,11 +14,17 @@
  * 11: top-level `fn` declarations are hoisted ahead of top-level statements.
  * 12: the line table is LTV1 (delta+LEB128) instead of 12-byte records.
  * 13: string constants are K_STRREF indices into one module string table.
- * 14: function flags are u16 (FN_TRACE and future high bits). */
-#define JAIC_VERSION     14
+ * 14: function flags are u16 (FN_TRACE and future high bits).
+ * 15: exception-table rows carry the stack depth their handler resumes at. */
+#define JAIC_VERSION     15
 
 #define JAIC_VERSION_FNFLAGS16 14
 
+/* First container version whose exception-table rows carry a depth. Below it
+ * every row was emitted at depth 0 -- a `try` anywhere deeper pushed a dynamic
+ * handler instead -- so 0 is what the reader supplies. */
+#define JAIC_VERSION_EXCDEPTH 15
+
 /* Oldest container the reader accepts.
  *
  * LOWER THIS BEFORE BUMPING JAIC_VERSION, not after. A strict reader refuses
@@ -88,6 +94,8 @@ ObjFunction *jaiDeserializeModule(const uint8_t *data, size_t size,
 
 /* Cache file management. */
 void  jaiCachePathFor(const char *sourcePath, char *out, size_t outSize);
+/* The same, for the compiled tier's .jaij; empty when there is no cache path. */
+void  jaiWarmPathFor(const char *sourcePath, char *out, size_t outSize);
 bool  jaiCacheStore(const char *sourcePath, ObjModule *module,
                     ObjFunction *body, uint64_t sourceHash, uint32_t flags);
 /* The whole cached image for `sourcePath`, or NULL. The caller owns the buffer
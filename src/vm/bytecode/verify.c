@@ -14,7 +14,7 @@
 
 /* Keep in sync with chunk.h. */
 int jaiOpBranchOperandAt(uint8_t op) {
-    switch (op) {
+    switch (jaiOpGeneric(op)) {
     case OP_JUMP:
     case OP_JUMP_IF_FALSE:
     case OP_JUMP_IF_TRUE:
@@ -45,6 +45,10 @@ int jaiOpBranchOperandAt(uint8_t op) {
     case OP_MATCH_TYPE:
     case OP_MATCH_TYPE_POP:
     case OP_MATCH_FIELDS:
+    /* Only the default. The arms' targets live in the table constant, so a
+     * reader of this function sees an edge to J and must ask jaiSwitchCaseAt
+     * for the rest. */
+    case OP_SWITCH:
         return 3;
     case OP_MATCH_RANGE:
     case OP_MATCH_RANGE_POP:
@@ -73,6 +77,7 @@ bool jaiOpFallsThrough(uint8_t op) {
     case OP_THROW:
     case OP_RERAISE:
     case OP_HALT:
+    case OP_SWITCH:
         return false;
     default:
         /* OP_TAIL_CALL normally ends the frame, but the emitter is free to
@@ -82,8 +87,8 @@ bool jaiOpFallsThrough(uint8_t op) {
 }
 
 /* Byte offsets of the u16 local-slot operands of `op`, if any. */
-static int slotOperands(uint8_t op, int *out) {
-    switch (op) {
+int jaiOpSlotOperands(uint8_t op, int *out) {
+    switch (jaiOpGeneric(op)) {
     case OP_GET_LOCAL:
     case OP_SET_LOCAL:
     case OP_BIND:
@@ -118,6 +123,12 @@ static int slotOperands(uint8_t op, int *out) {
     case OP_JUMP_IF_CMP_LOCAL_K:
         out[0] = 1;   /* the slot follows the u8 comparison */
         return 1;
+    case OP_REST_GET:
+        out[0] = 0;
+        return 1;
+    case OP_CALL_REST:
+        out[0] = 1;   /* the slot follows the u8 count */
+        return 1;
     case OP_GET_LOCAL2:
     case OP_ADD_LOCALS:
         out[0] = 0;
@@ -171,6 +182,7 @@ static int constOperands(uint8_t op, int *out) {
     case OP_EXPORT:
     case OP_ASSERT_FAIL:
     case OP_TYPE_GUARD:
+    case OP_SWITCH:
     case OP_INVOKE:
     case OP_SUPER_INVOKE:
     case OP_CLOSURE:
@@ -182,6 +194,7 @@ static int constOperands(uint8_t op, int *out) {
         out[1] = 3;
         return 2;
     case OP_CALL_KW:
+    case OP_CALL_KW_IC:
         out[0] = 1;
         return 1;
     case OP_JUMP_IF_CMP_LOCAL_K:   /* K follows the u8 comparison and u16 slot */
@@ -244,7 +257,7 @@ static Effect fallEffect(const Chunk *chunk, int offset, uint8_t op,
      * enum stays underneath and the table's +1 is the truth. */
     case OP_NEG: case OP_POS: case OP_BNOT: case OP_NOT:
     case OP_GET_ITER: case OP_TYPE_GUARD: case OP_IS_INSTANCE:
-    case OP_TO_FLOAT:
+    case OP_TO_FLOAT: case OP_REST_GET:
         e.pops = 1;
         e.pushes = 1;
         return e;
@@ -256,11 +269,13 @@ static Effect fallEffect(const Chunk *chunk, int offset, uint8_t op,
         return e;
     case OP_CALL:
     case OP_CALL_SPREAD:
+    case OP_CALL_REST:
     case OP_TAIL_CALL:
         e.pops = (int)a[0] + 1;
         e.pushes = 1;
         return e;
-    case OP_CALL_KW: {
+    case OP_CALL_KW:
+    case OP_CALL_KW_IC: {
         int kw = tupleArity(chunk, jaiReadU24(a + 1));
         if (kw < 0) { e.known = false; return e; }
         e.pops = (int)a[0] + kw + 1;
@@ -367,7 +382,7 @@ static bool verifyChunk(const ObjFunction *fn, char *errBuf, size_t errBufSize,
     /* Pass 1: decode linearly, checking operand widths and operand ranges. */
     for (int offset = 0; offset < n;) {
         boundary[offset] = true;
-        uint8_t op = chunk->code[offset];
+        uint8_t op = jaiOpGeneric(chunk->code[offset]);
         if (op >= OP_COUNT) {
             VFAIL("offset %d: opcode 0x%02x is not a valid opcode (OP_COUNT = %d)",
                   offset, (unsigned)op, (int)OP_COUNT);
@@ -426,7 +441,7 @@ static bool verifyChunk(const ObjFunction *fn, char *errBuf, size_t errBufSize,
         }
 
         int slotAt[3];
-        int slotCount = slotOperands(op, slotAt);
+        int slotCount = jaiOpSlotOperands(op, slotAt);
         for (int k = 0; k < slotCount; k++) {
             uint16_t slot = jaiReadU16(a + slotAt[k]);
             if (slot >= fn->maxSlots) {
@@ -436,6 +451,23 @@ static bool verifyChunk(const ObjFunction *fn, char *errBuf, size_t errBufSize,
             }
         }
 
+        /* The count a view reads is the variadic slot's, and only a function
+         * whose caller left its arguments as a view has one there. */
+        if ((op == OP_REST_GET || op == OP_CALL_REST) &&
+            (!(fn->flags & FN_REST_VIEW) || !(fn->flags & FN_VARIADIC) ||
+             jaiReadU16(a + slotAt[0]) != 1 + (unsigned)fn->arity)) {
+            VFAIL("offset %d: %s reads slot %u, which is not this function's "
+                  "viewed variadic parameter", offset, jaiOpName((OpCode)op),
+                  (unsigned)jaiReadU16(a + slotAt[0]));
+        }
+
+        if (op == OP_SWITCH &&
+            !jaiSwitchCheck(chunk->constants.data[jaiReadU24(a)],
+                            offset + 1 + operands, n)) {
+            VFAIL("offset %d: OP_SWITCH table %u is malformed", offset,
+                  (unsigned)jaiReadU24(a));
+        }
+
         if (op == OP_GET_UPVALUE || op == OP_SET_UPVALUE) {
             if (a[0] >= fn->upvalueCount) {
                 VFAIL("offset %d: %s uses upvalue %u but the closure has %u",
@@ -467,7 +499,7 @@ static bool verifyChunk(const ObjFunction *fn, char *errBuf, size_t errBufSize,
 
     /* Pass 2: every code address lands on an instruction boundary. */
     for (int offset = 0; offset < n;) {
-        uint8_t op = chunk->code[offset];
+        uint8_t op = jaiOpGeneric(chunk->code[offset]);
         int operands = jaiOpOperandSize((OpCode)op);
         if (op == OP_CLOSURE) {
             uint32_t k = jaiReadU24(chunk->code + offset + 1);
@@ -486,6 +518,18 @@ static bool verifyChunk(const ObjFunction *fn, char *errBuf, size_t errBufSize,
                       "boundary", offset, jaiOpName((OpCode)op), target);
             }
         }
+        if (op == OP_SWITCH) {
+            Value table = chunk->constants.data[jaiReadU24(chunk->code + offset + 1)];
+            JaiSwitchCase c;
+            for (int i = 0; i < jaiSwitchSize(table); i++) {
+                if (!jaiSwitchCaseAt(table, i, &c)) continue;
+                int target = offset + 1 + operands + c.rel;
+                if (!boundary[target]) {
+                    VFAIL("offset %d: OP_SWITCH arm targets %d, which is not "
+                          "an instruction boundary", offset, target);
+                }
+            }
+        }
         offset += 1 + operands;
     }
 
@@ -513,12 +557,17 @@ static bool verifyChunk(const ObjFunction *fn, char *errBuf, size_t errBufSize,
             VFAIL("exception entry %d: handler %u is not an instruction "
                   "boundary", e, (unsigned)entry->handler);
         }
-        if (entry->typeConst != UINT32_MAX &&
+        if (entry->typeConst != JAI_HANDLER_CATCH_ALL &&
+            entry->typeConst != JAI_HANDLER_FINALLY &&
             entry->typeConst >= (uint32_t)chunk->constants.count) {
             VFAIL("exception entry %d: type constant %u is out of range "
                   "(%d constants)", e, (unsigned)entry->typeConst,
                   chunk->constants.count);
         }
+        if (entry->depth > fn->maxSlots) {
+            VFAIL("exception entry %d: depth %u is past the frame's %u slots",
+                  e, (unsigned)entry->depth, (unsigned)fn->maxSlots);
+        }
     }
     for (int d = 0; d < (int)fn->defaultCount && fn->defaultOffsets != NULL; d++) {
         uint32_t at = fn->defaultOffsets[d];
@@ -533,15 +582,31 @@ static bool verifyChunk(const ObjFunction *fn, char *errBuf, size_t errBufSize,
     depth[0] = 0;
     work[workCount++] = 0;
 
+    /* An exception-table handler resumes at the depth its entry records -- the
+     * unwinder restores exactly that -- so it is as precise a seed as offset
+     * 0, and a path that reaches it another way must agree. */
+    for (int e = 0; e < (int)fn->exceptionCount; e++) {
+        const ExceptionEntry *entry = &fn->exceptions[e];
+        int at = (int)entry->handler;
+        if (depth[at] < 0) {
+            depth[at] = (int)entry->depth;
+            work[workCount++] = at;
+        } else if (depth[at] != (int)entry->depth) {
+            VFAIL("exception entry %d: handler %d resumes at depth %u but "
+                  "another entry resumes it at depth %d", e, at,
+                  (unsigned)entry->depth, depth[at]);
+        }
+    }
+
     /* Repeats until a round adds nothing, since a seeded block can contain
-     * further entry points. Precise seeds (dynamic handlers) go first, so an
-     * exception-table handler/default thunk (both imprecise, depth 0) only
-     * seed once nothing precise is left. */
+     * further entry points. Precise seeds (dynamic handlers) go first, so a
+     * default thunk (imprecise, depth 0) only seeds once nothing precise is
+     * left. */
     for (;;) {
         while (workCount > 0) {
             int offset = work[--workCount];
             int here = depth[offset];
-            uint8_t op = chunk->code[offset];
+            uint8_t op = jaiOpGeneric(chunk->code[offset]);
             const uint8_t *a = chunk->code + offset + 1;
 
             int operands = jaiOpOperandSize((OpCode)op);
@@ -608,6 +673,9 @@ static bool verifyChunk(const ObjFunction *fn, char *errBuf, size_t errBufSize,
                 case OP_MATCH_FIELDS:
                     jumpDepth = here;   /* nothing destructured on no-match */
                     break;
+                case OP_SWITCH:
+                    jumpDepth = here - 1;   /* the subject goes on every edge */
+                    break;
                 default:
                     jumpDepth = here;   /* the *_KEEP forms and MATCH_* peek */
                     break;
@@ -636,13 +704,33 @@ static bool verifyChunk(const ObjFunction *fn, char *errBuf, size_t errBufSize,
                           depth[to], offset, jaiOpName((OpCode)op));
                 }
             }
+
+            /* OP_SWITCH's arms: one more edge per table entry, all at the
+             * depth of its default. */
+            if (op == OP_SWITCH) {
+                Value table = chunk->constants.data[jaiReadU24(a)];
+                JaiSwitchCase c;
+                for (int i = 0; i < jaiSwitchSize(table); i++) {
+                    if (!jaiSwitchCaseAt(table, i, &c)) continue;
+                    int to = next + c.rel;
+                    if (depth[to] < 0) {
+                        depth[to] = after;
+                        if (approx != NULL) approx[to] = approx[offset];
+                        work[workCount++] = to;
+                    } else if (depth[to] != after) {
+                        VFAIL("offset %d: stack depth %d here disagrees with "
+                              "depth %d reached by another path (from %d, "
+                              "OP_SWITCH)", to, after, depth[to], offset);
+                    }
+                }
+            }
         }
 
         /* A dynamic handler's target runs at the depth of its own PUSH (the
-         * unwinder restores that), not at 0 like an exception-table handler. */
+         * unwinder restores that). */
         int added = 0;
         for (int offset = 0; offset < n;) {
-            uint8_t op = chunk->code[offset];
+            uint8_t op = jaiOpGeneric(chunk->code[offset]);
             int operands = jaiOpOperandSize((OpCode)op);
             if (op == OP_CLOSURE) {
                 uint32_t k = jaiReadU24(chunk->code + offset + 1);
@@ -666,18 +754,7 @@ static bool verifyChunk(const ObjFunction *fn, char *errBuf, size_t errBufSize,
         if (added > 0) continue;
 
         /* Exactly one imprecise seed per round: seeding them all at once can
-         * pin a nested region's handler at depth 0 before the precise pass
-         * reaches it -- e.g. a `finally` inside a loop, whose handler is
-         * really at depth 1 (under the iterator). */
-        for (int e = 0; e < (int)fn->exceptionCount && added == 0; e++) {
-            uint32_t handler = fn->exceptions[e].handler;
-            if (depth[handler] < 0) {
-                depth[handler] = 0;
-                if (approx != NULL) approx[handler] = true;
-                work[workCount++] = (int)handler;
-                added++;
-            }
-        }
+         * pin an entry point at depth 0 before a precise path reaches it. */
         for (int d = 0; d < (int)fn->defaultCount && added == 0 &&
                         fn->defaultOffsets != NULL; d++) {
             uint32_t at = fn->defaultOffsets[d];
@@ -30,4 +30,10 @@ int jaiOpBranchOperandAt(uint8_t op);
  * its fall-through edge ends, and a second copy of the list would drift. */
 bool jaiOpFallsThrough(uint8_t op);
 
+/* Byte indexes of `op`'s u16 local-slot operands, written into `out` (room for
+ * three), and how many there are. OP_CLOSURE's captures are not among them:
+ * their count depends on the function it names. Exported for the JIT's live
+ * ranges, which are only as sound as this list is complete. */
+int jaiOpSlotOperands(uint8_t op, int *out);
+
 #endif /* JAI_VM_VERIFY_H */
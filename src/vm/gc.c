@@ -11,17 +11,32 @@
 
 #define JAI_GC_DEFAULT_GROW_FACTOR 2.0
 #define JAI_GC_DEFAULT_MIN_HEAP    ((size_t)1 << 20)
+/* Allocation between minor collections. Small enough that a nursery's worth
+ * of survivors is a short trace, large enough that most of what a loop
+ * allocates is already dead by the time it is looked at. */
+#define JAI_GC_DEFAULT_NURSERY     ((size_t)2 << 20)
+#define JAI_GC_DEFAULT_PROMOTE_AGE 2u
+/* What compiled code can push before the next collection grows the array. */
+#define JAI_GC_REMEMBERED_MIN      1024u
 
 GCState *jaiGCActive;
 bool jaiGCInCollect;
 static GCState *activeGC(void) { return jaiGCActive != NULL ? jaiGCActive : vm.gc; }
 size_t jaiGCLimit;
+JaiGCRememberedSet jaiGCRemembered;
+
+/* Sticky marks: whether survivors of a full collection keep their mark, i.e.
+ * whether there is an old generation at all. */
+static bool gcSticky(const GCState *g) { return g->nurseryBytes != 0; }
 
 void jaiGCSyncLimit(void) {
     const GCState *g = jaiGCActive;
-    jaiGCLimit = (g != NULL && g->enabled && !jaiGCInCollect && !g->stress)
-                     ? g->nextGC
-                     : 0;
+    if (g == NULL || !g->enabled || jaiGCInCollect || g->stress) {
+        jaiGCLimit = 0;
+        return;
+    }
+    jaiGCLimit = gcSticky(g) && g->nextMinor < g->nextGC ? g->nextMinor
+                                                         : g->nextGC;
 }
 
 /* Non-const: it advances the cadence counter. Called once per allocation on
@@ -46,10 +61,19 @@ static size_t gcNextThreshold(const GCState *g, size_t live) {
     return next > floorBytes ? next : floorBytes;
 }
 
+static size_t envSize(const char *name, size_t fallback) {
+    const char *v = getenv(name);
+    if (v == NULL || v[0] == '\0') return fallback;
+    char *end = NULL;
+    unsigned long long n = strtoull(v, &end, 10);
+    return end != v && *end == '\0' ? (size_t)n : fallback;
+}
+
 void jaiGCInit(GCState *gc) {
     if (gc == NULL) JAI_PANIC("jaiGCInit: NULL collector state");
 
     gc->objects = NULL;
+    gc->young = NULL;
     gc->grayStack = NULL;
     gc->grayCount = 0;
     gc->grayCapacity = 0;
@@ -73,9 +97,23 @@ void jaiGCInit(GCState *gc) {
     gc->stress = false;
     gc->verbose = false;
 
+    gc->nurseryBytes = envSize("JAITHON_GC_NURSERY", JAI_GC_DEFAULT_NURSERY);
+    gc->nextMinor = jaiHeapBytes + gc->nurseryBytes;
+    gc->promoteAge = JAI_GC_DEFAULT_PROMOTE_AGE;
+    {
+        const char *v = getenv("JAITHON_GC_VERIFY");
+        gc->verify = v != NULL && v[0] != '\0';
+    }
+
     gc->collections = 0;
     gc->totalFreed = 0;
     gc->totalPauseSeconds = 0.0;
+    gc->minorCollections = 0;
+    gc->promoted = 0;
+    gc->minorPauseSeconds = 0.0;
+
+    jaiGCRemembered.count = 0;
+    jaiGCRemembered.overflow = 0;
 
     jaiGCActive = gc;
     vm.gc = gc;
@@ -86,13 +124,22 @@ void jaiGCInit(GCState *gc) {
 void jaiGCFree(GCState *gc) {
     if (gc == NULL) return;
 
-    Obj *object = gc->objects;
-    while (object != NULL) {
-        Obj *next = object->next;
-        jaiFreeObject(object);
-        object = next;
+    Obj *const lists[] = {gc->young, gc->objects};
+    for (size_t i = 0; i < sizeof lists / sizeof lists[0]; i++) {
+        Obj *object = lists[i];
+        while (object != NULL) {
+            Obj *next = object->next;
+            jaiFreeObject(object);
+            object = next;
+        }
     }
     gc->objects = NULL;
+    gc->young = NULL;
+    free(jaiGCRemembered.items);
+    jaiGCRemembered.items = NULL;
+    jaiGCRemembered.count = 0;
+    jaiGCRemembered.capacity = 0;
+    jaiGCRemembered.overflow = 0;
 
     JAI_FREE_ARRAY(Value, gc->tempRoots, gc->tempRootCapacity);
     gc->tempRoots = NULL;
@@ -139,8 +186,19 @@ uint64_t jaiGCMarked, jaiGCSwept, jaiGCSweptDead;
 double   jaiGCMarkSec, jaiGCInternSec, jaiGCSweepSec;
 #endif
 
+/* Probing: blackenObject run over one object to ask whether it holds a young
+ * one, without marking anything. Every edge blackenObject follows reaches
+ * jaiGCMarkObject only for an unmarked -- outside a collection's mark phase,
+ * a young -- object, so the first one to get here is the answer. */
+static bool gcProbing;
+static Obj *gcProbeHit;
+
 void jaiGCMarkObject(Obj *obj) {
     if (obj == NULL || obj->isMarked) return;
+    if (JAI_UNLIKELY(gcProbing)) {
+        if (gcProbeHit == NULL) gcProbeHit = obj;
+        return;
+    }
     obj->isMarked = true;
 #ifdef JAI_ALLOC_CENSUS
     jaiGCMarked++;
@@ -207,6 +265,7 @@ static void blackenFunction(ObjFunction *fn) {
     jaiGCMark((Obj *)fn->qualifiedName);
     jaiGCMark((Obj *)fn->module);
     jaiGCMark((Obj *)fn->owner);
+    jaiGCMark((Obj *)fn->siteClosure);
     markStrings(fn->paramNames, (int)fn->paramCount);
     markChunk(&fn->chunk);
 }
@@ -223,6 +282,10 @@ static void blackenClass(ObjClass *c) {
     jaiTableMark(&c->restricted);
 
     for (int i = 0; i < (int)c->traitCount; i++) jaiGCMark((Obj *)c->traits[i]);
+    for (int i = 0; i < (int)c->vtableCount; i++) {
+        jaiGCMark((Obj *)c->vtables[i].trait);
+        markValues(c->vtables[i].methods, (int)c->vtables[i].count);
+    }
     for (int i = 0; i < (int)c->fieldCount; i++) jaiGCMark((Obj *)c->fields[i].name);
 
     jaiGCMarkVal(c->initializer);
@@ -319,6 +382,7 @@ static void blackenObject(Obj *obj) {
         jaiTableMark(&trait->defaults);
         for (int i = 0; i < (int)trait->superCount; i++)
             jaiGCMark((Obj *)trait->supers[i]);
+        markStrings(trait->methodNames, (int)trait->methodCount);
         break;
     }
     case OBJ_INSTANCE: {
@@ -408,6 +472,7 @@ static void markRoots(GCState *g) {
 
     jaiMarkAsciiChars();
     jaiJitMarkFrames();
+    jaiJitMarkQueue();
 
     markValues(vm.defers.data, vm.defers.count);
     markStrings(vm.modulePath.data, vm.modulePath.count);
@@ -416,6 +481,7 @@ static void markRoots(GCState *g) {
     jaiGCMark((Obj *)vm.mainModule);
     jaiGCMark((Obj *)vm.builtins);
     jaiGCMarkVal(vm.pendingException);
+    jaiVMMarkTraceback();
 
     markInternedNames();
     markWellKnownClasses();
@@ -425,15 +491,170 @@ static void markRoots(GCState *g) {
         markValues(g->rootRanges[i].values, g->rootRanges[i].count);
     }
     markValues(g->permanentRoots, g->permanentRootCount);
+#if defined(JAI_NANBOX)
+    jaiIntBoxScanStack();
+#endif
 }
 
 static void traceReferences(GCState *g) {
     while (g->grayCount > 0) blackenObject(g->grayStack[--g->grayCount]);
 }
 
+//remembered set
+
+static void rememberedReserve(uint32_t capacity) {
+    JaiGCRememberedSet *r = &jaiGCRemembered;
+    if (capacity <= r->capacity) return;
+    //the raw system allocator, like the gray stack: a barrier never collects
+    Obj **grown = realloc(r->items, sizeof(Obj *) * (size_t)capacity);
+    if (grown == NULL) JAI_PANIC("out of memory growing the GC remembered set");
+    r->items = grown;
+    r->capacity = capacity;
+}
+
+void jaiGCRemember(Obj *owner) {
+    if (owner->gcBits & JAI_GC_REMEMBERED) return;
+    JaiGCRememberedSet *r = &jaiGCRemembered;
+    if (JAI_UNLIKELY(r->count >= r->capacity)) {
+        rememberedReserve(r->capacity != 0 ? r->capacity * 2u
+                                           : JAI_GC_REMEMBERED_MIN);
+    }
+    owner->gcBits |= JAI_GC_REMEMBERED;
+    r->items[r->count++] = owner;
+}
+
+/* After a full collection nothing is young, so nothing needs remembering. */
+static void forgetRemembered(void) {
+    JaiGCRememberedSet *r = &jaiGCRemembered;
+    for (uint32_t i = 0; i < r->count; i++)
+        r->items[i]->gcBits &= (uint8_t)~JAI_GC_REMEMBERED;
+    r->count = 0;
+    r->overflow = 0;
+}
+
+/* Compiled code pushes without growing (see JaiGCRememberedSet), so it is
+ * left room between collections rather than asked to find some. */
+static void rememberedHeadroom(void) {
+    JaiGCRememberedSet *r = &jaiGCRemembered;
+    if (r->capacity - r->count < JAI_GC_REMEMBERED_MIN / 2u) {
+        uint32_t want = r->capacity * 2u;
+        rememberedReserve(want > JAI_GC_REMEMBERED_MIN ? want
+                                                       : JAI_GC_REMEMBERED_MIN);
+    }
+}
+
+/* A young object `obj` refers to, or NULL. Only meaningful outside a mark
+ * phase, where unmarked is young. A string's one reference is its owner, and
+ * blackenObject has nothing to say about it. */
+static Obj *youngChild(Obj *obj) {
+    if (obj->type == OBJ_STRING) {
+        Obj *owner = (Obj *)((ObjString *)obj)->owner;
+        return owner != NULL && !owner->isMarked ? owner : NULL;
+    }
+    gcProbing = true;
+    gcProbeHit = NULL;
+    blackenObject(obj);
+    gcProbing = false;
+    return gcProbeHit;
+}
+
+static void traceRemembered(void) {
+    JaiGCRememberedSet *r = &jaiGCRemembered;
+    for (uint32_t i = 0; i < r->count; i++) {
+        Obj *obj = r->items[i];
+        if (obj->type == OBJ_STRING) {
+            jaiGCMark((Obj *)((ObjString *)obj)->owner);
+        } else {
+            blackenObject(obj);
+        }
+    }
+}
+
+/* Once a minor collection has promoted what it will, an old object stays in
+ * the set only while it still holds something young -- or while a temp root
+ * pins it, see pinTempRoots. */
+static void keepRemembered(void) {
+    JaiGCRememberedSet *r = &jaiGCRemembered;
+    uint32_t kept = 0;
+    for (uint32_t i = 0; i < r->count; i++) {
+        Obj *obj = r->items[i];
+        bool pinned = (obj->gcBits & JAI_GC_PINNED) != 0;
+        obj->gcBits &= (uint8_t)~JAI_GC_PINNED;
+        if (pinned || youngChild(obj) != NULL) {
+            r->items[kept++] = obj;
+        } else {
+            obj->gcBits &= (uint8_t)~JAI_GC_REMEMBERED;
+        }
+    }
+    r->count = kept;
+}
+
+/* What a temp root or root range holds directly is an object C code is still
+ * building -- a function whose constants are being read in, a list being
+ * filled -- and that code stores into it with no barrier, because until now
+ * nothing it stored into could be old. So such an object is not aged while it
+ * is pinned, and one that is old already (promoted by a full collection, or
+ * before it was pinned) is traced as remembered for as long as it stays
+ * pinned. Only sticky collections pin: without an old generation no store can
+ * be missed. */
+static void pinValues(const Value *values, int count) {
+    if (values == NULL) return;
+    for (int i = 0; i < count; i++) {
+        if (!IS_OBJ(values[i])) continue;
+        Obj *obj = AS_OBJ(values[i]);
+        obj->gcBits |= JAI_GC_PINNED;
+        if (obj->isMarked) jaiGCRemember(obj);
+    }
+}
+
+static void pinTempRoots(GCState *g) {
+    pinValues(g->tempRoots, g->tempRootCount);
+    for (int i = 0; i < g->rootRangeCount; i++) {
+        pinValues(g->rootRanges[i].values, g->rootRanges[i].count);
+    }
+}
+
+/* JAITHON_GC_VERIFY. Costs a probe of the whole old generation per minor
+ * collection, which is the point: it is the one check that does not trust
+ * the barriers it is checking. */
+static void verifyBarriers(const GCState *g) {
+    for (Obj *obj = g->objects; obj != NULL; obj = obj->next) {
+        if (obj->gcBits & JAI_GC_REMEMBERED) continue;
+        Obj *child = youngChild(obj);
+        if (child != NULL) {
+            JAI_PANIC("gc verify: an old %s holds a young %s and is not "
+                      "remembered (a store without a write barrier)",
+                      jaiObjTypeName(obj->type), jaiObjTypeName(child->type));
+        }
+    }
+}
+
 //sweep
 
-static int sweep(GCState *g) {
+/* Frees an object nothing reached; the bytes it returns are the ones the
+ * caller still has to charge, once, after its loop.
+ *
+ * The overwhelming majority of what a sweep frees owns nothing but its own
+ * block -- 94-98% of the objects it visits are corpses on every benchmark that
+ * allocates, and they are instances, strings, tuples, iterators and ranges.
+ * Those go straight onto the bin here rather than through jaiFreeObject, which
+ * is 550 instructions and saves six register pairs on entry it does not need
+ * for any of them. jaiObjSoleBlock is the same size jaiFreeObject would have
+ * used. */
+static inline size_t freeUnreached(Obj *unreached) {
+    size_t sole = jaiObjSoleBlock(unreached);
+    if (JAI_LIKELY(sole != 0 && jaiSmallServes(sole))) {
+        jaiSmallDeleteUnaccounted(unreached, sole);
+        return sole;
+    }
+    jaiFreeObject(unreached);
+    return 0;
+}
+
+/* The old generation, at a full collection. Survivors keep their mark when
+ * marks are sticky; one a temp root pinned goes back into the remembered set,
+ * which the collection has just emptied. */
+static int sweep(GCState *g, bool sticky) {
     int freedObjects = 0;
     size_t freedBytes = 0;
     Obj *previous = NULL;
@@ -445,7 +666,12 @@ static int sweep(GCState *g) {
         if (!object->isMarked) jaiGCSweptDead++;
 #endif
         if (object->isMarked) {
-            object->isMarked = false; //white again for the next cycle
+            if (!sticky) {
+                object->isMarked = false; //white again for the next cycle
+            } else if (object->gcBits & JAI_GC_PINNED) {
+                object->gcBits &= (uint8_t)~JAI_GC_PINNED;
+                jaiGCRemember(object);
+            }
             previous = object;
             object = object->next;
             continue;
@@ -458,21 +684,67 @@ static int sweep(GCState *g) {
         } else {
             g->objects = object;
         }
-        /* The overwhelming majority of what a sweep frees owns nothing but its
-         * own block -- 94-98% of the objects it visits are corpses on every
-         * benchmark that allocates, and they are instances, strings, tuples,
-         * iterators and ranges. Those go straight onto the bin here rather
-         * than through jaiFreeObject, which is 550 instructions and saves six
-         * register pairs on entry it does not need for any of them.
-         * jaiObjSoleBlock is the same size jaiFreeObject would have used. */
-        size_t sole = jaiObjSoleBlock(unreached);
-        if (JAI_LIKELY(sole != 0 && jaiSmallServes(sole))) {
-            jaiSmallDeleteUnaccounted(unreached, sole);
-            freedBytes += sole;   /* charged once, after the loop */
+        freedBytes += freeUnreached(unreached);
+        freedObjects++;
+    }
+
+    jaiHeapAccountFreed(freedBytes);
+    return freedObjects;
+}
+
+/* The young generation. A survivor ages by one unless pinned, and at
+ * promoteAge -- or at any age, in a full collection -- moves to the old list
+ * still marked, which is what makes it old. */
+static int sweepYoung(GCState *g, bool full) {
+    const bool sticky = gcSticky(g);
+    int freedObjects = 0;
+    size_t freedBytes = 0;
+    Obj *previous = NULL;
+    Obj *object = g->young;
+
+    while (object != NULL) {
+#ifdef JAI_ALLOC_CENSUS
+        jaiGCSwept++;
+        if (!object->isMarked) jaiGCSweptDead++;
+#endif
+        Obj *next = object->next;
+        if (object->isMarked) {
+            uint8_t bits = object->gcBits;
+            unsigned age = (bits & JAI_GC_AGE_MASK) +
+                           ((bits & JAI_GC_PINNED) ? 0u : 1u);
+            if (!full && age < g->promoteAge) {
+                object->gcBits = (uint8_t)age;
+                object->isMarked = false;
+                previous = object;
+                object = next;
+                continue;
+            }
+            if (previous != NULL) {
+                previous->next = next;
+            } else {
+                g->young = next;
+            }
+            object->gcBits = 0;
+            object->next = g->objects;
+            g->objects = object;
+            if (!sticky) {
+                object->isMarked = false;
+            } else if (bits & JAI_GC_PINNED) {
+                jaiGCRemember(object);   /* only a full collection gets here */
+            }
+            g->promoted++;
+            object = next;
+            continue;
+        }
+
+        if (previous != NULL) {
+            previous->next = next;
         } else {
-            jaiFreeObject(unreached);
+            g->young = next;
         }
+        freedBytes += freeUnreached(object);
         freedObjects++;
+        object = next;
     }
 
     jaiHeapAccountFreed(freedBytes);
@@ -481,21 +753,32 @@ static int sweep(GCState *g) {
 
 //collection stuff
 
-void jaiGCCollect(void) {
-    GCState *g = activeGC();
-    if (g == NULL || !g->enabled || jaiGCInCollect) return;
-
-    jaiGCInCollect = true;
-    jaiGCSyncLimit();
-    double started = jaiClockMonotonic();
-    bool verbose = gcVerboseOn(g);
-    size_t before = gcLiveBytes(g);
-    if (verbose) fprintf(stderr, "-- gc begin\n");
+/* The phases both kinds of collection share. A minor one differs in three
+ * places: its roots include the remembered set, the marker stops at old
+ * objects because they are already marked, and only the young list is swept.
+ * A full one first unmarks the old generation so that it is traced like
+ * everything else -- which is all "as before" needs. */
+static int collectPhases(GCState *g, bool full) {
+    const bool sticky = gcSticky(g);
+    if (full) {
+        forgetRemembered();
+        if (sticky) {
+            for (Obj *obj = g->objects; obj != NULL; obj = obj->next)
+                obj->isMarked = false;
+        }
+#if defined(JAI_NANBOX)
+        /* Minor collections mark cells and never sweep them. */
+        jaiIntBoxUnmark();
+#endif
+    }
+    if (sticky) pinTempRoots(g);
+    if (!full && g->verify) verifyBarriers(g);
 
 #ifdef JAI_ALLOC_CENSUS
     double t0 = jaiClockMonotonic();
 #endif
     markRoots(g);
+    if (!full) traceRemembered();
     traceReferences(g);
 #ifdef JAI_ALLOC_CENSUS
     double t1 = jaiClockMonotonic();
@@ -508,38 +791,117 @@ void jaiGCCollect(void) {
     double t2 = jaiClockMonotonic();
 #endif
 
-    int freedObjects = sweep(g);
+    Obj *oldHead = g->objects;
+    int freedObjects = full ? sweep(g, sticky) : 0;
+    freedObjects += sweepYoung(g, full);
+    if (!full) {
+        keepRemembered();
+        /* Promoted ahead of oldHead: each one that still refers to a young
+         * survivor is now an old object holding a young one. */
+        for (Obj *obj = g->objects; obj != oldHead; obj = obj->next) {
+            if (!(obj->gcBits & JAI_GC_REMEMBERED) && youngChild(obj) != NULL)
+                jaiGCRemember(obj);
+        }
+    }
+#if defined(JAI_NANBOX)
+    if (full) jaiIntBoxSweep();
+#endif
 #ifdef JAI_ALLOC_CENSUS
     double t3 = jaiClockMonotonic();
     jaiGCMarkSec += t1 - t0;
     jaiGCInternSec += t2 - t1;
     jaiGCSweepSec += t3 - t2;
 #endif
+    return freedObjects;
+}
+
+static void collect(bool full) {
+    GCState *g = activeGC();
+    if (g == NULL || !g->enabled || jaiGCInCollect) return;
+    /* Compiled code that found the set full could not record its store, so
+     * only a full trace is sure to see what it stored. */
+    if (!gcSticky(g) || jaiGCRemembered.overflow) full = true;
+
+    jaiGCInCollect = true;
+    jaiGCSyncLimit();
+    double started = jaiClockMonotonic();
+    /* A background compile reads the heap; nothing it can reach is freed
+     * under it. The wait counts as pause, because it is one. */
+    jaiJitHold();
+    bool verbose = gcVerboseOn(g);
+    size_t before = gcLiveBytes(g);
+    uint64_t promotedBefore = g->promoted;
+    if (verbose) fprintf(stderr, full ? "-- gc begin\n" : "-- gc minor begin\n");
+
+    int freedObjects = collectPhases(g, full);
+    /* The sweep retired the code of every function it freed; what is not
+     * running any more goes back to the code heap. */
+    size_t freedCode = jaiJitReclaim();
+    rememberedHeadroom();
 
     size_t after = gcLiveBytes(g);
     size_t freedBytes = before > after ? before - after : 0;
 
-    g->nextGC = gcNextThreshold(g, after);
+    /* With generations the heap between two full collections also holds a
+     * nursery that minor collections keep emptying, so the full threshold is
+     * the old generation's budget with the nursery on top: otherwise a small
+     * heap reaches it before it ever fills the nursery, and every collection
+     * is a full one. */
+    if (full) {
+        g->nextGC = gcNextThreshold(g, after);
+        if (gcSticky(g)) g->nextGC += g->nurseryBytes;
+    }
+    g->nextMinor = after + g->nurseryBytes;
     jaiGCSyncLimit();
-    g->collections++;
+    double pause = jaiClockMonotonic() - started;
+    if (full) {
+        g->collections++;
+    } else {
+        g->minorCollections++;
+        g->minorPauseSeconds += pause;
+    }
     g->totalFreed += freedBytes;
-    g->totalPauseSeconds += jaiClockMonotonic() - started;
+    g->totalPauseSeconds += pause;
 
     if (verbose) {
         fprintf(stderr, "-- gc sweep: freed %zu bytes in %d objects\n",
                 freedBytes, freedObjects);
+        if (g->promoted != promotedBefore) {
+            fprintf(stderr, "-- gc promoted %llu objects, %u remembered\n",
+                    (unsigned long long)(g->promoted - promotedBefore),
+                    jaiGCRemembered.count);
+        }
+        if (freedCode > 0) {
+            fprintf(stderr, "-- gc jit: reclaimed %zu bytes of code\n", freedCode);
+        }
         fprintf(stderr, "-- gc end: %zu -> %zu bytes (next at %zu)\n",
                 before, after, g->nextGC);
     }
 
+    jaiJitRelease();
     jaiGCInCollect = false;
     jaiGCSyncLimit();
 }
 
+void jaiGCCollect(void) { collect(true); }
+
+/* Trace from the roots and the remembered set, stopping at the old
+ * generation; free the young objects that were not reached. */
+void jaiGCCollectYoung(void) { collect(false); }
+
 void jaiGCMaybeCollect(void) {
     GCState *g = activeGC();
     if (g == NULL || !g->enabled || jaiGCInCollect) return;
-    if (gcStressDue(g) || gcLiveBytes(g) > g->nextGC) jaiGCCollect();
+    if (gcStressDue(g)) {
+        /* Mostly minor collections, which are what a missing barrier breaks,
+         * with a full one often enough that promotion is stressed too. */
+        uint64_t n = g->collections + g->minorCollections;
+        collect(!gcSticky(g) || n % 4u == 3u);
+    } else if (gcLiveBytes(g) > g->nextGC) {
+        collect(true);
+    } else if (gcSticky(g) && gcLiveBytes(g) > g->nextMinor) {
+        collect(false);
+    }
 }
 
 static void jaiGCGrowRoots(void);
@@ -547,9 +909,20 @@ static void jaiGCGrowRoots(void);
 void jaiGCTrackObject(Obj *obj) {
     GCState *g = jaiGCActive;
     if (JAI_UNLIKELY(g == NULL)) JAI_PANIC("jaiGCTrackObject before jaiGCInit");
-    obj->isMarked = jaiGCInCollect;
-    obj->next = g->objects;
-    g->objects = obj;
+    obj->gcBits = 0;
+    if (JAI_UNLIKELY(jaiGCInCollect)) {
+        /* Made during a collection: it survives this one, and a young object
+         * marked after the young sweep would look old to the next. So it is
+         * old from the start, and remembered in case what it holds is not. */
+        obj->isMarked = true;
+        obj->next = g->objects;
+        g->objects = obj;
+        jaiGCRemember(obj);
+        return;
+    }
+    obj->isMarked = false;
+    obj->next = g->young;
+    g->young = obj;
 }
 
 void jaiGCPushRoot(Value v) {
@@ -625,10 +998,16 @@ void jaiGCPrintStats(FILE *out) {
     }
 
     double totalMs = g->totalPauseSeconds * 1000.0;
-    double averageMs = g->collections > 0 ? totalMs / (double)g->collections : 0.0;
+    uint64_t all = g->collections + g->minorCollections;
+    double averageMs = all > 0 ? totalMs / (double)all : 0.0;
 
     fprintf(out, "gc statistics:\n");
     fprintf(out, "  collections     : %llu\n", (unsigned long long)g->collections);
+    fprintf(out, "  minor           : %llu (%.3f ms)\n",
+            (unsigned long long)g->minorCollections,
+            g->minorPauseSeconds * 1000.0);
+    fprintf(out, "  promoted        : %llu\n", (unsigned long long)g->promoted);
+    fprintf(out, "  remembered      : %u\n", jaiGCRemembered.count);
     fprintf(out, "  live bytes      : %zu\n", gcLiveBytes(g));
     fprintf(out, "  next collection : %zu\n", g->nextGC);
     fprintf(out, "  total freed     : %llu bytes\n",
@@ -6,7 +6,10 @@
 typedef struct { const Value *values; int count; } JaiGCRootRange;
 
 typedef struct GCState {
-    Obj      *objects; //list of every live obj
+    Obj      *objects; //the old generation: everything that has been promoted
+    /* The young generation: every object allocated since it last survived
+     * enough minor collections to be promoted (see jaiGCCollectYoung). */
+    Obj      *young;
     Obj     **grayStack;
     int       grayCount;
     int       grayCapacity;
@@ -39,9 +42,25 @@ typedef struct GCState {
     unsigned  stressEvery;
     unsigned  stressTick;
 
+    /* Allocation between two minor collections, and the heap size at which
+     * the next one runs. 0 turns the young generation off: every collection
+     * is then a full one, which is what JAITHON_GC_NURSERY=0 asks for. */
+    size_t    nurseryBytes;
+    size_t    nextMinor;
+    /* How many minor collections an object survives before it is promoted. */
+    uint8_t   promoteAge;
+    /* JAITHON_GC_VERIFY: before each minor collection, check that no old
+     * object outside the remembered set holds a young one -- a missing write
+     * barrier, found at the collection after the store instead of as a
+     * use-after-free some time later. */
+    bool      verify;
+
     uint64_t  collections;
     uint64_t  totalFreed;
     double    totalPauseSeconds;
+    uint64_t  minorCollections;
+    uint64_t  promoted;
+    double    minorPauseSeconds;
 } GCState;
 
 void jaiGCInit(GCState *gc);
@@ -49,6 +68,7 @@ void jaiGCFree(GCState *gc);
 
 void jaiGCMaybeCollect(void);
 void jaiGCCollect(void);
+void jaiGCCollectYoung(void);
 void jaiGCEnable(bool enabled);
 
 extern GCState *jaiGCActive;
@@ -70,9 +90,77 @@ JAI_INLINE void jaiGCMark(Obj *obj) {
     if (obj != NULL && !obj->isMarked) jaiGCMarkObject(obj);
 }
 
+/* Generations.
+ *
+ * Nothing moves: the VM keeps raw Obj pointers in C locals and in compiled
+ * code's registers, so a young object is one on GCState.young, not one at a
+ * young address. Marks are sticky instead -- a promoted object keeps its mark
+ * between collections -- which makes `isMarked` outside a collection mean
+ * "old", lets a minor collection's marker stop at the old generation with the
+ * test it already makes, and leaves the weak tables' "unmarked means dead"
+ * correct without change.
+ *
+ * The price is the write barrier. A minor collection does not trace the old
+ * generation, so an old object that comes to hold a young one has to be
+ * traced anyway, and the store that made it so records it here: every store
+ * of a Value into a heap object that may already be old goes through
+ * jaiGCBarrier. The set is kept per object rather than per card, because
+ * nothing is at a fixed address to carve into cards, and because the objects
+ * that get remembered are the ones a program keeps mutating -- a long-lived
+ * list or dict -- which a card would have to rescan in pieces anyway.
+ *
+ * gcBits holds the rest: whether the object is in the remembered set, whether
+ * a temp root pinned it young this cycle, and how many minor collections a
+ * young object has survived. */
+#define JAI_GC_REMEMBERED 0x80u
+#define JAI_GC_PINNED     0x40u
+#define JAI_GC_AGE_MASK   0x0fu
+
+/* Laid out for compiled code, which pushes onto it without a call (see
+ * emitWriteBarrier): it cannot grow the array, so where C code would it sets
+ * `overflow` instead and the next collection is a full one. */
+typedef struct {
+    Obj     **items;
+    uint32_t  count;
+    uint32_t  capacity;
+    uint8_t   overflow;
+} JaiGCRememberedSet;
+
+extern JaiGCRememberedSet jaiGCRemembered;
+
+void jaiGCRemember(Obj *owner);
+
+/* `owner` now holds `v`. Old holding young is the only pair a minor
+ * collection could miss; a store into a young object, or of a non-object or
+ * an old one, costs the one load and compare. */
+JAI_INLINE void jaiGCBarrier(Obj *owner, Value v) {
+    if (JAI_UNLIKELY(owner->isMarked) && IS_OBJ(v) && !AS_OBJ(v)->isMarked)
+        jaiGCRemember(owner);
+}
+
+/* For a bulk copy into `owner`: remember it if it is old, without looking at
+ * what was copied. The next minor collection drops it again if none of it was
+ * young. */
+JAI_INLINE void jaiGCBarrierAll(Obj *owner) {
+    if (JAI_UNLIKELY(owner->isMarked)) jaiGCRemember(owner);
+}
+
+#if defined(JAI_NANBOX)
+/* intbox.c: the cells behind ints too wide for a NaN-boxed Value. */
+void   jaiIntBoxMark(Value v);
+void   jaiIntBoxScanStack(void);
+void   jaiIntBoxUnmark(void);
+size_t jaiIntBoxSweep(void);
+
+JAI_INLINE void jaiGCMarkVal(Value v) {
+    if (IS_OBJ(v)) jaiGCMark(AS_OBJ(v));
+    else if (JAI_UNLIKELY(JAI_NB_IS_INT_BOX(v))) jaiIntBoxMark(v);
+}
+#else
 JAI_INLINE void jaiGCMarkVal(Value v) {
     if (IS_OBJ(v)) jaiGCMark(AS_OBJ(v));
 }
+#endif
 
 void jaiGCPushRoot(Value v);
 void jaiGCPopRoots(int n);
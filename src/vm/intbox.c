@@ -0,0 +1,192 @@
+/* intbox.c — heap cells for the ints a JAI_NANBOX Value cannot hold inline.
+ *
+ * A NaN-boxed Value carries an int in 48 bits (value.h). The language's int
+ * is 64, so the rest -- hashes, bit masks, anything past 1.4e14 -- is boxed:
+ * the Value holds the address of an 8-byte cell with the int in it. Most
+ * programs never make one; a hashing loop makes one per iteration, so the
+ * cells are cheap to make and to find dead.
+ *
+ * They are not Objs. An Obj has a header twice the int's size, a place on the
+ * sweep list and an ObjType every switch would have to learn, and an int is
+ * none of those things. Cells live in 64 KiB slabs aligned to their size, so
+ * the slab and index of a cell are arithmetic on its address, with a mark and
+ * a live bit per cell at the head of the slab and free cells chained through
+ * their own payload.
+ *
+ * The hard part is liveness. Every native written before this treated an int
+ * as something that needs no rooting, so one may hold a boxed int in a C
+ * local across an allocation that collects. jaiGCMarkVal marks a box wherever
+ * the heap stores one; jaiIntBoxScanStack covers the locals by reading the
+ * C stack (and, through setjmp, the registers) conservatively, keeping any
+ * cell that a word there could be the Value of -- or the address of, since the
+ * compiler is free to keep only the unmasked pointer. A false hit keeps eight
+ * bytes for one more cycle. Only cells are found this way; objects stay
+ * precisely rooted, exactly as before.
+ *
+ * Making a cell never collects: INT_VAL is an expression in a few hundred
+ * places that assume it cannot run the collector. The bytes are charged to
+ * jaiHeapBytes, so the next allocation that can collect sees them. */
+
+#if defined(JAI_NANBOX)
+
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#  define _GNU_SOURCE   /* pthread_getattr_np */
+#endif
+
+#include "vm/gc.h"
+
+#include <pthread.h>
+#include <setjmp.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SLAB_BYTES  ((size_t)1 << 16)
+#define SLAB_CELLS  (SLAB_BYTES / sizeof(int64_t))
+#define BITMAP_WORDS (SLAB_CELLS / 64u)
+
+typedef struct IntSlab {
+    uint64_t        mark[BITMAP_WORDS];
+    uint64_t        live[BITMAP_WORDS];
+    struct IntSlab *next;
+    unsigned        liveCount;
+} IntSlab;
+
+/* The header's cells are never handed out. */
+#define FIRST_CELL ((sizeof(IntSlab) + sizeof(int64_t) - 1) / sizeof(int64_t))
+
+static IntSlab  *sSlabs;
+static int64_t  *sFree;          /* chained through each free cell's payload */
+static uintptr_t sLowest = UINTPTR_MAX, sHighest;
+
+static IntSlab *slabOf(const void *cell) {
+    return (IntSlab *)((uintptr_t)cell & ~(uintptr_t)(SLAB_BYTES - 1));
+}
+
+static size_t cellIndex(const IntSlab *slab, const void *cell) {
+    return (size_t)((const int64_t *)cell - (const int64_t *)slab);
+}
+
+static void growSlabs(void) {
+    IntSlab *slab = aligned_alloc(SLAB_BYTES, SLAB_BYTES);
+    if (slab == NULL) JAI_PANIC("out of memory boxing an int");
+    memset(slab, 0, sizeof *slab);
+    slab->next = sSlabs;
+    sSlabs = slab;
+    int64_t *cells = (int64_t *)slab;
+    for (size_t i = SLAB_CELLS; i-- > FIRST_CELL;) {
+        *(int64_t **)&cells[i] = sFree;
+        sFree = &cells[i];
+    }
+    if ((uintptr_t)slab < sLowest) sLowest = (uintptr_t)slab;
+    if ((uintptr_t)slab + SLAB_BYTES > sHighest) {
+        sHighest = (uintptr_t)slab + SLAB_BYTES;
+    }
+}
+
+Value jaiIntBoxNew(int64_t i) {
+    if (JAI_UNLIKELY(sFree == NULL)) growSlabs();
+    int64_t *cell = sFree;
+    sFree = *(int64_t **)cell;
+    *cell = i;
+    IntSlab *slab = slabOf(cell);
+    size_t k = cellIndex(slab, cell);
+    slab->live[k / 64u] |= (uint64_t)1 << (k % 64u);
+    slab->liveCount++;
+    jaiHeapBytes += sizeof *cell;
+    return jaiNbBits(JAI_NB_INT_BOX | (uint64_t)(uintptr_t)cell);
+}
+
+void jaiIntBoxMark(Value v) {
+    int64_t *cell = (int64_t *)(uintptr_t)(v.bits & JAI_NB_PTR_MASK);
+    IntSlab *slab = slabOf(cell);
+    size_t k = cellIndex(slab, cell);
+    slab->mark[k / 64u] |= (uint64_t)1 << (k % 64u);
+}
+
+/* A word that might be a cell's Value or address. Kept only if it lands on a
+ * live cell of a slab this file made: anything else is some other word. */
+static void markIfCell(uintptr_t word) {
+    if ((word >> 48) == (JAI_NB_INT_BOX >> 48)) word &= JAI_NB_PTR_MASK;
+    if (word < sLowest || word >= sHighest || (word & 7u) != 0) return;
+    IntSlab *candidate = slabOf((const void *)word);
+    for (IntSlab *slab = sSlabs; slab != NULL; slab = slab->next) {
+        if (slab != candidate) continue;
+        size_t k = cellIndex(slab, (const void *)word);
+        if (k < FIRST_CELL) return;
+        uint64_t bit = (uint64_t)1 << (k % 64u);
+        if (slab->live[k / 64u] & bit) slab->mark[k / 64u] |= bit;
+        return;
+    }
+}
+
+static uintptr_t stackHigh(void) {
+    static uintptr_t high;
+    if (high != 0) return high;
+    pthread_t self = pthread_self();
+#if defined(__APPLE__)
+    high = (uintptr_t)pthread_get_stackaddr_np(self);
+#else
+    pthread_attr_t attr;
+    void  *low = NULL;
+    size_t size = 0;
+    if (pthread_getattr_np(self, &attr) == 0) {
+        if (pthread_attr_getstack(&attr, &low, &size) == 0 && low != NULL) {
+            high = (uintptr_t)low + size;
+        }
+        pthread_attr_destroy(&attr);
+    }
+#endif
+    if (high == 0) JAI_PANIC("JAI_NANBOX: cannot find the stack to scan");
+    return high;
+}
+
+/* Not inlined, so that its frame -- and the registers setjmp spills into it --
+ * is below every frame of the collection's callers. */
+JAI_NOINLINE void jaiIntBoxScanStack(void) {
+    if (sSlabs == NULL) return;
+    jmp_buf regs;
+    setjmp(regs);
+    const uintptr_t *word = (const uintptr_t *)(void *)&regs;
+    const uintptr_t *end = (const uintptr_t *)stackHigh();
+    for (; word < end; word++) markIfCell(*word);
+}
+
+/* Minor collections mark cells (a young object or a root can hold one) but
+ * leave them to the next full collection, which starts from no marks so that
+ * a cell only a minor collection saw is not kept one cycle longer. */
+void jaiIntBoxUnmark(void) {
+    for (IntSlab *slab = sSlabs; slab != NULL; slab = slab->next)
+        memset(slab->mark, 0, sizeof slab->mark);
+}
+
+size_t jaiIntBoxSweep(void) {
+    size_t freed = 0;
+    IntSlab **link = &sSlabs;
+    while (*link != NULL) {
+        IntSlab *slab = *link;
+        int64_t *cells = (int64_t *)slab;
+        for (size_t w = 0; w < BITMAP_WORDS; w++) {
+            uint64_t dead = slab->live[w] & ~slab->mark[w];
+            slab->live[w] &= slab->mark[w];
+            slab->mark[w] = 0;
+            while (dead != 0) {
+                size_t k = w * 64u + (size_t)__builtin_ctzll(dead);
+                dead &= dead - 1;
+                *(int64_t **)&cells[k] = sFree;
+                sFree = &cells[k];
+                slab->liveCount--;
+                freed += sizeof(int64_t);
+            }
+        }
+        link = &slab->next;
+    }
+    jaiHeapAccountFreed(freed);
+    return freed;
+}
+
+#else
+
+/* ISO C wants a translation unit to declare something. */
+typedef int jaiIntBoxUnused;
+
+#endif /* JAI_NANBOX */
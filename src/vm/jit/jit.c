@@ -1,3 +1,15 @@
+/* Feature macros must precede every include: sigaction and setitimer are
+ * POSIX, and -std=c11 on its own leaves struct sigaction incomplete. */
+#if !defined(_POSIX_C_SOURCE)
+#  define _POSIX_C_SOURCE 200809L
+#endif
+#if defined(__APPLE__) && !defined(_DARWIN_C_SOURCE)
+#  define _DARWIN_C_SOURCE
+#endif
+#if defined(__linux__) && !defined(_DEFAULT_SOURCE)
+#  define _DEFAULT_SOURCE
+#endif
+
 #include "vm/jit/jit.h"
 
 #include "vm/vm.h"
@@ -14,6 +26,10 @@
 #endif
 
 bool jaiJitEnabled(void) {
+#if defined(JAI_NANBOX)
+    /* Every body bakes in the {tag, payload} pair; see value.h. */
+    return false;
+#endif
     static int cached = -1;
     if (cached < 0) {
         const char *off = getenv("JAITHON_NO_JIT");
@@ -22,24 +38,12 @@ bool jaiJitEnabled(void) {
     return cached != 0;
 }
 
-static JaiCodeArena sArena;
-static bool sArenaReady;
-
-static bool arenaReady(void) {
-    if (!sArenaReady) {
-        if (!jaiCodeArenaInit(&sArena, 1u << 20)) return false;
-        sArenaReady = true;
-    }
-    return true;
-}
-
 /* The compiled tier's entire repertoire, for now: a body that is exactly
  * `OP_RETURN_NULL`. Useless as an optimisation, deliberately -- it's the
  * smallest proof that generated code can be entered, run, and returned from
  * leaving the stack exactly as OP_RETURN would. */
 static bool compileReturnNull(ObjFunction *fn) {
     if (fn->chunk.count != 1 || fn->chunk.code[0] != OP_RETURN_NULL) return false;
-    if (!arenaReady() || sArena.sealed) return false;
 
 #if defined(__aarch64__) || defined(__arm64__)
     /* mov w0, #0 ; ret -- the return value is carried by the C caller below,
@@ -52,13 +56,14 @@ static bool compileReturnNull(ObjFunction *fn) {
     return false;
 #endif
 
-    uint8_t *entry = jaiCodeArenaWrite(&sArena, code, sizeof code);
+    uint8_t *entry = jaiCodeHeapPlace(jaiJitCodeHeap(), code, sizeof code,
+                                      NULL, 0);
     if (entry == NULL) return false;
-    /* Sealing the whole arena per function is wasteful and temporary: a real
-     * tier writes many functions and seals in batches. */
-    if (!jaiCodeArenaSeal(&sArena)) return false;
     fn->jitCode = entry;
     fn->jitKind = 0;   /* returns null; ignores its arguments */
+    if (JAI_UNLIKELY(jaiJitPerfEnabled())) {
+        jaiJitPerfNote(fn, NULL, 0, entry, sizeof code, NULL, 0);
+    }
     return true;
 }
 
@@ -69,7 +74,6 @@ static bool compileAccessor(ObjFunction *fn) {
 
     unsigned slot = (unsigned)c->code[1] | ((unsigned)c->code[2] << 8);
     if (slot == 0 || slot > 31) return false;   /* see the imm7 note above */
-    if (!arenaReady() || sArena.sealed) return false;
 
 #if defined(__aarch64__) || defined(__arm64__)
     uint32_t imm7 = (uint32_t)(slot * 2);       /* (slot * 16) / 8 */
@@ -81,15 +85,32 @@ static bool compileAccessor(ObjFunction *fn) {
         /* ret                        */
         0xd65f03c0u,
     };
+#elif defined(__x86_64__)
+    /* The slot base arrives in rdi (SysV). disp32 always, so one encoding
+     * covers every slot up to the limit above. */
+    uint32_t disp = (uint32_t)(slot * 16);
+    const uint8_t code[] = {
+        /* movups xmm0, [rdi + slot*16] */
+        0x0f, 0x10, 0x87,
+        (uint8_t)disp, (uint8_t)(disp >> 8), (uint8_t)(disp >> 16),
+        (uint8_t)(disp >> 24),
+        /* movups [rdi], xmm0            */
+        0x0f, 0x11, 0x07,
+        /* ret                           */
+        0xc3,
+    };
 #else
     return false;   /* no stencil for this architecture yet */
 #endif
 
-    uint8_t *entry = jaiCodeArenaWrite(&sArena, code, sizeof code);
+    uint8_t *entry = jaiCodeHeapPlace(jaiJitCodeHeap(), code, sizeof code,
+                                      NULL, 0);
     if (entry == NULL) return false;
-    if (!jaiCodeArenaSeal(&sArena)) return false;
     fn->jitCode = entry;
     fn->jitKind = 1;   /* accessor: takes the slot base */
+    if (JAI_UNLIKELY(jaiJitPerfEnabled())) {
+        jaiJitPerfNote(fn, NULL, 0, entry, sizeof code, NULL, 0);
+    }
     return true;
 }
 
@@ -112,12 +133,52 @@ typedef void (*JaiCompiledAccessor)(Value *slotBase);
 JaiJitOutcome jaiJitEnter(ObjClosure *closure, Value *slotBase) {
     ObjFunction *fn = closure->fn;
 
+    /* A form whose module has moved on is never entered again. Retired here,
+     * where it is found, the function is compiled afresh against the module
+     * as it now is; left in place, it declined every call for the rest of the
+     * run. */
+    if (fn->jitFunc != NULL &&
+        (fn->module == NULL || fn->module->version != fn->jitFuncModuleVersion)) {
+        jaiJitRetireFunc(fn);
+        if (fn->jitRefused) return JAI_JIT_DECLINED;
+    }
+
+    /* A warm start is for the arguments it was recorded with; a first hot
+     * entry with others goes back to counting, before anything is queued. */
+    if (JAI_UNLIKELY(fn->jitWarm != NULL) && !jaiJitWarmFits(closure, slotBase)) {
+        return JAI_JIT_DECLINED;
+    }
+
+    /* A hot function is handed to the compiler thread and keeps running
+     * interpreted until its body is ready; the first call that finds it
+     * ready installs it. A function the thread has no job for -- one the tier
+     * refuses outright, or any function before the thread can be started --
+     * falls through and is compiled here, as it always was. */
+    if (fn->jitFunc == NULL && fn->jitCode == NULL && !jaiJitSync()) {
+        if (fn->jitPending == JAI_JIT_QUEUED) jaiJitInstallReady();
+        if (fn->jitPending == JAI_JIT_IDLE) {
+            JaiJitJob *job = jaiJitJobNew(closure, slotBase);
+            if (job != NULL) {
+                if (jaiJitQueue(job)) fn->jitPending = JAI_JIT_QUEUED;
+                else jaiJitJobFree(job);
+            }
+        }
+        if (fn->jitPending == JAI_JIT_QUEUED) return JAI_JIT_DECLINED;
+    }
+
     /* Whole-function tier first: the only one that makes a hot function
      * meaningfully faster, and it declines quickly otherwise. */
     if (fn->jitFunc != NULL) return jaiJitEnterFunc(closure, slotBase);
 
     if (fn->jitCode == NULL) {
-        if (jaiJitCompileFunc(closure, slotBase)) {
+        bool compiled = false;
+        if (fn->jitPending != JAI_JIT_THREAD_DECLINED) {
+            jaiJitHold();
+            compiled = jaiJitCompileFunc(closure, slotBase);
+            jaiJitRelease();
+        }
+        fn->jitPending = JAI_JIT_IDLE;
+        if (compiled) {
             fn->jitFuncModuleVersion = fn->module->version;
             return jaiJitEnterFunc(closure, slotBase);
         }
@@ -29,6 +29,12 @@ _Static_assert(JAI_IC_OBS_BUDGET <= JAI_JIT_THRESHOLD,
 _Static_assert(JAI_IC_OBS_BUDGET_TRACE <= JAI_JIT_TRACE_THRESHOLD,
                "a traced function's caches must settle before it compiles");
 
+/* Entries a function with a warm start (jit_warm.c) still runs interpreted:
+ * enough for its caches' shortened window to close first. */
+#define JAI_JIT_WARM_ENTRIES 8
+_Static_assert(JAI_IC_OBS_BUDGET_TRACE <= JAI_JIT_WARM_ENTRIES,
+               "a warm function's caches must settle before it compiles");
+
 /* DECLINED: nothing touched, interpreter should run the call. ERROR: compiled
  * code called out, the callee raised, and those effects already happened, so
  * the call must not be re-run. */
@@ -56,6 +62,116 @@ JaiJitOutcome jaiJitEnter(ObjClosure *closure, Value *slotBase);
  * does not speak; enter obeys the same boundary contract as jaiJitEnter. */
 bool jaiJitCompileFunc(ObjClosure *closure, Value *slotBase);
 
+/* ------------------------------------------------------------------ */
+/* Compiling in the background                                          */
+/* ------------------------------------------------------------------ */
+
+/* A hot function is compiled on a dedicated thread (jit_thread.c) while the
+ * interpreter keeps running it, and the result is installed on the
+ * interpreter's own thread at its next safepoint. The compile reads the
+ * chunk and its feedback in place -- the only bytecode the interpreter ever
+ * rewrites is an opcode flipped between its generic and quickened forms, and
+ * every read here folds the two with jaiOpGeneric; a feedback byte is only
+ * ever a prediction the body guards -- but reads every value the interpreter
+ * can write from a copy the job took, and asks for another round when it
+ * finds one missing.
+ *
+ * Anything that would move or free what a compile is reading -- a
+ * collection, a new global, a changed class -- first waits for it with
+ * jaiJitHold. JAITHON_JIT_SYNC=1 (`--jit-sync`) compiles on the calling
+ * thread instead, so a run's compiled set is a function of its input alone. */
+
+/* Where a function's background compile is, in ObjFunction::jitPending. */
+enum {
+    JAI_JIT_IDLE,          /* no job: the next hot entry makes one */
+    JAI_JIT_QUEUED,        /* a job is on the thread or waiting to install */
+    JAI_JIT_THREAD_DECLINED, /* the thread could not compile it */
+    JAI_JIT_COMPILE_HERE   /* the copies never settled; compile in place */
+};
+
+typedef struct JaiJitJob JaiJitJob;
+
+typedef enum {
+    JAI_JIT_JOB_INSTALLED,
+    JAI_JIT_JOB_DECLINED,
+    JAI_JIT_JOB_AGAIN,     /* wanted values are now copied; run it again */
+    JAI_JIT_JOB_HERE       /* give up on the thread for this function */
+} JaiJitJobResult;
+
+/* jit_func.c. New, Install and Mark run on the interpreter's thread; Run on
+ * whichever thread holds the compile lock. New returns NULL for a function
+ * the tier would refuse anyway. */
+JaiJitJob *jaiJitJobNew(ObjClosure *closure, Value *slotBase);
+void jaiJitJobRun(JaiJitJob *job);
+JaiJitJobResult jaiJitJobInstall(JaiJitJob *job);
+void jaiJitJobMark(const JaiJitJob *job);
+void jaiJitJobFree(JaiJitJob *job);
+ObjClosure *jaiJitJobClosure(const JaiJitJob *job);
+
+/* jit_thread.c. */
+bool jaiJitSync(void);
+/* Hands `job` to the thread, starting it on first use. False when there is no
+ * thread to hand it to; the caller still owns the job. */
+bool jaiJitQueue(JaiJitJob *job);
+/* Installs whatever the thread has finished, if it can without waiting. */
+void jaiJitInstallReady(void);
+/* Waits out any compile in flight and keeps the next from starting until the
+ * matching release. Nests, and costs nothing before the thread exists. */
+void jaiJitHold(void);
+void jaiJitRelease(void);
+void jaiJitMarkQueue(void);
+void jaiJitShutdown(void);
+
+/* jit_reclaim.c. A compiled form is retired when nothing may enter it again,
+ * and its code is reclaimed at the end of a collection once nothing is still
+ * running it. */
+/* The whole-function form, whose module has moved on since it was built. */
+void jaiJitRetireFunc(ObjFunction *fn);
+/* Every loop form, likewise. */
+void jaiJitRetireOsr(ObjFunction *fn);
+/* Everything `fn` has compiled; `fn` is being freed. */
+void jaiJitForget(ObjFunction *fn);
+/* Frees retired code if no frame on this thread's stack is inside any of it.
+ * Returns the bytes freed. Called by the collector, under its hold. */
+size_t jaiJitReclaim(void);
+void jaiJitPrintStats(FILE *out);
+
+/* jit_warm.c. What compiled in one run, written beside the module's .jaic at
+ * exit and read back when the next run loads it, so that the same functions
+ * compile after JAI_JIT_WARM_ENTRIES calls instead of JAI_JIT_THRESHOLD. */
+/* After `body` has been loaded or compiled from `sourcePath`: `read` applies
+ * the file if it matches, `write` has it rewritten by jaiJitWarmSave. */
+void jaiJitWarmAttach(const char *sourcePath, ObjFunction *body,
+                      uint64_t sourceHash, bool read, bool write);
+/* On a warm function's first hot entry: whether these are the arguments its
+ * record was made for. When they are not, the function goes back to the full
+ * threshold and observation window, and this answers false. */
+bool jaiJitWarmFits(ObjClosure *closure, const Value *slotBase);
+/* jit_func.c: whether `v` can enter a parameter compiled as `kind`, pinned to
+ * the class named `className` when that is not NULL. */
+bool jaiJitValueFits(uint8_t kind, Value v, const char *className);
+/* From jaiVMFree, before anything is freed. */
+void jaiJitWarmSave(void);
+void jaiJitWarmForget(ObjFunction *fn);
+
+/* jit_perf.c. JAITHON_PERF_MAP=1 and JAITHON_JITDUMP=1: name each installed
+ * body for `perf`, in /tmp/perf-<pid>.map and /tmp/jit-<pid>.dump. */
+/* A source position inside a body: the instruction at byte `codeOffset` is
+ * the start of bytecode offset `bcOffset`. */
+typedef struct {
+    uint32_t codeOffset;
+    uint32_t bcOffset;
+} JaiJitLine;
+bool jaiJitPerfEnabled(void);
+/* Only the jitdump uses lines; a compile builds them when this says so. */
+bool jaiJitPerfWantsLines(void);
+/* `code` has just been placed for `fn`. `tag` is NULL for the whole function,
+ * or "osr" / "loop" with `at` the bytecode offset of the loop. `lines`, which
+ * may be NULL, are in code order. */
+void jaiJitPerfNote(const ObjFunction *fn, const char *tag, int at,
+                    const void *code, size_t length, const JaiJitLine *lines,
+                    unsigned lineCount);
+
 /* Populate the freshly pushed frame from the deopt record. */
 bool jaiJitApplyDeopt(ObjClosure *closure, Value *slotBase);
 
@@ -122,8 +238,50 @@ bool jaiCodeArenaSeal(JaiCodeArena *arena);
 bool jaiCodeArenaUnseal(JaiCodeArena *arena);
 void jaiCodeArenaFree(JaiCodeArena *arena);
 
-/* The one arena compiled code lives in. Never freed: a compiled function is
- * reachable for the life of the process. */
-JaiCodeArena *jaiJitArena(void);
+/* Where every compiled body lives: arenas of JAI_CODE_CHUNK bytes, chained as
+ * they fill, with bodies placed JAI_CODE_ALIGN-aligned. See jit_arena.c. */
+#define JAI_CODE_CHUNK (1u << 20)
+#define JAI_CODE_ALIGN 32u
+
+typedef struct JaiCodeChunk JaiCodeChunk;
+
+typedef struct {
+    JaiCodeChunk *chunks;       /* newest first */
+    size_t        chunkSize;
+    size_t        chunkCount;
+    unsigned      batch;        /* open batches; sealing waits for the last */
+    size_t        mapped;       /* bytes of address space held */
+    size_t        live;         /* in bodies still in use */
+    size_t        retired;      /* in bodies retired and not yet reclaimed */
+    uint64_t      reclaimed;    /* over the heap's life */
+    uint64_t      placed;       /* bodies, over the heap's life */
+    uint64_t      seals;
+} JaiCodeHeap;
+
+/* An empty heap; nothing is mapped until the first body is placed. */
+void jaiCodeHeapInit(JaiCodeHeap *heap, size_t chunkSize);
+/* Copies a body in and returns its entry, or NULL when no memory can be had.
+ * Sealed before returning unless a batch is open. `guard`, when not NULL,
+ * points at a counter that stays at `guardValue` for as long as the body may
+ * run: the reclaimer treats a running body whose guard has moved as stale. */
+uint8_t *jaiCodeHeapPlace(JaiCodeHeap *heap, const void *bytes, size_t length,
+                          const uint32_t *guard, uint32_t guardValue);
+/* Between these, placed bodies are left writable and sealed together at the
+ * end. Nothing placed in the batch may run before it ends. Nests. */
+void jaiCodeHeapBeginBatch(JaiCodeHeap *heap);
+bool jaiCodeHeapEndBatch(JaiCodeHeap *heap);
+/* The body at `entry` will not be entered again. Its memory is not reused
+ * until jaiCodeHeapReclaim finds it safe. False for an address the heap did
+ * not hand out or has already retired. */
+bool jaiCodeHeapRetire(JaiCodeHeap *heap, const void *entry);
+/* Frees retired bodies that nothing in [lo, hi) -- the caller's stack -- may
+ * still be running: none that a word there points into, and none sharing a
+ * guard value with a retired or stale body that one does. Returns the bytes
+ * freed. */
+size_t jaiCodeHeapReclaim(JaiCodeHeap *heap, const void *lo, const void *hi);
+void jaiCodeHeapFree(JaiCodeHeap *heap);
+
+/* The process's code heap. */
+JaiCodeHeap *jaiJitCodeHeap(void);
 
 #endif /* JAI_VM_JIT_H */
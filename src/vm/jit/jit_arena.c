@@ -1,7 +1,22 @@
+/* Feature macros must precede every include: MAP_ANON is outside C11, and
+ * glibc hides it even under _POSIX_C_SOURCE, so Linux asks for the default
+ * set as well. */
+#if !defined(_POSIX_C_SOURCE)
+#  define _POSIX_C_SOURCE 200809L
+#endif
+#if defined(__APPLE__) && !defined(_DARWIN_C_SOURCE)
+#  define _DARWIN_C_SOURCE
+#endif
+#if defined(__linux__) && !defined(_DEFAULT_SOURCE)
+#  define _DEFAULT_SOURCE
+#endif
+
 #include "vm/jit/jit.h"
 
+#include <stdlib.h>
 #include <string.h>
 #include <sys/mman.h>
+#include <unistd.h>
 
 #if defined(__APPLE__)
 #  include <libkern/OSCacheControl.h>
@@ -33,18 +48,25 @@ uint8_t *jaiCodeArenaWrite(JaiCodeArena *arena, const void *bytes,
     return at;
 }
 
+/* Not optional on arm64: the data and instruction caches are not coherent,
+ * so without this the CPU can fetch whatever was in the line before. */
+static void flushInstructions(uint8_t *from, uint8_t *to) {
+#if defined(__APPLE__)
+    sys_icache_invalidate(from, (size_t)(to - from));
+#elif defined(__GNUC__)
+    __builtin___clear_cache((char *)from, (char *)to);
+#else
+    (void)from;
+    (void)to;
+#endif
+}
+
 bool jaiCodeArenaSeal(JaiCodeArena *arena) {
     if (arena->sealed) return true;
     if (mprotect(arena->code, arena->capacity, PROT_READ | PROT_EXEC) != 0) {
         return false;
     }
-    /* Not optional on arm64: the data and instruction caches are not coherent,
-     * so without this the CPU can fetch whatever was in the line before. */
-#if defined(__APPLE__)
-    sys_icache_invalidate(arena->code, arena->used);
-#elif defined(__GNUC__)
-    __builtin___clear_cache((char *)arena->code, (char *)arena->code + arena->used);
-#endif
+    flushInstructions(arena->code, arena->code + arena->used);
     arena->sealed = true;
     return true;
 }
@@ -66,13 +88,404 @@ void jaiCodeArenaFree(JaiCodeArena *arena) {
     memset(arena, 0, sizeof *arena);
 }
 
+/* ------------------------------------------------------------------ */
+/* The code heap                                                        */
+/* ------------------------------------------------------------------ */
+
+/* Every compiled body lives here: arenas chained as they fill, each tiled by
+ * a block list that records what is where. The heap replaced a single 1 MB
+ * arena that was unsealed and resealed whole around every function and never
+ * gave a byte back, so a long enough run -- a server reloading modules, a
+ * program that keeps making closures -- filled it, and from then on every
+ * compile failed and the tier stopped without a word.
+ *
+ * Three things differ from that arena, and each is a lesson it taught:
+ *
+ *   growth     a full chunk chains another rather than failing the compile
+ *   sealing    only the pages a body is written to are made writable, and
+ *              inside a batch they stay so until the batch ends: installing
+ *              six bodies is one unseal and one seal, not six of each, and
+ *              nothing outside those pages ever loses its execute bit
+ *   reuse      a body its owner no longer needs is RETIRED, not freed; it is
+ *              freed by jaiCodeHeapReclaim, once nothing can still be running
+ *              it, and its block is then the first choice for the next body
+ *
+ * Blocks are JAI_CODE_ALIGN-aligned and -sized, so a body always starts at
+ * the same offset modulo the fetch block; see installBuilt in jit_func.c for
+ * why that is worth the padding. */
+
+enum { BLOCK_FREE, BLOCK_LIVE, BLOCK_RETIRED };
+
+typedef struct {
+    uint32_t        offset;
+    uint32_t        length;
+    uint8_t         state;
+    /* See jaiCodeHeapPlace: what says the body has gone stale. */
+    uint32_t        guardValue;
+    const uint32_t *guard;
+} CodeBlock;
+
+struct JaiCodeChunk {
+    JaiCodeArena  arena;        /* `used` is the bump pointer; `sealed` unused */
+    CodeBlock    *blocks;       /* by offset, tiling [0, arena.used) exactly */
+    size_t        blockCount;
+    size_t        blockCapacity;
+    size_t        freeBytes;    /* in FREE blocks below arena.used */
+    /* The pages that are writable right now, page-aligned; empty when equal.
+     * Everything outside them is read-execute. */
+    size_t        openLo, openHi;
+    /* Bytes written since the last seal -- what the instruction cache has to
+     * forget. */
+    size_t        dirtyLo, dirtyHi;
+    JaiCodeChunk *next;
+};
+
+static size_t pageSize(void) {
+    static size_t cached;
+    if (cached == 0) {
+        long p = sysconf(_SC_PAGESIZE);
+        cached = p > 0 ? (size_t)p : 4096u;
+    }
+    return cached;
+}
+
+void jaiCodeHeapInit(JaiCodeHeap *heap, size_t chunkSize) {
+    memset(heap, 0, sizeof *heap);
+    size_t page = pageSize();
+    heap->chunkSize = (chunkSize + page - 1) & ~(page - 1);
+    if (heap->chunkSize == 0) heap->chunkSize = page;
+}
+
+static bool chunkSeal(JaiCodeHeap *heap, JaiCodeChunk *c) {
+    if (c->openHi == c->openLo) return true;
+    if (mprotect(c->arena.code + c->openLo, c->openHi - c->openLo,
+                 PROT_READ | PROT_EXEC) != 0) {
+        return false;
+    }
+    if (c->dirtyHi > c->dirtyLo) {
+        flushInstructions(c->arena.code + c->dirtyLo, c->arena.code + c->dirtyHi);
+    }
+    c->openLo = c->openHi = 0;
+    c->dirtyLo = c->dirtyHi = 0;
+    heap->seals++;
+    return true;
+}
+
+/* Makes [at, at+length) writable. A run of pages that does not touch the open
+ * one is sealed first, so a chunk only ever has one writable run and a seal
+ * needs no list of them. */
+static bool chunkOpen(JaiCodeHeap *heap, JaiCodeChunk *c, size_t at,
+                      size_t length) {
+    size_t page = pageSize();
+    size_t lo = at & ~(page - 1);
+    size_t hi = (at + length + page - 1) & ~(page - 1);
+    if (c->openHi > c->openLo) {
+        if (lo >= c->openLo && hi <= c->openHi) return true;
+        if (hi < c->openLo || lo > c->openHi) {
+            if (!chunkSeal(heap, c)) return false;
+        } else {
+            if (c->openLo < lo) lo = c->openLo;
+            if (c->openHi > hi) hi = c->openHi;
+        }
+    }
+    if (mprotect(c->arena.code + lo, hi - lo, PROT_READ | PROT_WRITE) != 0) {
+        return false;
+    }
+    c->openLo = lo;
+    c->openHi = hi;
+    return true;
+}
+
+static bool insertBlock(JaiCodeChunk *c, size_t at, CodeBlock block) {
+    if (c->blockCount == c->blockCapacity) {
+        size_t cap = c->blockCapacity < 16 ? 16 : c->blockCapacity * 2;
+        CodeBlock *grown = realloc(c->blocks, cap * sizeof *grown);
+        if (grown == NULL) return false;
+        c->blocks = grown;
+        c->blockCapacity = cap;
+    }
+    memmove(&c->blocks[at + 1], &c->blocks[at],
+            (c->blockCount - at) * sizeof *c->blocks);
+    c->blocks[at] = block;
+    c->blockCount++;
+    return true;
+}
+
+static void removeBlock(JaiCodeChunk *c, size_t at) {
+    memmove(&c->blocks[at], &c->blocks[at + 1],
+            (c->blockCount - at - 1) * sizeof *c->blocks);
+    c->blockCount--;
+}
+
+/* A block just made FREE: merged with free neighbours, and handed back to the
+ * bump pointer if it ends the chunk. */
+static void coalesce(JaiCodeChunk *c, size_t at) {
+    c->freeBytes += c->blocks[at].length;
+    if (at + 1 < c->blockCount && c->blocks[at + 1].state == BLOCK_FREE) {
+        c->blocks[at].length += c->blocks[at + 1].length;
+        removeBlock(c, at + 1);
+    }
+    if (at > 0 && c->blocks[at - 1].state == BLOCK_FREE) {
+        c->blocks[at - 1].length += c->blocks[at].length;
+        removeBlock(c, at);
+        at--;
+    }
+    if (at + 1 == c->blockCount) {
+        c->freeBytes -= c->blocks[at].length;
+        c->arena.used = c->blocks[at].offset;
+        removeBlock(c, at);
+    }
+}
+
+/* First fit among the holes reclamation left, so freed code is reused before
+ * the heap grows. */
+static bool reserveHole(JaiCodeHeap *heap, size_t need, JaiCodeChunk **out,
+                        size_t *index) {
+    for (JaiCodeChunk *c = heap->chunks; c != NULL; c = c->next) {
+        if (c->freeBytes < need) continue;
+        for (size_t i = 0; i < c->blockCount; i++) {
+            CodeBlock *b = &c->blocks[i];
+            if (b->state != BLOCK_FREE || b->length < need) continue;
+            if (b->length > need) {
+                CodeBlock rest = { b->offset + (uint32_t)need,
+                                   b->length - (uint32_t)need,
+                                   BLOCK_FREE, 0, NULL };
+                if (!insertBlock(c, i + 1, rest)) return false;
+                b = &c->blocks[i];
+                b->length = (uint32_t)need;
+            }
+            b->state = BLOCK_LIVE;
+            c->freeBytes -= need;
+            *out = c;
+            *index = i;
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool reserveBump(JaiCodeHeap *heap, size_t need, JaiCodeChunk **out,
+                        size_t *index) {
+    JaiCodeChunk *c = heap->chunks;
+    while (c != NULL && c->arena.capacity - c->arena.used < need) c = c->next;
+    if (c == NULL) {
+        size_t page = pageSize();
+        size_t capacity = heap->chunkSize;
+        if (need > capacity) capacity = (need + page - 1) & ~(page - 1);
+        /* Offsets are 32-bit in the block list. */
+        if (capacity > UINT32_MAX) return false;
+        c = calloc(1, sizeof *c);
+        if (c == NULL) return false;
+        if (!jaiCodeArenaInit(&c->arena, capacity)) {
+            free(c);
+            return false;
+        }
+        /* A fresh mapping is writable throughout; the first seal flips all of
+         * it at once. */
+        c->openLo = 0;
+        c->openHi = capacity;
+        c->next = heap->chunks;
+        heap->chunks = c;
+        heap->chunkCount++;
+        heap->mapped += capacity;
+    }
+    CodeBlock block = { (uint32_t)c->arena.used, (uint32_t)need, BLOCK_LIVE,
+                        0, NULL };
+    if (!insertBlock(c, c->blockCount, block)) return false;
+    c->arena.used += need;
+    *out = c;
+    *index = c->blockCount - 1;
+    return true;
+}
+
+uint8_t *jaiCodeHeapPlace(JaiCodeHeap *heap, const void *bytes, size_t length,
+                          const uint32_t *guard, uint32_t guardValue) {
+    if (length == 0) return NULL;
+    size_t need = (length + JAI_CODE_ALIGN - 1) & ~(size_t)(JAI_CODE_ALIGN - 1);
+    JaiCodeChunk *c = NULL;
+    size_t i = 0;
+    if (!reserveHole(heap, need, &c, &i) && !reserveBump(heap, need, &c, &i)) {
+        return NULL;
+    }
+    size_t at = c->blocks[i].offset;
+    if (!chunkOpen(heap, c, at, need)) {
+        c->blocks[i].state = BLOCK_FREE;
+        coalesce(c, i);
+        return NULL;
+    }
+    memcpy(c->arena.code + at, bytes, length);
+    if (c->dirtyHi == c->dirtyLo) {
+        c->dirtyLo = at;
+        c->dirtyHi = at + length;
+    } else {
+        if (at < c->dirtyLo) c->dirtyLo = at;
+        if (at + length > c->dirtyHi) c->dirtyHi = at + length;
+    }
+    c->blocks[i].guard = guard;
+    c->blocks[i].guardValue = guardValue;
+    heap->live += need;
+    heap->placed++;
+    /* Outside a batch this is a batch of one. A failed seal still leaves the
+     * body placed: the batch's end, or the next seal, tries again, and until
+     * then nothing is pointed at it. */
+    if (heap->batch == 0 && !chunkSeal(heap, c)) return NULL;
+    return c->arena.code + at;
+}
+
+void jaiCodeHeapBeginBatch(JaiCodeHeap *heap) {
+    heap->batch++;
+}
+
+bool jaiCodeHeapEndBatch(JaiCodeHeap *heap) {
+    if (heap->batch == 0 || --heap->batch > 0) return true;
+    bool ok = true;
+    for (JaiCodeChunk *c = heap->chunks; c != NULL; c = c->next) {
+        if (!chunkSeal(heap, c)) ok = false;
+    }
+    return ok;
+}
+
+static CodeBlock *findBlock(const JaiCodeHeap *heap, uintptr_t address,
+                            uintptr_t *start) {
+    for (JaiCodeChunk *c = heap->chunks; c != NULL; c = c->next) {
+        uintptr_t base = (uintptr_t)c->arena.code;
+        if (address < base || address >= base + c->arena.used) continue;
+        uint32_t off = (uint32_t)(address - base);
+        size_t lo = 0, hi = c->blockCount;
+        while (hi - lo > 1) {
+            size_t mid = lo + (hi - lo) / 2;
+            if (c->blocks[mid].offset <= off) lo = mid;
+            else hi = mid;
+        }
+        if (start != NULL) *start = base + c->blocks[lo].offset;
+        return &c->blocks[lo];
+    }
+    return NULL;
+}
+
+bool jaiCodeHeapRetire(JaiCodeHeap *heap, const void *entry) {
+    if (entry == NULL) return false;
+    uintptr_t start = 0;
+    CodeBlock *b = findBlock(heap, (uintptr_t)entry, &start);
+    if (b == NULL || b->state != BLOCK_LIVE || start != (uintptr_t)entry) {
+        return false;
+    }
+    b->state = BLOCK_RETIRED;
+    heap->live -= b->length;
+    heap->retired += b->length;
+    return true;
+}
+
+/* What a scan of the stack found a running body to hold back: the body itself
+ * when it is retired, and -- when it is retired or stale -- every body built
+ * against the same guard value. A stale body can still call anything it baked
+ * in, and the heap cannot see which bodies those are; but a baked call is only
+ * ever made to a body compiled against the same module version as the caller,
+ * so the pair names all of them. */
+typedef struct {
+    uintptr_t        start;     /* of the retired body itself, or 0 */
+    const uint32_t  *guard;
+    uint32_t         guardValue;
+} Pin;
+
+#define JAI_CODE_PINS 64
+
+static bool pinned(const Pin *pins, size_t count, uintptr_t start,
+                   const CodeBlock *b) {
+    for (size_t i = 0; i < count; i++) {
+        if (pins[i].start == start) return true;
+        if (b->guard != NULL && pins[i].guard == b->guard &&
+            pins[i].guardValue == b->guardValue) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/* Conservative in the one direction that matters: any word that looks like an
+ * address inside a body counts as that body running. More running stale
+ * bodies than there are pins frees nothing at all. */
+size_t jaiCodeHeapReclaim(JaiCodeHeap *heap, const void *lo, const void *hi) {
+    if (heap->retired == 0) return 0;
+    Pin pins[JAI_CODE_PINS];
+    size_t pinCount = 0;
+    uintptr_t from = ((uintptr_t)lo + sizeof(uintptr_t) - 1) &
+                     ~(uintptr_t)(sizeof(uintptr_t) - 1);
+    for (const uintptr_t *w = (const uintptr_t *)from;
+         (const void *)(w + 1) <= hi; w++) {
+        uintptr_t start = 0;
+        const CodeBlock *b = findBlock(heap, *w, &start);
+        if (b == NULL || b->state == BLOCK_FREE) continue;
+        bool retired = b->state == BLOCK_RETIRED;
+        if (!retired && (b->guard == NULL || *b->guard == b->guardValue)) {
+            continue;   /* live and current: calls only what is current */
+        }
+        if (pinned(pins, pinCount, retired ? start : 0, b)) continue;
+        if (pinCount == JAI_CODE_PINS) return 0;
+        pins[pinCount].start = retired ? start : 0;
+        pins[pinCount].guard = b->guard;
+        pins[pinCount].guardValue = b->guardValue;
+        pinCount++;
+    }
+
+    size_t freed = 0;
+    JaiCodeChunk **link = &heap->chunks;
+    while (*link != NULL) {
+        JaiCodeChunk *c = *link;
+        size_t i = 0;
+        while (i < c->blockCount) {
+            if (c->blocks[i].state != BLOCK_RETIRED ||
+                pinned(pins, pinCount,
+                       (uintptr_t)c->arena.code + c->blocks[i].offset,
+                       &c->blocks[i])) {
+                i++;
+                continue;
+            }
+            c->blocks[i].state = BLOCK_FREE;
+            freed += c->blocks[i].length;
+            coalesce(c, i);
+            /* Coalescing can only have merged into the left neighbour, so
+             * carry on from there. */
+            if (i > 0) i--;
+        }
+        /* An emptied chunk goes back to the system unless it is the last one:
+         * keeping one mapped saves the next compile an mmap. */
+        if (c->arena.used == 0 && heap->chunkCount > 1) {
+            *link = c->next;
+            heap->mapped -= c->arena.capacity;
+            heap->chunkCount--;
+            jaiCodeArenaFree(&c->arena);
+            free(c->blocks);
+            free(c);
+            continue;
+        }
+        link = &c->next;
+    }
+    heap->retired -= freed;
+    heap->reclaimed += freed;
+    return freed;
+}
+
+void jaiCodeHeapFree(JaiCodeHeap *heap) {
+    JaiCodeChunk *c = heap->chunks;
+    while (c != NULL) {
+        JaiCodeChunk *next = c->next;
+        jaiCodeArenaFree(&c->arena);
+        free(c->blocks);
+        free(c);
+        c = next;
+    }
+    size_t chunkSize = heap->chunkSize;
+    memset(heap, 0, sizeof *heap);
+    heap->chunkSize = chunkSize;
+}
 
-JaiCodeArena *jaiJitArena(void) {
-    static JaiCodeArena arena;
-    static bool tried;
-    if (!tried) {
-        tried = true;
-        if (!jaiCodeArenaInit(&arena, 1u << 20)) return NULL;
+JaiCodeHeap *jaiJitCodeHeap(void) {
+    static JaiCodeHeap heap;
+    static bool ready;
+    if (!ready) {
+        ready = true;
+        jaiCodeHeapInit(&heap, JAI_CODE_CHUNK);
     }
-    return arena.code != NULL ? &arena : NULL;
+    return &heap;
 }
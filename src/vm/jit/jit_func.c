@@ -1,13 +1,21 @@
-/* jit_func.c -- whole-function JIT tier: compiles self-recursive, integer-only bodies to native arm64, bailing to the interpreter on overflow, deep recursion, or an unsupported shape. */
+/* jit_func.c -- whole-function JIT tier: compiles self-recursive, integer-only bodies to native arm64 (lowered to x86-64 by jit_x64.c on that host), bailing to the interpreter on overflow, deep recursion, or an unsupported shape. */
+/* Feature macros must precede every include: pthread_getattr_np, the only way
+ * to read a Linux thread's stack bounds, is a GNU extension. */
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#  define _GNU_SOURCE
+#endif
 #include "vm/jit/jit.h"
 
 #include "vm/jit/jit_arm64.h"
+#include "vm/jit/jit_x64.h"
 /* For jaiJitFieldReadFor: which builtins are one load from their receiver. */
 #include "vm/jit/jit_field_read.h"
+#include "vm/jit/jit_vec.h"
 #include "vm/gc.h"
 /* For jaiBuiltinMethod: resolving `xs.len()` to a native needs the runtime's name table. */
 #include "runtime/runtime.h"
-/* For jaiOpBranchOperandAt: says which opcodes carry a branch target. */
+/* For jaiOpBranchOperandAt and jaiOpSlotOperands: which opcodes carry a
+ * branch target, and which name a local. */
 #include "vm/bytecode/verify.h"
 #include "vm/vm.h"
 
@@ -16,7 +24,8 @@
 #include <stddef.h>
 #include <string.h>
 
-#if (defined(__aarch64__) || defined(__arm64__))
+#if (defined(__aarch64__) || defined(__arm64__) || defined(__x86_64__)) && \
+    !defined(JAI_NANBOX)
 
 #include <pthread.h>
 
@@ -32,11 +41,25 @@ typedef struct { int64_t value; int64_t bailed; } JitResult;
  * every entry for a function compiled near the top of stack and called later from deep in the interpreter. */
 static uintptr_t stackLimit(void) {
     pthread_t self = pthread_self();
+#if defined(__APPLE__)
     void  *top  = pthread_get_stackaddr_np(self);
     size_t size = pthread_get_stacksize_np(self);
     if (top == NULL || size == 0) return 0;
+    uintptr_t low = (uintptr_t)top - size;
+#else
+    /* glibc reports the LOW end, and for the main thread derives the size
+     * from RLIMIT_STACK -- the same bound the kernel grows the stack to. */
+    pthread_attr_t attr;
+    void  *low0 = NULL;
+    size_t size = 0;
+    if (pthread_getattr_np(self, &attr) != 0) return 0;
+    int rc = pthread_attr_getstack(&attr, &low0, &size);
+    pthread_attr_destroy(&attr);
+    if (rc != 0 || low0 == NULL || size == 0) return 0;
+    uintptr_t low = (uintptr_t)low0;
+#endif
     /* Margin covers the deepest compiled frame plus what the interpreter needs to unwind and report the error. */
-    return (uintptr_t)top - size + (256u * 1024u);
+    return low + (256u * 1024u);
 }
 
 
@@ -87,12 +110,17 @@ typedef struct JitCallDesc {
     /* link/nroots come first so `roots` sits at a fixed offset from the chain head; link != NULL means this descriptor is on the collector's walk chain. */
     struct JitCallDesc *link;
     int64_t nroots;
-    Value   roots[JIT_MAX_SAVED];
+    /* `words`: the operands of a block-kernel call (jitVecLoop), which never
+     * collects and so has no roots to give this area. */
+    union {
+        Value   roots[JIT_MAX_SAVED];
+        int64_t words[2 * JIT_MAX_SAVED];
+    };
     Value   callee;
     Value   args[JIT_MAX_ARGS_OUT];
     Value   result;
     int64_t argc;
-    /* aux: only OP_GET_SLICE uses it, for which of start/stop/step are present -- `xs[null:3]` vs `xs[:3]` can't be told apart from the values alone. */
+    /* aux: OP_GET_SLICE's record of which of start/stop/step are present -- `xs[null:3]` vs `xs[:3]` can't be told apart from the values alone; a block kernel's plan; an unpinned invoke's InlineCache. */
     int64_t aux;
 } JitCallDesc;
 
@@ -110,7 +138,13 @@ void jaiJitMarkFrames(void) {
  * was O(roots) per call-out; a bulk jaiGCPushRoots variant was tried and reverted, since it still copied every value. Returns 0 on success, 1 with an exception pending. */
 /* Not a deopt: overflow raises directly, since the interpreter would also throw here. A bail is only
  * sound before any write; raising stays sound after a field store has already happened. */
+/* `which` 3 is float `/` by zero, which shares the stubs for the same reason:
+ * the interpreter raises there too, and a quotient of inf is a wrong answer. */
 static void jitThrowOverflow(int64_t which) {
+    if (which == 3) {
+        (void)jaiThrow(vm.cDivisionByZeroError, "float division by zero");
+        return;
+    }
     static const char *ops[3]  = { "+",  "-",  "*"  };
     static const char *wrap[3] = { "+%", "-%", "*%" };
     int i = (which >= 0 && which < 3) ? (int)which : 0;
@@ -191,11 +225,14 @@ static int jitInvokeMethod(JitCallDesc *d) {
 
 /* Receiver whose class the model could not pin. The method NAME travels in the
  * descriptor's callee slot -- there is no method Value to put there -- and the
- * resolve happens per call against the shared megamorphic table. */
+ * resolve happens per call, through the site's trait vtable once the
+ * interpreter has found one (aux is the site's InlineCache) and against the
+ * shared megamorphic table otherwise. */
 static int jitInvokeByName(JitCallDesc *d) {
     jaiGCPushRootRange(d->roots, (int)d->nroots);
-    bool ok = jaiInvokeMethodByName(AS_STRING(d->callee), d->args,
-                                    (int)d->argc, &d->result);
+    bool ok = jaiInvokeMethodByName(AS_STRING(d->callee),
+                                    (const InlineCache *)(uintptr_t)d->aux,
+                                    d->args, (int)d->argc, &d->result);
     jaiGCPopRootRange();
     return ok ? 0 : 1;
 }
@@ -219,6 +256,29 @@ static int jitBuildList(JitCallDesc *d) {
     return 0;
 }
 
+/* Only for a tuple that escapes: one unpacked where it is built never gets
+ * here (see the OP_BUILD_TUPLE arm). */
+static int jitBuildTuple(JitCallDesc *d) {
+    jaiGCPushRootRange(d->roots, (int)d->nroots);
+    ObjTuple *tuple = jaiTupleNew(d->args, (int)d->argc);
+    d->result = OBJ_VAL(tuple);
+    jaiGCPopRootRange();
+    return 0;
+}
+
+/* A counted loop handed to its block kernel (jit_vec.h): one payload per
+ * plan operand in `words`, the plan in `aux`. Returns how many iterations
+ * ran; a reduction's value comes back in `result`. */
+static int64_t jitVecLoop(JitCallDesc *d) {
+    const JaiVecPlan *plan = (const JaiVecPlan *)(uintptr_t)d->aux;
+    if (plan->kind == JAI_VEC_MAP) return jaiVecRun(plan, d->words, NULL);
+    double acc;
+    memcpy(&acc, &d->words[plan->target], sizeof acc);
+    int64_t ran = jaiVecRun(plan, d->words, &acc);
+    d->result = FLOAT_VAL(acc);
+    return ran;
+}
+
 /* args: start, stop, inclusive-flag. Allocates twice (range + iterator), so roots go down first as usual. */
 static int jitMakeRangeIter(JitCallDesc *d) {
     jaiGCPushRootRange(d->roots, (int)d->nroots);
@@ -286,6 +346,14 @@ static int jitListGrow(ObjList *list, uint64_t tag, int64_t payload) {
     return 0;
 }
 
+/* jaiJitFinishDeopt, widened for the `cmp x0, #0` that tests it. A bool comes
+ * back in the low byte only, and neither ABI promises anything about the rest
+ * of the register: x86-64 compilers routinely leave a `setcc al` result with
+ * garbage above it, which the 64-bit compare would read as success. */
+static int64_t jitFinishDeopt(ObjClosure *closure, Value *out) {
+    return jaiJitFinishDeopt(closure, out) ? 1 : 0;
+}
+
 /* Safe because jaiGCWanted()==false is gc.c's own proof no collection can happen here (collections begin
  * only in jaiGCMaybeCollect), and the object is fully built before being linked in. NULL means "declined": caller falls back to the descriptor path, which roots and may collect. */
 static ObjInstance *jitInstanceAlloc(ObjClass *cls) {
@@ -305,6 +373,7 @@ static ObjInstance *jitInstanceAlloc(ObjClass *cls) {
     obj->isMarked = false;
     obj->subFlag = false;
     obj->subFlag2 = false;
+    obj->gcBits = 0;
 
     inst->klass = cls;
     inst->fieldCount = count;
@@ -312,9 +381,9 @@ static ObjInstance *jitInstanceAlloc(ObjClass *cls) {
  * and an unwritten field is whatever the last occupant of this bin left behind. */
     for (uint16_t i = 0; i < count; ++i) inst->fields[i] = NULL_VAL;
 
-    /* Linked last: a mid-collection isMarked state can't arise here, since a collection in progress makes jaiGCLimit zero and the first line above would already have declined. */
-    obj->next = g->objects;
-    g->objects = obj;
+    /* Linked last, into the young generation as jaiGCTrackObject would: a mid-collection isMarked state can't arise here, since a collection in progress makes jaiGCLimit zero and the first line above would already have declined. */
+    obj->next = g->young;
+    g->young = obj;
 
     vm.allocCount++;
     return inst;
@@ -427,7 +496,7 @@ static bool holdsRegister(SlotKind k) {
 #define FIXUP_BAIL   UINT32_MAX
 #define FIXUP_ENTRY  (UINT32_MAX - 1u)
 #define FIXUP_THREW  (UINT32_MAX - 2u)
-#define FIXUP_OVF    (UINT32_MAX - 3u)   /* minus 0,1,2 for the three operators */
+#define FIXUP_OVF    (UINT32_MAX - 3u)   /* minus 0..3: three operators and `/` */
 #define FIXUP_DEOPT    (UINT32_MAX - 7u)                     /* minus a deopt index */
 #define FIXUP_EXIT     (FIXUP_DEOPT - JIT_MAX_DEOPT)         /* minus an exit index */
 #define FIXUP_SELFSLOW (FIXUP_EXIT - JIT_MAX_EXIT)           /* minus a self-call index */
@@ -551,6 +620,19 @@ typedef struct {
      * a float read through the FP bank costs one `ldr d` plus one `fmov d,x` from an X register, so a flat per-use count would wrongly credit an X register for such a slot. Two banks, two ledgers. */
     uint32_t  slotSaveX[JIT_MAX_SLOTS + 1];
     uint32_t  slotSaveFp[JIT_MAX_SLOTS + 1];
+    /* First and last offset at which each slot's value can be needed (see
+     * slotLiveRanges). Function tier only: an OSR home is the interpreter's
+     * own Value, live for the whole loop by construction, so `liveRanges`
+     * false there means "everything is live everywhere". */
+    bool      liveRanges;
+    uint32_t  slotLiveLo[JIT_MAX_SLOTS + 1];
+    uint32_t  slotLiveHi[JIT_MAX_SLOTS + 1];
+    /* Took its register over from a slot whose range had already ended, so
+     * the prologue must leave it alone: zeroing it there would zero the
+     * earlier owner. */
+    bool      slotInherits[JIT_MAX_SLOTS + 1];
+    unsigned  sharedHomes;   /* slots with slotInherits set */
+    unsigned  frameHomes;    /* earned a register and live in the frame */
     const uint8_t *loopDepth;
     unsigned  loopDepthCount;
     unsigned  fpSaveOffset;
@@ -560,6 +642,8 @@ typedef struct {
      * a call may not fit as an expression; the compile retries with this set when that's what went wrong. */
     bool      noInline;
     bool      inlined;
+    /* Callee bytecode bytes this body has inlined so far; see JIT_INLINE_BUDGET. */
+    unsigned  inlineSpent;
     /* Inlined callee: its locals are operand-stack entries of the CALLER's frame (slots 1..n are the
      * already-present argument entries); nothing is copied, no frame appears -- but the interpreter has no idea, so every guard inside deoptimises to `inlIp` (the caller's OP_CALL) with the model as of `inlDepth`. */
     bool      inlining;
@@ -571,6 +655,12 @@ typedef struct {
      * only meaningful while `inlining`, the only thing that writes it, so a zeroed Emit never reads stale state. */
     int       inlClosureReg;
     int       inlSlot[JIT_MAX_SLOTS + 1];
+    /* The caller's OP_CALL is followed by `UNPACK n` with no rest, so an
+     * inlined body ending in `BUILD_TUPLE n; RETURN` may hand back its n
+     * elements as n entries instead of a tuple -- inlTupleWant is that n, 0
+     * for any other call site, and inlTupleN is set once the body did. */
+    unsigned  inlTupleWant;
+    unsigned  inlTupleN;
     /* A local whose kind differs across paths into some point: lives in the frame with its tag, and every
      * read guards. Not exotic -- the compiler reuses one slot for non-overlapping loop induction variables (nbody's advance). */
     bool      dynamicLocal[JIT_MAX_SLOTS + 1];
@@ -708,8 +798,8 @@ typedef struct {
     uint8_t     lastOp;
     unsigned  descOffset;
     int       exceptionExit;
-    bool      overflowUsed[3];
-    int       overflowStub[3];
+    bool      overflowUsed[4];
+    int       overflowStub[4];
 
     /* One per guard: the bytecode offset to resume at, and a snapshot of the
      * compile-time model there. The stub that writes them is emitted after the
@@ -867,6 +957,13 @@ static bool localTagInFrame(const Emit *e, unsigned slot) {
     return e->dynamicLocal[slot];
 }
 
+/* Whether `slot` can still be needed at `ip`, by the bytecode's live ranges
+ * (see slotLiveRanges); without them, always. */
+static bool slotLiveAt(const Emit *e, unsigned slot, uint32_t ip) {
+    if (!e->liveRanges || slot > JIT_MAX_SLOTS) return true;
+    return ip >= e->slotLiveLo[slot] && ip <= e->slotLiveHi[slot];
+}
+
 /* Per-access instruction savings from giving `slot` a register instead of a frame home, accumulated
  * by the accessors during the measuring pass and weighted by loop nesting. Zero-saving slots are excluded outright, not just ranked last -- otherwise a tie-break could hand a register to a slot the loop never touches, paying a prologue write for nothing.
  *
@@ -1786,6 +1883,86 @@ static void dropCalleeEntry(Emit *e) {
     e->depth--;
 }
 
+/* Reverses the top `n` entries, values and model together: what `UNPACK n`
+ * does to the tuple `BUILD_TUPLE n` made of them, without the tuple. Every
+ * entry is put in its own X register first, so a swap is three `mov`s and
+ * nothing -- a borrow, a pending literal, a float in the bank -- is left
+ * describing a register that now holds the other entry. False, with nothing
+ * emitted, when an entry holds no register to swap. */
+static bool reverseTopEntries(Emit *e, unsigned n) {
+    if (e->depth < n || e->valueDepth < n) return false;
+    for (unsigned i = 0; i < n; i++) {
+        if (!holdsRegister(e->stack[e->depth - 1u - i])) return false;
+    }
+    unsigned dbase = e->depth - n, vbase = e->valueDepth - n;
+    for (unsigned i = 0; i < n; i++) {
+        fpSyncOne(e, vbase + i);
+        settleEntry(e, vbase + i);
+    }
+    for (unsigned i = 0; i < n / 2u; i++) {
+        unsigned a = i, b = n - 1u - i;
+        unsigned ra = valueXReg(e, vbase + a), rb = valueXReg(e, vbase + b);
+        emit(e, jaiA64MovX(JIT_SCRATCH_A, ra));
+        emit(e, jaiA64MovX(ra, rb));
+        emit(e, jaiA64MovX(rb, JIT_SCRATCH_A));
+
+        unsigned da = dbase + a, db = dbase + b;
+        SlotKind  k  = e->stack[da];      e->stack[da] = e->stack[db];           e->stack[db] = k;
+        uint32_t  sh = e->stackShape[da]; e->stackShape[da] = e->stackShape[db]; e->stackShape[db] = sh;
+        ObjClass *cl = e->stackClass[da]; e->stackClass[da] = e->stackClass[db]; e->stackClass[db] = cl;
+        Value     sv = e->stackSeen[da];  e->stackSeen[da] = e->stackSeen[db];   e->stackSeen[db] = sv;
+        int       lc = e->stackLocal[da]; e->stackLocal[da] = e->stackLocal[db]; e->stackLocal[db] = lc;
+        bool      as = e->stackAscii[da]; e->stackAscii[da] = e->stackAscii[db]; e->stackAscii[db] = as;
+
+        unsigned va = vbase + a, vb = vbase + b;
+        bool ka = (e->kKnown >> va) & 1u, kb = (e->kKnown >> vb) & 1u;
+        int64_t kv = e->kKnownVal[va];
+        e->kKnownVal[va] = e->kKnownVal[vb];
+        e->kKnownVal[vb] = kv;
+        e->kKnown &= ~((1u << va) | (1u << vb));
+        if (kb) e->kKnown |= 1u << va;
+        if (ka) e->kKnown |= 1u << vb;
+    }
+    return true;
+}
+
+/* `dst[i] = src[i]` for every i at once: no move may read a register an
+ * earlier one already wrote. A move whose destination nothing still pending
+ * reads goes first; when every pending move is some other's source, they form
+ * a cycle, and parking one source in JIT_SCRATCH_A breaks it. */
+static void emitParallelMove(Emit *e, const unsigned *dst, const unsigned *src0,
+                             unsigned n) {
+    unsigned src[JIT_MAX_STACK];
+    bool done[JIT_MAX_STACK];
+    for (unsigned i = 0; i < n; i++) {
+        src[i] = src0[i];
+        done[i] = dst[i] == src[i];
+    }
+    for (;;) {
+        bool any = false, moved = false;
+        for (unsigned i = 0; i < n; i++) {
+            if (done[i]) continue;
+            any = true;
+            bool read = false;
+            for (unsigned j = 0; j < n && !read; j++) {
+                read = j != i && !done[j] && src[j] == dst[i];
+            }
+            if (read) continue;
+            emit(e, jaiA64MovX(dst[i], src[i]));
+            done[i] = true;
+            moved = true;
+        }
+        if (!any) return;
+        if (moved) continue;
+        for (unsigned i = 0; i < n; i++) {
+            if (done[i]) continue;
+            emit(e, jaiA64MovX(JIT_SCRATCH_A, src[i]));
+            src[i] = JIT_SCRATCH_A;
+            break;
+        }
+    }
+}
+
 /* Depth and the kind of every entry, in one word. Registers are assigned from
  * the depth and instructions are chosen from the kinds, so a join reached with
  * either one different is a join this tier cannot compile. */
@@ -1954,6 +2131,32 @@ static bool jitSplitStress(void) {
     return cached != 0;
 }
 
+/* JAITHON_JIT_NO_INLINE=1 compiles every body as if each of its inlines had
+ * declined: calls stay calls. The tier's answers must not depend on inlining,
+ * so a result that changes under this flag is an inliner bug, and the flag is
+ * how one is bisected. It also withholds the inline-cache pin at OP_INVOKE,
+ * since that guard exists to give the inliner a class to look a method up in. */
+static bool jitNoInline(void) {
+    static int cached = -1;
+    if (cached < 0) {
+        const char *v = getenv("JAITHON_JIT_NO_INLINE");
+        cached = (v != NULL && v[0] != '\0' && strcmp(v, "0") != 0) ? 1 : 0;
+    }
+    return cached != 0;
+}
+
+/* JAITHON_JIT_NO_VEC=1 leaves every counted loop to its scalar body, for the
+ * same reason JAITHON_JIT_NO_INLINE exists: the block kernel must not change
+ * an answer, and this is the flag that shows whether it did. */
+static bool jitNoVec(void) {
+    static int cached = -1;
+    if (cached < 0) {
+        const char *v = getenv("JAITHON_JIT_NO_VEC");
+        cached = (v != NULL && v[0] != '\0' && strcmp(v, "0") != 0) ? 1 : 0;
+    }
+    return cached != 0;
+}
+
 /* Neither an inline's state nor mid-instruction state is the model's actual current state. Inside an
  * inline the interpreter hasn't made the call yet, so it resumes at OP_CALL holding just callee+args, not the inlined body's locals/temporaries. Outside one, a guard mid-instruction (OP_GET_LOCAL2 pushes then guards) leaves the model deeper than the interpreter's stack there -- handing over those extra entries strands them, and a loop can read its own iterator as its loop variable. `instDepth` is the model at the instruction's START, matching the interpreter; only entries THIS instruction pushed (the topmost) may be trimmed back to it -- an instruction that already popped something the interpreter still holds cannot be repaired and is refused. */
 static bool deoptSite(Emit *e, uint32_t ip, uint32_t *ipOut,
@@ -2300,6 +2503,22 @@ static int hoistFor(const Emit *e, int slot) {
  * range", not "to the head", because the head is only the entrance a
  * structured loop is supposed to have -- this is what makes that a checked
  * fact rather than an assumption about the emitter. */
+/* Whether the OP_SWITCH at `at` (`len` bytes) sends an arm into [lo, hi).
+ * Its default is the ordinary branch operand; its arms are only in the
+ * table, so every scan for "what can branch here" has to ask this too. */
+static bool switchArmEnters(const Chunk *c, int at, int len, int32_t lo,
+                            int32_t hi) {
+    if (jaiOpGeneric(c->code[at]) != OP_SWITCH) return false;
+    Value table = c->constants.data[jaiReadU24(c->code + at + 1)];
+    JaiSwitchCase arm;
+    for (int i = 0; i < jaiSwitchSize(table); i++) {
+        if (!jaiSwitchCaseAt(table, i, &arm)) continue;
+        int32_t to = (int32_t)(at + len) + arm.rel;
+        if (to >= lo && to < hi) return true;
+    }
+    return false;
+}
+
 static bool onlyBackEdgesEnter(const Chunk *c, uint32_t top, uint32_t end) {
     for (int at = 0; at < c->count;) {
         int len = instructionLength(c, at);
@@ -2311,6 +2530,9 @@ static bool onlyBackEdgesEnter(const Chunk *c, uint32_t top, uint32_t end) {
                          jaiReadI16(c->code + at + 1 + rel);
             if (to >= (int32_t)top && to < (int32_t)end) return false;
         }
+        if (switchArmEnters(c, at, len, (int32_t)top, (int32_t)end)) {
+            return false;
+        }
         at += len;
     }
     return true;
@@ -2534,6 +2756,205 @@ static bool negatedCondition(uint8_t cmp, unsigned *out) {
     }
 }
 
+/* ------------------------------------------------------------------ */
+/* Compiling on the compiler thread                                     */
+/* ------------------------------------------------------------------ */
+
+/* A body compiled but not yet placed: the host's machine code and everything
+ * the entry guard will need to know about it. The compile writes one of these
+ * and installBuilt applies it, which is what lets the compiler thread produce
+ * a body without touching the code heap or the function it is for. */
+typedef struct {
+    uint8_t  *code;       /* malloc'd, entered at byte 0 */
+    size_t    length;
+    uint8_t   paramKind[JIT_MAX_ARITY];
+    uint32_t  paramShape[JIT_MAX_ARITY];
+    uint8_t   argBase;
+    uint8_t   argCount;
+    uint8_t   returnKind;
+    uint32_t  returnShape;
+    ObjClass *returnClass;   /* remembered by shape once installed, or NULL */
+    bool      noWrite;
+    JaiJitLine *lines;       /* malloc'd, for jaiJitPerfNote; usually NULL */
+    unsigned    lineCount;
+} JitBuilt;
+
+/* What the compiler thread was given to look at in place of the heap.
+ *
+ * The tier specialises on LIVE values -- a field's kind is read off the
+ * receiver the call arrived with, a list's element kind off its first element
+ * -- and on the interpreter's thread that costs nothing. On the compiler
+ * thread it is a race the interpreter is free to lose at any moment: a store
+ * to a field is two stores, tag and payload, and a read between them is an
+ * object tag over an integer. So the compiler thread reads no container the
+ * interpreter can write. It reads copies, taken on the interpreter's thread:
+ * the arguments and what they hold at job creation, and anything else the
+ * compile turns out to want on the next round (jobWant). A builtin method is
+ * the same story for a different reason -- resolving one allocates the bound
+ * wrapper -- so the native is looked up for it in the same way. */
+typedef struct {
+    const Obj *obj;        /* the container copied; NULL for a builtin */
+    int        type;       /* a builtin's receiver type, see receiverType */
+    ObjString *name;       /* a builtin's name */
+    int32_t    count;      /* a list's or dict's length at the copy */
+    uint16_t   valueCount;
+    Value     *values;     /* malloc'd: an instance's fields, a list's head, a
+                            * dict's first live key and value, a closure's
+                            * upvalues, or a builtin's native */
+} JitSample;
+
+/* More than this many missing samples in one round and the rest wait for the
+ * next; past JIT_JOB_ROUNDS the function is compiled on the interpreter's
+ * thread instead, where nothing has to be copied. Each round is a whole
+ * compile, so the budget is what bounds the thread's wasted work. */
+#define JIT_JOB_WANTS  8u
+#define JIT_JOB_ROUNDS 4u
+
+struct JaiJitJob {
+    ObjClosure *closure;
+    /* Taken when the job was made. Anything the compile resolves is at least
+     * this new, so pinning the installed form to it can only retire the form
+     * early, never let it outlive a rebinding. */
+    uint32_t    moduleVersion;
+    /* The interpreter's stack bound, which the body bakes in -- stackLimit()
+     * on the compiler thread would answer for the wrong stack. */
+    uintptr_t   stackLimit;
+    ObjString  *strName;      /* "str", interned where interning may allocate */
+    Value       args[JIT_MAX_ARITY + 1];
+    int        *chunkDepth;   /* malloc'd; the verifier runs on this thread */
+    JitSample  *samples;
+    unsigned    sampleCount;
+    unsigned    sampleCapacity;
+    Value       want[JIT_JOB_WANTS];
+    int         wantType[JIT_JOB_WANTS];
+    ObjString  *wantName[JIT_JOB_WANTS];
+    unsigned    wantCount;
+    bool        missed;       /* the last round stopped for want of a sample */
+    unsigned    rounds;
+    bool        compiled;
+    JitBuilt    built;
+};
+
+/* The job being compiled, or NULL when the compile is running on the
+ * interpreter's thread and may read the heap directly. A file static for the
+ * reason the Emit buffers are: one compile at a time, and jaiJitHold is what
+ * makes that so across the two threads. */
+static JaiJitJob *gJob;
+
+/* A builtin depends on the receiver's type, never on what it holds, so that is
+ * the key: value types below 16, object types above. */
+static int receiverType(Value v) {
+    return IS_OBJ(v) ? 16 + (int)OBJ_TYPE(v) : (int)jaiValueType(v);
+}
+
+static const JitSample *jobSample(const Obj *obj, int type, ObjString *name) {
+    for (unsigned i = 0; i < gJob->sampleCount; i++) {
+        const JitSample *s = &gJob->samples[i];
+        if (s->obj == obj && s->name == name && (obj != NULL || s->type == type)) {
+            return s;
+        }
+    }
+    return NULL;
+}
+
+/* Asks for a sample on the next round. The compile that wanted it fails, so
+ * every caller treats a miss exactly as it treats a container with nothing in
+ * it. */
+static void jobWant(Value receiver, int type, ObjString *name) {
+    gJob->missed = true;
+    for (unsigned i = 0; i < gJob->wantCount; i++) {
+        if (gJob->wantName[i] != name || gJob->wantType[i] != type) continue;
+        /* A builtin is keyed by type alone; anything else by its object. */
+        if (type > 0 || (IS_OBJ(gJob->want[i]) && IS_OBJ(receiver) &&
+                         AS_OBJ(gJob->want[i]) == AS_OBJ(receiver))) {
+            return;
+        }
+    }
+    if (gJob->wantCount >= JIT_JOB_WANTS) return;
+    gJob->want[gJob->wantCount]     = receiver;
+    gJob->wantType[gJob->wantCount] = type;
+    gJob->wantName[gJob->wantCount] = name;
+    gJob->wantCount++;
+}
+
+static bool sampleField(ObjInstance *inst, unsigned slot, Value *out) {
+    if (slot >= inst->fieldCount) return false;
+    if (gJob == NULL) { *out = inst->fields[slot]; return true; }
+    const JitSample *s = jobSample(&inst->obj, 0, NULL);
+    if (s == NULL) { jobWant(OBJ_VAL(inst), 0, NULL); return false; }
+    if (slot >= s->valueCount) return false;
+    *out = s->values[slot];
+    return true;
+}
+
+/* items[0], or false for an empty list. */
+static bool sampleListHead(ObjList *list, Value *out) {
+    if (gJob == NULL) {
+        if (list->count <= 0) return false;
+        *out = list->items[0];
+        return true;
+    }
+    const JitSample *s = jobSample(&list->obj, 0, NULL);
+    if (s == NULL) { jobWant(OBJ_VAL(list), 0, NULL); return false; }
+    if (s->count <= 0 || s->valueCount < 1) return false;
+    *out = s->values[0];
+    return true;
+}
+
+static bool firstLiveEntry(const JaiTable *t, Value *key, Value *value);
+
+static bool sampleDictHead(ObjDict *dict, Value *key, Value *value) {
+    if (gJob == NULL) return firstLiveEntry(&dict->table, key, value);
+    const JitSample *s = jobSample(&dict->obj, 0, NULL);
+    if (s == NULL) { jobWant(OBJ_VAL(dict), 0, NULL); return false; }
+    if (s->valueCount < 2) return false;
+    *key   = s->values[0];
+    *value = s->values[1];
+    return true;
+}
+
+/* An upvalue may still be open, pointing into the interpreter's stack, which is
+ * the most mutable memory there is. */
+static bool sampleUpvalue(ObjClosure *cl, unsigned index, Value *out) {
+    if (index >= (unsigned)cl->upvalueCount) return false;
+    if (gJob == NULL) {
+        if (cl->upvalues[index] == NULL) return false;
+        *out = *cl->upvalues[index]->location;
+        return true;
+    }
+    const JitSample *s = jobSample(&cl->obj, 0, NULL);
+    if (s == NULL) { jobWant(OBJ_VAL(cl), 0, NULL); return false; }
+    if (index >= s->valueCount) return false;
+    *out = s->values[index];
+    return true;
+}
+
+/* A module global's value. The key set only changes under jaiJitHold, but a
+ * value can be overwritten at any moment -- by compiled code too, which takes
+ * no lock -- and a Value is two words. */
+static bool sampleGlobal(ObjModule *m, ObjString *name, Value *out) {
+    if (gJob == NULL) return jaiModuleGet(m, name, out);
+    const JitSample *s = jobSample(&m->obj, 0, name);
+    if (s == NULL) { jobWant(OBJ_VAL(m), 0, name); return false; }
+    if (s->valueCount < 1) return false;
+    *out = s->values[0];
+    return true;
+}
+
+/* jaiBuiltinMethod, for a compile that may not allocate. `receiver` is what
+ * the interpreter's thread resolves against when it fills the want; NULL_VAL
+ * asks it to make one of `type`. The answer is the native itself, which every
+ * caller unwraps a bound method to anyway. */
+static bool sampleBuiltin(Value receiver, int type, ObjString *name,
+                          Value *out) {
+    if (gJob == NULL) return jaiBuiltinMethod(receiver, name, out);
+    const JitSample *s = jobSample(NULL, type, name);
+    if (s == NULL) { jobWant(receiver, type, name); return false; }
+    if (s->valueCount < 1) return false;
+    *out = s->values[0];
+    return true;
+}
+
 static ObjClass *globalClass(ObjClosure *closure, uint32_t nameIdx) {
     ObjFunction *fn = closure->fn;
     if (fn->module == NULL) return NULL;
@@ -2541,7 +2962,7 @@ static ObjClass *globalClass(ObjClosure *closure, uint32_t nameIdx) {
     Value name = fn->chunk.constants.data[nameIdx];
     if (!IS_STRING(name)) return NULL;
     Value bound;
-    if (!jaiModuleGet(fn->module, AS_STRING(name), &bound)) return NULL;
+    if (!sampleGlobal(fn->module, AS_STRING(name), &bound)) return NULL;
     return IS_CLASS(bound) ? AS_CLASS(bound) : NULL;
 }
 
@@ -2570,7 +2991,7 @@ static ObjFunction *globalFunction(ObjClosure *closure, uint32_t nameIdx,
     Value name = fn->chunk.constants.data[nameIdx];
     if (!IS_STRING(name)) return NULL;
     Value bound;
-    if (!jaiModuleGet(fn->module, AS_STRING(name), &bound)) return NULL;
+    if (!sampleGlobal(fn->module, AS_STRING(name), &bound)) return NULL;
     if (!IS_CLOSURE(bound)) return NULL;
     *out = bound;
     return AS_CLOSURE(bound)->fn;
@@ -2585,10 +3006,12 @@ static ObjNative *globalNative(ObjClosure *closure, uint32_t nameIdx,
     if (nameIdx >= (uint32_t)fn->chunk.constants.count) return NULL;
     Value name = fn->chunk.constants.data[nameIdx];
     if (!IS_STRING(name)) return NULL;
-    Value shadow;
-    if (jaiModuleGet(fn->module, AS_STRING(name), &shadow)) return NULL;
+    if (jaiTableFindEntryInterned(&fn->module->globals, AS_STRING(name)) !=
+        NULL) {
+        return NULL;
+    }
     Value bound;
-    if (!jaiModuleGet(vm.builtins, AS_STRING(name), &bound)) return NULL;
+    if (!sampleGlobal(vm.builtins, AS_STRING(name), &bound)) return NULL;
     if (!IS_NATIVE(bound)) return NULL;
     *out = bound;
     return AS_NATIVE(bound);
@@ -2602,7 +3025,7 @@ static bool globalIsSelf(ObjClosure *closure, uint32_t nameIdx) {
     if (!IS_STRING(name)) return false;
 
     Value bound;
-    if (!jaiModuleGet(fn->module, AS_STRING(name), &bound)) return false;
+    if (!sampleGlobal(fn->module, AS_STRING(name), &bound)) return false;
     return IS_CLOSURE(bound) && AS_CLOSURE(bound)->fn == fn;
 }
 
@@ -2629,7 +3052,9 @@ static JaiEntry *globalSlot(Emit *e, ObjClosure *closure, uint32_t nameIdx,
     } else if (e->globalsTable != t) {
         return NULL;
     }
-    if (out != NULL) *out = slot->value;
+    if (out != NULL && !sampleGlobal(fn->module, AS_STRING(name), out)) {
+        return NULL;
+    }
     return slot;
 }
 
@@ -2684,6 +3109,59 @@ static bool feedbackSlotKind(uint8_t fb, SlotKind *k, unsigned *tag) {
     return true;
 }
 
+/* jaiGCBarrier for an object just stored into `rOwner`, inline and without a
+ * call. The common case -- a young owner, which every object being filled in
+ * right after it was made is -- is a load and a branch. An old one is pushed
+ * onto the remembered set here rather than by jaiGCRemember, because a call
+ * would clobber x0..x8 (see noteScratchClobber) at every store that might need
+ * one; so where C code would grow a full array this only sets `overflow`,
+ * which makes the next collection a full one. The stored value is not looked
+ * at: an old owner is remembered whatever it was given, and the next minor
+ * collection drops it again if nothing it holds is young.
+ *
+ * Spends JIT_SCRATCH_B..D; `rOwner` may be JIT_SCRATCH_A or any register the
+ * body owns. Sets the flags. */
+static void emitWriteBarrier(Emit *e, unsigned rOwner) {
+    const unsigned base = JIT_SCRATCH_B, n = JIT_SCRATCH_C, t = JIT_SCRATCH_D;
+    unsigned young, seen, full, done;
+
+    emit(e, jaiA64LdrByte(t, rOwner, (unsigned)offsetof(Obj, isMarked)));
+    emit(e, jaiA64SubsXImm(31, t, 0));
+    young = e->count;
+    emit(e, jaiA64BCond(JAI_A64_EQ, 0));
+    emit(e, jaiA64LdrByte(t, rOwner, (unsigned)offsetof(Obj, gcBits)));
+    seen = e->count;
+    emit(e, jaiA64Tbnz(t, 7u, 0));
+    emitConst64(e, base, (int64_t)(uintptr_t)&jaiGCRemembered);
+    emit(e, jaiA64LdrW(n, base, (unsigned)offsetof(JaiGCRememberedSet, count)));
+    emit(e, jaiA64LdrW(t, base,
+                       (unsigned)offsetof(JaiGCRememberedSet, capacity)));
+    emit(e, jaiA64SubsXReg(31, n, t));
+    full = e->count;
+    emit(e, jaiA64BCond(JAI_A64_HS, 0));
+    /* Bit 7 is clear (the tbnz above), so adding it sets it. */
+    emit(e, jaiA64LdrByte(t, rOwner, (unsigned)offsetof(Obj, gcBits)));
+    emit(e, jaiA64AddXImm(t, t, JAI_GC_REMEMBERED));
+    emit(e, jaiA64StrByte(t, rOwner, (unsigned)offsetof(Obj, gcBits)));
+    emit(e, jaiA64LdrX(t, base, (unsigned)offsetof(JaiGCRememberedSet, items)));
+    emit(e, jaiA64AddXLsl(t, t, n, 3));
+    emit(e, jaiA64StrX(rOwner, t, 0));
+    emit(e, jaiA64AddXImm(n, n, 1));
+    emit(e, jaiA64StrW(n, base, (unsigned)offsetof(JaiGCRememberedSet, count)));
+    done = e->count;
+    emit(e, jaiA64B(0));
+    if (full < JIT_MAX_INSTS && e->count > full) {
+        e->code[full] = jaiA64BCond(JAI_A64_HS, (int32_t)(e->count - full));
+    }
+    emit(e, jaiA64MovzX(t, 1, 0));
+    emit(e, jaiA64StrByte(t, base,
+                          (unsigned)offsetof(JaiGCRememberedSet, overflow)));
+    if (e->count >= JIT_MAX_INSTS) return;   /* e->failed is already set */
+    e->code[young] = jaiA64BCond(JAI_A64_EQ, (int32_t)(e->count - young));
+    e->code[seen] = jaiA64Tbnz(t, 7u, (int32_t)(e->count - seen));
+    e->code[done] = jaiA64B((int32_t)(e->count - done));
+}
+
 /* The store half of `list.push` and of a comprehension's append: they differ
  * only in where the list sits on the stack and in what is left behind, so the
  * bounds check, the grow fixup and the two stores live here. Returns false
@@ -2748,6 +3226,7 @@ static bool emitListStore(Emit *e, SlotKind vk, unsigned rList, unsigned rVal) {
     emit(e, jaiA64AddXImm(JIT_SCRATCH_A, JIT_SCRATCH_A, 1));
     emit(e, jaiA64StrW(JIT_SCRATCH_A, rList,
                        (unsigned)offsetof(ObjList, version)));
+    if (vtag == VAL_OBJ) emitWriteBarrier(e, rList);
     e->wroteHeap = true;
     return true;
 }
@@ -2779,6 +3258,47 @@ static bool siteInvokeResultKind(const Chunk *chunk, uint16_t cacheIdx,
     return feedbackSlotKind(merged, k, tag);
 }
 
+/* An instance receiver the model could not pin, at an OP_INVOKE site whose
+ * inline cache has only ever seen one class: guards that class and pins it,
+ * so the rest of the arm resolves the method now and can inline it or call
+ * its compiled entry -- exactly what it does for a receiver the model knew.
+ * The guard runs before anything the call does, so a miss deopts to the
+ * OP_INVOKE itself and the interpreter makes the call. A site that has seen
+ * two classes is left alone: one of them would deopt every time it came.
+ *
+ * Pinned only after the guard is emitted, so the guard's own deopt record
+ * still describes the receiver as unpinned. A sample of another class is
+ * dropped rather than kept: a field kind read off it would be a guess about
+ * a different layout. */
+static unsigned valueIndexOf(const Emit *e, unsigned idx);
+
+static void pinMonomorphicReceiver(Emit *e, const Chunk *chunk, unsigned ridx,
+                                   uint16_t cacheIdx) {
+    if (chunk->caches == NULL || (int)cacheIdx >= chunk->cacheCount) return;
+    const InlineCache *ic = &chunk->caches[cacheIdx];
+    if (ic->state != IC_MONO || ic->count != 1) return;
+    uint32_t shape = ic->shapeId[0];
+    ObjClass *cls = NULL;
+    if (shape == 0 || !jaiClassForShape(shape, &cls) || cls == NULL) return;
+    unsigned r = valueXReg(e, valueIndexOf(e, ridx));
+    emit(e, jaiA64LdrX(JIT_SCRATCH_A, r, (unsigned)offsetof(ObjInstance, klass)));
+    emit(e, jaiA64LdrW(JIT_SCRATCH_A, JIT_SCRATCH_A,
+                       (unsigned)offsetof(ObjClass, shapeId)));
+    emitConst64(e, JIT_SCRATCH_B, (int64_t)shape);
+    emit(e, jaiA64SubsXReg(31, JIT_SCRATCH_A, JIT_SCRATCH_B));
+    branchOnDeopt(e, JAI_A64_NE);
+    e->stackClass[ridx] = cls;
+    e->stackShape[ridx] = shape;
+    Value seen = e->stackSeen[ridx];
+    if (!IS_INSTANCE(seen) || AS_INSTANCE(seen)->klass != cls) {
+        e->stackSeen[ridx] = NULL_VAL;
+    }
+    if (getenv("JAI_JIT_WHY")) {
+        fprintf(stderr, "[jit] receiver pinned to %s by its inline cache\n",
+                cls->name ? cls->name->chars : "?");
+    }
+}
+
 /* The same test feedbackSlotKind applies to a call's result, as a predicate on a Value: is this a heap
  * object with no stack kind of its own, so SLOT_OBJ's "read, pass, store, root and nothing else" describes it exactly? Excludes the kinds a later arm resolves to a register-free entry (class/closure/native/...), which SLOT_OBJ would silently outrank. */
 static bool rawObjValue(Value v) {
@@ -2886,6 +3406,7 @@ static bool adoptLocalKindSeen(Emit *e, unsigned slot, SlotKind kind,
  * path (the emitted code links the descriptor onto the collector's frame chain instead, since a bare `bl` pushes nothing). */
 static bool emitRootFill(Emit *e, unsigned d, unsigned *nrootsOut) {
     unsigned nroots = 0;
+    uint32_t here = e->inlining ? e->inlIp : e->curOffset;
     for (unsigned slot = e->base; slot < e->base + e->locals; slot++) {
         if (e->localKind[slot] != SLOT_INST &&
             e->localKind[slot] != SLOT_LIST &&
@@ -2894,6 +3415,10 @@ static bool emitRootFill(Emit *e, unsigned d, unsigned *nrootsOut) {
             e->localKind[slot] != SLOT_MAYBE_INST) {
             continue;
         }
+        /* A local nothing will read again is not a root: what it points to may
+         * go, and the deopt stub leaves such a slot to the frame's own copy
+         * rather than hand back the pointer left in its home (slotLiveAt). */
+        if (!slotLiveAt(e, slot, here)) continue;
         if (nroots >= JIT_MAX_SAVED) { e->whyNot = "too many roots"; return false; }
         unsigned at = d + (unsigned)offsetof(JitCallDesc, roots) +
                       nroots * (unsigned)sizeof(Value);
@@ -3110,7 +3635,7 @@ static void emitSelfSlowStubs(Emit *e, ObjClosure *closure) {
                                                    ? e->selfSlow[si].callee
                                                    : closure));
         emit(e, jaiA64AddXImm(1, 31, resultAt));
-        emitConst64(e, JIT_SCRATCH_D, (int64_t)(uintptr_t)&jaiJitFinishDeopt);
+        emitConst64(e, JIT_SCRATCH_D, (int64_t)(uintptr_t)&jitFinishDeopt);
         emit(e, jaiA64Blr(JIT_SCRATCH_D));
         if (e->selfSlow[si].roots > 0) {
             emitConst64(e, JIT_SCRATCH_A, (int64_t)(uintptr_t)&gJitFrames);
@@ -3452,6 +3977,9 @@ static bool offsetIsBranchTarget(const Chunk *c, uint32_t off) {
              * instruction, which is what `at + len` is. */
             if ((int32_t)(at + len) + jump == (int32_t)off) return true;
         }
+        if (switchArmEnters(c, at, len, (int32_t)off, (int32_t)off + 1)) {
+            return true;
+        }
         at += len;
     }
     return false;
@@ -3515,6 +4043,23 @@ static bool powerOfTwoShift(int64_t k, unsigned *shift) {
     return true;
 }
 
+/* `rd = rx % k` with Jaithon's floor rule, for a literal k > 0: the low bits
+ * for a power of two, else sdiv/msub and the one-bit fixup a positive divisor
+ * needs. Neither the zero nor the -1 check applies, so nothing here guards. */
+static void emitModByLiteral(Emit *e, unsigned rd, unsigned rx, int64_t k) {
+    unsigned kshift;
+    if (powerOfTwoShift(k, &kshift)) {
+        if (kshift == 0) emitConst64(e, rd, 0);
+        else emit(e, jaiA64AndXOnes(rd, rx, kshift));
+        return;
+    }
+    emitConst64(e, JIT_SCRATCH_A, k);
+    emit(e, jaiA64SdivX(JIT_SCRATCH_B, rx, JIT_SCRATCH_A));
+    emit(e, jaiA64MsubX(rd, JIT_SCRATCH_B, JIT_SCRATCH_A, rx));
+    emitFloorFixup(e, rd, JIT_SCRATCH_A, true, k,
+                   jaiA64AddX(rd, rd, JIT_SCRATCH_A));
+}
+
 /* Something inside an inlined body could not be emitted, so the whole compile
  * is worth retrying with inlining off rather than declining: the same call
  * through the descriptor still compiles, and a compiled form with a real call
@@ -3522,9 +4067,30 @@ static bool powerOfTwoShift(int64_t k, unsigned *shift) {
  * are -- compilation is not reentrant, nothing it calls compiles anything. */
 static bool gInlineFailed;
 
+/* Callee bytecode, in bytes, one compiled body may take in by inlining, over
+ * all of its call sites together. Each inline is small on its own -- the
+ * walkers below refuse anything with a branch in it -- but a loop that calls
+ * a dozen of them inlines a dozen, and every one widens the live range of its
+ * operands and adds guards whose deopt records the body has to carry. Past
+ * this the call is the better trade. Both compiles of a body (the measuring
+ * pass and the real one) walk the same sites in the same order, so they spend
+ * it identically. */
+#define JIT_INLINE_BUDGET 512u
+
+static bool inlineWithinBudget(Emit *e, const ObjFunction *cfn) {
+    if (e->inlineSpent + (unsigned)cfn->chunk.count <= JIT_INLINE_BUDGET) {
+        return true;
+    }
+    if (getenv("JAI_JIT_WHY")) {
+        fprintf(stderr, "[jit] inline budget spent (%u bytes), calling %s\n",
+                e->inlineSpent, cfn->name ? cfn->name->chars : "<anon>");
+    }
+    return false;
+}
+
 /* Structural check, answered before anything is emitted (a half-inlined body can't be taken back):
  * no branches (no offset map, no join, no fixup naming a callee offset in the caller's table); exactly one RETURN, last; locals only via the four opcodes the inline frame understands, and only slots this callee actually has; globals only for the two builtins the tier emits inline (else a global VALUE load would bake a JaiEntry from the callee's own table, needing its own guard); nothing that stores (a guard inside re-executes the WHOLE call, so an earlier store would run twice). What's left is straight-line register arithmetic -- the main walker already speaks it, so no second emitter is needed. `evalA` in spectral is fifteen instructions of exactly this shape. */
-static bool inlinableBody(ObjClosure *callee, unsigned argc,
+static bool inlinableBody(ObjClosure *callee, unsigned argc, unsigned tupleWant,
                           unsigned *maxSlotOut, bool *readsUpvalueOut) {
     ObjFunction *cfn = callee->fn;
     const Chunk *c = &cfn->chunk;
@@ -3536,7 +4102,7 @@ static bool inlinableBody(ObjClosure *callee, unsigned argc,
     bool sawReturn = false;
     bool readsUpvalue = false;
     for (int off = 0; off < c->count;) {
-        uint8_t op = c->code[off];
+        uint8_t op = jaiOpGeneric(c->code[off]);
         int len = instructionLength(c, off);
         if (len <= 0) return false;
         unsigned slot = 0, slot2 = 0;
@@ -3589,6 +4155,16 @@ static bool inlinableBody(ObjClosure *callee, unsigned argc,
         case OP_SHL: case OP_SHR: case OP_BNOT:
         case OP_TYPE_GUARD:
             break;
+        /* Only as the thing returned, to a caller that unpacks exactly that
+         * many (`tupleWant`): then the tuple is never built at all. */
+        case OP_BUILD_TUPLE:
+            if (tupleWant == 0 || jaiReadU16(c->code + off + 1) != tupleWant) {
+                return false;
+            }
+            if (off + len >= c->count || c->code[off + len] != OP_RETURN) {
+                return false;
+            }
+            break;
         case OP_RETURN:
             if (off + len != c->count) return false;
             sawReturn = true;
@@ -3605,6 +4181,51 @@ static bool inlinableBody(ObjClosure *callee, unsigned argc,
     return true;
 }
 
+/* inlineGlobalCall's ending for a body that returned the n elements of a
+ * tuple (e->inlTupleN) to a caller about to unpack them: they become n
+ * entries, element 0 on top as UNPACK would leave it, and inlTupleN stays set
+ * to tell the call site its UNPACK has been done too. Every element is in an
+ * X register (the inline OP_RETURN synced them), and the caller's homes for
+ * them may be those same registers in another order, hence the parallel
+ * move. */
+static bool inlineTupleResult(Emit *e, ObjFunction *cfn, unsigned cidx,
+                              const int *savedSlot) {
+    unsigned n = e->inlTupleN;
+    if (e->depth < cidx + n) { e->failed = true; return false; }
+    SlotKind  kind[JIT_MAX_STACK];
+    uint32_t  shape[JIT_MAX_STACK];
+    ObjClass *klass[JIT_MAX_STACK];
+    unsigned  src[JIT_MAX_STACK], dst[JIT_MAX_STACK];
+    /* Popped top first, so index i is element n-1-i. */
+    for (unsigned i = 0; i < n; i++) {
+        shape[i] = e->stackShape[e->depth - 1];
+        klass[i] = e->stackClass[e->depth - 1];
+        if (!popValueRaw(e, &src[i], &kind[i])) { e->failed = true; return false; }
+    }
+    while (e->depth > cidx) {
+        if (holdsRegister(e->stack[e->depth - 1])) {
+            unsigned r;
+            if (!popValueRaw(e, &r, NULL)) { e->failed = true; return false; }
+        } else {
+            e->depth--;
+        }
+    }
+    e->inlining = false;
+    memcpy(e->inlSlot, savedSlot, sizeof e->inlSlot);
+
+    for (unsigned i = 0; i < n; i++) {
+        if (!pushValue(e, kind[i], shape[i], klass[i])) {
+            e->failed = true;
+            return false;
+        }
+        dst[i] = pushReg(e) - 1;
+    }
+    emitParallelMove(e, dst, src, n);
+    e->inlineSpent += (unsigned)cfn->chunk.count;
+    e->inlined = true;
+    return true;
+}
+
 /* Inlines the callee's body: slot 1+i IS entry cidx+1+i already on the stack, so nothing is copied in;
  * a bound slot pins one more entry underneath what's pushed after it, sound only because the body is straight-line. Callee's module must be the caller's, and its baked builtins are retired by the CALLER's own module-version check (the callee's is never run). `calleeReg`: needed only if the body reads an upvalue, since `callee` is a SAMPLE closure at an indirect site -- one ObjFunction, many closures (`|x| x + step`), so its captured cells aren't necessarily the next call's. Constants/globals are safe from the sample since they belong to the function/module, not the closure. */
 static bool inlineGlobalCall(Emit *e, ObjFunction *caller, ObjClosure *callee,
@@ -3627,8 +4248,22 @@ static bool inlineGlobalCall(Emit *e, ObjFunction *caller, ObjClosure *callee,
     unsigned cidx = e->depth - argc - 1;
     unsigned maxSlot = 0;
     bool readsUpvalue = false;
-    if (!inlinableBody(callee, argc, &maxSlot, &readsUpvalue)) return false;
+    /* `let (q, r) = f(x)`: the call is followed by UNPACK with no rest, and
+     * nothing else reaches that UNPACK, so the body may return the elements
+     * themselves rather than a tuple made to be taken apart again. */
+    const Chunk *cc = &caller->chunk;
+    uint32_t unpackAt = callOff + 2u;
+    unsigned tupleWant = 0;
+    if ((int)unpackAt + 3 <= cc->count && cc->code[unpackAt] == OP_UNPACK &&
+        cc->code[unpackAt + 2] == 255 && cc->code[unpackAt + 1] >= 1 &&
+        !offsetIsBranchTarget(cc, unpackAt)) {
+        tupleWant = cc->code[unpackAt + 1];
+    }
+    if (!inlinableBody(callee, argc, tupleWant, &maxSlot, &readsUpvalue)) {
+        return false;
+    }
     if (readsUpvalue && calleeReg < 0) return false;
+    if (!inlineWithinBudget(e, cfn)) return false;
     if (getenv("JAI_JIT_WHY")) {
         fprintf(stderr, "[jit] inlining %s\n",
                 cfn->name ? cfn->name->chars : "<anon>");
@@ -3658,6 +4293,8 @@ static bool inlineGlobalCall(Emit *e, ObjFunction *caller, ObjClosure *callee,
     e->inlValueBase = e->valueDepth;
     e->inlIp        = callOff;
     e->inlClosureReg = calleeReg;
+    e->inlTupleWant = tupleWant;
+    e->inlTupleN    = 0;
 
     /* The callee's own offset map, so its offsets cannot land in the
      * caller's. Nothing reads it back -- there are no branches -- but
@@ -3680,6 +4317,7 @@ static bool inlineGlobalCall(Emit *e, ObjFunction *caller, ObjClosure *callee,
     e->curOffset = savedCurOffset;
     e->instDepth = savedInstDepth;
     e->instValueDepth = savedInstValue;
+    e->inlTupleWant = 0;
 
     if (!ok || e->failed) {
         /* Instructions have been written; there is no taking them back. The
@@ -3692,6 +4330,8 @@ static bool inlineGlobalCall(Emit *e, ObjFunction *caller, ObjClosure *callee,
         return false;
     }
 
+    if (e->inlTupleN > 0) return inlineTupleResult(e, cfn, cidx, savedSlot);
+
     /* OP_RETURN left the result on top and everything the body pinned beneath
      * it. Both are read while `inlining` is still set, because that is what
      * says which bank they are in; only the result's new home belongs to the
@@ -3733,10 +4373,19 @@ static bool inlineGlobalCall(Emit *e, ObjFunction *caller, ObjClosure *callee,
         unsigned dst = pushReg(e) - 1;
         if (dst != rres) emit(e, jaiA64MovX(dst, rres));
     }
+    e->inlineSpent += (unsigned)cfn->chunk.count;
     e->inlined = true;
     return true;
 }
 
+/* How far an inlined OP_CALL moves the walk: past the call, and past the
+ * UNPACK after it too when inlineTupleResult already did that one. */
+static int inlinedCallLength(Emit *e) {
+    int len = e->inlTupleN > 0 ? 5 : 2;
+    e->inlTupleN = 0;
+    return len;
+}
+
 /* A call to a global function that has itself compiled. Its return kind types
  * the result; the tag that actually comes back is checked, and a surprise
  * deopts to the instruction after the call, since the call has happened. */
@@ -3849,8 +4498,10 @@ static bool emitGlobalCall(Emit *e, ObjFunction *caller, unsigned argc,
 
 /* Emit a method's body directly, when that body is one expression.
  *
- * Deliberately narrow: no jumps, no stores, no calls, only field reads of its
- * own parameters and int or float arithmetic. Those restrictions are what make
+ * Deliberately narrow: no jumps, no stores, no calls, only reads of its own
+ * parameters and of their fields, literals, and int or float arithmetic --
+ * which covers a getter, `Vec2.dot`, and every `apply` in poly_dispatch
+ * (`(x + self.k) % M`, with M a literal). Those restrictions are what make
  * a second walker over the callee's bytecode safe to write -- with no branches
  * there is no offset map to keep, and with no stores there is nothing to undo
  * if a guard inside it deoptimises to the call site.
@@ -3877,6 +4528,7 @@ static bool inlineMethodWalk(Emit *e, ObjClosure *closure, uint32_t nameIdx,
     if (mfn->flags & (FN_VARIADIC | FN_KWREST | FN_INIT)) return false;
     if (mfn->upvalueCount != 0) return false;
     if (mfn->chunk.count > 96) return false;
+    if (!inlineWithinBudget(e, mfn)) return false;
 
     unsigned inReg[JIT_MAX_ARGS_OUT + 1];
     Value    inSeen[JIT_MAX_ARGS_OUT + 1];
@@ -3895,8 +4547,129 @@ static bool inlineMethodWalk(Emit *e, ObjClosure *closure, uint32_t nameIdx,
     int n = mfn->chunk.count;
     for (int pass = 0; pass < 2; pass++) {
         int depth0 = (int)e->depth;
+        /* Whether the top entry is an int literal the walk just pushed, and
+         * which: a modulus by a positive literal needs neither the zero nor
+         * the -1 check, and the floor fixup shrinks to one bit test. */
+        bool kTop = false;
+        int64_t kTopVal = 0;
         for (int o = 0; o < n;) {
-            uint8_t op = c[o];
+            uint8_t op = jaiOpGeneric(c[o]);
+            bool wasK = kTop;
+            int64_t wasKVal = kTopVal;
+            kTop = false;
+            if (op == OP_GET_LOCAL || op == OP_GET_LOCAL2) {
+                /* A parameter is the caller's entry for it, so reading one is
+                 * a copy of that entry -- kind, class and sample included,
+                 * which is what lets a field read off it be typed. OP_INVOKE
+                 * has settled every entry before this runs, so each is in its
+                 * own X register. */
+                unsigned reads = op == OP_GET_LOCAL ? 1u : 2u;
+                for (unsigned k = 0; k < reads; k++) {
+                    unsigned slot = jaiReadU16(c + o + 1 + 2u * k);
+                    if (slot > argc) return false;
+                    SlotKind sk = e->stack[ridx + slot];
+                    if (sk != SLOT_INT && sk != SLOT_FLOAT && sk != SLOT_INST) {
+                        return false;
+                    }
+                    if (!pushValue3(e, sk, e->stackShape[ridx + slot],
+                                    inCls[slot], inSeen[slot], -1)) {
+                        return false;
+                    }
+                    unsigned rd = pushReg(e) - 1;
+                    if (pass == 1 && rd != inReg[slot]) {
+                        emit(e, jaiA64MovX(rd, inReg[slot]));
+                    }
+                }
+                o += 1 + 2 * (int)reads;
+                continue;
+            }
+            if (op == OP_GET_FIELD) {
+                /* The same read as OP_GET_FIELD_LOCAL below, off an entry the
+                 * walk pushed rather than off a parameter slot. */
+                uint32_t nidx = jaiReadU24(c + o + 1);
+                if ((int)e->depth <= depth0) return false;
+                unsigned top = e->depth - 1;
+                ObjClass *fcls = e->stackClass[top];
+                Value fseen = e->stackSeen[top];
+                if (e->stack[top] != SLOT_INST || fcls == NULL) return false;
+                if (nidx >= (uint32_t)mfn->chunk.constants.count) return false;
+                Value fname = mfn->chunk.constants.data[nidx];
+                if (!IS_STRING(fname)) return false;
+                const FieldInfo *fi = jaiClassFieldInfo(fcls, AS_STRING(fname));
+                if (fi == NULL || fi->isStatic) return false;
+                if (!IS_INSTANCE(fseen)) return false;
+                Value fv;
+                if (!sampleField(AS_INSTANCE(fseen), fi->slot, &fv)) return false;
+                SlotKind fk; unsigned ftag;
+                if (IS_INT(fv))        { fk = SLOT_INT;   ftag = VAL_INT; }
+                else if (IS_FLOAT(fv)) { fk = SLOT_FLOAT; ftag = VAL_FLOAT; }
+                else return false;
+                unsigned fbase = (unsigned)offsetof(ObjInstance, fields) +
+                                 (unsigned)fi->slot * (unsigned)sizeof(Value);
+                unsigned rrecv = pushReg(e) - 1;
+                unsigned drop;
+                if (!popValue(e, &drop, NULL)) return false;
+                if (!pushValue(e, fk, 0, NULL)) return false;
+                if (pass == 1) {
+                    emit(e, jaiA64LdrW(JIT_SCRATCH_A, rrecv, fbase));
+                    emit(e, jaiA64SubsXImm(31, JIT_SCRATCH_A, ftag));
+                    branchOnDeoptAt(e, JAI_A64_NE, (uint32_t)callOff, false);
+                    emit(e, jaiA64LdrX(pushReg(e) - 1, rrecv, fbase + 8));
+                }
+                o += 6;
+                continue;
+            }
+            if (op == OP_INT || op == OP_CONST) {
+                int64_t bits;
+                SlotKind kk;
+                if (op == OP_INT) {
+                    bits = jaiReadI16(c + o + 1);
+                    kk = SLOT_INT;
+                } else {
+                    uint32_t kidx = jaiReadU24(c + o + 1);
+                    if (kidx >= (uint32_t)mfn->chunk.constants.count) return false;
+                    Value k = mfn->chunk.constants.data[kidx];
+                    if (IS_INT(k)) {
+                        bits = AS_INT(k);
+                        kk = SLOT_INT;
+                    } else if (IS_FLOAT(k)) {
+                        double d = AS_FLOAT(k);
+                        memcpy(&bits, &d, sizeof bits);
+                        kk = SLOT_FLOAT;
+                    } else {
+                        return false;
+                    }
+                }
+                if (!pushValue(e, kk, 0, NULL)) return false;
+                if (pass == 1) emitConst64(e, pushReg(e) - 1, bits);
+                kTop = kk == SLOT_INT;
+                kTopVal = bits;
+                o += op == OP_INT ? 3 : 4;
+                continue;
+            }
+            if (op == OP_MOD) {
+                if (!wasK || wasKVal <= 0) return false;
+                unsigned rb, ra; SlotKind kb, ka;
+                if (!popValue(e, &rb, &kb)) return false;
+                if (!popValue(e, &ra, &ka)) return false;
+                if (ka != SLOT_INT || kb != SLOT_INT) return false;
+                if (!pushValue(e, SLOT_INT, 0, NULL)) return false;
+                if (pass == 1) emitModByLiteral(e, pushReg(e) - 1, ra, wasKVal);
+                o += 1;
+                continue;
+            }
+            if (op == OP_MOD_INT_CONST) {
+                int16_t imm = jaiReadI16(c + o + 1);
+                if (imm <= 0) return false;
+                unsigned ra; SlotKind ka;
+                if ((int)e->depth <= depth0) return false;
+                if (!popValue(e, &ra, &ka)) return false;
+                if (ka != SLOT_INT) return false;
+                if (!pushValue(e, SLOT_INT, 0, NULL)) return false;
+                if (pass == 1) emitModByLiteral(e, pushReg(e) - 1, ra, imm);
+                o += 3;
+                continue;
+            }
             if (op == OP_GET_FIELD_LOCAL) {
                 unsigned slot = jaiReadU16(c + o + 1);
                 uint32_t nidx = jaiReadU24(c + o + 3);
@@ -3910,8 +4683,8 @@ static bool inlineMethodWalk(Emit *e, ObjClosure *closure, uint32_t nameIdx,
                 if (fi == NULL || fi->isStatic) return false;
                 if (!IS_INSTANCE(inSeen[slot])) return false;
                 ObjInstance *si = AS_INSTANCE(inSeen[slot]);
-                if (fi->slot >= si->fieldCount) return false;
-                Value fv = si->fields[fi->slot];
+                Value fv;
+                if (!sampleField(si, fi->slot, &fv)) return false;
                 SlotKind fk; unsigned ftag;
                 if (IS_INT(fv))        { fk = SLOT_INT;   ftag = VAL_INT; }
                 else if (IS_FLOAT(fv)) { fk = SLOT_FLOAT; ftag = VAL_FLOAT; }
@@ -3986,7 +4759,12 @@ static bool inlineMethodWalk(Emit *e, ObjClosure *closure, uint32_t nameIdx,
     if (!pushValue(e, kres, 0, NULL)) return false;
     unsigned dst = pushReg(e) - 1;
     if (dst != rres) emit(e, jaiA64MovX(dst, rres));
+    e->inlineSpent += (unsigned)mfn->chunk.count;
     e->inlined = true;
+    if (getenv("JAI_JIT_WHY")) {
+        fprintf(stderr, "[jit] inlining method %s.%s\n",
+                rcls->name ? rcls->name->chars : "?", AS_STRING(mname)->chars);
+    }
     return true;
 }
 
@@ -4360,7 +5138,7 @@ static bool deferSurvives(uint8_t op) {
  * arms below by hand, and harmless if it says yes too often: the consumer
  * settles what it cannot fold. */
 static bool foldsIntLiteral(uint8_t op) {
-    switch (op) {
+    switch (jaiOpGeneric(op)) {
     case OP_ADD: case OP_SUB:
     case OP_LT: case OP_LE: case OP_GT: case OP_GE:
     case OP_EQ: case OP_NE:
@@ -4381,7 +5159,7 @@ static bool fpWorthLoading(const Emit *e, const uint8_t *code, int next,
                            int stop) {
     if (e->fpOff) return false;
     for (unsigned step = 0; step < 24u && next < stop; step++) {
-        uint8_t op = code[next];
+        uint8_t op = jaiOpGeneric(code[next]);
         if (fpConsumer(op)) return true;
         if (!fpFastOp(op)) return false;
         int size = jaiOpOperandSize((OpCode)op);
@@ -4455,6 +5233,76 @@ static bool skipResumeOk(const Emit *e, uint32_t at) {
            e->chunkDepth[at] == 0;
 }
 
+typedef struct {
+    int64_t  key;
+    uint32_t target;
+} JitSwitchArm;
+
+static int switchArmOrder(const void *a, const void *b) {
+    const JitSwitchArm *x = a, *y = b;
+    return x->key < y->key ? -1 : x->key > y->key;
+}
+
+static void emitCmpKey(Emit *e, unsigned r, int64_t key) {
+    if (key >= -4095 && key <= 4095) {
+        emitCmpImm(e, r, key);
+    } else {
+        emitConst64(e, JIT_SCRATCH_B, key);
+        emit(e, jaiA64SubsXReg(31, r, JIT_SCRATCH_B));
+    }
+}
+
+/* Binary search down to runs of three, which are tested for equality one by
+ * one: below that a split costs as many compares as it saves. */
+static void emitSwitchTree(Emit *e, unsigned r, const JitSwitchArm *arms,
+                           unsigned n, uint32_t dflt) {
+    if (n <= 3) {
+        for (unsigned i = 0; i < n; i++) {
+            emitCmpKey(e, r, arms[i].key);
+            branchTo(e, arms[i].target, true, JAI_A64_EQ);
+        }
+        branchTo(e, dflt, false, 0);
+        return;
+    }
+    unsigned mid = n / 2;
+    emitCmpKey(e, r, arms[mid].key);
+    unsigned at = e->count;
+    emit(e, jaiA64BCond(JAI_A64_GE, 0));
+    emitSwitchTree(e, r, arms, mid, dflt);
+    e->code[at] = jaiA64BCond(JAI_A64_GE, (int32_t)(e->count - at));
+    emitSwitchTree(e, r, arms + mid, n - mid, dflt);
+}
+
+/* OP_SWITCH on the int on top. Everything is settled before the first
+ * compare, so the branches between compares emit nothing that could move
+ * the subject or the flags. */
+static bool emitSwitch(Emit *e, const Chunk *c, int off) {
+    Value table = c->constants.data[jaiReadU24(c->code + off + 1)];
+    uint32_t after = (uint32_t)off + 6u;
+    uint32_t dflt = (uint32_t)((int32_t)after + jaiReadI16(c->code + off + 4));
+    int size = jaiSwitchSize(table);
+    JitSwitchArm *arms = malloc(sizeof *arms * (size_t)(size > 0 ? size : 1));
+    if (arms == NULL) { e->failed = true; return false; }
+    unsigned n = 0;
+    JaiSwitchCase arm;
+    for (int i = 0; i < size; i++) {
+        /* A string key can never equal an int subject. */
+        if (!jaiSwitchCaseAt(table, i, &arm) || arm.isString) continue;
+        arms[n].key = arm.intKey;
+        arms[n].target = after + (uint32_t)arm.rel;
+        n++;
+    }
+    qsort(arms, n, sizeof *arms, switchArmOrder);
+
+    fpSyncAll(e);
+    settleAll(e);
+    unsigned r;
+    if (!popValue(e, &r, NULL)) { free(arms); return false; }
+    emitSwitchTree(e, r, arms, n, dflt);
+    free(arms);
+    return !e->failed;
+}
+
 static bool emitUnarmedDeopt(Emit *e, const Chunk *c, int *off, int stop) {
     if (e->inlining) {
         /* Half an inlined body cannot be taken back, and the caller reads the
@@ -4501,6 +5349,70 @@ static bool emitUnarmedDeopt(Emit *e, const Chunk *c, int *off, int stop) {
     return true;
 }
 
+/* Just opened a counted loop at `at`: if its body is one the block kernel
+ * runs (jit_vec.h), call the kernel now and advance the counter by however
+ * many iterations it ran. The scalar body emitted after this is untouched and
+ * takes over from the counter -- the iterations left at the end, or the one
+ * the kernel stopped short of, with every guard and deopt it always had.
+ *
+ * Declining costs nothing but the kernel: any operand whose kind is not the
+ * one its role needs, or not fixed for the whole body, and the loop simply
+ * runs as it did before. Returns false only when the emitter itself failed. */
+static bool emitVecLoop(Emit *e, ObjFunction *fn, uint32_t at) {
+    if (e->inlining || !e->callsOut || jitNoVec()) return true;
+    if (e->depth != 0 || e->valueDepth != 0) return true;
+    const JaiVecPlan *plan = jaiVecPlanFor(fn, at);
+    if (plan == NULL) return true;
+    for (unsigned i = 0; i < plan->argCount; i++) {
+        unsigned slot = plan->argSlot[i];
+        if (!localInRange(e, slot) || e->dynamicLocal[slot]) return true;
+        SlotKind want;
+        switch ((JaiVecRole)plan->argRole[i]) {
+        case JAI_VEC_ARG_LIST:  want = SLOT_LIST;  break;
+        case JAI_VEC_ARG_FLOAT:
+        case JAI_VEC_ARG_ACC:   want = SLOT_FLOAT; break;
+        default:                want = SLOT_INT;   break;
+        }
+        if (e->localKind[slot] != want) return true;
+    }
+
+    unsigned d = e->descOffset;
+    for (unsigned i = 0; i < plan->argCount; i++) {
+        unsigned slot = plan->argSlot[i];
+        if (slot == 0) e->usesSlot0 = true;
+        unsigned r = localIn(e, slot, JIT_SCRATCH_A);
+        emit(e, jaiA64StrX(r, 31, d + (unsigned)offsetof(JitCallDesc, words) +
+                                      i * 8u));
+    }
+    emitConst64(e, JIT_SCRATCH_A, (int64_t)(uintptr_t)plan);
+    emit(e, jaiA64StrX(JIT_SCRATCH_A, 31,
+                       d + (unsigned)offsetof(JitCallDesc, aux)));
+    emit(e, jaiA64AddXImm(0, 31, d));
+    emitConst64(e, JIT_SCRATCH_A, (int64_t)(uintptr_t)&jitVecLoop);
+    noteScratchClobber(e);
+    emit(e, jaiA64Blr(JIT_SCRATCH_A));
+
+    unsigned curSlot = plan->argSlot[0];
+    unsigned rCur = localIn(e, curSlot, JIT_SCRATCH_B);
+    unsigned dst = localDest(e, curSlot);
+    emit(e, jaiA64AddX(dst, rCur, 0));
+    localOut(e, curSlot, dst);
+    if (plan->kind == JAI_VEC_MAP) {
+        e->wroteHeap = true;
+    } else {
+        emit(e, jaiA64LdrX(JIT_SCRATCH_A, 31,
+                           d + (unsigned)offsetof(JitCallDesc, result) + 8));
+        localOut(e, plan->argSlot[plan->target], JIT_SCRATCH_A);
+    }
+    if (!e->measuring && getenv("JAI_JIT_WHY")) {
+        fprintf(stderr, "[jit] %s: loop at %u runs in blocks (%s, %u nodes)\n",
+                fn->name ? fn->name->chars : "<anon>", (unsigned)at,
+                plan->kind == JAI_VEC_MAP ? "map" : "reduction",
+                (unsigned)plan->nodeCount);
+    }
+    return !e->failed;
+}
+
 static bool compileBody(Emit *e, ObjClosure *closure) {
     ObjFunction *fn = closure->fn;
     const uint8_t *code = fn->chunk.code;
@@ -4543,7 +5455,7 @@ static bool compileBody(Emit *e, ObjClosure *closure) {
             }
             break;
         }
-        uint8_t op = code[off];
+        uint8_t op = jaiOpGeneric(code[off]);
         afterUncond = !jaiOpFallsThrough(op);
         /* Whose regions these are matters: inside an inline the offsets are the
          * callee's while every guard resumes at the CALLER's call site, so the
@@ -4653,6 +5565,21 @@ static bool compileBody(Emit *e, ObjClosure *closure) {
             off += instructionLength(&fn->chunk, off);
             continue;
         }
+        if (e->inlining && op == OP_RETURN && e->inlTupleN > 0) {
+            /* The elements of a tuple that was never built (see
+             * OP_BUILD_TUPLE), every one of them in its own X register. */
+            unsigned n = e->inlTupleN;
+            if (e->depth < n || e->valueDepth < n) return false;
+            for (unsigned i = 0; i < n; i++) {
+                if (!holdsRegister(e->stack[e->depth - 1u - i])) {
+                    e->whyNot = "an inlined body returning a value with no register";
+                    return false;
+                }
+                fpSyncOne(e, e->valueDepth - 1u - i);
+            }
+            settleAll(e);
+            break;
+        }
         if (e->inlining && op == OP_RETURN) {
             /* The result is on top and stays there; the caller's driver takes
              * it from the model. */
@@ -5557,7 +6484,8 @@ static bool compileBody(Emit *e, ObjClosure *closure) {
             {
                 ObjModule *fmod = closure->fn->module;
                 Value bound;
-                ObjString *sname = jaiStringIntern("str", 3);
+                ObjString *sname = gJob != NULL ? gJob->strName
+                                                : jaiStringIntern("str", 3);
                 if (fmod == NULL || sname == NULL ||
                     jaiTableGetInterned(&fmod->globals, sname, &bound)) {
                     e->whyNot = "the module binds its own str";
@@ -5590,6 +6518,21 @@ static bool compileBody(Emit *e, ObjClosure *closure) {
             break;
         }
 
+        case OP_SWITCH: {
+            /* An int subject is a compare tree over the table's keys; whether
+             * the interpreter found them by subtraction or by perfect hash
+             * does not matter here. Anything else -- a string, a float that
+             * may equal an int key, an instance with __eq__ -- is the
+             * interpreter's, from this offset. */
+            if (e->depth == 0 || e->stack[e->depth - 1] != SLOT_INT) {
+                if (!emitUnarmedDeopt(e, &fn->chunk, &off, stop)) return false;
+                continue;
+            }
+            if (!emitSwitch(e, &fn->chunk, off)) return false;
+            off += 6;
+            break;
+        }
+
         case OP_LOOP: {
             /* Compiled code has no safepoint on the back edge (uninterruptible, unsampled) -- acceptable only
              * because this tier bails on anything unbounded: the loop is over ints, can't allocate, and the stack guard still catches runaway recursion. Ctrl-C during a long compiled loop waits for the loop to end. */
@@ -5717,6 +6660,13 @@ static bool compileBody(Emit *e, ObjClosure *closure) {
                 e->stack[e->depth - 2] == SLOT_FLOAT) {
                 unsigned ib = e->valueDepth - 1, ia = e->valueDepth - 2;
                 unsigned db = fpOperand(e, ib), da = fpOperand(e, ia);
+                /* A zero divisor raises, as it does in the interpreter. Tested
+                 * before the pops, so that inside a `try` the guard can still
+                 * resume at this instruction with both operands in place. */
+                if (op == OP_DIV) {
+                    emit(e, jaiA64FcmpDZero(db));
+                    branchOnOverflow(e, 3u, JAI_A64_EQ);
+                }
                 if (!popValueRaw(e, &rb, &kb)) return false;
                 if (!popValueRaw(e, &ra, &ka)) return false;
                 if (!pushValue(e, SLOT_FLOAT, 0, NULL)) return false;
@@ -5915,8 +6865,8 @@ static bool compileBody(Emit *e, ObjClosure *closure) {
                                                 : e->localSeen[slot];
             if (!IS_INSTANCE(seen)) return false;
             ObjInstance *inst = AS_INSTANCE(seen);
-            if (info->slot >= inst->fieldCount) return false;
-            Value fieldVal = inst->fields[info->slot];
+            Value fieldVal;
+            if (!sampleField(inst, info->slot, &fieldVal)) return false;
 
             SlotKind kind;
             unsigned tag;
@@ -6116,11 +7066,11 @@ static bool compileBody(Emit *e, ObjClosure *closure) {
             }
             if (!popValue(e, &rr, &kr)) return false;
             if (kr != SLOT_INST) return false;
-            /* An object goes in as readily as a number. The collector is a plain mark-sweep with no write
-             * barrier and nothing moves, so the only question is reachability: the receiver is rooted (it
-             * is a live SLOT_INST here), and after the store the value hangs off it, while before the store
-             * it was rooted in its own right by emitRootFill. What is refused is a kind with no payload
-             * register to store (class/function/native/self) and SLOT_ITER, whose index lives in memory. */
+            /* An object goes in as readily as a number. Nothing moves, so the questions are reachability and
+             * generation: the receiver is rooted (it is a live SLOT_INST here), and after the store the value
+             * hangs off it, while before the store it was rooted in its own right by emitRootFill; an old
+             * receiver is remembered by emitWriteBarrier. What is refused is a kind with no payload register
+             * to store (class/function/native/self) and SLOT_ITER, whose index lives in memory. */
             if (kv != SLOT_INT && kv != SLOT_FLOAT && kv != SLOT_BOOL &&
                 kv != SLOT_OBJ && kv != SLOT_LIST && kv != SLOT_INST &&
                 kv != SLOT_MAYBE_INST) {
@@ -6143,6 +7093,10 @@ static bool compileBody(Emit *e, ObjClosure *closure) {
             emit(e, jaiA64StrW(JIT_SCRATCH_A, rr, base));
             if (vIsFp) emit(e, jaiA64StrD(dv, rr, base + 8));
             else       emit(e, jaiA64StrX(rv, rr, base + 8));
+            if (kv == SLOT_OBJ || kv == SLOT_LIST || kv == SLOT_INST ||
+                kv == SLOT_MAYBE_INST) {
+                emitWriteBarrier(e, rr);
+            }
             /* Only a kind a later read can replay EXACTLY is remembered; the rest merely retire what was
              * known of this field (local -1), because the read side would otherwise take SLOT_INST with no
              * class behind it -- a shape every field offset it then resolved would be resolved against. */
@@ -6261,9 +7215,7 @@ static bool compileBody(Emit *e, ObjClosure *closure) {
              * read once here and checked on every entry into the loop. */
             Value seen = NULL_VAL;
             ObjClosure *cl = closure;
-            if (index < (unsigned)cl->upvalueCount && cl->upvalues[index] != NULL) {
-                seen = *cl->upvalues[index]->location;
-            }
+            (void)sampleUpvalue(cl, index, &seen);
             SlotKind kind;
             unsigned tag;
             uint32_t seenShape = 0;
@@ -6337,8 +7289,8 @@ static bool compileBody(Emit *e, ObjClosure *closure) {
             if (info == NULL || info->isStatic) return false;
             if (!IS_INSTANCE(seen)) return false;
             ObjInstance *inst = AS_INSTANCE(seen);
-            if (info->slot >= inst->fieldCount) return false;
-            Value fieldVal = inst->fields[info->slot];
+            Value fieldVal;
+            if (!sampleField(inst, info->slot, &fieldVal)) return false;
 
             SlotKind kind;
             unsigned tag;
@@ -6406,6 +7358,53 @@ static bool compileBody(Emit *e, ObjClosure *closure) {
             break;
         }
 
+        case OP_BUILD_TUPLE: {
+            /* A tuple is almost always taken apart where it is made: `(a, b) =
+             * (b, a + b)` and `let (q, r) = (x, y)` are BUILD_TUPLE n straight
+             * into UNPACK n, and the tuple is garbage the moment UNPACK reads
+             * it. Nothing else can see it, so there is nothing to allocate --
+             * UNPACK leaves element 0 on top, BUILD_TUPLE took it from the
+             * bottom, and the pair of them is the top n entries reversed. A
+             * jump onto the UNPACK would bring a real tuple, so that is left
+             * to the general path. */
+            unsigned n = jaiReadU16(code + off + 1);
+            uint32_t next = (uint32_t)off + 3u;
+            if (n >= 1 && (int)next + 3 <= stop && code[next] == OP_UNPACK &&
+                code[next + 1] == n && code[next + 2] == 255 &&
+                !offsetIsBranchTarget(&fn->chunk, next) &&
+                reverseTopEntries(e, n)) {
+                off += 6;
+                break;
+            }
+            /* An inlined body returning the pair its caller unpacks: leave the
+             * elements where they are, for inlineGlobalCall to hand over. */
+            if (e->inlining && e->inlTupleWant == n && n >= 1 &&
+                code[next] == OP_RETURN) {
+                e->inlTupleN = n;
+                off += 3;
+                break;
+            }
+            /* Escapes -- returned, stored, passed on: it has to exist. */
+            if (n <= JIT_MAX_ARGS_OUT && e->callsOut && e->depth >= n &&
+                emitDescriptor(e, NULL_VAL, e->depth - n, n,
+                               (void *)&jitBuildTuple)) {
+                for (unsigned i = 0; i < n; i++) {
+                    unsigned r;
+                    if (!popValue(e, &r, NULL)) return false;
+                }
+                if (!pushValue(e, SLOT_OBJ, 0, NULL)) return false;
+                emit(e, jaiA64LdrX(pushReg(e) - 1, 31,
+                                   e->descOffset +
+                                       (unsigned)offsetof(JitCallDesc, result) + 8));
+                e->wroteHeap = true;
+                off += 3;
+                break;
+            }
+            if (!emitUnarmedDeopt(e, &fn->chunk, &off, stop)) return false;
+            afterUncond = true;
+            continue;
+        }
+
         case OP_BUILD_LIST: {
             unsigned n = jaiReadU16(code + off + 1);
             if (n > JIT_MAX_ARGS_OUT) return false;
@@ -6654,6 +7653,12 @@ static bool compileBody(Emit *e, ObjClosure *closure) {
                 break;
             }
 
+            if (rk == SLOT_INST && e->stackClass[ridx] == NULL &&
+                !e->noInline) {
+                pinMonomorphicReceiver(e, &fn->chunk, ridx,
+                                       jaiReadU16(code + off + 5));
+            }
+
             if (rk == SLOT_INST) {
                 /* A method whose whole body is one arithmetic expression over receiver+arguments is worth inlining:
                  * the call costs more than the expression. Vec2.dot is four field reads, two multiplies and an add, reached through a descriptor, a helper and a compiled entry. */
@@ -6692,6 +7697,18 @@ static bool compileBody(Emit *e, ObjClosure *closure) {
                         e->whyNot = "an unpinned receiver's result kind";
                         return false;
                     }
+                    /* The site's cache goes out with the name: it is where
+                     * the interpreter records the trait and index, and it can
+                     * do so after this body is compiled. */
+                    uint16_t cacheIdx = jaiReadU16(code + off + 5);
+                    const InlineCache *site =
+                        fn->chunk.caches != NULL &&
+                        (int)cacheIdx < fn->chunk.cacheCount
+                            ? &fn->chunk.caches[cacheIdx] : NULL;
+                    emitConst64(e, JIT_SCRATCH_A, (int64_t)(uintptr_t)site);
+                    emit(e, jaiA64StrX(JIT_SCRATCH_A, 31,
+                                       e->descOffset +
+                                       (unsigned)offsetof(JitCallDesc, aux)));
                     if (!emitDescriptor(e, mname, ridx, argc + 1,
                                         (void *)&jitInvokeByName)) {
                         return false;
@@ -6867,7 +7884,8 @@ static bool compileBody(Emit *e, ObjClosure *closure) {
                 Value oname = fn->chunk.constants.data[nameIdx];
                 if (!IS_STRING(oname)) return false;
                 Value obound;
-                if (!jaiBuiltinMethod(oseen, AS_STRING(oname), &obound)) {
+                if (!sampleBuiltin(oseen, receiverType(oseen),
+                                   AS_STRING(oname), &obound)) {
                     e->whyNot = "an invoke that is not a builtin of the "
                                 "observed receiver's type";
                     return false;
@@ -6951,14 +7969,16 @@ static bool compileBody(Emit *e, ObjClosure *closure) {
              * body built with no sample to look at, an empty probe list answers just as well. Rooted across the lookup since resolving allocates the bound wrapper; only the native is kept, and that outlives it. */
             Value probe = e->stackSeen[ridx];
             bool madeProbe = false;
-            if (!IS_LIST(probe)) {
+            if (!IS_LIST(probe) && gJob == NULL) {
                 ObjList *tmp = jaiListNew(0);
                 probe = OBJ_VAL(tmp);
                 jaiGCPushRoot(probe);
                 madeProbe = true;
             }
             Value bound;
-            bool found = jaiBuiltinMethod(probe, AS_STRING(nameVal), &bound);
+            bool found = sampleBuiltin(IS_LIST(probe) ? probe : NULL_VAL,
+                                       16 + (int)OBJ_LIST, AS_STRING(nameVal),
+                                       &bound);
             if (madeProbe) jaiGCPopRoot();
             if (!found) return false;
             Value nativeVal = IS_BOUND(bound) ? AS_BOUND(bound)->method : bound;
@@ -7039,9 +8059,7 @@ static bool compileBody(Emit *e, ObjClosure *closure) {
                  * will yield. */
                 Value srcv = e->stackSeen[e->depth - 1];
                 Value sample = NULL_VAL;
-                if (IS_LIST(srcv) && AS_LIST(srcv)->count > 0) {
-                    sample = AS_LIST(srcv)->items[0];
-                }
+                if (IS_LIST(srcv)) (void)sampleListHead(AS_LIST(srcv), &sample);
                 if (IS_NULL(sample)) {
                     e->whyNot = "iterating a list with nothing to look at";
                     return false;
@@ -7132,6 +8150,7 @@ static bool compileBody(Emit *e, ObjClosure *closure) {
             emit(e, jaiA64CselX(JIT_SCRATCH_B, rLo, JIT_SCRATCH_A, JAI_A64_LT));
             localOut(e, endSlot, JIT_SCRATCH_B);
             localOut(e, curSlot, rLo);
+            if (!emitVecLoop(e, fn, (uint32_t)off)) return false;
             off += 6;
             break;
         }
@@ -7687,8 +8706,7 @@ static bool compileBody(Emit *e, ObjClosure *closure) {
                 /* Shape 4 carries the dict itself, so the sample is its first
                  * live entry -- the one the loop is about to yield. */
                 if (!IS_DICT(psample) ||
-                    !firstLiveEntry(&AS_DICT(psample)->table,
-                                    &pseen[0], &pseen[1])) {
+                    !sampleDictHead(AS_DICT(psample), &pseen[0], &pseen[1])) {
                     e->whyNot = "iterating a dict with nothing to look at";
                     return false;
                 }
@@ -8047,9 +9065,8 @@ static bool compileBody(Emit *e, ObjClosure *closure) {
 
             Value seenList = e->stackSeen[e->depth - 2];
             if (!IS_LIST(seenList)) return false;
-            ObjList *sl = AS_LIST(seenList);
-            if (sl->count <= 0) return false;
-            Value elem = sl->items[0];
+            Value elem;
+            if (!sampleListHead(AS_LIST(seenList), &elem)) return false;
             SlotKind kind;
             unsigned tag;
             ObjClass *elemClass = NULL;
@@ -8225,6 +9242,7 @@ static bool compileBody(Emit *e, ObjClosure *closure) {
             emit(e, jaiA64AddXImm(JIT_SCRATCH_A, JIT_SCRATCH_A, 1));
             emit(e, jaiA64StrW(JIT_SCRATCH_A, rList,
                                (unsigned)offsetof(ObjList, version)));
+            if (vtag == VAL_OBJ) emitWriteBarrier(e, rList);
             e->wroteHeap = true;
 
             unsigned d1, d2, d3;
@@ -8505,13 +9523,19 @@ static bool compileBody(Emit *e, ObjClosure *closure) {
                             (int32_t)(e->count - at));
                     }
                 }
-                /* No write barrier: mark-sweep traces module globals as a root every collection, so a raw store is
-                 * enough. Nothing between the tag and payload writes can allocate, so no collection can ever see them disagree. */
+                /* Nothing between the tag and payload writes can allocate, so no collection can ever see them
+                 * disagree. The globals live in the module, which is the object an old-holds-young store has to
+                 * remember -- jaiModuleSet's barrier, with the module baked in. */
                 emitTagFor(e, sk, src, JIT_SCRATCH_B, JIT_SCRATCH_A);
                 emit(e, jaiA64StrW(JIT_SCRATCH_B, JIT_SCRATCH_D,
                                    (unsigned)offsetof(JaiEntry, value)));
                 emit(e, jaiA64StrX(src, JIT_SCRATCH_D,
                                    (unsigned)offsetof(JaiEntry, value) + 8u));
+                if (sk != SLOT_INT && sk != SLOT_FLOAT && sk != SLOT_BOOL) {
+                    emitConst64(e, JIT_SCRATCH_A,
+                                (int64_t)(uintptr_t)closure->fn->module);
+                    emitWriteBarrier(e, JIT_SCRATCH_A);
+                }
             }
             /* Re-running this call interpreted would apply the store twice, so
              * from here a bail is no longer free. */
@@ -8536,7 +9560,7 @@ static bool compileBody(Emit *e, ObjClosure *closure) {
                 if (IS_CLOSURE(cvv) &&
                     inlineGlobalCall(e, fn, AS_CLOSURE(cvv), argc,
                                      (uint32_t)off, -1)) {
-                    off += 2;
+                    off += inlinedCallLength(e);
                     break;
                 }
                 if (e->failed) return false;
@@ -8658,7 +9682,7 @@ static bool compileBody(Emit *e, ObjClosure *closure) {
                  * neither frame, argument shuffle, nor root fill. An indirect site needs NONE of the checks below to inline -- no argument kind has to match a specialisation, and the callee need not have compiled at all, since arguments stay in the caller's own registers with the caller's own kinds. */
                 if (inlineGlobalCall(e, fn, AS_CLOSURE(cv), argc,
                                      (uint32_t)off, (int)rCallee0)) {
-                    off += 2;
+                    off += inlinedCallLength(e);
                     break;
                 }
                 if (e->failed) return false;
@@ -8687,7 +9711,7 @@ static bool compileBody(Emit *e, ObjClosure *closure) {
                 unsigned rCallee = rCallee0;   /* guarded above */
 
                 /* Straight to the callee's compiled entry, not through jaiCallValue/an interpreter frame -- same
-                 * convention a self-call and jaiJitEnterFunc use. Callee must live in this module since the caller's module-version guard stands in for the callee's own entry check. The baked jitFunc address can't go stale: the arena is never freed and jitFunc is written once; only the ObjFunction identity needs guarding (done above). */
+                 * convention a self-call and jaiJitEnterFunc use. Callee must live in this module since the caller's module-version guard stands in for the callee's own entry check. The baked jitFunc address can't go stale while that guard holds: the callee's form is only retired once the module moves (which retires this body too) or once the callee is freed, and the code heap keeps retired code while any stale body is running. Only the ObjFunction identity needs guarding (done above). */
                 unsigned calleeArgs = (unsigned)cfn->jitArgCount;
                 bool wantsClosure = calleeArgs == argc + 1u;
                 if (cfn->module != fn->module || cfn->jitArgBase != 1u ||
@@ -9119,20 +10143,30 @@ static bool adoptLocalKind(Emit *e, unsigned slot, SlotKind kind,
     return adoptLocalKindSeen(e, slot, kind, shape, klass, NULL_VAL);
 }
 
+/* malloc rather than JAI_ALLOC: the compiler thread allocates these too, and
+ * the VM's allocator is the interpreter's alone. */
 static void jitFree(int *map, int *depths, int *chunkDepth, int count) {
-    JAI_FREE_ARRAY(int, map, count);
-    JAI_FREE_ARRAY(int, depths, count);
-    JAI_FREE_ARRAY(int, chunkDepth, count);
+    (void)count;
+    free(map);
+    free(depths);
+    free(chunkDepth);
 }
 
 /* The bytecode's own answer for every offset, or NULL if it cannot be had.
  * NULL is not a failure: modelAgreesWithChunk simply has nothing to check
- * against, which is the state the tier was in before this existed. */
+ * against, which is the state the tier was in before this existed. The
+ * verifier allocates, so on the compiler thread the job's copy is used. */
 static int *chunkDepthTable(const ObjFunction *fn) {
-    int *d = JAI_ALLOC(int, fn->chunk.count + 1);
+    size_t bytes = sizeof(int) * (size_t)(fn->chunk.count + 1);
+    if (gJob != NULL && gJob->chunkDepth == NULL) return NULL;
+    int *d = malloc(bytes);
     if (d == NULL) return NULL;
+    if (gJob != NULL) {
+        memcpy(d, gJob->chunkDepth, bytes);
+        return d;
+    }
     if (!jaiChunkStackDepths(fn, d)) {
-        JAI_FREE_ARRAY(int, d, fn->chunk.count + 1);
+        free(d);
         return NULL;
     }
     return d;
@@ -9171,10 +10205,174 @@ static bool eligible(ObjFunction *fn) {
 /* Filled by loopDepthTable, which lives with the OSR entry below. */
 static const uint8_t *loopDepthFor(const Chunk *c, unsigned *count);
 
-/* Greedy: most instructions-saved first, across BOTH register banks at once (an int slot read 4x in
- * a loop outranks a float slot read 2x, different pools, but comparing them in one order keeps that meaningful when only one pool runs out -- see noteSlotCost). Three exclusions: a zero-saving slot is skipped outright, not just ranked last (else a tie-break could pay a prologue write for nothing); a dynamic slot keeps its frame home, since only the frame has anywhere to put a run-time tag; a wrong guess costs an `fmov`, never a wrong answer, since only fmov/ldr/str ever touch a home. */
-/* Both tiers plan through this, on the same ledgers (see noteSlotCost). What is
- * still per-tier is named here rather than duplicated:
+/* Where each slot's value can still be needed, read off the bytecode: slot s
+ * is live over [lo[s], hi[s]], the first and last offsets that touch it, and
+ * nowhere outside. Two slots whose ranges do not meet can then share one
+ * register, which is the whole point -- a numeric kernel's temporaries are
+ * mostly short-lived, and twenty of them fit in ten registers if no more
+ * than ten are ever live at once.
+ *
+ * Straight-line order is a sound approximation but for two things:
+ *
+ *   * back edges. A value written near the bottom of a loop is read near the
+ *     top on the next trip, which in offset order is BEFORE it was written.
+ *     Any range that meets a loop is therefore widened to cover all of it,
+ *     repeated until nothing grows, so that nested loops widen outwards. The
+ *     same holds for a handler above the code it protects, which is a back
+ *     edge the exception table draws instead of an OP_LOOP.
+ *   * a first touch that is a READ. The interpreter would find the frame's
+ *     null there, and the range has to reach back to the entry to say so;
+ *     parameters and slot 0 (the callee, or `self`, which OP_SUPER_INVOKE reads
+ *     without naming it) are live from the entry for the same reason.
+ *
+ * A slot captured by reference by a closure is live everywhere: the closure
+ * can read it from any call. False when the chunk will not decode, in which
+ * case nothing may share. */
+#define JIT_MAX_LIVE_REGIONS 256u
+
+static bool slotLiveRanges(const ObjFunction *fn, unsigned nslots,
+                           uint32_t *lo, uint32_t *hi) {
+    const Chunk *c = &fn->chunk;
+    uint32_t last = (uint32_t)c->count;
+    static uint32_t regionTop[JIT_MAX_LIVE_REGIONS];
+    static uint32_t regionEnd[JIT_MAX_LIVE_REGIONS];
+    unsigned regions = 0;
+    bool seen[JIT_MAX_SLOTS + 1];
+    if (nslots > JIT_MAX_SLOTS + 1u) nslots = JIT_MAX_SLOTS + 1u;
+    for (unsigned s = 0; s < nslots; s++) {
+        seen[s] = s == 0 || s <= (unsigned)fn->arity;
+        lo[s] = 0;
+        hi[s] = s == 0 ? last : 0;
+    }
+
+    for (int off = 0; off < c->count;) {
+        uint8_t op = c->code[off];
+        int len = instructionLength(c, off);
+        if (len <= 0) return false;
+        int at = jaiOpBranchOperandAt(op);
+        if (at >= 0) {
+            long target = (long)off + len + jaiReadI16(c->code + off + 1 + at);
+            if (target <= off) {
+                if (regions >= JIT_MAX_LIVE_REGIONS || target < 0) return false;
+                regionTop[regions] = (uint32_t)target;
+                regionEnd[regions] = (uint32_t)off;
+                regions++;
+            }
+        }
+        int slotAt[3];
+        int count = jaiOpSlotOperands(op, slotAt);
+        for (int k = 0; k < count; k++) {
+            unsigned s = jaiReadU16(c->code + off + 1 + slotAt[k]);
+            if (s >= nslots) continue;
+            /* The operands these opcodes only ever store to; every other slot
+             * operand is read, whatever else the instruction does with it. */
+            bool writes = (k == 0 && (op == OP_SET_LOCAL || op == OP_BIND ||
+                                      op == OP_ADD_BIND || op == OP_SUB_BIND ||
+                                      op == OP_MUL_BIND ||
+                                      op == OP_FOR_ITER_BIND ||
+                                      op == OP_FOR_RANGE_BIND)) ||
+                          op == OP_FOR_ITER_PAIR || op == OP_ITER_RANGE;
+            if (!seen[s]) {
+                seen[s] = true;
+                lo[s] = writes ? (uint32_t)off : 0u;
+            }
+            if ((uint32_t)off > hi[s]) hi[s] = (uint32_t)off;
+        }
+        if (op == OP_CLOSURE) {
+            for (int u = off + 4; u + 3 <= off + len; u += 3) {
+                uint8_t how = c->code[u];
+                if (how == 0) continue;   /* an upvalue of this closure's own */
+                unsigned s = jaiReadU16(c->code + u + 1);
+                if (s >= nslots) continue;
+                bool byRef = (how & 1u) != 0 && (how & 2u) == 0;
+                if (!seen[s] || byRef) lo[s] = 0;
+                seen[s] = true;
+                if (byRef) hi[s] = last;
+                else if ((uint32_t)off > hi[s]) hi[s] = (uint32_t)off;
+            }
+        }
+        off += len;
+    }
+    for (uint16_t i = 0; i < fn->exceptionCount; i++) {
+        const ExceptionEntry *x = &fn->exceptions[i];
+        if (x->handler >= x->end) continue;
+        if (regions >= JIT_MAX_LIVE_REGIONS) return false;
+        regionTop[regions] = x->handler;
+        regionEnd[regions] = x->end;
+        regions++;
+    }
+
+    for (bool grew = true; grew;) {
+        grew = false;
+        for (unsigned r = 0; r < regions; r++) {
+            for (unsigned s = 0; s < nslots; s++) {
+                if (!seen[s]) continue;
+                if (lo[s] > regionEnd[r] || hi[s] < regionTop[r]) continue;
+                if (lo[s] > regionTop[r]) { lo[s] = regionTop[r]; grew = true; }
+                if (hi[s] < regionEnd[r]) { hi[s] = regionEnd[r]; grew = true; }
+            }
+        }
+    }
+    return true;
+}
+
+/* Only a slot whose every bit pattern is harmless may take over a register
+ * from another: the deopt stub and the root fill both read a home whenever its
+ * slot is live, and between an inherited register's hand-over and the slot's
+ * first store that home still holds the LAST owner's value. An int, a float or
+ * a bool made of someone else's bits is a wrong number nobody reads; an object
+ * kind made of them is a pointer the collector would chase. */
+static bool slotMayShare(const Emit *e, const Emit *m, unsigned slot) {
+    if (!e->liveRanges) return false;
+    SlotKind k = m->localKind[slot];
+    return k == SLOT_INT || k == SLOT_FLOAT || k == SLOT_BOOL;
+}
+
+/* An evicted slot is offered the other bank before the frame, as the
+ * whole-body plan would have offered it: a register there free since before
+ * the slot's range began -- or never held, for a slot that may not share. */
+static void rehomeEvicted(Emit *e, const Emit *m, unsigned slot, bool fp,
+                          int *held, bool *ever, uint32_t *lastHi,
+                          unsigned avail, unsigned xBase, unsigned *top) {
+    if (fp && e->osr && m->localKind[slot] != SLOT_FLOAT) return;
+    if ((fp ? m->slotSaveFp[slot] : m->slotSaveX[slot]) == 0) return;
+    bool shares = slotMayShare(e, m, slot);
+    uint32_t lo = e->liveRanges ? e->slotLiveLo[slot] : 0u;
+    for (unsigned r = 0; r < avail; r++) {
+        if (held[r] >= 0) continue;
+        if (ever[r] && (!shares || lastHi[r] >= lo)) continue;
+        held[r] = (int)slot;
+        e->slotInherits[slot] = ever[r];
+        ever[r] = true;
+        lastHi[r] = e->liveRanges ? e->slotLiveHi[slot] : UINT32_MAX;
+        if (fp) e->slotFpReg[slot] = (uint8_t)(JIT_FP_FIRST_SAVED + r);
+        else    e->slotXReg[slot] = (uint8_t)(JIT_FIRST_SAVED + xBase + r);
+        if (r + 1u > *top) *top = r + 1u;
+        return;
+    }
+}
+
+/* Linear scan over those ranges, in order of where they start, both register
+ * banks at once; both tiers plan through it, on the same ledgers (see
+ * noteSlotCost).
+ *
+ * A slot is offered the bank that saves it more first, then the other. When
+ * neither has a free register, the live holder that saves least in that bank
+ * is evicted if this slot would save more, and goes to the other bank or the
+ * frame -- for its whole range, never split, since a split would need moves
+ * at every edge that crosses it and the frame home is one `ldr` away anyway.
+ * A register frees up when its holder's range ends, and only a slot slotMayShare allows takes a
+ * register that has had a holder before; every other slot keeps its register
+ * to itself from the prologue on, exactly as the whole-body plan this replaced
+ * gave them out.
+ *
+ * Three exclusions, unchanged from that plan: a zero-saving slot is skipped
+ * outright, not just ranked last (else a tie-break could pay a prologue write
+ * for nothing); a dynamic slot keeps its frame home, since only the frame has
+ * anywhere to put a run-time tag; and a wrong guess costs an `fmov`, never a
+ * wrong answer, since only fmov/ldr/str ever touch a home.
+ *
+ * What is still per-tier is named here rather than duplicated:
  *
  *   `skip`     slots the caller has already ruled out for reasons the ledgers
  *              cannot see -- OSR passes the ones captured by reference by a
@@ -9192,116 +10390,298 @@ static const uint8_t *loopDepthFor(const Chunk *c, unsigned *count);
  *              one-byte `strb`, which is the garbage-high-byte bug the OSR
  *              prologue's X arm narrows against. Only a float may take an FP
  *              home there.
+ *   ranges     the function tier's (e->liveRanges); OSR has none, so every
+ *              range is the whole loop and nothing is ever handed over.
  *   `strandedOut`  counted for the OSR census: slots that earned a register and
- *              found none left, which is what a wider bank would buy. */
+ *              found none left, which is what a wider bank would buy. The
+ *              function tier reads the same count as e->frameHomes. */
 static void planSlotRegisters(Emit *e, const Emit *m, unsigned availX,
                               const bool *skip, unsigned *strandedOut) {
-    unsigned availFp = JIT_FP_MAX_SAVED;
     unsigned xBase = e->osr ? osrReserved(e) : 0u;
     unsigned top = e->base + e->locals;
     if (top > JIT_MAX_SLOTS + 1u) top = JIT_MAX_SLOTS + 1u;
-    while (availX > 0 || availFp > 0) {
-        unsigned bestSlot = 0, bestGain = 0;
-        bool bestFp = false;
-        for (unsigned slot = e->base; slot < top; slot++) {
-            if (e->slotXReg[slot] != 0 || e->slotFpReg[slot] != 0) continue;
-            if (e->dynamicLocal[slot]) continue;
-            if (skip != NULL && skip[slot]) continue;
-            bool fpOk = !e->osr || m->localKind[slot] == SLOT_FLOAT;
-            if (availFp > 0 && fpOk && m->slotSaveFp[slot] > bestGain) {
-                bestGain = m->slotSaveFp[slot];
-                bestSlot = slot;
-                bestFp   = true;
-            }
-            if (availX > 0 && m->slotSaveX[slot] > bestGain) {
-                bestGain = m->slotSaveX[slot];
-                bestSlot = slot;
-                bestFp   = false;
-            }
-        }
-        if (bestGain == 0) break;
-        if (bestFp) {
-            e->slotFpReg[bestSlot] =
-                (uint8_t)(JIT_FP_FIRST_SAVED + e->fpLocals++);
-            availFp--;
-        } else {
-            e->slotXReg[bestSlot] =
-                (uint8_t)(JIT_FIRST_SAVED + xBase + e->xLocals++);
-            availX--;
-        }
-    }
-    if (strandedOut == NULL) return;
+    if (availX > JIT_MAX_SAVED) availX = JIT_MAX_SAVED;
+
+    uint8_t  order[JIT_MAX_SLOTS + 1];
+    uint32_t gain[JIT_MAX_SLOTS + 1];
+    unsigned n = 0;
     for (unsigned slot = e->base; slot < top; slot++) {
-        if (e->slotXReg[slot] != 0 || e->slotFpReg[slot] != 0) continue;
+        e->slotInherits[slot] = false;
         if (e->dynamicLocal[slot]) continue;
         if (skip != NULL && skip[slot]) continue;
-        if (m->slotSaveX[slot] == 0 && m->slotSaveFp[slot] == 0) continue;
-        (*strandedOut)++;
+        bool fpOk = !e->osr || m->localKind[slot] == SLOT_FLOAT;
+        uint32_t g = m->slotSaveX[slot];
+        if (fpOk && m->slotSaveFp[slot] > g) g = m->slotSaveFp[slot];
+        if (g == 0) continue;
+        /* Insertion sort: by start, then most-saving first. Sixty-five
+         * entries at most, once per compile. */
+        uint32_t lo = e->liveRanges ? e->slotLiveLo[slot] : 0u;
+        unsigned at = n++;
+        while (at > 0) {
+            unsigned prev = order[at - 1];
+            uint32_t plo = e->liveRanges ? e->slotLiveLo[prev] : 0u;
+            if (plo < lo || (plo == lo && gain[prev] >= g)) break;
+            order[at] = order[at - 1];
+            at--;
+        }
+        order[at] = (uint8_t)slot;
+        gain[slot] = g;
+    }
+
+    /* Per register, its current holder (-1 for none) and whether it has ever
+     * had one. A holder that may not share never expires. */
+    int      xHeld[JIT_MAX_SAVED], fpHeld[JIT_FP_MAX_SAVED];
+    bool     xEver[JIT_MAX_SAVED], fpEver[JIT_FP_MAX_SAVED];
+    uint32_t xLastHi[JIT_MAX_SAVED], fpLastHi[JIT_FP_MAX_SAVED];
+    for (unsigned r = 0; r < JIT_MAX_SAVED; r++) {
+        xHeld[r] = -1; xEver[r] = false; xLastHi[r] = 0;
+    }
+    for (unsigned r = 0; r < JIT_FP_MAX_SAVED; r++) {
+        fpHeld[r] = -1; fpEver[r] = false; fpLastHi[r] = 0;
+    }
+    unsigned xTop = 0, fpTop = 0;
+
+    for (unsigned i = 0; i < n; i++) {
+        unsigned slot = order[i];
+        bool shares = slotMayShare(e, m, slot);
+        uint32_t lo = e->liveRanges ? e->slotLiveLo[slot] : 0u;
+        for (unsigned r = 0; r < availX; r++) {
+            int h = xHeld[r];
+            if (h >= 0 && slotMayShare(e, m, (unsigned)h) &&
+                e->slotLiveHi[h] < lo) {
+                xHeld[r] = -1;
+            }
+        }
+        for (unsigned r = 0; r < JIT_FP_MAX_SAVED; r++) {
+            int h = fpHeld[r];
+            if (h >= 0 && slotMayShare(e, m, (unsigned)h) &&
+                e->slotLiveHi[h] < lo) {
+                fpHeld[r] = -1;
+            }
+        }
+
+        bool fpOk = !e->osr || m->localKind[slot] == SLOT_FLOAT;
+        uint32_t gx = m->slotSaveX[slot];
+        uint32_t gf = fpOk ? m->slotSaveFp[slot] : 0u;
+        bool placed = false;
+        for (unsigned pass = 0; pass < 2u && !placed; pass++) {
+            /* FP first on a tie, as the greedy plan's strict comparison did. */
+            bool fp = (pass == 0) == (gf >= gx);
+            uint32_t g = fp ? gf : gx;
+            if (g == 0) continue;
+            int      *held  = fp ? fpHeld : xHeld;
+            bool     *ever  = fp ? fpEver : xEver;
+            unsigned  avail = fp ? JIT_FP_MAX_SAVED : availX;
+            uint32_t *lastHi = fp ? fpLastHi : xLastHi;
+            const uint32_t *save = fp ? m->slotSaveFp : m->slotSaveX;
+            int pick = -1;
+            for (unsigned r = 0; r < avail && pick < 0; r++) {
+                if (held[r] < 0 && (shares || !ever[r])) pick = (int)r;
+            }
+            bool inherits = pick >= 0 && ever[pick];
+            if (pick < 0) {
+                /* Evict the cheapest holder this slot could stand in for: one
+                 * that took a fresh register, unless this slot may share. */
+                uint32_t worst = g;
+                for (unsigned r = 0; r < avail; r++) {
+                    int h = held[r];
+                    if (h < 0 || save[h] >= worst) continue;
+                    if (!shares && e->slotInherits[h]) continue;
+                    worst = save[h];
+                    pick = (int)r;
+                }
+                if (pick < 0) continue;
+                unsigned h = (unsigned)held[pick];
+                inherits = e->slotInherits[h];
+                e->slotInherits[h] = false;
+                if (fp) e->slotFpReg[h] = 0;
+                else    e->slotXReg[h] = 0;
+                rehomeEvicted(e, m, h, !fp, fp ? xHeld : fpHeld,
+                              fp ? xEver : fpEver, fp ? xLastHi : fpLastHi,
+                              fp ? availX : JIT_FP_MAX_SAVED, xBase,
+                              fp ? &xTop : &fpTop);
+            }
+            held[pick] = (int)slot;
+            ever[pick] = true;
+            lastHi[pick] = e->liveRanges ? e->slotLiveHi[slot] : UINT32_MAX;
+            e->slotInherits[slot] = inherits;
+            if (fp) {
+                e->slotFpReg[slot] = (uint8_t)(JIT_FP_FIRST_SAVED + (unsigned)pick);
+                if ((unsigned)pick + 1u > fpTop) fpTop = (unsigned)pick + 1u;
+            } else {
+                e->slotXReg[slot] =
+                    (uint8_t)(JIT_FIRST_SAVED + xBase + (unsigned)pick);
+                if ((unsigned)pick + 1u > xTop) xTop = (unsigned)pick + 1u;
+            }
+            placed = true;
+        }
+    }
+    e->xLocals = xTop;
+    e->fpLocals = fpTop;
+
+    e->sharedHomes = 0;
+    e->frameHomes = 0;
+    for (unsigned i = 0; i < n; i++) {
+        unsigned slot = order[i];
+        if (e->slotInherits[slot]) e->sharedHomes++;
+        if (e->slotXReg[slot] == 0 && e->slotFpReg[slot] == 0) e->frameHomes++;
     }
+    if (strandedOut != NULL) *strandedOut += e->frameHomes;
 }
 
-/* Writes a body into the arena and seals it again, or seals and reports
- * failure.
- *
- * The sealing is the point. `jaiCodeArenaUnseal` turns the WHOLE arena back to
- * read-write, which takes the execute bit off every function already compiled
- * into it -- so an early return between the unseal and the seal leaves the
- * tier's entire back catalogue unexecutable, and the next call into any of it
- * dies with KERN_PROTECTION_FAILURE inside `callClosure`. That is not
- * hypothetical: the write fails exactly when the 1 MB arena is full, which a
- * long enough run reaches, and it produced an intermittent SIGBUS in the test
- * suite that moved around as unrelated changes altered how much got compiled.
- * Every exit from here re-seals. */
-static uint8_t *arenaEmit(JaiCodeArena *arena, const uint32_t *code,
-                          unsigned count) {
-    while ((arena->used & 31u) != 0) {
-        uint32_t pad = jaiA64Nop();
-        if (jaiCodeArenaWrite(arena, &pad, sizeof pad) == NULL) {
-            jaiCodeArenaSeal(arena);
-            return NULL;
-        }
-    }
-    uint8_t *entry = jaiCodeArenaWrite(arena, code, count * sizeof code[0]);
-    if (entry == NULL) {
-        jaiCodeArenaSeal(arena);
-        return NULL;
+/* The words are the plan; this is the code. On arm64 they are the same thing,
+ * and on x86-64 jit_x64.c turns them into the x86-64 that does the same thing
+ * -- a body it cannot lower declines like any other unsupported shape. Either
+ * way the result is a malloc'd copy, made on whichever thread compiled it, so
+ * that placing it is all that is left for the interpreter's. */
+static bool lowerForHost(const uint32_t *code, unsigned count, uint8_t **out,
+                         size_t *length, JaiJitLine *lines,
+                         unsigned lineCount) {
+#if defined(__x86_64__)
+    const char *why = NULL;
+    uint32_t *byteAt = NULL;
+    if (lines != NULL) {
+        byteAt = malloc(sizeof *byteAt * ((size_t)count + 1));
+        if (byteAt == NULL) return false;
     }
-    if (!jaiCodeArenaSeal(arena)) return NULL;
-    return entry;
+    if (!jaiX64LowerMapped(code, count, out, length, byteAt, &why)) {
+        if (getenv("JAI_JIT_WHY")) {
+            fprintf(stderr, "[jit] x86-64 lowering stopped: %s\n",
+                    why != NULL ? why : "unknown");
+        }
+        free(byteAt);
+        return false;
+    }
+    for (unsigned i = 0; i < lineCount; i++) {
+        lines[i].codeOffset = byteAt[lines[i].codeOffset];
+    }
+    free(byteAt);
+    return true;
+#else
+    *length = (size_t)count * sizeof code[0];
+    *out = malloc(*length);
+    if (*out == NULL) return false;
+    memcpy(*out, code, *length);
+    for (unsigned i = 0; i < lineCount; i++) {
+        lines[i].codeOffset *= (uint32_t)sizeof code[0];
+    }
+    return true;
+#endif
+}
+
+static int lineOrder(const void *a, const void *b) {
+    const JaiJitLine *x = a, *y = b;
+    if (x->codeOffset != y->codeOffset) return x->codeOffset < y->codeOffset ? -1 : 1;
+    return x->bcOffset < y->bcOffset ? -1 : x->bcOffset > y->bcOffset;
+}
+
+/* Where each bytecode instruction the body compiled begins, as word indices
+ * until lowerForHost turns them into bytes. Only for the jitdump, which wants
+ * source lines against addresses; NULL whenever it is not being written.
+ * Instructions inlined from a callee are not in `map` (see OP_CALL's inliner,
+ * which swaps in its own), so they count against the call site's line. */
+static JaiJitLine *wordLines(const int *map, int mapCount, unsigned *count) {
+    *count = 0;
+    if (!jaiJitPerfWantsLines()) return NULL;
+    unsigned n = 0;
+    for (int i = 0; i < mapCount; i++) n += map[i] >= 0;
+    if (n == 0) return NULL;
+    JaiJitLine *lines = malloc(sizeof *lines * n);
+    if (lines == NULL) return NULL;
+    n = 0;
+    for (int i = 0; i < mapCount; i++) {
+        if (map[i] < 0) continue;
+        lines[n].codeOffset = (uint32_t)map[i];
+        lines[n].bcOffset = (uint32_t)i;
+        n++;
+    }
+    qsort(lines, n, sizeof *lines, lineOrder);
+    *count = n;
+    return lines;
+}
+
+/* Places a built body and points the function at it. False leaves the
+ * function exactly as it was: the entry is written last, and nothing reads
+ * the other fields without it. */
+static bool installBuilt(ObjFunction *fn, const JitBuilt *b) {
+    /* The entry is 32-aligned (JAI_CODE_ALIGN), which is two things at once.
+     *
+     * The literal pool's alignment is what it looks, as the 8-align this
+     * replaced already gave. And every body now starts at a fixed offset
+     * modulo the fetch block, so a size change ANYWHERE upstream stops
+     * relabelling where every later body lands. That relabelling was the
+     * suite's largest source of false A/B results: sweeping 0-7 padding nops
+     * moved bitops +/-13% and loop_sum +/-7% with byte-identical loop bodies,
+     * and matrix_mul +/-18.9% and list_ops +/-15.4% were both observed between
+     * binaries with identical dynamic instruction counts. The cost is at most
+     * 28 wasted bytes per compiled body.
+     *
+     * Guarded by the module's version, which is what the caller is about to
+     * pin it to: a body found running after that moves may be calling other
+     * stale bodies, and the heap must not reclaim them under it. */
+    uint8_t *entry = fn->module != NULL
+        ? jaiCodeHeapPlace(jaiJitCodeHeap(), b->code, b->length,
+                           &fn->module->version, fn->module->version)
+        : jaiCodeHeapPlace(jaiJitCodeHeap(), b->code, b->length, NULL, 0);
+    if (entry == NULL) return false;
+    for (unsigned i = 0; i < b->argCount; i++) {
+        fn->jitParamKind[i]  = b->paramKind[i];
+        fn->jitParamShape[i] = b->paramShape[i];
+    }
+    fn->jitReturnKind  = b->returnKind;
+    fn->jitReturnShape = b->returnShape;
+    if (b->returnClass != NULL) jaiClassRememberShape(b->returnClass);
+    fn->jitArgBase     = b->argBase;
+    fn->jitArgCount    = b->argCount;
+    fn->jitFuncNoWrite = b->noWrite;
+    fn->jitFunc = entry;
+    if (JAI_UNLIKELY(jaiJitPerfEnabled())) {
+        jaiJitPerfNote(fn, NULL, 0, entry, b->length, b->lines, b->lineCount);
+    }
+    return true;
 }
 
 static bool compileFuncOnce(ObjClosure *closure, Value *slotBase,
                             const bool *dynamic, bool *needDynamic,
                             const bool *nullable, bool *needNullable,
-                            bool noInline);
+                            bool noInline, JitBuilt *out);
 
-bool jaiJitCompileFunc(ObjClosure *closure, Value *slotBase) {
-    ObjFunction *fn = closure->fn;
-    if (!eligible(fn)) return false;
+/* A round that stopped for want of a sample is over: every later attempt would
+ * stop at the same place, and the next round will have it. */
+static bool jobMissed(void) {
+    return gJob != NULL && gJob->missed;
+}
+
+static bool compileFunc(ObjClosure *closure, Value *slotBase, JitBuilt *out) {
 
     /* Up to a few attempts: each one may discover another slot that two paths
-     * disagree about, and the next begins knowing it. */
+     * disagree about, and the next begins knowing it. Eight, not four: the
+     * front end hands a dead variable's slot to the next one declared, so a
+     * kernel in stages -- floats, then ints in the same slots -- has that many
+     * to find, and a failed attempt stops at its conflict and costs little. */
     bool dynamic[JIT_MAX_SLOTS + 1];
     bool need[JIT_MAX_SLOTS + 1];
     bool nullable[JIT_MAX_SLOTS + 1];
     bool needNull[JIT_MAX_SLOTS + 1];
     memset(dynamic, 0, sizeof dynamic);
     memset(nullable, 0, sizeof nullable);
-    for (int attempt = 0; attempt < 4; attempt++) {
+    for (int attempt = 0; attempt < 8; attempt++) {
         memset(need, 0, sizeof need);
         memset(needNull, 0, sizeof needNull);
         if (compileFuncOnce(closure, slotBase, dynamic, need, nullable,
-                            needNull, false)) {
+                            needNull, false, out)) {
             return true;
         }
+        if (jobMissed()) return false;
         /* An inlined body that could not be emitted is not a decline: the
          * same call through the descriptor still compiles, and a compiled
          * form with a real call in it beats none at all. */
         if (gInlineFailed &&
             compileFuncOnce(closure, slotBase, dynamic, need, nullable,
-                            needNull, true)) {
+                            needNull, true, out)) {
             return true;
         }
+        if (jobMissed()) return false;
         bool grew = false;
         for (unsigned i = 0; i <= JIT_MAX_SLOTS; i++) {
             if (need[i] && !dynamic[i]) { dynamic[i] = true; grew = true; }
@@ -9316,24 +10696,256 @@ bool jaiJitCompileFunc(ObjClosure *closure, Value *slotBase) {
     return false;
 }
 
+bool jaiJitCompileFunc(ObjClosure *closure, Value *slotBase) {
+    if (!eligible(closure->fn)) return false;
+    JitBuilt built;
+    memset(&built, 0, sizeof built);
+    bool ok = compileFunc(closure, slotBase, &built) &&
+              installBuilt(closure->fn, &built);
+    free(built.code);
+    free(built.lines);
+    return ok;
+}
+
+/* Copies `count` values into a new sample. False only when out of memory,
+ * which the caller reports as a failed job -- never as an empty sample, which
+ * would be a claim about the heap. */
+static bool jobAddSample(JaiJitJob *job, const Obj *obj, int type,
+                         ObjString *name, int32_t count, const Value *values,
+                         unsigned valueCount) {
+    if (job->sampleCount == job->sampleCapacity) {
+        unsigned cap = job->sampleCapacity < 16 ? 16 : job->sampleCapacity * 2;
+        JitSample *grown = realloc(job->samples, sizeof *grown * cap);
+        if (grown == NULL) return false;
+        job->samples = grown;
+        job->sampleCapacity = cap;
+    }
+    JitSample *s = &job->samples[job->sampleCount];
+    s->obj = obj;
+    s->type = type;
+    s->name = name;
+    s->count = count;
+    s->valueCount = (uint16_t)valueCount;
+    s->values = NULL;
+    if (valueCount > 0) {
+        s->values = malloc(sizeof(Value) * valueCount);
+        if (s->values == NULL) return false;
+        memcpy(s->values, values, sizeof(Value) * valueCount);
+    }
+    job->sampleCount++;
+    return true;
+}
+
+static bool jobHas(const JaiJitJob *job, const Obj *obj, ObjString *name) {
+    for (unsigned i = 0; i < job->sampleCount; i++) {
+        if (job->samples[i].obj == obj && job->samples[i].name == name) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/* What the sample helpers above read off a container, copied now. Anything
+ * that is not a container gets an empty sample, which reads as "nothing to
+ * specialise on" -- the same answer the live read would give. */
+static bool jobAddContainer(JaiJitJob *job, Value v) {
+    if (!IS_OBJ(v) || jobHas(job, AS_OBJ(v), NULL)) return true;
+    Obj *obj = AS_OBJ(v);
+    if (IS_INSTANCE(v)) {
+        ObjInstance *inst = AS_INSTANCE(v);
+        unsigned n = (unsigned)inst->fieldCount;
+        return jobAddSample(job, obj, 0, NULL, (int32_t)n, inst->fields, n);
+    }
+    if (IS_LIST(v)) {
+        ObjList *list = AS_LIST(v);
+        return jobAddSample(job, obj, 0, NULL, (int32_t)list->count,
+                            list->items, list->count > 0 ? 1u : 0u);
+    }
+    if (IS_DICT(v)) {
+        ObjDict *dict = AS_DICT(v);
+        Value pair[2];
+        bool any = firstLiveEntry(&dict->table, &pair[0], &pair[1]);
+        return jobAddSample(job, obj, 0, NULL, (int32_t)dict->table.count,
+                            pair, any ? 2u : 0u);
+    }
+    if (IS_CLOSURE(v)) {
+        ObjClosure *cl = AS_CLOSURE(v);
+        Value seen[256];
+        unsigned n = 0;
+        /* Up to the first unset upvalue: sampleUpvalue declines on it live,
+         * and stopping there makes it decline on the copy too. */
+        while (n < (unsigned)cl->upvalueCount && n < 256u &&
+               cl->upvalues[n] != NULL) {
+            seen[n] = *cl->upvalues[n]->location;
+            n++;
+        }
+        return jobAddSample(job, obj, 0, NULL, (int32_t)n, seen, n);
+    }
+    return jobAddSample(job, obj, 0, NULL, 0, NULL, 0);
+}
+
+static bool jobAddGlobal(JaiJitJob *job, ObjModule *m, ObjString *name) {
+    if (jobHas(job, &m->obj, name)) return true;
+    Value v;
+    bool found = jaiModuleGet(m, name, &v);
+    return jobAddSample(job, &m->obj, 0, name, 0, &v, found ? 1u : 0u);
+}
+
+/* Resolved exactly as sampleBuiltin resolves it live, on a receiver of the
+ * wanted type. A list is the only type the compile asks about without having
+ * one in hand, so it is the only one made here. */
+static bool jobAddBuiltin(JaiJitJob *job, Value receiver, int type,
+                          ObjString *name) {
+    for (unsigned i = 0; i < job->sampleCount; i++) {
+        const JitSample *s = &job->samples[i];
+        if (s->obj == NULL && s->type == type && s->name == name) return true;
+    }
+    if (!IS_OBJ(receiver) && type == 16 + (int)OBJ_LIST) {
+        receiver = OBJ_VAL(jaiListNew(0));
+    }
+    jaiGCPushRoot(receiver);
+    Value method;
+    bool found = jaiBuiltinMethod(receiver, name, &method);
+    jaiGCPopRoots(1);
+    if (found && IS_BOUND(method)) method = AS_BOUND(method)->method;
+    return jobAddSample(job, NULL, type, name, 0, &method, found ? 1u : 0u);
+}
+
+void jaiJitJobFree(JaiJitJob *job) {
+    if (job == NULL) return;
+    for (unsigned i = 0; i < job->sampleCount; i++) {
+        free(job->samples[i].values);
+    }
+    free(job->samples);
+    free(job->chunkDepth);
+    free(job->built.code);
+    free(job->built.lines);
+    free(job);
+}
+
+JaiJitJob *jaiJitJobNew(ObjClosure *closure, Value *slotBase) {
+    ObjFunction *fn = closure->fn;
+    if (!eligible(fn) || fn->module == NULL) return NULL;
+    JaiJitJob *job = calloc(1, sizeof *job);
+    if (job == NULL) return NULL;
+    job->closure = closure;
+    job->moduleVersion = fn->module->version;
+    job->stackLimit = stackLimit();
+    job->strName = jaiStringIntern("str", 3);
+    unsigned argc = (unsigned)fn->arity + 1u;
+    memcpy(job->args, slotBase, sizeof(Value) * argc);
+    job->chunkDepth = malloc(sizeof(int) * (size_t)(fn->chunk.count + 1));
+    if (job->chunkDepth != NULL && !jaiChunkStackDepths(fn, job->chunkDepth)) {
+        free(job->chunkDepth);
+        job->chunkDepth = NULL;
+    }
+    /* What the first round will certainly read: the arguments and what they
+     * hold, the closure's own upvalues, and every name the body could resolve
+     * as a global. Everything else is asked for as it turns up. */
+    bool ok = job->strName != NULL &&
+              jobAddContainer(job, OBJ_VAL(closure));
+    for (unsigned i = 0; ok && i < argc; i++) {
+        ok = jobAddContainer(job, job->args[i]);
+    }
+    for (int i = 0; ok && i < fn->chunk.constants.count; i++) {
+        Value k = fn->chunk.constants.data[i];
+        if (!IS_STRING(k)) continue;
+        ok = jobAddGlobal(job, fn->module, AS_STRING(k)) &&
+             (vm.builtins == NULL ||
+              jobAddGlobal(job, vm.builtins, AS_STRING(k)));
+    }
+    if (!ok) {
+        jaiJitJobFree(job);
+        return NULL;
+    }
+    return job;
+}
+
+void jaiJitJobRun(JaiJitJob *job) {
+    job->missed = false;
+    job->wantCount = 0;
+    free(job->built.code);
+    free(job->built.lines);
+    memset(&job->built, 0, sizeof job->built);
+    gJob = job;
+    job->compiled = compileFunc(job->closure, job->args, &job->built);
+    gJob = NULL;
+    job->rounds++;
+}
+
+JaiJitJobResult jaiJitJobInstall(JaiJitJob *job) {
+    ObjFunction *fn = job->closure->fn;
+    if (!job->compiled && job->missed) {
+        if (job->rounds >= JIT_JOB_ROUNDS) return JAI_JIT_JOB_HERE;
+        for (unsigned i = 0; i < job->wantCount; i++) {
+            Value w = job->want[i];
+            bool ok;
+            if (job->wantName[i] != NULL && job->wantType[i] == 0 &&
+                IS_MODULE(w)) {
+                ok = jobAddGlobal(job, AS_MODULE(w), job->wantName[i]);
+            } else if (job->wantName[i] != NULL) {
+                ok = jobAddBuiltin(job, w, job->wantType[i], job->wantName[i]);
+            } else {
+                ok = jobAddContainer(job, w);
+            }
+            if (!ok) return JAI_JIT_JOB_HERE;
+        }
+        return JAI_JIT_JOB_AGAIN;
+    }
+    if (!job->compiled) return JAI_JIT_JOB_DECLINED;
+    /* A global was rebound while the body was being built. Installed, it
+     * would only be retired on its first entry, having cost a place in the
+     * code heap; declined, the function is compiled afresh once it is hot
+     * again. */
+    if (fn->module->version != job->moduleVersion) return JAI_JIT_JOB_DECLINED;
+    if (!installBuilt(fn, &job->built)) return JAI_JIT_JOB_DECLINED;
+    fn->jitFuncModuleVersion = job->moduleVersion;
+    return JAI_JIT_JOB_INSTALLED;
+}
+
+void jaiJitJobMark(const JaiJitJob *job) {
+    jaiGCMark(&job->closure->obj);
+    if (job->strName != NULL) jaiGCMark(&job->strName->obj);
+    for (unsigned i = 0; i <= (unsigned)job->closure->fn->arity; i++) {
+        jaiGCMarkVal(job->args[i]);
+    }
+    for (unsigned i = 0; i < job->sampleCount; i++) {
+        const JitSample *s = &job->samples[i];
+        if (s->obj != NULL) jaiGCMark((Obj *)s->obj);
+        if (s->name != NULL) jaiGCMark(&s->name->obj);
+        for (unsigned j = 0; j < s->valueCount; j++) jaiGCMarkVal(s->values[j]);
+    }
+    for (unsigned i = 0; i < job->wantCount; i++) {
+        jaiGCMarkVal(job->want[i]);
+        if (job->wantName[i] != NULL) jaiGCMark(&job->wantName[i]->obj);
+    }
+    if (job->built.returnClass != NULL) jaiGCMark(&job->built.returnClass->obj);
+}
+
+ObjClosure *jaiJitJobClosure(const JaiJitJob *job) {
+    return job->closure;
+}
+
 static bool compileFuncOnce(ObjClosure *closure, Value *slotBase,
                             const bool *dynamic, bool *needDynamic,
                             const bool *nullable, bool *needNullable,
-                            bool noInline) {
+                            bool noInline, JitBuilt *out) {
     ObjFunction *fn = closure->fn;
     gInlineFailed = false;
+    noInline = noInline || jitNoInline();
 
     if (getenv("JAI_JIT_WHY")) {
         fprintf(stderr, "[jit] considering %s\n",
                 fn->name ? fn->name->chars : "<anon>");
     }
 
-    JaiCodeArena *arena = jaiJitArena();
-    if (arena == NULL) return false;
-
-    int *map = JAI_ALLOC(int, fn->chunk.count + 1);
-    int *depths = JAI_ALLOC(int, fn->chunk.count + 1);
+    int *map = malloc(sizeof(int) * (size_t)(fn->chunk.count + 1));
+    int *depths = malloc(sizeof(int) * (size_t)(fn->chunk.count + 1));
     int *chunkDepth = chunkDepthTable(fn);
+    if (map == NULL || depths == NULL) {
+        jitFree(map, depths, chunkDepth, fn->chunk.count + 1);
+        return false;
+    }
     for (int i = 0; i <= fn->chunk.count; i++) { map[i] = -1; depths[i] = -1; }
 
 
@@ -9352,6 +10964,8 @@ static bool compileFuncOnce(ObjClosure *closure, Value *slotBase,
     e.chunkDepthCount = fn->chunk.count + 1;
     e.limitLiteral = -1;
     e.bailBlock    = -1;
+    e.liveRanges   = slotLiveRanges(fn, JIT_MAX_SLOTS + 1u, e.slotLiveLo,
+                                    e.slotLiveHi);
 
     /* The prologue can't be emitted first: its save set depends on how deep the operand stack gets,
      * which only the body knows. So the body goes into the buffer at a fixed offset and the prologue is written in front of it afterwards, with every instruction index shifted by the same amount. */
@@ -9365,6 +10979,11 @@ static bool compileFuncOnce(ObjClosure *closure, Value *slotBase,
      * whether the body reads it; the real pass then drops it if not. */
     body.base         = 0;
     body.locals       = (unsigned)fn->maxSlots;
+    /* The same ranges, so that the root count it measures is the one the
+     * real pass will root. */
+    body.liveRanges   = e.liveRanges;
+    memcpy(body.slotLiveLo, e.slotLiveLo, sizeof body.slotLiveLo);
+    memcpy(body.slotLiveHi, e.slotLiveHi, sizeof body.slotLiveHi);
     body.usesUpvalues = fn->upvalueCount > 0;
     body.callsOut     = true;      /* the measuring pass may emit one */
     body.measuring    = true;
@@ -9437,8 +11056,9 @@ static bool compileFuncOnce(ObjClosure *closure, Value *slotBase,
         /* Too many to keep in registers, so the operand stack takes the
          * registers first -- that is expression depth, not the number of
          * variables a function happens to declare -- and whatever is left over
-         * goes to the slots that earn it. What does not earn one lives in the
-         * frame. */
+         * goes to the slots that earn it, handed from one slot to the next
+         * where their live ranges do not meet. What does not earn one lives in
+         * the frame. */
         e.spilled = true;
         saved = extra + body.maxValue;
         if (saved > JIT_MAX_SAVED) {
@@ -9450,9 +11070,10 @@ static bool compileFuncOnce(ObjClosure *closure, Value *slotBase,
     }
     if (e.whyNot != NULL) {
         if (getenv("JAI_JIT_WHY")) {
-            fprintf(stderr, "[jit] %s stopped: %s (%u locals, %u stack)\n",
+            fprintf(stderr, "[jit] %s stopped: %s (%u locals, %u stack, "
+                    "%u spilled)\n",
                     fn->name ? fn->name->chars : "<anon>", e.whyNot, e.locals,
-                    body.maxValue);
+                    body.maxValue, e.frameHomes);
         }
         jitFree(map, depths, chunkDepth, fn->chunk.count + 1);
         return false;
@@ -9538,9 +11159,12 @@ static bool compileFuncOnce(ObjClosure *closure, Value *slotBase,
     /* A local the interpreter would have left as NULL_VAL starts at zero here.
      * The checker guarantees definite assignment before any read, so this is
      * belt and braces -- but a register holding the last call's value would be
-     * a bug that only shows up under recursion. */
+     * a bug that only shows up under recursion. A slot that inherits its
+     * register is left alone: the register is an earlier slot's until then, and
+     * that slot may be an argument. */
     for (unsigned i = realArgs; i < e.locals; i++) {
         unsigned slot = e.base + i;
+        if (e.slotInherits[slot]) continue;
         if (!e.spilled) {
             emit(&e, jaiA64MovzX(JIT_FIRST_SAVED + i, 0, 0));
         } else if (e.slotXReg[slot] != 0) {
@@ -9631,6 +11255,15 @@ static bool compileFuncOnce(ObjClosure *closure, Value *slotBase,
                 skipLocals |= (uint64_t)1 << i;
                 continue;
             }
+            /* Out of its live range the home may hold the slot's own dead
+             * pointer, no longer rooted, or the bits of whichever slot has the
+             * register now. The interpreter stores before it reads, so the
+             * frame's own copy -- null or the argument bindCallArgs put there
+             * -- serves, and costs the stub nothing. */
+            if (!slotLiveAt(&e, slot, e.deopt[k].ip)) {
+                skipLocals |= (uint64_t)1 << i;
+                continue;
+            }
             /* Only an opaque slot is null; everything else non-scalar is an object. Listing object kinds
              * explicitly instead once wrote a SLOT_OBJ local (string/dict/closure) out as null on every deopt -- invisible until a body holding one could compile and then actually deopt. */
             unsigned tag = kind == SLOT_INT    ? VAL_INT
@@ -9774,7 +11407,7 @@ static bool compileFuncOnce(ObjClosure *closure, Value *slotBase,
 
     /* One throwing stub per operator, out of line: the hot path keeps the same
      * single not-taken b.vs it always had. */
-    for (unsigned i = 0; i < 3; i++) {
+    for (unsigned i = 0; i < 4; i++) {
         if (!e.overflowUsed[i]) { e.overflowStub[i] = -1; continue; }
         e.overflowStub[i] = (int)e.count;
         emit(&e, jaiA64MovzX(0, i, 0));
@@ -9787,7 +11420,7 @@ static bool compileFuncOnce(ObjClosure *closure, Value *slotBase,
     /* Literal pool, 8-byte aligned so the 64-bit loads are aligned. */
     if ((e.count & 1u) != 0) emit(&e, jaiA64Nop());
     e.limitLiteral = (int)e.count;
-    uintptr_t limit = stackLimit();
+    uintptr_t limit = gJob != NULL ? gJob->stackLimit : stackLimit();
     if (limit == 0) {
         if (getenv("JAI_JIT_WHY")) {
             fprintf(stderr, "[jit] %s stopped: no stack bound available\n",
@@ -9869,7 +11502,7 @@ static bool compileFuncOnce(ObjClosure *closure, Value *slotBase,
                 return false;
             }
         } else if (f->targetOffset <= FIXUP_OVF &&
-                   f->targetOffset >= FIXUP_OVF - 2u) {
+                   f->targetOffset >= FIXUP_OVF - 3u) {
             target = e.overflowStub[FIXUP_OVF - f->targetOffset];
             if (target < 0) {
                 if (getenv("JAI_JIT_WHY")) {
@@ -9936,26 +11569,10 @@ static bool compileFuncOnce(ObjClosure *closure, Value *slotBase,
             }
         }
     }
+    unsigned lineCount = 0;
+    JaiJitLine *lines = wordLines(map, fn->chunk.count + 1, &lineCount);
     jitFree(map, depths, chunkDepth, fn->chunk.count + 1);
 
-    /* A `bl` at instruction i must reach instruction 0 of this function, so
-     * the recursive-call fixups above are relative to the function's own
-     * start, which is where the arena is about to place it. */
-    if (!jaiCodeArenaUnseal(arena)) return false;
-    /* The entry is 32-aligned, which is two things at once.
-     *
-     * The literal pool's alignment is what it looks, as the 8-align this
-     * replaced already gave. And every body now starts at a fixed offset
-     * modulo the fetch block, so a size change ANYWHERE upstream stops
-     * relabelling where every later body lands. That relabelling was the
-     * suite's largest source of false A/B results: sweeping 0-7 padding nops
-     * moved bitops +/-13% and loop_sum +/-7% with byte-identical loop bodies,
-     * and matrix_mul +/-18.9% and list_ops +/-15.4% were both observed between
-     * binaries with identical dynamic instruction counts. The cost is at most
-     * 28 wasted bytes per compiled body in a 1 MB arena. */
-    uint8_t *entry = arenaEmit(arena, e.code, e.count);
-    if (entry == NULL) return false;
-
     /* The tier's whole bail protocol rests on partial execution being invisible. Field writes end that:
      * a body that stores to an instance and then bails would have the store applied again by the interpreted re-run. Nothing in the suite hits this, but "hard to construct" isn't the standard a compiled tier gets to work to. */
     if (e.whyNot != NULL && getenv("JAI_JIT_WHY")) {
@@ -9967,7 +11584,7 @@ static bool compileFuncOnce(ObjClosure *closure, Value *slotBase,
             fprintf(stderr, "[jit] %s declined: a bail follows a heap write\n",
                     fn->name ? fn->name->chars : "<anon>");
         }
-        jitFree(map, depths, chunkDepth, fn->chunk.count + 1);
+        free(lines);
         return false;
     }
 
@@ -9979,43 +11596,55 @@ static bool compileFuncOnce(ObjClosure *closure, Value *slotBase,
         }
         /* A self-call before the first return had to guess, and guessed
          * wrong. */
+        free(lines);
         return false;
     }
+
+    /* A `bl` at instruction i must reach instruction 0 of this function, so
+     * the recursive-call fixups above are relative to the function's own
+     * start -- which is what keeps the body position-independent until
+     * installBuilt gives it one. */
+    memset(out, 0, sizeof *out);
     for (unsigned i = 0; i < argCount; i++) {
         if (e.usesUpvalues && i == closureArg) {
-            fn->jitParamKind[i]  = (uint8_t)SLOT_CLOSURE;
-            fn->jitParamShape[i] = 0;
+            out->paramKind[i]  = (uint8_t)SLOT_CLOSURE;
+            out->paramShape[i] = 0;
             continue;
         }
-        fn->jitParamKind[i]  = (uint8_t)e.localKind[i + e.base];
-        fn->jitParamShape[i] = e.localShape[i + e.base];
+        out->paramKind[i]  = (uint8_t)e.localKind[i + e.base];
+        out->paramShape[i] = e.localShape[i + e.base];
     }
-    fn->jitReturnKind = (uint8_t)e.returnKind;
-    fn->jitReturnShape = e.returnShape;
+    out->returnKind  = (uint8_t)e.returnKind;
+    out->returnShape = e.returnShape;
     if (e.returnKind == SLOT_INST && e.returnShape != 0) {
-        ObjClass *rc = NULL;
         for (unsigned i = 0; i < e.base + e.locals; i++) {
             if (e.localClass[i] != NULL &&
                 e.localClass[i]->shapeId == e.returnShape) {
-                rc = e.localClass[i];
+                out->returnClass = e.localClass[i];
                 break;
             }
         }
-        jaiClassRememberShape(rc);
     }
-    fn->jitArgBase    = (uint8_t)e.base;
-    fn->jitArgCount   = (uint8_t)argCount;
-    fn->jitFuncNoWrite = !e.wroteHeap;
+    out->argBase  = (uint8_t)e.base;
+    out->argCount = (uint8_t)argCount;
+    out->noWrite  = !e.wroteHeap;
+    if (!lowerForHost(e.code, e.count, &out->code, &out->length, lines,
+                      lineCount)) {
+        free(lines);
+        return false;
+    }
+    out->lines = lines;
+    out->lineCount = lineCount;
 
     if (getenv("JAI_JIT_WHY")) {
         fprintf(stderr,
                 "[jit] compiled %s  arity=%u locals=%u insts=%u saved=%u "
-                "spill=%d xloc=%u fploc=%u fix=%u deopt=%u maxval=%u base=%u\n",
+                "spill=%u shared=%u xloc=%u fploc=%u fix=%u deopt=%u "
+                "maxval=%u base=%u\n",
                 fn->name ? fn->name->chars : "<anon>", e.arity, e.locals,
-                e.count, e.savedCount, (int)e.spilled, e.xLocals, e.fpLocals,
-                e.fixupCount, e.deoptCount, body.maxValue, e.base);
+                e.count, e.savedCount, e.frameHomes, e.sharedHomes, e.xLocals,
+                e.fpLocals, e.fixupCount, e.deoptCount, body.maxValue, e.base);
     }
-    fn->jitFunc = entry;
     return true;
 }
 
@@ -10147,19 +11776,20 @@ static bool compileOsr(ObjClosure *closure, uint32_t top, Value *slots,
                        bool wholeBody, bool noInline) {
     bool hasIter = iterKind != 0;
     ObjFunction *fn = closure->fn;
+    noInline = noInline || jitNoInline();
     if (!isInstructionStart(&fn->chunk, top)) return false;
     uint32_t end = findLoopEnd(&fn->chunk, top, wholeBody);
     if (end == 0 || end <= top) return false;
     /* The entry re-checks every slot, so this is the size of that record --
      * nbody's advance declares nineteen. */
     if (fn->maxSlots < 1 || (unsigned)fn->maxSlots > 40) return false;
-
-    JaiCodeArena *arena = jaiJitArena();
-    if (arena == NULL) return false;
-
-    int *map = JAI_ALLOC(int, fn->chunk.count + 1);
-    int *depths = JAI_ALLOC(int, fn->chunk.count + 1);
+    int *map = malloc(sizeof(int) * (size_t)(fn->chunk.count + 1));
+    int *depths = malloc(sizeof(int) * (size_t)(fn->chunk.count + 1));
     int *chunkDepth = chunkDepthTable(fn);
+    if (map == NULL || depths == NULL) {
+        jitFree(map, depths, chunkDepth, fn->chunk.count + 1);
+        return false;
+    }
     for (int i = 0; i <= fn->chunk.count; i++) { map[i] = -1; depths[i] = -1; }
 
     static Emit e;
@@ -10590,7 +12220,7 @@ static bool compileOsr(ObjClosure *closure, uint32_t top, Value *slots,
     emitConst64(&e, 0, (int64_t)-2);          /* -2: an exception is pending */
     emitEpilogue(&e, 0);
 
-    for (unsigned i = 0; i < 3; i++) {
+    for (unsigned i = 0; i < 4; i++) {
         if (!e.overflowUsed[i]) { e.overflowStub[i] = -1; continue; }
         e.overflowStub[i] = (int)e.count;
         OSR_SYNC_ITER();
@@ -10704,7 +12334,7 @@ static bool compileOsr(ObjClosure *closure, uint32_t top, Value *slots,
         else if (f->targetOffset <= FIXUP_GROW &&
                  f->targetOffset > FIXUP_GROW - JIT_MAX_GROW)
             target = e.grow[FIXUP_GROW - f->targetOffset].stub;
-        else if (f->targetOffset <= FIXUP_OVF && f->targetOffset >= FIXUP_OVF - 2u)
+        else if (f->targetOffset <= FIXUP_OVF && f->targetOffset >= FIXUP_OVF - 3u)
             target = e.overflowStub[FIXUP_OVF - f->targetOffset];
         else {
             if (f->targetOffset > (uint32_t)fn->chunk.count) { jitFree(map, depths, chunkDepth, fn->chunk.count + 1); return false; }
@@ -10727,16 +12357,31 @@ static bool compileOsr(ObjClosure *closure, uint32_t top, Value *slots,
         else if (f->conditional) e.code[f->instIndex] = jaiA64BCond(word & 0xfu, rel);
         else e.code[f->instIndex] = jaiA64B(rel);
     }
+    unsigned lineCount = 0;
+    JaiJitLine *lines = wordLines(map, fn->chunk.count + 1, &lineCount);
     jitFree(map, depths, chunkDepth, fn->chunk.count + 1);
 
-    if (!jaiCodeArenaUnseal(arena)) return false;
-    /* Same 32-alignment as the function tier above, for the same two reasons. */
-    uint8_t *entry = arenaEmit(arena, e.code, e.count);
-    if (entry == NULL) return false;
+    /* Same 32-alignment as the function tier above, for the same two reasons.
+     * A loop is compiled where it is entered, on the interpreter's thread:
+     * the frame it reads its samples from is live only there. */
+    uint8_t *bytes = NULL;
+    size_t length = 0;
+    if (!lowerForHost(e.code, e.count, &bytes, &length, lines, lineCount) ||
+        fn->osrCount >= JAI_OSR_MAX) {
+        free(bytes);
+        free(lines);
+        return false;
+    }
+    uint8_t *entry = fn->module != NULL
+        ? jaiCodeHeapPlace(jaiJitCodeHeap(), bytes, length,
+                           &fn->module->version, fn->module->version)
+        : jaiCodeHeapPlace(jaiJitCodeHeap(), bytes, length, NULL, 0);
+    free(bytes);
+    if (entry == NULL) { free(lines); return false; }
 
-    if (fn->osrCount >= JAI_OSR_MAX) return false;
     JaiOsrForm *form = &fn->osrForms[fn->osrCount];
     form->code  = entry;
+    form->declines = 0;
     form->top   = top;
     form->slots = (uint8_t)e.locals;
     form->iterKind = iterKind;
@@ -10759,6 +12404,7 @@ static bool compileOsr(ObjClosure *closure, uint32_t top, Value *slots,
                         fn->name ? fn->name->chars : "<anon>", top,
                         JAI_OSR_SHAPES);
             }
+            free(lines);
             return false;
         }
         form->shapeSlot[form->shapeCount] = (uint8_t)i;
@@ -10769,6 +12415,10 @@ static bool compileOsr(ObjClosure *closure, uint32_t top, Value *slots,
     fn->osrCount++;
     fn->osrHot = true;
     fn->jitOsrModuleVersion = fn->module != NULL ? fn->module->version : 0;
+    if (JAI_UNLIKELY(jaiJitPerfEnabled())) {
+        jaiJitPerfNote(fn, "osr", (int)top, entry, length, lines, lineCount);
+    }
+    free(lines);
     if (getenv("JAI_JIT_WHY")) {
         fprintf(stderr, "[jit] osr %s at %u: %u instructions iter=%u\n",
                 fn->name ? fn->name->chars : "<anon>", top, e.count,
@@ -10877,6 +12527,15 @@ int jaiJitEnterOsr(ObjClosure *closure, uint32_t top, uint32_t *resumeAt) {
         }
     }
 
+    /* Before looking for a form: a new one is pinned to the module as it is
+     * now, and compiling it while the old ones stayed would make them look
+     * current again. Retired, every head compiles afresh. */
+    if (fn->osrCount > 0 &&
+        (fn->module == NULL || fn->module->version != fn->jitOsrModuleVersion)) {
+        jaiJitRetireOsr(fn);
+        return 0;
+    }
+
     JaiOsrForm *form = NULL;
     for (unsigned i = 0; i < fn->osrCount; i++) {
         /* Kind as well as offset: a form compiled for a range head, entered with a list iterator, would read
@@ -10910,14 +12569,20 @@ int jaiJitEnterOsr(ObjClosure *closure, uint32_t top, uint32_t *resumeAt) {
          * declines and NOTHING is compiled. tests/bench's contour follower is
          * exactly that shape. So the prefix stays as the fallback: some of the
          * loop compiled beats none of it. */
-        if (!compileOsr(closure, top, frame->slots, iterKind, elemSample,
-                        elemMixed, true, false) &&
-            !compileOsr(closure, top, frame->slots, iterKind, elemSample,
-                        elemMixed, true, true) &&
-            !compileOsr(closure, top, frame->slots, iterKind, elemSample,
-                        elemMixed, false, false) &&
-            !compileOsr(closure, top, frame->slots, iterKind, elemSample,
-                        elemMixed, false, true)) {
+        /* The emitter's state is one compile's worth, shared with the
+         * compiler thread; see jaiJitHold. */
+        jaiJitHold();
+        bool compiled =
+            compileOsr(closure, top, frame->slots, iterKind, elemSample,
+                       elemMixed, true, false) ||
+            compileOsr(closure, top, frame->slots, iterKind, elemSample,
+                       elemMixed, true, true) ||
+            compileOsr(closure, top, frame->slots, iterKind, elemSample,
+                       elemMixed, false, false) ||
+            compileOsr(closure, top, frame->slots, iterKind, elemSample,
+                       elemMixed, false, true);
+        jaiJitRelease();
+        if (!compiled) {
             /* Inlining widens live ranges; a loop that will not fit with it
              * may fit without, and a compiled call beats no compile at all. */
             if (miss == fn->osrMissCount && miss < JAI_OSR_MAX) {
@@ -10945,7 +12610,7 @@ int jaiJitEnterOsr(ObjClosure *closure, uint32_t top, uint32_t *resumeAt) {
         }
         form = &fn->osrForms[fn->osrCount - 1];
     }
-    if (fn->module == NULL || fn->module->version != fn->jitOsrModuleVersion) return 0;
+    if (fn->module == NULL) return 0;
 
     /* Every slot must still hold what it held when this was compiled. */
     for (unsigned i = 0; i < form->slots; i++) {
@@ -11081,6 +12746,31 @@ static inline bool jitArgIn(ObjClosure *closure, const Value *slotBase,
     return true;
 }
 
+/* jitArgIn's question asked of a record rather than of a compiled form, so
+ * the class is named instead of numbered. Only ever an early-compile
+ * heuristic: the form that results still guards every argument itself. */
+bool jaiJitValueFits(uint8_t kind, Value v, const char *className) {
+    switch ((SlotKind)kind) {
+    case SLOT_INT:   return IS_INT(v);
+    case SLOT_FLOAT: return IS_FLOAT(v);
+    case SLOT_BOOL:  return IS_BOOL(v);
+    case SLOT_LIST:  return IS_LIST(v);
+    case SLOT_OBJ:   return IS_OBJ(v);
+    case SLOT_MAYBE_INST:
+        if (IS_NULL(v)) return true;
+        /* fall through */
+    case SLOT_INST: {
+        if (!IS_INSTANCE(v)) return false;
+        const ObjClass *k = AS_INSTANCE(v)->klass;
+        if (className == NULL) return true;
+        return k != NULL && k->qualifiedName != NULL &&
+               strcmp(k->qualifiedName->chars, className) == 0;
+    }
+    default:
+        return true;
+    }
+}
+
 static inline JaiJitOutcome jitResultOut(ObjFunction *fn, JitResult r,
                                          Value *slotBase) {
     if (r.bailed == 2) return JAI_JIT_ERROR;
@@ -11202,8 +12892,7 @@ bool jaiCallFn1(Value callee, Value arg, Value *out) {
         return jaiCallValue1(callee, arg, out);
     }
 
-    if (JAI_UNLIKELY(vm.stack == NULL ||
-                     vm.stackTop + 3 > vm.stack + JAI_STACK_MAX)) {
+    if (JAI_UNLIKELY(vm.stack == NULL || vm.stackTop + 3 > vm.stackLimit)) {
         return jaiCallValue1(callee, arg, out);
     }
 
@@ -11247,20 +12936,6 @@ bool jaiCallFn1(Value callee, Value arg, Value *out) {
     return callFn1Rerun(base, out);
 }
 
-#else
-
-bool jaiJitCompileFunc(ObjClosure *closure, Value *slotBase) {
-    (void)closure; (void)slotBase; return false;
-}
-JaiJitOutcome jaiJitEnterFunc(ObjClosure *closure, Value *slotBase) {
-    (void)closure; (void)slotBase; return JAI_JIT_DECLINED;
-}
-bool jaiCallFn1(Value callee, Value arg, Value *out) {
-    return jaiCallValue1(callee, arg, out);
-}
-
-#endif
-
 /* A conditional branch whose target is reached with a different operand stack
  * than the branch leaves from -- the exhausted arm of a for-loop, where the
  * interpreter drops the iterator. */
@@ -11279,3 +12954,39 @@ static void branchToDepth(Emit *e, uint32_t targetOffset, unsigned cond,
     e->fixupCount++;
     emit(e, jaiA64BCond(cond, 0));
 }
+
+#else
+
+bool jaiJitCompileFunc(ObjClosure *closure, Value *slotBase) {
+    (void)closure; (void)slotBase; return false;
+}
+/* No job is ever made, so the thread is never started. */
+JaiJitJob *jaiJitJobNew(ObjClosure *closure, Value *slotBase) {
+    (void)closure; (void)slotBase; return NULL;
+}
+void jaiJitJobRun(JaiJitJob *job) { (void)job; }
+JaiJitJobResult jaiJitJobInstall(JaiJitJob *job) {
+    (void)job; return JAI_JIT_JOB_DECLINED;
+}
+void jaiJitJobMark(const JaiJitJob *job) { (void)job; }
+void jaiJitJobFree(JaiJitJob *job) { (void)job; }
+ObjClosure *jaiJitJobClosure(const JaiJitJob *job) { (void)job; return NULL; }
+JaiJitOutcome jaiJitEnterFunc(ObjClosure *closure, Value *slotBase) {
+    (void)closure; (void)slotBase; return JAI_JIT_DECLINED;
+}
+bool jaiJitValueFits(uint8_t kind, Value v, const char *className) {
+    (void)kind; (void)v; (void)className; return true;
+}
+bool jaiCallFn1(Value callee, Value arg, Value *out) {
+    return jaiCallValue1(callee, arg, out);
+}
+/* Nothing compiled, so nothing ever deopts and no compiled frame links. */
+bool jaiJitApplyDeopt(ObjClosure *closure, Value *slotBase) {
+    (void)closure; (void)slotBase; return false;
+}
+void jaiJitMarkFrames(void) {}
+int jaiJitEnterOsr(ObjClosure *closure, uint32_t top, uint32_t *resumeAt) {
+    (void)closure; (void)top; (void)resumeAt; return 0;
+}
+
+#endif
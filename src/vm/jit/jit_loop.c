@@ -6,6 +6,7 @@
 
 #include "vm/bytecode/chunk.h"
 #include "vm/jit/jit_arm64.h"
+#include "vm/jit/jit_x64.h"
 #include "vm/vm.h"
 
 /* The compiled loop: matches one exact opcode shape (loop_sum's body), not a
@@ -13,7 +14,7 @@
  * failure can write back the pre-iteration values and safely re-run in the
  * interpreter; a body that calls, allocates, or writes a field is refused. */
 
-#if defined(__aarch64__) || defined(__arm64__)
+#if defined(__aarch64__) || defined(__arm64__) || defined(__x86_64__)
 
 typedef struct {
     unsigned accSlot, iSlot;
@@ -25,7 +26,9 @@ static bool matchLoop(const Chunk *c, uint32_t at, LoopShape *out) {
     const uint8_t *p = c->code;
     if (at + 27 > (uint32_t)c->count) return false;
 
-    if (p[at] != OP_JUMP_IF_CMP_LOCAL_K || p[at + 1] != OP_LT) return false;
+    if (jaiOpGeneric(p[at]) != OP_JUMP_IF_CMP_LOCAL_K || p[at + 1] != OP_LT) {
+        return false;
+    }
     out->iSlot = (unsigned)p[at + 2] | ((unsigned)p[at + 3] << 8);
     uint32_t kIndex = (uint32_t)p[at + 4] | ((uint32_t)p[at + 5] << 8) |
                       ((uint32_t)p[at + 6] << 16);
@@ -152,13 +155,7 @@ static bool magicDivide(int64_t d, int64_t *magic, unsigned *shift) {
     return true;
 }
 
-static void *compileLoop(const LoopShape *shape) {
-    JaiCodeArena *arena = jaiJitArena();
-    /* Unseal rather than decline: the function tier shares this arena and
-     * seals it after each compile, so declining would refuse every later loop
-     * once a program's first compiled thing was a function. */
-    if (arena == NULL || !jaiCodeArenaUnseal(arena)) return NULL;
-
+static void *compileLoop(const LoopShape *shape, size_t *placed) {
     unsigned accInt = shape->accSlot * 16 + 8, accTag = shape->accSlot * 16;
     unsigned iInt   = shape->iSlot * 16 + 8,   iTag   = shape->iSlot * 16;
 
@@ -233,21 +230,29 @@ static void *compileLoop(const LoopShape *shape) {
     w[toDone]         = jaiA64BCond(JAI_A64_GE, done - toDone);
     w[toBailWrite]    = jaiA64BCond(JAI_A64_VS, bailWrite - toBailWrite);
 
-    uint8_t *entry = jaiCodeArenaWrite(arena, w, (size_t)n * sizeof w[0]);
-    if (entry == NULL) {
-        /* Seal before giving up. The unseal above took the execute bit off
-         * every function already in the arena, and the write fails exactly
-         * when the arena is full -- so returning here without re-sealing
-         * leaves the whole back catalogue unexecutable. See `arenaEmit` in
-         * jit_func.c for what that looked like when it happened. */
-        jaiCodeArenaSeal(arena);
-        return NULL;
+#if defined(__x86_64__)
+    /* The same words, lowered as the function tier's are (jit_x64.h). */
+    uint8_t *bytes = NULL;
+    size_t length = 0;
+    const char *why = NULL;
+    uint8_t *entry = NULL;
+    if (jaiX64Lower(w, (unsigned)n, &bytes, &length, &why)) {
+        entry = jaiCodeHeapPlace(jaiJitCodeHeap(), bytes, length, NULL, 0);
+        free(bytes);
+        *placed = length;
+    } else if (getenv("JAI_JIT_WHY")) {
+        fprintf(stderr, "[jit] x86-64 lowering stopped: %s\n", why);
     }
+#else
+    uint8_t *entry = jaiCodeHeapPlace(jaiJitCodeHeap(), w,
+                                      (size_t)n * sizeof w[0], NULL, 0);
+    *placed = (size_t)n * sizeof w[0];
+#endif
+    if (entry == NULL) return NULL;
     if (getenv("JAI_JIT_TRACE")) {
         fprintf(stderr, "[jit] loop entry %p (mod 64 = %u)\n", (void *)entry,
                 (unsigned)((uintptr_t)entry & 63u));
     }
-    if (!jaiCodeArenaSeal(arena)) return NULL;
     return entry;
 }
 
@@ -263,8 +268,12 @@ bool jaiJitEnterLoop(ObjClosure *closure, uint32_t targetOffset) {
         } else {
             return false;
         }
-        void *code = compileLoop(&shape);
+        size_t length = 0;
+        void *code = compileLoop(&shape, &length);
         if (code == NULL) return false;
+        if (JAI_UNLIKELY(jaiJitPerfEnabled())) {
+            jaiJitPerfNote(fn, "loop", (int)targetOffset, code, length, NULL, 0);
+        }
         fn->jitLoop = code;
         fn->jitLoopExit = shape.exitOffset;
         fn->jitLoopTop = targetOffset;
@@ -314,7 +323,7 @@ bool jaiJitEnterLoop(ObjClosure *closure, uint32_t targetOffset) {
     return true;
 }
 
-#else   /* not arm64 */
+#else   /* neither arm64 nor x86-64 */
 
 bool jaiJitEnterLoop(ObjClosure *closure, uint32_t targetOffset) {
     (void)closure;
@@ -0,0 +1,276 @@
+/* jit_perf.c — telling `perf` what the compiled tier put where.
+ *
+ * Compiled bodies live in anonymous executable mappings (jit_arena.c), so a
+ * profile of a Jaithon service attributes their time to `[unknown]` -- or, for
+ * the hot ones, to nothing anyone can act on. perf has two ways of being told
+ * otherwise, and both are written here, as each body is installed:
+ *
+ *   JAITHON_PERF_MAP=1  appends "<start> <size> <name>" to /tmp/perf-<pid>.map,
+ *                       which `perf report` reads at report time. Symbols
+ *                       only, but no extra step.
+ *   JAITHON_JITDUMP=1   writes /tmp/jit-<pid>.dump in perf's jitdump format:
+ *                       each body's bytes, and a source line for every
+ *                       bytecode instruction the body compiled, taken from
+ *                       the chunk's LTV1 table. `perf inject --jit` turns it
+ *                       into one ELF per body, so `perf annotate` shows the
+ *                       instructions against Jaithon lines. Record with
+ *                       `perf record -k mono`: the records are stamped with
+ *                       CLOCK_MONOTONIC, and perf matches on the clock.
+ *
+ * A body is named by its function's qualified name; an OSR form adds
+ * `[osr@<offset>]`, the bytecode offset of the loop it enters, and a counted
+ * loop kernel `[loop@<offset>]`. The code heap reuses reclaimed chunks, so an
+ * address may be named twice over a run; perf takes the later load record as
+ * the one in force from its timestamp on, and a map's reader takes whichever
+ * entry it meets, which is the price of the map needing no tooling.
+ *
+ * Nothing here runs unless one of the variables is set: the install paths ask
+ * jaiJitPerfEnabled() first, and the compile builds its line pairs only when
+ * jaiJitPerfWantsLines() says the dump will use them. Every install happens on
+ * the interpreter's thread, so the files need no lock. Both are Linux-only; on
+ * anything else the functions answer false and do nothing. */
+
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#  define _GNU_SOURCE   /* syscall(SYS_gettid) */
+#endif
+
+#include "vm/jit/jit.h"
+
+#include "common/diag.h"
+#include "vm/vm.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__linux__)
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#  include <sys/syscall.h>
+#  include <time.h>
+#  include <unistd.h>
+#endif
+
+static bool envOn(const char *name) {
+    const char *v = getenv(name);
+    return v != NULL && v[0] != '\0' && strcmp(v, "0") != 0;
+}
+
+#if defined(__linux__)
+
+/* The jitdump layout, from tools/perf/Documentation/jitdump-specification.txt.
+ * Every field is in the writer's byte order; the magic tells the reader which
+ * that was. */
+#define JITDUMP_MAGIC       0x4A695444u   /* "JiTD" */
+#define JITDUMP_VERSION     1u
+#define JIT_CODE_LOAD       0u
+#define JIT_CODE_DEBUG_INFO 2u
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t totalSize;
+    uint32_t elfMach;
+    uint32_t pad1;
+    uint32_t pid;
+    uint64_t timestamp;
+    uint64_t flags;
+} JitdumpHeader;
+
+typedef struct {
+    uint32_t id;
+    uint32_t totalSize;
+    uint64_t timestamp;
+} JitdumpRecord;
+
+_Static_assert(sizeof(JitdumpHeader) == 40, "jitdump file header is 40 bytes");
+_Static_assert(sizeof(JitdumpRecord) == 16, "jitdump record header is 16 bytes");
+
+static int      sPerfState = -1;   /* -1 unasked, then a bitmask of the two */
+static FILE    *sMap;
+static FILE    *sDump;
+static uint64_t sCodeIndex;
+
+#define PERF_MAP  1
+#define PERF_DUMP 2
+
+static uint64_t monotonicNs(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+/* perf finds the dump by watching the process map it: the MMAP record for a
+ * file called jit-<pid>.dump is what `perf inject --jit` looks for. So the
+ * first page is mapped executable and left mapped -- the mapping is the
+ * marker, not a way in. */
+static FILE *openDump(void) {
+    char path[64];
+    snprintf(path, sizeof path, "/tmp/jit-%ld.dump", (long)getpid());
+    int fd = open(path, O_CREAT | O_TRUNC | O_RDWR, 0644);
+    if (fd < 0) return NULL;
+    long page = sysconf(_SC_PAGESIZE);
+    void *marker = mmap(NULL, page > 0 ? (size_t)page : 4096u,
+                        PROT_READ | PROT_EXEC, MAP_PRIVATE, fd, 0);
+    if (marker == MAP_FAILED) { close(fd); return NULL; }
+    FILE *fp = fdopen(fd, "wb");
+    if (fp == NULL) { close(fd); return NULL; }
+
+    JitdumpHeader h;
+    memset(&h, 0, sizeof h);
+    h.magic = JITDUMP_MAGIC;
+    h.version = JITDUMP_VERSION;
+    h.totalSize = (uint32_t)sizeof h;
+#if defined(__x86_64__)
+    h.elfMach = 62;    /* EM_X86_64 */
+#elif defined(__aarch64__)
+    h.elfMach = 183;   /* EM_AARCH64 */
+#endif
+    h.pid = (uint32_t)getpid();
+    h.timestamp = monotonicNs();
+    fwrite(&h, sizeof h, 1, fp);
+    fflush(fp);
+    return fp;
+}
+
+static int perfState(void) {
+    if (sPerfState >= 0) return sPerfState;
+    sPerfState = 0;
+    if (envOn("JAITHON_PERF_MAP")) {
+        char path[64];
+        snprintf(path, sizeof path, "/tmp/perf-%ld.map", (long)getpid());
+        sMap = fopen(path, "w");
+        if (sMap != NULL) sPerfState |= PERF_MAP;
+    }
+    if (envOn("JAITHON_JITDUMP")) {
+        sDump = openDump();
+        if (sDump != NULL) sPerfState |= PERF_DUMP;
+    }
+    return sPerfState;
+}
+
+bool jaiJitPerfEnabled(void) { return perfState() != 0; }
+
+bool jaiJitPerfWantsLines(void) { return (perfState() & PERF_DUMP) != 0; }
+
+static void bodyName(const ObjFunction *fn, const char *tag, int at,
+                     char *out, size_t size) {
+    const char *name = fn->qualifiedName != NULL ? fn->qualifiedName->chars
+                     : fn->name != NULL          ? fn->name->chars
+                                                 : "<script>";
+    if (tag != NULL) snprintf(out, size, "%s[%s@%d]", name, tag, at);
+    else             snprintf(out, size, "%s", name);
+}
+
+/* One debug entry per line change, in address order. perf attributes every
+ * byte from an entry's address up to the next entry's to that entry's line,
+ * so runs of one line collapse to their first instruction. */
+static void writeDebugInfo(const ObjFunction *fn, const uint8_t *code,
+                           const JaiJitLine *lines, unsigned lineCount,
+                           uint64_t now) {
+    const char *file = NULL;
+    JaiSourceFile *src = jaiSourceGet(fn->chunk.sourceFileId);
+    if (src != NULL) file = src->path;
+    else if (fn->module != NULL && fn->module->path != NULL)
+        file = fn->module->path->chars;
+    if (file == NULL || lineCount == 0) return;
+
+    int *lineOf = malloc(sizeof *lineOf * lineCount);
+    if (lineOf == NULL) return;
+    uint64_t entries = 0;
+    int prev = -1;
+    for (unsigned i = 0; i < lineCount; i++) {
+        uint32_t start = 0, end = 0;
+        jaiChunkSpanAt(&fn->chunk, (int)lines[i].bcOffset, &start, &end);
+        int line = 0;
+        jaiSourceLineCol(fn->chunk.sourceFileId, start, &line, NULL);
+        lineOf[i] = line > 0 && line != prev ? line : 0;
+        if (lineOf[i] != 0) { entries++; prev = line; }
+    }
+    if (entries == 0) { free(lineOf); return; }
+
+    size_t nameLen = strlen(file) + 1;
+    JitdumpRecord r = {
+        JIT_CODE_DEBUG_INFO,
+        (uint32_t)(sizeof r + 16u + entries * (16u + nameLen)),
+        now,
+    };
+    uint64_t head[2] = { (uint64_t)(uintptr_t)code, entries };
+    fwrite(&r, sizeof r, 1, sDump);
+    fwrite(head, sizeof head, 1, sDump);
+    bool first = true;
+    for (unsigned i = 0; i < lineCount; i++) {
+        if (lineOf[i] == 0) continue;
+        /* The prologue belongs to no instruction; it counts against the
+         * first line rather than against nothing. */
+        uint64_t addr = (uint64_t)(uintptr_t)
+            (first ? code : code + lines[i].codeOffset);
+        first = false;
+        uint32_t lineDiscrim[2] = { (uint32_t)lineOf[i], 0 };
+        fwrite(&addr, sizeof addr, 1, sDump);
+        fwrite(lineDiscrim, sizeof lineDiscrim, 1, sDump);
+        fwrite(file, nameLen, 1, sDump);
+    }
+    free(lineOf);
+}
+
+static void writeCodeLoad(const char *name, const uint8_t *code, size_t length,
+                          uint64_t now) {
+    size_t nameLen = strlen(name) + 1;
+    JitdumpRecord r = {
+        JIT_CODE_LOAD,
+        (uint32_t)(sizeof r + 8u + 32u + nameLen + length),
+        now,
+    };
+    uint32_t ids[2] = { (uint32_t)getpid(), (uint32_t)syscall(SYS_gettid) };
+    uint64_t where[4] = {
+        (uint64_t)(uintptr_t)code,   /* vma */
+        (uint64_t)(uintptr_t)code,   /* code_addr */
+        (uint64_t)length,
+        sCodeIndex++,
+    };
+    fwrite(&r, sizeof r, 1, sDump);
+    fwrite(ids, sizeof ids, 1, sDump);
+    fwrite(where, sizeof where, 1, sDump);
+    fwrite(name, nameLen, 1, sDump);
+    fwrite(code, length, 1, sDump);
+}
+
+void jaiJitPerfNote(const ObjFunction *fn, const char *tag, int at,
+                    const void *code, size_t length, const JaiJitLine *lines,
+                    unsigned lineCount) {
+    int state = perfState();
+    if (state == 0 || code == NULL || length == 0) return;
+    char name[512];
+    bodyName(fn, tag, at, name, sizeof name);
+
+    if (state & PERF_MAP) {
+        fprintf(sMap, "%lx %zx %s\n", (unsigned long)(uintptr_t)code, length,
+                name);
+        fflush(sMap);
+    }
+    if (state & PERF_DUMP) {
+        /* The debug record goes first: perf attaches it to the next load. */
+        uint64_t now = monotonicNs();
+        if (lines != NULL) {
+            writeDebugInfo(fn, code, lines, lineCount, now);
+        }
+        writeCodeLoad(name, code, length, now);
+        fflush(sDump);
+    }
+}
+
+#else /* !__linux__ */
+
+bool jaiJitPerfEnabled(void) { (void)envOn; return false; }
+
+bool jaiJitPerfWantsLines(void) { return false; }
+
+void jaiJitPerfNote(const ObjFunction *fn, const char *tag, int at,
+                    const void *code, size_t length, const JaiJitLine *lines,
+                    unsigned lineCount) {
+    (void)fn; (void)tag; (void)at; (void)code; (void)length;
+    (void)lines; (void)lineCount;
+}
+
+#endif
@@ -0,0 +1,134 @@
+/* Feature macros must precede every include: pthread_getattr_np is a GNU
+ * extension, and pthread_get_stackaddr_np is hidden on Darwin without its own
+ * default set. */
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#  define _GNU_SOURCE
+#endif
+#if defined(__APPLE__) && !defined(_DARWIN_C_SOURCE)
+#  define _DARWIN_C_SOURCE
+#endif
+
+#include "vm/jit/jit.h"
+#include "vm/jit/jit_vec.h"
+
+#include <pthread.h>
+#include <setjmp.h>
+#include <stdio.h>
+#include <string.h>
+
+/* When compiled code stops being needed, and when its memory can be had back.
+ *
+ * Those are two different moments, and running them together is the one way
+ * to get this wrong. A form is RETIRED as soon as nothing will enter it again:
+ * its function was freed, or its module rebound a global the form baked in.
+ * But retired code can still be running -- a compiled body that called out to
+ * the interpreter is on the native stack while the rebinding happens, and will
+ * be returned into -- so its memory is only reclaimed at the end of a
+ * collection, and only if no word on this thread's stack points into it. See
+ * jaiCodeHeapReclaim for why one such word holds everything back.
+ *
+ * Retiring also re-arms the tier. A form retired by a rebinding used to stay
+ * in place, declining every call for the rest of the run, so a function was
+ * compiled against the first binding it saw and interpreted ever after once
+ * that moved. */
+
+/* Per function, over all tiers; see ObjFunction::jitRetires. Four re-arms is
+ * enough for a module that rebinds during start-up and then settles. */
+#define JAI_JIT_MAX_RETIRES 4
+
+static void retireCode(const void *code) {
+    if (code != NULL) (void)jaiCodeHeapRetire(jaiJitCodeHeap(), code);
+}
+
+static void countRetire(ObjFunction *fn) {
+    if (fn->jitRetires < UINT8_MAX) fn->jitRetires++;
+}
+
+/* Under a hold: the compiler thread reads a callee's jitFunc to bake a call
+ * to it. */
+void jaiJitRetireFunc(ObjFunction *fn) {
+    if (fn->jitFunc == NULL) return;
+    jaiJitHold();
+    retireCode(fn->jitFunc);
+    fn->jitFunc = NULL;
+    fn->jitPending = JAI_JIT_IDLE;
+    countRetire(fn);
+    if (fn->jitRetires >= JAI_JIT_MAX_RETIRES) fn->jitRefused = true;
+    jaiJitRelease();
+}
+
+void jaiJitRetireOsr(ObjFunction *fn) {
+    if (fn->osrCount == 0) return;
+    jaiJitHold();
+    for (unsigned i = 0; i < fn->osrCount; i++) retireCode(fn->osrForms[i].code);
+    memset(fn->osrForms, 0, sizeof fn->osrForms);
+    fn->osrCount = 0;
+    fn->osrHot = false;
+    countRetire(fn);
+    if (fn->jitRetires >= JAI_JIT_MAX_RETIRES) fn->osrRefused = true;
+    jaiJitRelease();
+}
+
+/* From the sweep, which already holds the thread off. Nothing is cleared: the
+ * function is about to be freed. */
+void jaiJitForget(ObjFunction *fn) {
+    retireCode(fn->jitFunc);
+    retireCode(fn->jitCode);
+    retireCode(fn->jitLoop);
+    for (unsigned i = 0; i < fn->osrCount; i++) retireCode(fn->osrForms[i].code);
+    jaiVecPlansFree(fn);
+    jaiJitWarmForget(fn);
+}
+
+/* The high end of this thread's stack, or NULL where there is no way to ask --
+ * which keeps every retired body forever, as the tier always did. Cached:
+ * glibc answers for the main thread by reading /proc/self/maps. */
+static void *stackHigh(void) {
+    static void     *cached;
+    static pthread_t owner;
+    if (cached != NULL && pthread_equal(owner, pthread_self())) return cached;
+    void *high = NULL;
+#if defined(__APPLE__)
+    high = pthread_get_stackaddr_np(pthread_self());
+#elif defined(__linux__)
+    pthread_attr_t attr;
+    if (pthread_getattr_np(pthread_self(), &attr) == 0) {
+        void  *low = NULL;
+        size_t size = 0;
+        if (pthread_attr_getstack(&attr, &low, &size) == 0 && low != NULL) {
+            high = (char *)low + size;
+        }
+        pthread_attr_destroy(&attr);
+    }
+#endif
+    cached = high;
+    owner = pthread_self();
+    return high;
+}
+
+size_t jaiJitReclaim(void) {
+    JaiCodeHeap *heap = jaiJitCodeHeap();
+    if (heap->retired == 0) return 0;
+    void *high = stackHigh();
+    if (high == NULL) return 0;
+    /* The callee-saved registers, spilled onto this frame so the scan sees
+     * them too. A return address only lives in one of those in a leaf, and
+     * nothing that collects is one, but it costs nothing to be sure. */
+    jmp_buf regs;
+    (void)setjmp(regs);
+    return jaiCodeHeapReclaim(heap, (const void *)&regs, high);
+}
+
+void jaiJitPrintStats(FILE *out) {
+    if (out == NULL) return;
+    const JaiCodeHeap *heap = jaiJitCodeHeap();
+    fprintf(out, "jit code heap:\n");
+    fprintf(out, "  chunks          : %zu (%zu bytes mapped)\n",
+            heap->chunkCount, heap->mapped);
+    fprintf(out, "  live            : %zu bytes\n", heap->live);
+    fprintf(out, "  retired         : %zu bytes\n", heap->retired);
+    fprintf(out, "  reclaimed       : %llu bytes\n",
+            (unsigned long long)heap->reclaimed);
+    fprintf(out, "  bodies placed   : %llu\n", (unsigned long long)heap->placed);
+    fprintf(out, "  seals           : %llu\n", (unsigned long long)heap->seals);
+}
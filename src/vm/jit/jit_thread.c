@@ -0,0 +1,251 @@
+/* Feature macros must precede every include: pthread_sigmask is POSIX, and
+ * -std=c11 on its own leaves it undeclared. */
+#if !defined(_POSIX_C_SOURCE)
+#  define _POSIX_C_SOURCE 200809L
+#endif
+#if defined(__APPLE__) && !defined(_DARWIN_C_SOURCE)
+#  define _DARWIN_C_SOURCE
+#endif
+
+#include "vm/jit/jit.h"
+
+#include "vm/gc.h"
+
+#include <pthread.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* The compiler thread. One of it: a compile is a few hundred microseconds of
+ * work on file-static emitter state, and one thread keeping up with the hot
+ * set is all the interpreter ever needs -- a second would only contend for
+ * the compile lock below.
+ *
+ * Two locks, taken in this order and never the other:
+ *
+ *   sCompileLock  held by the thread for the whole of a compile, and by the
+ *                 interpreter (jaiJitHold) around anything that would move
+ *                 or free what a compile reads, and around every install
+ *   sQueueLock    the three lists below; held only to link and unlink
+ *
+ * The interpreter never WAITS for a compile except at a hold, and a hold is
+ * only taken where it is about to do something far slower than a compile
+ * anyway: a collection, or a rebinding that retires compiled code. An install
+ * that finds the thread busy is simply tried again at the next safepoint. */
+
+typedef struct JitNode {
+    JaiJitJob      *job;
+    struct JitNode *next;
+} JitNode;
+
+static pthread_mutex_t sCompileLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t sQueueLock   = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  sQueueWake   = PTHREAD_COND_INITIALIZER;
+
+static pthread_t sThread;
+static bool      sStarted;
+static bool      sStopping;
+
+static JitNode *sWaiting;       /* FIFO: oldest first */
+static JitNode *sWaitingTail;
+static JitNode *sRunning;       /* taken off sWaiting, not yet on sDone */
+static JitNode *sDone;
+static JitNode *sInstalling;    /* between sDone and freed, on this thread */
+/* Read without sQueueLock on every call into a queued function, so it is the
+ * one thing here that has to be atomic. */
+static atomic_uint sDoneCount;
+
+/* The interpreter's side of sCompileLock, which nests: a collection inside a
+ * global rebinding inside an install is one hold. Only ever touched on the
+ * interpreter's thread. */
+static unsigned sHoldDepth;
+static bool     sHoldLocked;
+
+bool jaiJitSync(void) {
+    static int cached = -1;
+    if (cached < 0) {
+        const char *on = getenv("JAITHON_JIT_SYNC");
+        cached = (on != NULL && on[0] != '\0' && strcmp(on, "0") != 0) ? 1 : 0;
+    }
+    return cached != 0;
+}
+
+static void *compilerMain(void *arg) {
+    (void)arg;
+    for (;;) {
+        pthread_mutex_lock(&sQueueLock);
+        while (!sStopping && sWaiting == NULL) {
+            pthread_cond_wait(&sQueueWake, &sQueueLock);
+        }
+        if (sStopping) {
+            pthread_mutex_unlock(&sQueueLock);
+            return NULL;
+        }
+        JitNode *node = sWaiting;
+        sWaiting = node->next;
+        if (sWaiting == NULL) sWaitingTail = NULL;
+        sRunning = node;
+        pthread_mutex_unlock(&sQueueLock);
+
+        pthread_mutex_lock(&sCompileLock);
+        jaiJitJobRun(node->job);
+        pthread_mutex_unlock(&sCompileLock);
+
+        pthread_mutex_lock(&sQueueLock);
+        sRunning = NULL;
+        node->next = sDone;
+        sDone = node;
+        atomic_fetch_add(&sDoneCount, 1u);
+        pthread_mutex_unlock(&sQueueLock);
+    }
+}
+
+/* Every signal blocked for the thread's whole life. The sampling timer's
+ * SIGPROF in particular must land on the interpreter: its handler only sets
+ * a flag the interpreter polls, and delivered here it would set it for
+ * nothing and steal the tick. */
+static bool startThread(void) {
+    sigset_t all, old;
+    sigfillset(&all);
+    if (pthread_sigmask(SIG_SETMASK, &all, &old) != 0) return false;
+    bool ok = pthread_create(&sThread, NULL, compilerMain, NULL) == 0;
+    pthread_sigmask(SIG_SETMASK, &old, NULL);
+    if (!ok) return false;
+    sStarted = true;
+    sStopping = false;
+    if (sHoldDepth > 0 && !sHoldLocked) {
+        pthread_mutex_lock(&sCompileLock);
+        sHoldLocked = true;
+    }
+    return true;
+}
+
+static void pushWaiting(JitNode *node) {
+    node->next = NULL;
+    if (sWaitingTail != NULL) sWaitingTail->next = node;
+    else sWaiting = node;
+    sWaitingTail = node;
+    pthread_cond_signal(&sQueueWake);
+}
+
+bool jaiJitQueue(JaiJitJob *job) {
+    if (!sStarted && !startThread()) return false;
+    JitNode *node = malloc(sizeof *node);
+    if (node == NULL) return false;
+    node->job = job;
+    pthread_mutex_lock(&sQueueLock);
+    pushWaiting(node);
+    pthread_mutex_unlock(&sQueueLock);
+    return true;
+}
+
+void jaiJitHold(void) {
+    if (sHoldDepth++ == 0 && sStarted) {
+        pthread_mutex_lock(&sCompileLock);
+        sHoldLocked = true;
+    }
+}
+
+void jaiJitRelease(void) {
+    if (--sHoldDepth == 0 && sHoldLocked) {
+        sHoldLocked = false;
+        pthread_mutex_unlock(&sCompileLock);
+    }
+}
+
+void jaiJitInstallReady(void) {
+    if (!sStarted || atomic_load(&sDoneCount) == 0) return;
+    /* Installing writes the code heap and the function both, and the thread's
+     * next compile may be reading that function as a callee -- so installs
+     * happen only between compiles, and never wait for one. */
+    bool took = false;
+    if (!sHoldLocked) {
+        if (pthread_mutex_trylock(&sCompileLock) != 0) return;
+        sHoldLocked = true;
+        took = true;
+    }
+    sHoldDepth++;
+    /* Every body installed here is sealed at once, at the end: nothing runs
+     * compiled code until this returns. */
+    jaiCodeHeapBeginBatch(jaiJitCodeHeap());
+    for (;;) {
+        pthread_mutex_lock(&sQueueLock);
+        JitNode *node = sDone;
+        if (node != NULL) {
+            sDone = node->next;
+            atomic_fetch_sub(&sDoneCount, 1u);
+        }
+        sInstalling = node;
+        pthread_mutex_unlock(&sQueueLock);
+        if (node == NULL) break;
+
+        ObjFunction *fn = jaiJitJobClosure(node->job)->fn;
+        JaiJitJobResult result = jaiJitJobInstall(node->job);
+        if (result == JAI_JIT_JOB_AGAIN) {
+            pthread_mutex_lock(&sQueueLock);
+            sInstalling = NULL;
+            pushWaiting(node);
+            pthread_mutex_unlock(&sQueueLock);
+            continue;
+        }
+        switch (result) {
+        case JAI_JIT_JOB_INSTALLED: fn->jitPending = JAI_JIT_IDLE; break;
+        case JAI_JIT_JOB_HERE:      fn->jitPending = JAI_JIT_COMPILE_HERE; break;
+        default:                    fn->jitPending = JAI_JIT_THREAD_DECLINED; break;
+        }
+        sInstalling = NULL;
+        jaiJitJobFree(node->job);
+        free(node);
+    }
+    (void)jaiCodeHeapEndBatch(jaiJitCodeHeap());
+    sHoldDepth--;
+    if (took) {
+        sHoldLocked = false;
+        pthread_mutex_unlock(&sCompileLock);
+    }
+}
+
+/* Called from markRoots, which runs under a hold, so no job is mid-compile;
+ * the queue lock is for the lists alone. */
+void jaiJitMarkQueue(void) {
+    if (!sStarted) return;
+    pthread_mutex_lock(&sQueueLock);
+    for (JitNode *n = sWaiting; n != NULL; n = n->next) jaiJitJobMark(n->job);
+    for (JitNode *n = sDone; n != NULL; n = n->next) jaiJitJobMark(n->job);
+    if (sRunning != NULL) jaiJitJobMark(sRunning->job);
+    if (sInstalling != NULL) jaiJitJobMark(sInstalling->job);
+    pthread_mutex_unlock(&sQueueLock);
+}
+
+static void freeList(JitNode *n) {
+    while (n != NULL) {
+        JitNode *next = n->next;
+        jaiJitJobFree(n->job);
+        free(n);
+        n = next;
+    }
+}
+
+/* Joins the thread and drops whatever it had not finished. The functions
+ * those jobs were for are going away with the VM that owns them. */
+void jaiJitShutdown(void) {
+    if (!sStarted) return;
+    pthread_mutex_lock(&sQueueLock);
+    sStopping = true;
+    pthread_cond_broadcast(&sQueueWake);
+    pthread_mutex_unlock(&sQueueLock);
+    if (sHoldLocked) {
+        sHoldLocked = false;
+        pthread_mutex_unlock(&sCompileLock);
+    }
+    pthread_join(sThread, NULL);
+    freeList(sWaiting);
+    freeList(sDone);
+    freeList(sRunning);
+    sWaiting = sWaitingTail = sRunning = sDone = sInstalling = NULL;
+    atomic_store(&sDoneCount, 0u);
+    sHoldDepth = 0;
+    sStarted = false;
+    sStopping = false;
+}
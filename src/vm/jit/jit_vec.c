@@ -0,0 +1,624 @@
+#include "vm/jit/jit_vec.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "vm/bytecode/chunk.h"
+
+/* Elements per block. Small enough that every node's buffer for one block
+ * stays in L1 together (16 nodes x 64 doubles = 8 KiB), large enough that
+ * the per-block work -- the tag pass, the loop over nodes -- is spread thin. */
+#define VEC_BLOCK 64
+
+/* ------------------------------------------------------------------ */
+/* The plan                                                             */
+/* ------------------------------------------------------------------ */
+
+/* What the symbolic walk below knows of one operand-stack entry. */
+typedef enum {
+    SYM_J,          /* the loop variable plus `off` */
+    SYM_INT,        /* an int literal */
+    SYM_LOCAL,      /* a local read, its role still unknown */
+    SYM_ELEM,       /* list[j + off], not yet known to be a float or a row */
+    SYM_NODE        /* a float-valued node */
+} SymKind;
+
+typedef struct {
+    uint8_t  kind;
+    int32_t  off;       /* SYM_J, SYM_ELEM */
+    int64_t  k;         /* SYM_INT */
+    unsigned slot;      /* SYM_LOCAL */
+    int      arg;       /* SYM_ELEM: the list's operand */
+    int      node;      /* SYM_NODE */
+} Sym;
+
+typedef struct {
+    JaiVecPlan *plan;
+    unsigned    var, cur, end;
+    Sym         stack[8];
+    unsigned    depth;
+} Build;
+
+/* Every local has one role for the whole body; a second use as something
+ * else -- the accumulator also read as a term, a list also used as a row
+ * index -- is a body this is not for. */
+static int operand(Build *b, unsigned slot, JaiVecRole role) {
+    JaiVecPlan *p = b->plan;
+    if (slot == b->cur || slot == b->end || slot == b->var) return -1;
+    for (unsigned i = 0; i < p->argCount; i++) {
+        if (p->argSlot[i] == slot) return p->argRole[i] == role ? (int)i : -1;
+    }
+    if (p->argCount >= JAI_VEC_MAX_OPERANDS || slot > UINT16_MAX) return -1;
+    p->argSlot[p->argCount] = (uint16_t)slot;
+    p->argRole[p->argCount] = (uint8_t)role;
+    return (int)p->argCount++;
+}
+
+static int addNode(Build *b, JaiVecNode node) {
+    JaiVecPlan *p = b->plan;
+    if (p->nodeCount >= JAI_VEC_MAX_NODES) return -1;
+    p->nodes[p->nodeCount] = node;
+    return (int)p->nodeCount++;
+}
+
+/* The entry as a float-valued node, or -1. An int literal only qualifies as
+ * the operand of arithmetic whose other side is a float, where it widens --
+ * `allowInt` -- and never as the value stored or accumulated, which would be
+ * an int. */
+static int asNode(Build *b, Sym *s, bool allowInt) {
+    JaiVecNode n;
+    memset(&n, 0, sizeof n);
+    switch ((SymKind)s->kind) {
+    case SYM_NODE:
+        return s->node;
+    case SYM_ELEM:
+        n.op = JAI_VEC_LOAD;
+        n.arg = (uint8_t)s->arg;
+        n.off = s->off;
+        break;
+    case SYM_LOCAL: {
+        int arg = operand(b, s->slot, JAI_VEC_ARG_FLOAT);
+        if (arg < 0) return -1;
+        n.op = JAI_VEC_LOCAL;
+        n.arg = (uint8_t)arg;
+        break;
+    }
+    case SYM_INT:
+        if (!allowInt) return -1;
+        n.op = JAI_VEC_CONST;
+        n.k = (double)s->k;
+        break;
+    default:
+        return -1;
+    }
+    int at = addNode(b, n);
+    if (at < 0) return -1;
+    s->kind = SYM_NODE;
+    s->node = at;
+    return at;
+}
+
+static bool push(Build *b, Sym s) {
+    if (b->depth >= sizeof b->stack / sizeof b->stack[0]) return false;
+    b->stack[b->depth++] = s;
+    return true;
+}
+
+static bool pushLocal(Build *b, unsigned slot) {
+    Sym s;
+    memset(&s, 0, sizeof s);
+    if (slot == b->var) {
+        s.kind = SYM_J;
+    } else {
+        s.kind = SYM_LOCAL;
+        s.slot = slot;
+    }
+    return push(b, s);
+}
+
+static bool arith(Build *b, uint8_t op) {
+    if (b->depth < 2) return false;
+    Sym *x = &b->stack[b->depth - 2], *y = &b->stack[b->depth - 1];
+    /* Index arithmetic: `j + 1`, `1 + j`, `j - 1`. */
+    if ((op == OP_ADD || op == OP_SUB) && x->kind == SYM_J &&
+        y->kind == SYM_INT) {
+        int64_t off = op == OP_ADD ? x->off + y->k : x->off - y->k;
+        if (off < -32768 || off > 32767) return false;
+        x->off = (int32_t)off;
+        b->depth--;
+        return true;
+    }
+    if (op == OP_ADD && x->kind == SYM_INT && y->kind == SYM_J) {
+        int64_t off = x->k + y->off;
+        if (off < -32768 || off > 32767) return false;
+        x->kind = SYM_J;
+        x->off = (int32_t)off;
+        b->depth--;
+        return true;
+    }
+    /* Float arithmetic. Two int literals would be int arithmetic. */
+    if (x->kind == SYM_INT && y->kind == SYM_INT) return false;
+    if (op == OP_DIV && y->kind == SYM_INT && y->k == 0) return false;
+    int na = asNode(b, x, true);
+    if (na < 0) return false;
+    int nb = asNode(b, y, true);
+    if (nb < 0) return false;
+    JaiVecNode n;
+    memset(&n, 0, sizeof n);
+    n.op = op == OP_ADD ? JAI_VEC_ADD
+         : op == OP_SUB ? JAI_VEC_SUB
+         : op == OP_MUL ? JAI_VEC_MUL
+                        : JAI_VEC_DIV;
+    n.a = (uint8_t)na;
+    n.b = (uint8_t)nb;
+    int at = addNode(b, n);
+    if (at < 0) return false;
+    b->depth--;
+    x->kind = SYM_NODE;
+    x->node = at;
+    return true;
+}
+
+static bool subscript(Build *b) {
+    if (b->depth < 2) return false;
+    Sym *x = &b->stack[b->depth - 2], *y = &b->stack[b->depth - 1];
+    if (x->kind == SYM_LOCAL && y->kind == SYM_J) {
+        int arg = operand(b, x->slot, JAI_VEC_ARG_LIST);
+        if (arg < 0) return false;
+        x->kind = SYM_ELEM;
+        x->arg = arg;
+        x->off = y->off;
+        b->depth--;
+        return true;
+    }
+    if (x->kind != SYM_ELEM) return false;
+    JaiVecNode n;
+    memset(&n, 0, sizeof n);
+    n.op = JAI_VEC_ROW;
+    n.arg = (uint8_t)x->arg;
+    n.off = x->off;
+    if (y->kind == SYM_INT) {
+        n.rowArg = JAI_VEC_ROW_CONST;
+        n.rowConst = y->k;
+    } else if (y->kind == SYM_J) {
+        n.rowArg = JAI_VEC_ROW_DIAG;
+        n.rowConst = y->off;
+    } else if (y->kind == SYM_LOCAL) {
+        int arg = operand(b, y->slot, JAI_VEC_ARG_INT);
+        if (arg < 0) return false;
+        n.rowArg = (int8_t)arg;
+    } else {
+        return false;
+    }
+    int at = addNode(b, n);
+    if (at < 0) return false;
+    b->depth--;
+    x->kind = SYM_NODE;
+    x->node = at;
+    return true;
+}
+
+/* The body between FOR_RANGE_BIND and its LOOP, walked once with a symbolic
+ * stack. Every opcode not named here -- a call, a field, a branch, a store to
+ * a local other than the accumulator -- ends the walk with no plan. */
+static bool buildPlan(const Chunk *c, uint32_t at, JaiVecPlan *p) {
+    const uint8_t *code = c->code;
+    uint32_t count = (uint32_t)c->count;
+    if (at + 15 > count) return false;
+    if (code[at] != OP_ITER_RANGE || code[at + 6] != OP_FOR_RANGE_BIND) {
+        return false;
+    }
+    Build b;
+    memset(&b, 0, sizeof b);
+    b.plan = p;
+    b.cur = jaiReadU16(code + at + 2);
+    b.end = jaiReadU16(code + at + 4);
+    int16_t exitJump = jaiReadI16(code + at + 7);
+    b.var = jaiReadU16(code + at + 9);
+    if (jaiReadU16(code + at + 11) != b.cur) return false;
+    if (jaiReadU16(code + at + 13) != b.end) return false;
+    uint32_t exit = (uint32_t)((int32_t)(at + 15) + exitJump);
+
+    p->argSlot[0] = (uint16_t)b.cur;
+    p->argRole[0] = JAI_VEC_ARG_COUNTER;
+    p->argSlot[1] = (uint16_t)b.end;
+    p->argRole[1] = JAI_VEC_ARG_END;
+    p->argCount = 2;
+
+    uint32_t q = at + 15;
+    for (;;) {
+        if (q >= count) return false;
+        Sym s;
+        memset(&s, 0, sizeof s);
+        /* Folded: a loop the interpreter has run is likely quickened. */
+        uint8_t op = jaiOpGeneric(code[q]);
+        switch (op) {
+        case OP_GET_LOCAL:
+            if (q + 3 > count) return false;
+            if (!pushLocal(&b, jaiReadU16(code + q + 1))) return false;
+            q += 3;
+            continue;
+        case OP_GET_LOCAL2:
+            if (q + 5 > count) return false;
+            if (!pushLocal(&b, jaiReadU16(code + q + 1))) return false;
+            if (!pushLocal(&b, jaiReadU16(code + q + 3))) return false;
+            q += 5;
+            continue;
+        case OP_ADD_INT_CONST:
+        case OP_SUB_INT_CONST: {
+            if (q + 5 > count) return false;
+            if (jaiReadU16(code + q + 1) != b.var) return false;
+            int16_t k = jaiReadI16(code + q + 3);
+            s.kind = SYM_J;
+            s.off = code[q] == OP_ADD_INT_CONST ? k : -(int32_t)k;
+            if (!push(&b, s)) return false;
+            q += 5;
+            continue;
+        }
+        case OP_INT:
+            if (q + 3 > count) return false;
+            s.kind = SYM_INT;
+            s.k = jaiReadI16(code + q + 1);
+            if (!push(&b, s)) return false;
+            q += 3;
+            continue;
+        case OP_CONST: {
+            if (q + 4 > count) return false;
+            uint32_t ki = jaiReadU24(code + q + 1);
+            if (ki >= (uint32_t)c->constants.count) return false;
+            Value k = c->constants.data[ki];
+            if (IS_INT(k)) {
+                s.kind = SYM_INT;
+                s.k = AS_INT(k);
+            } else if (IS_FLOAT(k)) {
+                JaiVecNode n;
+                memset(&n, 0, sizeof n);
+                n.op = JAI_VEC_CONST;
+                n.k = AS_FLOAT(k);
+                int node = addNode(&b, n);
+                if (node < 0) return false;
+                s.kind = SYM_NODE;
+                s.node = node;
+            } else {
+                return false;
+            }
+            if (!push(&b, s)) return false;
+            q += 4;
+            continue;
+        }
+        case OP_TO_FLOAT: {
+            /* On an int literal the conversion is done here; on a float it is
+             * the identity. Anything else was proved an int by the checker. */
+            if (b.depth < 1) return false;
+            Sym *top = &b.stack[b.depth - 1];
+            if (top->kind == SYM_INT) {
+                if (asNode(&b, top, true) < 0) return false;
+            } else if (top->kind != SYM_NODE && top->kind != SYM_ELEM) {
+                return false;
+            }
+            q += 1;
+            continue;
+        }
+        case OP_ADD: case OP_SUB: case OP_MUL: case OP_DIV:
+            if (!arith(&b, op)) return false;
+            q += 1;
+            continue;
+        case OP_GET_INDEX:
+            if (!subscript(&b)) return false;
+            q += 1;
+            continue;
+        case OP_SET_INDEX: {
+            if (b.depth != 3) return false;
+            Sym *list = &b.stack[0], *idx = &b.stack[1], *val = &b.stack[2];
+            if (list->kind != SYM_LOCAL || idx->kind != SYM_J) return false;
+            int arg = operand(&b, list->slot, JAI_VEC_ARG_LIST);
+            if (arg < 0) return false;
+            if (asNode(&b, val, false) < 0) return false;
+            /* The stored value must be the last node: the kernel's result. */
+            if (val->node != (int)p->nodeCount - 1) return false;
+            p->kind = JAI_VEC_MAP;
+            p->target = (uint8_t)arg;
+            p->outOff = idx->off;
+            q += 1;
+            break;
+        }
+        case OP_ADD_BIND: case OP_SUB_BIND: case OP_MUL_BIND: {
+            if (q + 3 > count || b.depth != 2) return false;
+            unsigned slot = jaiReadU16(code + q + 1);
+            Sym *acc = &b.stack[0], *val = &b.stack[1];
+            if (acc->kind != SYM_LOCAL || acc->slot != slot) return false;
+            int arg = operand(&b, slot, JAI_VEC_ARG_ACC);
+            if (arg < 0) return false;
+            if (asNode(&b, val, false) < 0) return false;
+            if (val->node != (int)p->nodeCount - 1) return false;
+            p->kind = code[q] == OP_ADD_BIND ? JAI_VEC_SUM
+                    : code[q] == OP_SUB_BIND ? JAI_VEC_DIFF
+                                             : JAI_VEC_PRODUCT;
+            p->target = (uint8_t)arg;
+            q += 3;
+            break;
+        }
+        default:
+            return false;
+        }
+        break;
+    }
+
+    /* The back edge, to this loop's own head, and nothing after it. */
+    if (q + 3 > count || code[q] != OP_LOOP) return false;
+    if ((uint32_t)((int32_t)(q + 3) + jaiReadI16(code + q + 1)) != at + 6) {
+        return false;
+    }
+    return exit == q + 3 && p->nodeCount > 0;
+}
+
+const JaiVecPlan *jaiVecPlanFor(ObjFunction *fn, uint32_t at) {
+    for (JaiVecPlan *p = fn->jitVecPlans; p != NULL; p = p->next) {
+        if (p->at == at) return p->nodeCount > 0 ? p : NULL;
+    }
+    JaiVecPlan *p = calloc(1, sizeof *p);
+    if (p == NULL) return NULL;
+    /* A miss is kept too, as a plan with no nodes, so a loop that does not
+     * match is walked once rather than on every compile that reaches it. */
+    if (!buildPlan(&fn->chunk, at, p)) {
+        memset(p, 0, sizeof *p);
+    }
+    p->at = at;
+    p->next = fn->jitVecPlans;
+    fn->jitVecPlans = p;
+    return p->nodeCount > 0 ? p : NULL;
+}
+
+void jaiVecPlansFree(ObjFunction *fn) {
+    JaiVecPlan *p = fn->jitVecPlans;
+    while (p != NULL) {
+        JaiVecPlan *next = p->next;
+        free(p);
+        p = next;
+    }
+    fn->jitVecPlans = NULL;
+}
+
+/* ------------------------------------------------------------------ */
+/* The kernel                                                           */
+/* ------------------------------------------------------------------ */
+
+/* One operator over a block: r = a OP b, element-wise, over `n` rounded up
+ * to whole vectors. The buffers are VEC_BLOCK long, so the round-up stays in
+ * bounds, and the lanes past `n` are never committed.
+ *
+ * Written with GCC's vector extension rather than intrinsics so one source
+ * is SSE2 on x86-64 and NEON on arm64; the AVX2 copy is the same body at
+ * twice the width, built for that target alone and chosen at run time. No
+ * FMA, anywhere: `a * b + c` fused rounds once where the interpreter rounds
+ * twice, and the answers would stop matching. */
+#if defined(__GNUC__)
+
+#define VEC_LANES(VecT, EXPR)                                                 \
+    for (unsigned i = 0; i < n; i += (unsigned)(sizeof(VecT) / sizeof(double))) { \
+        VecT x, y, z;                                                         \
+        memcpy(&x, a + i, sizeof x);                                          \
+        memcpy(&y, b + i, sizeof y);                                          \
+        z = EXPR;                                                             \
+        memcpy(r + i, &z, sizeof z);                                          \
+    }
+
+/* The switch outside the loops, so each loop is straight-line. */
+#define VEC_BODY(VecT)                                                        \
+    switch (op) {                                                             \
+    case JAI_VEC_ADD: VEC_LANES(VecT, x + y) break;                           \
+    case JAI_VEC_SUB: VEC_LANES(VecT, x - y) break;                           \
+    case JAI_VEC_MUL: VEC_LANES(VecT, x * y) break;                           \
+    default:          VEC_LANES(VecT, x / y) break;                           \
+    }
+
+typedef double VecD2 __attribute__((vector_size(16)));
+
+static void blockOp(double *restrict r, const double *restrict a,
+                    const double *restrict b, unsigned op, unsigned n) {
+    VEC_BODY(VecD2)
+}
+
+#if defined(__x86_64__)
+typedef double VecD4 __attribute__((vector_size(32)));
+
+__attribute__((target("avx2")))
+static void blockOpAvx2(double *restrict r, const double *restrict a,
+                        const double *restrict b, unsigned op, unsigned n) {
+    VEC_BODY(VecD4)
+}
+
+static bool haveAvx2(void) {
+    static int cached = -1;
+    if (cached < 0) {
+        __builtin_cpu_init();
+        cached = __builtin_cpu_supports("avx2") ? 1 : 0;
+    }
+    return cached != 0;
+}
+#endif
+
+#else   /* !__GNUC__: one lane */
+
+static void blockOp(double *restrict r, const double *restrict a,
+                    const double *restrict b, unsigned op, unsigned n) {
+    for (unsigned i = 0; i < n; i++) {
+        switch (op) {
+        case JAI_VEC_ADD: r[i] = a[i] + b[i]; break;
+        case JAI_VEC_SUB: r[i] = a[i] - b[i]; break;
+        case JAI_VEC_MUL: r[i] = a[i] * b[i]; break;
+        default:          r[i] = a[i] / b[i]; break;
+        }
+    }
+}
+
+#endif
+
+typedef void (*BlockOpFn)(double *restrict, const double *restrict,
+                          const double *restrict, unsigned, unsigned);
+
+static BlockOpFn pickBlockOp(void) {
+#if defined(__GNUC__) && defined(__x86_64__)
+    if (haveAvx2()) return blockOpAvx2;
+#endif
+    return blockOp;
+}
+
+static double asDouble(int64_t bits) {
+    double d;
+    memcpy(&d, &bits, sizeof d);
+    return d;
+}
+
+/* The tags are tested without a branch per element -- the test is OR-ed
+ * together and the doubles copied regardless -- and only a block that turns
+ * out to hold something else is walked again to find where. */
+static unsigned fillFloats(const Value *src, unsigned n, double *dst) {
+    unsigned bad = 0;
+    for (unsigned i = 0; i < n; i++) {
+        bad |= (unsigned)!IS_FLOAT(src[i]);
+        dst[i] = AS_FLOAT(src[i]);
+    }
+    if (bad == 0) return n;
+    for (unsigned i = 0; i < n; i++) {
+        if (!IS_FLOAT(src[i])) return i;
+    }
+    return n;
+}
+
+/* Fills one leaf's lanes from the heap, and returns how many of the first `n`
+ * it could: the first element that is not a float -- or, for a row, the first
+ * row that is not a list, is the list being written, or is too short -- ends
+ * the block there. */
+static unsigned fillLeaf(const JaiVecNode *node, ObjList *const *lists,
+                         const int64_t *args, const ObjList *out, int64_t j,
+                         unsigned n, double *dst) {
+    const Value *src = lists[node->arg]->items + (j + node->off);
+    if (node->op == JAI_VEC_LOAD) return fillFloats(src, n, dst);
+    for (unsigned i = 0; i < n; i++) {
+        if (!IS_LIST(src[i])) return i;
+        const ObjList *row = AS_LIST(src[i]);
+        if (row == out) return i;
+        int64_t m = node->rowArg >= 0 ? args[node->rowArg]
+                  : node->rowArg == JAI_VEC_ROW_DIAG ? j + (int64_t)i + node->rowConst
+                                                     : node->rowConst;
+        if (m < 0) m += row->count;
+        if (m < 0 || m >= row->count) return i;
+        if (!IS_FLOAT(row->items[m])) return i;
+        dst[i] = AS_FLOAT(row->items[m]);
+    }
+    return n;
+}
+
+int64_t jaiVecRun(const JaiVecPlan *plan, const int64_t *args, double *acc) {
+    int64_t cur = args[0], end = args[1];
+    /* `end` below `cur` is the wrapped end of `a..=INT64_MAX`: leave it to
+     * the loop that knows how to count there. */
+    if (end <= cur || cur < 0 || end > INT32_MAX) return 0;
+
+    ObjList *lists[JAI_VEC_MAX_OPERANDS] = { 0 };
+    for (unsigned i = 0; i < plan->argCount; i++) {
+        if (plan->argRole[i] != JAI_VEC_ARG_LIST) continue;
+        Obj *o = (Obj *)(uintptr_t)args[i];
+        if (o == NULL || o->type != OBJ_LIST) return 0;
+        lists[i] = (ObjList *)o;
+    }
+
+    /* Every index the run will use is in range from the outset: a negative
+     * one counts from the end in the interpreter, and an out-of-range one
+     * raises, and both are the scalar loop's to do. */
+    int64_t hi = end;
+    const ObjList *out = plan->kind == JAI_VEC_MAP ? lists[plan->target] : NULL;
+    if (out != NULL) {
+        if (cur + plan->outOff < 0) return 0;
+        if ((int64_t)out->count - plan->outOff < hi) {
+            hi = (int64_t)out->count - plan->outOff;
+        }
+        /* A float stored where `list[T]` promised something else raises. */
+        if (out->elemKind != FIELD_KIND_ANY &&
+            out->elemKind != FIELD_KIND_FLOAT) {
+            return 0;
+        }
+    }
+    for (unsigned k = 0; k < plan->nodeCount; k++) {
+        const JaiVecNode *node = &plan->nodes[k];
+        if (node->op != JAI_VEC_LOAD && node->op != JAI_VEC_ROW) continue;
+        const ObjList *l = lists[node->arg];
+        if (cur + node->off < 0) return 0;
+        if ((int64_t)l->count - node->off < hi) hi = (int64_t)l->count - node->off;
+        /* Reading the list being written at another offset would read, in a
+         * block, what the scalar loop had already overwritten. */
+        if (l == out && node->off != plan->outOff) return 0;
+    }
+    if (hi <= cur) return 0;
+
+    static _Alignas(32) double buf[JAI_VEC_MAX_NODES][VEC_BLOCK];
+    for (unsigned k = 0; k < plan->nodeCount; k++) {
+        const JaiVecNode *node = &plan->nodes[k];
+        double v;
+        if (node->op == JAI_VEC_CONST) {
+            v = node->k;
+        } else if (node->op == JAI_VEC_LOCAL) {
+            v = asDouble(args[node->arg]);
+        } else {
+            continue;
+        }
+        for (unsigned i = 0; i < VEC_BLOCK; i++) buf[k][i] = v;
+    }
+
+    BlockOpFn op = pickBlockOp();
+    const double *res = buf[plan->nodeCount - 1];
+    double a = acc != NULL ? *acc : 0.0;
+    int64_t j = cur;
+    while (j < hi) {
+        unsigned want = hi - j < VEC_BLOCK ? (unsigned)(hi - j) : VEC_BLOCK;
+        unsigned n = want;
+        for (unsigned k = 0; k < plan->nodeCount && n > 0; k++) {
+            const JaiVecNode *node = &plan->nodes[k];
+            switch (node->op) {
+            case JAI_VEC_LOAD:
+            case JAI_VEC_ROW:
+                n = fillLeaf(node, lists, args, out, j, n, buf[k]);
+                break;
+            case JAI_VEC_CONST:
+            case JAI_VEC_LOCAL:
+                break;
+            case JAI_VEC_DIV:
+                /* Float division by zero raises. The block ends before the
+                 * first iteration that would. */
+                for (unsigned i = 0; i < n; i++) {
+                    if (buf[node->b][i] == 0.0) { n = i; break; }
+                }
+                op(buf[k], buf[node->a], buf[node->b], node->op, n);
+                break;
+            default:
+                op(buf[k], buf[node->a], buf[node->b], node->op, n);
+                break;
+            }
+        }
+
+        switch (plan->kind) {
+        case JAI_VEC_MAP: {
+            Value *dst = lists[plan->target]->items + (j + plan->outOff);
+            for (unsigned i = 0; i < n; i++) dst[i] = FLOAT_VAL(res[i]);
+            break;
+        }
+        /* In order, one at a time: see the header. */
+        case JAI_VEC_SUM:
+            for (unsigned i = 0; i < n; i++) a = a + res[i];
+            break;
+        case JAI_VEC_DIFF:
+            for (unsigned i = 0; i < n; i++) a = a - res[i];
+            break;
+        default:
+            for (unsigned i = 0; i < n; i++) a = a * res[i];
+            break;
+        }
+        j += n;
+        if (n < want) break;
+    }
+
+    if (out != NULL && j > cur) jaiListTouch(lists[plan->target]);
+    if (acc != NULL) *acc = a;
+    return j - cur;
+}
@@ -0,0 +1,125 @@
+/* jit_vec.h — counted loops over float lists, run a block of elements at a
+ * time.
+ *
+ * A compiled `for j in a..b { out[j] = 0.25 * (up[j] + down[j]) }` still
+ * spends most of each iteration on the bookkeeping around one 16-byte Value:
+ * the bounds test, the tag test, the counter, the branch back. The arithmetic
+ * is a handful of instructions, and it is the same handful for every element.
+ * So the loop is handed to a kernel instead, which checks the tags of a block
+ * of elements in one pass and then does each operator across the whole block
+ * in vector lanes (two doubles on SSE2 and NEON, four on AVX2).
+ *
+ * It is a shape, not a compiler, in the same way jit_loop.c is. The body must
+ * be straight-line arithmetic over
+ *
+ *   - elements `xs[j + c]` of invariant lists, and `xs[j + c][m]` one level
+ *     further down, with `m` an invariant int local or a literal;
+ *   - invariant float locals and literals;
+ *   - `+ - * /`,
+ *
+ * ending either in `out[j + c] = <that>` (a map) or in `acc += <that>`,
+ * `-=` or `*=` (a reduction). Nothing else may be read or written, so running
+ * the iterations in blocks is indistinguishable from running them one at a
+ * time -- with one exception the plan refuses outright: a map that reads the
+ * list it writes at a different offset, where iteration j+1 would read what
+ * iteration j stored.
+ *
+ * A REDUCTION IS STILL ADDED UP IN ORDER. Float addition is not associative,
+ * and summing lanes separately would change the answer in the last bits, so
+ * only the element-wise part is done in lanes and the running total takes the
+ * results one at a time, exactly as the scalar loop does.
+ *
+ * The kernel never raises, never allocates and never deopts. Anything it is
+ * not sure of -- an element that is not a float, an index out of range, a
+ * zero divisor, a row that is the list being written -- ends the run just
+ * before that iteration, and the compiled scalar loop takes over from there
+ * with every guard it always had: that is the epilogue, and the deopt path. */
+#ifndef JAI_VM_JIT_VEC_H
+#define JAI_VM_JIT_VEC_H
+
+#include "vm/object/object.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define JAI_VEC_MAX_NODES    16
+#define JAI_VEC_MAX_OPERANDS 10
+#define JAI_VEC_ROW_CONST    (-1)
+#define JAI_VEC_ROW_DIAG     (-2)
+
+/* What the emitted call passes for each operand: the raw payload of a local,
+ * whose kind the compiled body has already proven. The emitter checks every
+ * operand's kind against its role, and declines the kernel (never the loop)
+ * on any disagreement. */
+typedef enum {
+    JAI_VEC_ARG_COUNTER,    /* the range's next value */
+    JAI_VEC_ARG_END,        /* one past its last */
+    JAI_VEC_ARG_LIST,       /* ObjList * */
+    JAI_VEC_ARG_FLOAT,      /* double, bit for bit */
+    JAI_VEC_ARG_INT,        /* int64_t: a row index */
+    JAI_VEC_ARG_ACC         /* double: the reduction's running value */
+} JaiVecRole;
+
+typedef enum {
+    JAI_VEC_LOAD,           /* list[j + off] */
+    JAI_VEC_ROW,            /* list[j + off][m] */
+    JAI_VEC_CONST,          /* k */
+    JAI_VEC_LOCAL,          /* an invariant float operand */
+    JAI_VEC_ADD,
+    JAI_VEC_SUB,
+    JAI_VEC_MUL,
+    JAI_VEC_DIV
+} JaiVecOp;
+
+typedef struct {
+    uint8_t op;             /* JaiVecOp */
+    uint8_t a, b;           /* operand nodes of a binary op */
+    uint8_t arg;            /* operand index: the list, or the float local */
+    /* ROW: operand index of `m`; JAI_VEC_ROW_CONST for `rowConst` itself;
+     * JAI_VEC_ROW_DIAG for the loop variable plus `rowConst`. */
+    int8_t  rowArg;
+    int32_t off;            /* LOAD, ROW: constant added to the loop variable */
+    int64_t rowConst;
+    double  k;              /* CONST */
+} JaiVecNode;
+
+typedef enum {
+    JAI_VEC_MAP,
+    JAI_VEC_SUM,            /* acc + x */
+    JAI_VEC_DIFF,           /* acc - x */
+    JAI_VEC_PRODUCT         /* acc * x */
+} JaiVecKind;
+
+/* Built from the bytecode alone, once per loop, and owned by the function it
+ * was built for (ObjFunction::jitVecPlans): compiled code holds a pointer to
+ * it for as long as it may run, which is until the function is freed. */
+typedef struct JaiVecPlan {
+    struct JaiVecPlan *next;
+    uint32_t   at;              /* the loop's OP_ITER_RANGE */
+    uint8_t    kind;            /* JaiVecKind */
+    uint8_t    nodeCount;       /* the last node is the result */
+    uint8_t    argCount;        /* 0 and 1 are always the counter and end */
+    /* Operand index of the list a map writes, or of a reduction's acc. */
+    uint8_t    target;
+    int32_t    outOff;          /* MAP: out[j + outOff] */
+    uint16_t   argSlot[JAI_VEC_MAX_OPERANDS];
+    uint8_t    argRole[JAI_VEC_MAX_OPERANDS];   /* JaiVecRole */
+    JaiVecNode nodes[JAI_VEC_MAX_NODES];
+} JaiVecPlan;
+
+/* The plan for the loop opened by the OP_ITER_RANGE at `at`, built on first
+ * ask, or NULL when that loop is not one of the shapes above. Called from the
+ * compiler thread with the compile lock held, which is also what keeps the
+ * list it appends to from being walked by jaiVecPlansFree meanwhile. */
+const JaiVecPlan *jaiVecPlanFor(ObjFunction *fn, uint32_t at);
+
+/* Runs iterations from the counter operand onward for as long as every one of
+ * them is certain to do exactly what the interpreter would, and returns how
+ * many it ran. `args` is one payload per operand, in plan order; the
+ * reduction's final value is written back through `acc`. */
+int64_t jaiVecRun(const JaiVecPlan *plan, const int64_t *args, double *acc);
+
+/* From jaiJitForget: the function is about to be freed. */
+void jaiVecPlansFree(ObjFunction *fn);
+
+#endif /* JAI_VM_JIT_VEC_H */
@@ -0,0 +1,520 @@
+/* jit_warm.c — what the compiled tier learned in one run, kept for the next.
+ *
+ * Every process starts cold: a function is interpreted for JAI_JIT_THRESHOLD
+ * entries, and its inline caches observe for JAI_IC_OBS_BUDGET invokes, before
+ * the tier will look at it. A long benchmark never notices. A CLI job that
+ * runs for 30 ms spends most of its life there, and does so again on every
+ * invocation, arriving at the same compiled set each time.
+ *
+ * So the set is written down. At exit, each module loaded from a source file
+ * leaves `__jaicache__/<stem>.jaij` beside its `.jaic`, naming the functions
+ * that reached the whole-function tier and what each was specialised to: the
+ * kind of every argument, and the class -- by qualified name, since a shape id
+ * is only meaningful inside the process that assigned it -- of every argument
+ * pinned to one. The next run that loads the module finds them and gives each
+ * one a warm start: its entry count begins JAI_JIT_WARM_ENTRIES short of the
+ * threshold, and its caches observe for JAI_IC_OBS_BUDGET_TRACE invokes, so it
+ * compiles after a handful of calls rather than sixty-four.
+ *
+ * WHAT IS NOT KEPT IS THE CODE. A compiled body bakes in the addresses of this
+ * process's helpers, classes, interned constants, global slots and callees'
+ * entries, at several dozen sites that record no relocation; re-pointing them
+ * in another process would mean resolving every one of those by name again,
+ * which is what compiling does anyway, in microseconds. What a cold run cannot
+ * have without waiting is the evidence the tier waits for, so that is what is
+ * carried over.
+ *
+ * A warm start is a prediction, like every other piece of feedback. The file
+ * is ignored outright unless its build id, CPU and source hash are this
+ * process's, and a record unless the function's bytecode hashes the same. A
+ * function whose first hot entry is not the arguments it was recorded for --
+ * another caller, another class -- goes back to the full threshold and the
+ * full observation window. And whatever compiles is entered through exactly
+ * the guards it would have had anyway, so being wrong costs a compile, never
+ * an answer.
+ *
+ * JAITHON_JIT_NO_WARM=1 neither reads nor writes the files; `--no-cache`
+ * turns them off with the rest of `__jaicache__`. */
+
+#include "vm/jit/jit.h"
+
+#include "vm/bytecode/serialize.h"
+#include "vm/vm.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define JAIJ_MAGIC    "JAIJ"
+#define JAIJ_VERSION  1u
+/* magic 4, version 2, reserved 2, build id 4, cpu 4, source hash 8 */
+#define JAIJ_HEADER   24u
+/* Nested functions and methods are found through their enclosing chunk's
+ * constants; no real program nests anywhere near this deep. */
+#define JAIJ_MAX_DEPTH 64
+
+struct JaiJitWarm {
+    uint8_t  argBase;
+    uint8_t  argCount;
+    uint8_t  kind[8];
+    char    *shapeName[8];  /* qualified class name where the kind pins one */
+    bool     spent;         /* the first hot entry has been looked at */
+};
+
+/* A module whose file is to be written at exit. The body is reachable from
+ * the module table for as long as the VM lives, and this is read before the
+ * VM is freed. */
+typedef struct {
+    char        *path;
+    uint64_t     hash;
+    ObjFunction *body;
+    bool         existed;   /* a file was there to read; keep it current */
+} WarmModule;
+
+static WarmModule *sModules;
+static size_t      sModuleCount, sModuleCap;
+
+static bool warmDisabled(void) {
+    static int cached = -1;
+    if (cached < 0) {
+        const char *off = getenv("JAITHON_JIT_NO_WARM");
+        cached = (off != NULL && off[0] != '\0' && strcmp(off, "0") != 0);
+    }
+    return cached != 0;
+}
+
+static bool warmWhy(void) {
+    static int cached = -1;
+    if (cached < 0) cached = getenv("JAI_JIT_WHY") != NULL;
+    return cached != 0;
+}
+
+/* What the code in this file could depend on about the machine: the
+ * instruction set it was emitted for, and the extensions the block kernel
+ * picks between. */
+static uint32_t warmCpu(void) {
+    uint32_t bits = 0;
+#if defined(__x86_64__)
+    bits |= 1u;
+#  if defined(__GNUC__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) bits |= 4u;
+#  endif
+#elif defined(__aarch64__) || defined(__arm64__)
+    bits |= 2u;
+#endif
+    return bits;
+}
+
+/* Of the code as emitted: by the time a record is written or checked the
+ * function has usually run, and the interpreter may have quickened it. */
+static uint32_t codeHash(const ObjFunction *fn) {
+    if (fn->chunk.count <= 0) return jaiCrc32(fn->chunk.code, 0);
+    uint8_t *generic = malloc((size_t)fn->chunk.count);
+    if (generic == NULL) return 0;
+    jaiChunkCopyGeneric(&fn->chunk, generic);
+    uint32_t hash = jaiCrc32(generic, (size_t)fn->chunk.count);
+    free(generic);
+    return hash;
+}
+
+static const char *fnName(const ObjFunction *fn) {
+    const ObjString *n = fn->qualifiedName != NULL ? fn->qualifiedName : fn->name;
+    return n != NULL ? n->chars : "";
+}
+
+/* ------------------------------------------------------------------ */
+/* Walking a module                                                     */
+/* ------------------------------------------------------------------ */
+
+typedef void (*FnVisit)(ObjFunction *fn, void *ctx);
+
+static void eachFunction(ObjFunction *fn, FnVisit visit, void *ctx, int depth) {
+    if (fn == NULL || depth > JAIJ_MAX_DEPTH) return;
+    visit(fn, ctx);
+    const ValueArray *k = &fn->chunk.constants;
+    for (int i = 0; i < k->count; i++) {
+        if (IS_FUNCTION(k->data[i])) {
+            eachFunction(AS_FUNCTION(k->data[i]), visit, ctx, depth + 1);
+        }
+    }
+}
+
+/* ------------------------------------------------------------------ */
+/* The file                                                             */
+/* ------------------------------------------------------------------ */
+
+/* Per record:
+ *     u16 nameLen, name         qualified name
+ *     u32 codeHash              CRC32 of the bytecode
+ *     u8  argBase, argCount
+ *     u8  kind[argCount]
+ *     per argument: u16 len, class name (len 0: no class pinned)
+ * then a trailing CRC32 of everything before it, as a .jaic has. */
+
+typedef struct {
+    uint8_t *data;
+    size_t   len, cap;
+    bool     bad;
+} Buf;
+
+static void put(Buf *b, const void *p, size_t n) {
+    if (b->bad || n == 0) return;
+    if (b->len + n > b->cap) {
+        size_t cap = b->cap < 256 ? 256 : b->cap;
+        while (cap < b->len + n) cap *= 2;
+        uint8_t *grown = realloc(b->data, cap);
+        if (grown == NULL) { b->bad = true; return; }
+        b->data = grown;
+        b->cap = cap;
+    }
+    memcpy(b->data + b->len, p, n);
+    b->len += n;
+}
+
+static void putU8(Buf *b, uint8_t v) { put(b, &v, 1); }
+
+static void putU16(Buf *b, uint16_t v) {
+    uint8_t p[2] = { (uint8_t)v, (uint8_t)(v >> 8) };
+    put(b, p, 2);
+}
+
+static void putU32(Buf *b, uint32_t v) {
+    uint8_t p[4] = { (uint8_t)v, (uint8_t)(v >> 8), (uint8_t)(v >> 16),
+                     (uint8_t)(v >> 24) };
+    put(b, p, 4);
+}
+
+static void putU64(Buf *b, uint64_t v) {
+    putU32(b, (uint32_t)v);
+    putU32(b, (uint32_t)(v >> 32));
+}
+
+static void putStr(Buf *b, const char *s) {
+    size_t n = s != NULL ? strlen(s) : 0;
+    if (n > UINT16_MAX) { b->bad = true; return; }
+    putU16(b, (uint16_t)n);
+    put(b, s, n);
+}
+
+typedef struct {
+    const uint8_t *p;
+    size_t         len, pos;
+    bool           bad;
+} Cur;
+
+static const uint8_t *take(Cur *c, size_t n) {
+    if (c->bad || n > c->len - c->pos) { c->bad = true; return NULL; }
+    const uint8_t *at = c->p + c->pos;
+    c->pos += n;
+    return at;
+}
+
+static uint8_t getU8(Cur *c) {
+    const uint8_t *p = take(c, 1);
+    return p != NULL ? p[0] : 0;
+}
+
+static uint16_t getU16(Cur *c) {
+    const uint8_t *p = take(c, 2);
+    return p != NULL ? (uint16_t)(p[0] | (p[1] << 8)) : 0;
+}
+
+static uint32_t readU32(const uint8_t *p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) |
+           ((uint32_t)p[3] << 24);
+}
+
+static uint32_t getU32(Cur *c) {
+    const uint8_t *p = take(c, 4);
+    return p != NULL ? readU32(p) : 0;
+}
+
+/* ------------------------------------------------------------------ */
+/* Reading                                                              */
+/* ------------------------------------------------------------------ */
+
+typedef struct {
+    char     name[256];
+    uint32_t hash;
+    uint8_t  argBase, argCount;
+    uint8_t  kind[8];
+    char    *shapeName[8];
+} Record;
+
+typedef struct {
+    Record *recs;
+    size_t  count;
+    size_t  applied;
+} Apply;
+
+static void warmFree(struct JaiJitWarm *w) {
+    if (w == NULL) return;
+    for (unsigned i = 0; i < 8; i++) free(w->shapeName[i]);
+    free(w);
+}
+
+static void applyOne(ObjFunction *fn, void *ctx) {
+    Apply *a = ctx;
+    /* A traced function already compiles early, and one that carries a
+     * record from an earlier load of the same body keeps it. */
+    if ((fn->flags & FN_TRACE) != 0 || fn->jitWarm != NULL) return;
+    const char *name = fnName(fn);
+    uint32_t hash = 0;
+    bool hashed = false;
+    for (size_t i = 0; i < a->count; i++) {
+        Record *r = &a->recs[i];
+        if (strcmp(r->name, name) != 0) continue;
+        if (!hashed) { hash = codeHash(fn); hashed = true; }
+        if (r->hash != hash) continue;
+
+        struct JaiJitWarm *w = calloc(1, sizeof *w);
+        if (w == NULL) return;
+        w->argBase = r->argBase;
+        w->argCount = r->argCount;
+        memcpy(w->kind, r->kind, sizeof w->kind);
+        for (unsigned j = 0; j < r->argCount; j++) {
+            w->shapeName[j] = r->shapeName[j];   /* moved */
+            r->shapeName[j] = NULL;
+        }
+        fn->jitWarm = w;
+
+        if (fn->entryCount < JAI_JIT_THRESHOLD - JAI_JIT_WARM_ENTRIES) {
+            fn->entryCount = JAI_JIT_THRESHOLD - JAI_JIT_WARM_ENTRIES;
+        }
+        for (int c = 0; c < fn->chunk.cacheCount; c++) {
+            InlineCache *ic = &fn->chunk.caches[c];
+            if (ic->obsBudget > JAI_IC_OBS_BUDGET_TRACE) {
+                ic->obsBudget = JAI_IC_OBS_BUDGET_TRACE;
+            }
+        }
+        a->applied++;
+        return;
+    }
+}
+
+static bool readRecords(Cur *c, Apply *a, size_t count) {
+    a->recs = calloc(count > 0 ? count : 1, sizeof *a->recs);
+    if (a->recs == NULL) return false;
+    for (size_t i = 0; i < count; i++) {
+        Record *r = &a->recs[i];
+        uint16_t n = getU16(c);
+        const uint8_t *name = take(c, n);
+        if (name == NULL || n >= sizeof r->name) return false;
+        memcpy(r->name, name, n);
+        r->name[n] = '\0';
+        r->hash = getU32(c);
+        r->argBase = getU8(c);
+        r->argCount = getU8(c);
+        if (c->bad || r->argCount > 8) return false;
+        for (unsigned j = 0; j < r->argCount; j++) r->kind[j] = getU8(c);
+        for (unsigned j = 0; j < r->argCount; j++) {
+            uint16_t sn = getU16(c);
+            const uint8_t *s = take(c, sn);
+            if (s == NULL) return false;
+            if (sn == 0) continue;
+            r->shapeName[j] = malloc((size_t)sn + 1);
+            if (r->shapeName[j] == NULL) return false;
+            memcpy(r->shapeName[j], s, sn);
+            r->shapeName[j][sn] = '\0';
+        }
+        a->count++;
+    }
+    return !c->bad && c->pos == c->len;
+}
+
+void jaiJitWarmAttach(const char *sourcePath, ObjFunction *body,
+                      uint64_t sourceHash, bool read, bool write) {
+    if (body == NULL || warmDisabled() || !jaiJitEnabled()) return;
+    char path[JAI_MAX_PATH];
+    jaiWarmPathFor(sourcePath, path, sizeof path);
+    if (path[0] == '\0') return;
+
+    bool existed = false;
+    if (read) {
+        size_t length = 0;
+        char *data = jaiReadFile(path, &length);
+        existed = data != NULL;
+        const uint8_t *p = (const uint8_t *)data;
+        bool ok = data != NULL && length >= JAIJ_HEADER + 8 &&
+                  memcmp(p, JAIJ_MAGIC, 4) == 0 &&
+                  (uint16_t)(p[4] | (p[5] << 8)) == JAIJ_VERSION &&
+                  jaiCrc32(p, length - 4) == readU32(p + length - 4) &&
+                  readU32(p + 8) == jaiBuildId() &&
+                  readU32(p + 12) == warmCpu() &&
+                  ((uint64_t)readU32(p + 16) |
+                   ((uint64_t)readU32(p + 20) << 32)) == sourceHash;
+        if (ok) {
+            Cur c = { p, length - 4, JAIJ_HEADER, false };
+            uint32_t count = getU32(&c);
+            Apply a = { NULL, 0, 0 };
+            /* All or nothing: a file that does not parse to its end is not
+             * the file this reader thinks it is. */
+            if (readRecords(&c, &a, count)) {
+                eachFunction(body, applyOne, &a, 0);
+                if (warmWhy()) {
+                    fprintf(stderr, "[jit] warm: %s: %zu functions from %zu records\n",
+                            sourcePath, a.applied, a.count);
+                }
+            }
+            for (size_t i = 0; i < a.count; i++) {
+                for (unsigned j = 0; j < 8; j++) free(a.recs[i].shapeName[j]);
+            }
+            free(a.recs);
+        }
+        if (data != NULL) (void)jaiRealloc(data, length + 1, 0);
+    }
+
+    if (!write) return;
+    if (sModuleCount == sModuleCap) {
+        size_t cap = sModuleCap < 8 ? 8 : sModuleCap * 2;
+        WarmModule *grown = realloc(sModules, cap * sizeof *grown);
+        if (grown == NULL) return;
+        sModules = grown;
+        sModuleCap = cap;
+    }
+    char *copy = jaiStrdup(sourcePath);
+    sModules[sModuleCount++] = (WarmModule){ copy, sourceHash, body, existed };
+}
+
+/* ------------------------------------------------------------------ */
+/* The first hot entry                                                  */
+/* ------------------------------------------------------------------ */
+
+bool jaiJitWarmFits(ObjClosure *closure, const Value *slotBase) {
+    ObjFunction *fn = closure->fn;
+    struct JaiJitWarm *w = fn->jitWarm;
+    if (w == NULL || w->spent) return true;
+    w->spent = true;
+
+    bool fits = true;
+    for (unsigned i = 0; i < w->argCount && fits; i++) {
+        fits = jaiJitValueFits(w->kind[i], slotBase[w->argBase + i],
+                               w->shapeName[i]);
+    }
+    if (fits) {
+        if (warmWhy()) fprintf(stderr, "[jit] warm: %s: hot early\n", fnName(fn));
+        return true;
+    }
+
+    /* Not what the record was made for, so the early window would only have
+     * seen this caller. Back to the full one: the caches reopen and merge on
+     * from what they have, and the count starts over. */
+    fn->entryCount = 0;
+    for (int c = 0; c < fn->chunk.cacheCount; c++) {
+        fn->chunk.caches[c].obsBudget = JAI_IC_OBS_BUDGET;
+    }
+    if (warmWhy()) {
+        fprintf(stderr, "[jit] warm: %s: entered with other arguments\n",
+                fnName(fn));
+    }
+    return false;
+}
+
+void jaiJitWarmForget(ObjFunction *fn) {
+    warmFree(fn->jitWarm);
+    fn->jitWarm = NULL;
+}
+
+/* ------------------------------------------------------------------ */
+/* Writing                                                              */
+/* ------------------------------------------------------------------ */
+
+typedef struct {
+    Buf      out;
+    uint32_t count;
+} Save;
+
+static void saveOne(ObjFunction *fn, void *ctx) {
+    Save *s = ctx;
+    const struct JaiJitWarm *w = fn->jitWarm;
+    uint8_t argBase, argCount, kind[8];
+    const char *shape[8] = { NULL };
+
+    if (fn->jitFunc != NULL) {
+        argBase = fn->jitArgBase;
+        argCount = fn->jitArgCount;
+        if (argCount > 8) return;
+        memcpy(kind, fn->jitParamKind, sizeof kind);
+        for (unsigned i = 0; i < argCount; i++) {
+            if (fn->jitParamShape[i] == 0) continue;
+            ObjClass *cls = NULL;
+            /* A class the shape table no longer answers for cannot be named,
+             * and a record that pins nothing would warm any caller. */
+            if (!jaiClassForShape(fn->jitParamShape[i], &cls) ||
+                cls->qualifiedName == NULL) {
+                return;
+            }
+            shape[i] = cls->qualifiedName->chars;
+        }
+    } else if (w != NULL) {
+        /* Not compiled this run -- never hot, or hot with other arguments --
+         * so nothing has contradicted the record, and it stands. */
+        argBase = w->argBase;
+        argCount = w->argCount;
+        memcpy(kind, w->kind, sizeof kind);
+        for (unsigned i = 0; i < argCount; i++) shape[i] = w->shapeName[i];
+    } else {
+        return;
+    }
+    if (strlen(fnName(fn)) >= sizeof ((Record *)0)->name) return;
+
+    putStr(&s->out, fnName(fn));
+    putU32(&s->out, codeHash(fn));
+    putU8(&s->out, argBase);
+    putU8(&s->out, argCount);
+    put(&s->out, kind, argCount);
+    for (unsigned i = 0; i < argCount; i++) putStr(&s->out, shape[i]);
+    s->count++;
+}
+
+static void saveModule(const WarmModule *m) {
+    Save s = { { NULL, 0, 0, false }, 0 };
+    put(&s.out, JAIJ_MAGIC, 4);
+    putU16(&s.out, (uint16_t)JAIJ_VERSION);
+    putU16(&s.out, 0);
+    putU32(&s.out, jaiBuildId());
+    putU32(&s.out, warmCpu());
+    putU64(&s.out, m->hash);
+    putU32(&s.out, 0);                      /* count, patched below */
+    eachFunction(m->body, saveOne, &s, 0);
+    if (s.out.bad || (s.count == 0 && !m->existed)) {
+        free(s.out.data);
+        return;
+    }
+    uint8_t *n = s.out.data + JAIJ_HEADER;
+    n[0] = (uint8_t)s.count;
+    n[1] = (uint8_t)(s.count >> 8);
+    n[2] = (uint8_t)(s.count >> 16);
+    n[3] = (uint8_t)(s.count >> 24);
+    putU32(&s.out, jaiCrc32(s.out.data, s.out.len));
+
+    char path[JAI_MAX_PATH];
+    jaiWarmPathFor(m->path, path, sizeof path);
+    char dir[JAI_MAX_PATH];
+    jaiPathDirname(dir, sizeof dir, path);
+    if (!s.out.bad && path[0] != '\0' && dir[0] != '\0' && jaiMakeDirs(dir)) {
+        /* The same pid-tagged temporary and rename a .jaic is stored with: two
+         * runs finishing together leave one whole file, never a mixture. */
+        char tmp[JAI_MAX_PATH];
+        int w = snprintf(tmp, sizeof tmp, "%s.tmp%ld", path, (long)getpid());
+        if (w > 0 && (size_t)w < sizeof tmp) {
+            if (!jaiWriteFile(tmp, s.out.data, s.out.len) ||
+                rename(tmp, path) != 0) {
+                (void)unlink(tmp);
+            }
+        }
+    }
+    free(s.out.data);
+}
+
+void jaiJitWarmSave(void) {
+    for (size_t i = 0; i < sModuleCount; i++) {
+        saveModule(&sModules[i]);
+        (void)jaiRealloc(sModules[i].path, strlen(sModules[i].path) + 1, 0);
+    }
+    free(sModules);
+    sModules = NULL;
+    sModuleCount = sModuleCap = 0;
+}
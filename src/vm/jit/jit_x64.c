@@ -0,0 +1,1676 @@
+/* jit_x64.c -- lowers the compiled tiers' arm64 word stream to x86-64. See
+ * jit_x64.h for the register plan and why this is a lowering rather than a
+ * second code generator. */
+#include "vm/jit/jit_x64.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/* ------------------------------------------------------------------ */
+/* Encoder                                                              */
+/* ------------------------------------------------------------------ */
+
+enum {
+    RAX, RCX, RDX, RBX, RSP, RBP, RSI, RDI,
+    R8, R9, R10, R11, R12, R13, R14, R15
+};
+
+#define XMM_SCRATCH 15
+
+/* x86 condition codes, the low nibble of jcc/setcc/cmovcc. */
+enum {
+    CC_O, CC_NO, CC_B, CC_AE, CC_E, CC_NE, CC_BE, CC_A,
+    CC_S, CC_NS, CC_P, CC_NP, CC_L, CC_GE, CC_LE, CC_G
+};
+
+typedef struct {
+    uint8_t *buf;
+    size_t   len;
+    size_t   cap;
+    bool     oom;
+    /* Set by every emitter whose instruction writes RFLAGS. The lowering
+     * reads it to learn whether an arm64 instruction that leaves NZCV alone
+     * turned into x86 that does not. */
+    bool     clobber;
+} X64;
+
+static void put(X64 *x, uint8_t b) {
+    if (x->len == x->cap) {
+        size_t cap = x->cap ? x->cap * 2 : 4096;
+        uint8_t *grown = realloc(x->buf, cap);
+        if (grown == NULL) { x->oom = true; x->len = 0; return; }
+        x->buf = grown;
+        x->cap = cap;
+    }
+    x->buf[x->len++] = b;
+}
+
+static void put32(X64 *x, uint32_t v) {
+    for (int i = 0; i < 4; i++) put(x, (uint8_t)(v >> (8 * i)));
+}
+
+static void put64(X64 *x, uint64_t v) {
+    for (int i = 0; i < 8; i++) put(x, (uint8_t)(v >> (8 * i)));
+}
+
+/* The r/m operand: a register, or [base + index*scale + disp]. index < 0 is
+ * no index; rsp can never be one, which the encoding reserves for "none". */
+typedef struct {
+    bool    mem;
+    int     reg;
+    int     index;
+    int     scale;
+    int32_t disp;
+} RM;
+
+static RM rmReg(int reg) {
+    RM r = { false, reg, -1, 1, 0 };
+    return r;
+}
+
+static RM rmMem(int base, int32_t disp) {
+    RM r = { true, base, -1, 1, disp };
+    return r;
+}
+
+static RM rmIdx(int base, int index, int scale, int32_t disp) {
+    RM r = { true, base, index, scale, disp };
+    return r;
+}
+
+/* One instruction: [prefix] [REX] opcode modrm [sib] [disp]. The mandatory
+ * 66/F2/F3 prefix goes before REX -- REX must immediately precede the opcode
+ * or the CPU ignores it. `byteRegs` forces a REX so register 4..7 in a byte
+ * operation means spl/bpl/sil/dil rather than ah/ch/dh/bh. */
+static void ins(X64 *x, uint8_t prefix, bool w, bool byteRegs,
+                const uint8_t *op, int oplen, int reg, RM rm) {
+    if (prefix != 0) put(x, prefix);
+    uint8_t rex = (uint8_t)(0x40 | (w ? 8 : 0) | ((reg & 8) ? 4 : 0) |
+                            (rm.mem && rm.index >= 8 ? 2 : 0) |
+                            ((rm.reg & 8) ? 1 : 0));
+    if (rex != 0x40 || (byteRegs && ((reg >= 4 && reg < 8) ||
+                                     (!rm.mem && rm.reg >= 4 && rm.reg < 8)))) {
+        put(x, rex);
+    }
+    for (int i = 0; i < oplen; i++) put(x, op[i]);
+    if (!rm.mem) {
+        put(x, (uint8_t)(0xc0 | ((reg & 7) << 3) | (rm.reg & 7)));
+        return;
+    }
+    /* rsp and r12 as a base need a SIB byte; rbp and r13 with mod 00 mean
+     * rip-relative/disp32-only, so a zero displacement still takes a disp8. */
+    bool sib = rm.index >= 0 || (rm.reg & 7) == 4;
+    int mod;
+    if (rm.disp == 0 && (rm.reg & 7) != 5) mod = 0;
+    else if (rm.disp >= -128 && rm.disp <= 127) mod = 1;
+    else mod = 2;
+    put(x, (uint8_t)((mod << 6) | ((reg & 7) << 3) | (sib ? 4 : (rm.reg & 7))));
+    if (sib) {
+        int ss = rm.scale == 8 ? 3 : rm.scale == 4 ? 2 : rm.scale == 2 ? 1 : 0;
+        int idx = rm.index >= 0 ? (rm.index & 7) : 4;
+        put(x, (uint8_t)((ss << 6) | (idx << 3) | (rm.reg & 7)));
+    }
+    if (mod == 1) put(x, (uint8_t)(int8_t)rm.disp);
+    else if (mod == 2) put32(x, (uint32_t)rm.disp);
+}
+
+static void op1(X64 *x, uint8_t prefix, bool w, uint8_t a, int reg, RM rm) {
+    ins(x, prefix, w, false, &a, 1, reg, rm);
+}
+
+static void op2(X64 *x, uint8_t prefix, bool w, uint8_t a, uint8_t b, int reg,
+                RM rm) {
+    const uint8_t op[2] = { a, b };
+    ins(x, prefix, w, false, op, 2, reg, rm);
+}
+
+static void movRR(X64 *x, int dst, int src) {
+    if (dst != src) op1(x, 0, true, 0x8b, dst, rmReg(src));
+}
+
+static void load(X64 *x, int dst, RM src) { op1(x, 0, true, 0x8b, dst, src); }
+static void store(X64 *x, RM dst, int src) { op1(x, 0, true, 0x89, src, dst); }
+static void lea(X64 *x, int dst, RM src) { op1(x, 0, true, 0x8d, dst, src); }
+
+/* mov reg, imm -- never `xor reg, reg`, which would write the flags. */
+static void movImm(X64 *x, int dst, int64_t v) {
+    if ((uint64_t)v <= 0xffffffffu) {
+        if (dst & 8) put(x, 0x41);
+        put(x, (uint8_t)(0xb8 + (dst & 7)));
+        put32(x, (uint32_t)v);
+    } else if (v >= INT32_MIN && v <= INT32_MAX) {
+        op1(x, 0, true, 0xc7, 0, rmReg(dst));
+        put32(x, (uint32_t)v);
+    } else {
+        put(x, (uint8_t)(0x48 | ((dst & 8) ? 1 : 0)));
+        put(x, (uint8_t)(0xb8 + (dst & 7)));
+        put64(x, (uint64_t)v);
+    }
+}
+
+/* The two-operand ALU forms, `op reg, r/m`: add 03, or 0b, and 23, sub 2b,
+ * xor 33, cmp 3b. */
+static void alu(X64 *x, uint8_t opc, int reg, RM rm) {
+    op1(x, 0, true, opc, reg, rm);
+    x->clobber = true;
+}
+
+/* The group-1 immediate forms, `op r/m, imm`: /0 add, /1 or, /4 and, /5 sub,
+ * /7 cmp. */
+static void aluImm(X64 *x, int ext, RM rm, int32_t imm) {
+    if (imm >= -128 && imm <= 127) {
+        op1(x, 0, true, 0x83, ext, rm);
+        put(x, (uint8_t)(int8_t)imm);
+    } else {
+        op1(x, 0, true, 0x81, ext, rm);
+        put32(x, (uint32_t)imm);
+    }
+    x->clobber = true;
+}
+
+/* Group-2 shifts: /4 shl, /5 shr, /7 sar -- by an immediate, or by cl. */
+static void shiftImm(X64 *x, int ext, RM rm, unsigned n) {
+    op1(x, 0, true, 0xc1, ext, rm);
+    put(x, (uint8_t)n);
+    x->clobber = true;
+}
+
+static void shiftCl(X64 *x, int ext, RM rm) {
+    op1(x, 0, true, 0xd3, ext, rm);
+    x->clobber = true;
+}
+
+/* Group-3: /3 neg, /5 one-operand imul (rdx:rax = rax * r/m), /7 idiv. */
+static void group3(X64 *x, int ext, RM rm) {
+    op1(x, 0, true, 0xf7, ext, rm);
+    x->clobber = true;
+}
+
+static void imul(X64 *x, int reg, RM rm) {
+    op2(x, 0, true, 0x0f, 0xaf, reg, rm);
+    x->clobber = true;
+}
+
+static void cmov(X64 *x, int cc, int reg, RM rm) {
+    op2(x, 0, true, 0x0f, (uint8_t)(0x40 + cc), reg, rm);
+}
+
+/* SSE2 scalar double: F2 0F 58 add, 59 mul, 5C sub, 5E div, 51 sqrt, 10/11
+ * movsd load/store. 66 0F 28 movapd, 2E ucomisd, 57 xorpd. */
+static void sse(X64 *x, uint8_t prefix, uint8_t opc, int reg, RM rm) {
+    op2(x, prefix, false, 0x0f, opc, reg, rm);
+    if (opc == 0x2e) x->clobber = true;
+}
+
+static void movapd(X64 *x, int dst, int src) {
+    if (dst != src) sse(x, 0x66, 0x28, dst, rmReg(src));
+}
+
+static void cqo(X64 *x) { put(x, 0x48); put(x, 0x99); }
+static void ret(X64 *x) { put(x, 0xc3); }
+
+static void pushReg(X64 *x, int r) {
+    if (r & 8) put(x, 0x41);
+    put(x, (uint8_t)(0x50 + (r & 7)));
+}
+
+static void popReg(X64 *x, int r) {
+    if (r & 8) put(x, 0x41);
+    put(x, (uint8_t)(0x58 + (r & 7)));
+}
+
+/* Short forward jumps inside one lowered instruction: emit, then patch the
+ * rel8 once the landing point is known. Every such sequence is a few dozen
+ * bytes, well inside the range. */
+static size_t jccShort(X64 *x, int cc) {
+    put(x, (uint8_t)(0x70 + cc));
+    put(x, 0);
+    return x->len - 1;
+}
+
+static size_t jmpShort(X64 *x) {
+    put(x, 0xeb);
+    put(x, 0);
+    return x->len - 1;
+}
+
+static void landShort(X64 *x, size_t at) {
+    if (x->oom) return;
+    x->buf[at] = (uint8_t)(int8_t)(x->len - (at + 1));
+}
+
+/* ------------------------------------------------------------------ */
+/* Decoded arm64                                                        */
+/* ------------------------------------------------------------------ */
+
+typedef enum {
+    A_BAD, A_NOP, A_DATA,
+    A_LDRX, A_STRX, A_LDRW, A_STRW, A_LDRB, A_STRB, A_LDRD, A_STRD,
+    A_LDP, A_STP, A_LDRLIT,
+    A_ADDI, A_SUBI, A_ADDSI, A_SUBSI,
+    A_ADD, A_ADDS, A_SUB, A_SUBS,     /* shifted register */
+    A_ADDX, A_SUBSX,                  /* extended register, uxtw */
+    A_AND, A_ORR, A_EOR, A_ANDI,
+    A_LSL, A_LSR, A_ASR, A_LSLV, A_LSRV, A_ASRV,
+    A_MADD, A_MSUB, A_SMULH, A_SDIV,
+    A_MOVZ, A_MOVN, A_MOVK,
+    A_CSEL, A_CSINC,
+    A_B, A_BCOND, A_BL, A_BLR, A_RET, A_TBZ, A_TBNZ,
+    A_FADD, A_FSUB, A_FMUL, A_FDIV, A_FNEG, A_FSQRT, A_FMOVDD,
+    A_FCMP, A_FCMPZ, A_FMOVDX, A_FMOVXD, A_FMOVDI, A_SCVTF, A_FCVTZS
+} A64Op;
+
+typedef struct {
+    uint8_t op;
+    uint8_t rd, rn, rm, ra;
+    uint8_t cond;
+    uint8_t shiftType;   /* 0 lsl, 1 lsr, 2 asr */
+    uint8_t amount;      /* shift amount, tested bit, or uxtw scale */
+    uint8_t mode;        /* ldp/stp: 1 post, 2 offset, 3 pre */
+    int64_t imm;         /* immediate, byte offset, or branch target index */
+} A64;
+
+static int64_t sext(uint32_t v, unsigned bits) {
+    uint64_t m = 1ull << (bits - 1);
+    return (int64_t)((v ^ m) - m);
+}
+
+/* VFPExpandImm for a double: sign, NOT(b) then b replicated, cd, efgh. */
+static uint64_t fpImm8Bits(unsigned imm8) {
+    uint64_t s = (imm8 >> 7) & 1u, b = (imm8 >> 6) & 1u;
+    uint64_t cd = (imm8 >> 4) & 3u, efgh = imm8 & 15u;
+    uint64_t exp = ((b ? 0u : 1u) << 10) | ((b ? 0xffu : 0u) << 2) | cd;
+    return (s << 63) | (exp << 52) | (efgh << 48);
+}
+
+static A64 decode(uint32_t w, unsigned at) {
+    A64 a;
+    memset(&a, 0, sizeof a);
+    a.op = A_BAD;
+    a.rd = (uint8_t)(w & 31u);
+    a.rn = (uint8_t)((w >> 5) & 31u);
+    a.rm = (uint8_t)((w >> 16) & 31u);
+    a.ra = (uint8_t)((w >> 10) & 31u);
+    unsigned imm12 = (w >> 10) & 0xfffu;
+
+    if (w == 0xd503201fu) { a.op = A_NOP; return a; }
+
+    switch (w & 0xffc00000u) {
+    case 0xf9400000u: a.op = A_LDRX; a.imm = imm12 * 8; return a;
+    case 0xf9000000u: a.op = A_STRX; a.imm = imm12 * 8; return a;
+    case 0xb9400000u: a.op = A_LDRW; a.imm = imm12 * 4; return a;
+    case 0xb9000000u: a.op = A_STRW; a.imm = imm12 * 4; return a;
+    case 0x39400000u: a.op = A_LDRB; a.imm = imm12;     return a;
+    case 0x39000000u: a.op = A_STRB; a.imm = imm12;     return a;
+    case 0xfd400000u: a.op = A_LDRD; a.imm = imm12 * 8; return a;
+    case 0xfd000000u: a.op = A_STRD; a.imm = imm12 * 8; return a;
+    default: break;
+    }
+
+    /* ldp/stp, 64-bit: opc 10, 101, V 0, then the index mode and L. */
+    if ((w & 0xfe000000u) == 0xa8000000u && ((w >> 23) & 3u) != 0) {
+        a.op = ((w >> 22) & 1u) ? A_LDP : A_STP;
+        a.mode = (uint8_t)((w >> 23) & 3u);
+        a.ra = (uint8_t)((w >> 10) & 31u);          /* Rt2 */
+        a.imm = sext((w >> 15) & 0x7fu, 7) * 8;
+        return a;
+    }
+    if ((w & 0xff000000u) == 0x58000000u) {
+        a.op = A_LDRLIT;
+        a.imm = (int64_t)at + sext((w >> 5) & 0x7ffffu, 19);
+        return a;
+    }
+
+    switch (w & 0xff800000u) {
+    case 0x91000000u: a.op = A_ADDI;  break;
+    case 0xd1000000u: a.op = A_SUBI;  break;
+    case 0xb1000000u: a.op = A_ADDSI; break;
+    case 0xf1000000u: a.op = A_SUBSI; break;
+    case 0xd2800000u: a.op = A_MOVZ;  break;
+    case 0x92800000u: a.op = A_MOVN;  break;
+    case 0xf2800000u: a.op = A_MOVK;  break;
+    case 0x92000000u: {
+        /* and Xd, Xn, #imm: only the low-run-of-ones pattern jaiA64AndXOnes
+         * builds -- N 1, immr 0. */
+        unsigned n = (w >> 22) & 1u, immr = (w >> 16) & 63u, imms = (w >> 10) & 63u;
+        if (n != 1u || immr != 0u || imms == 63u) return a;
+        a.op = A_ANDI;
+        a.amount = (uint8_t)(imms + 1u);
+        return a;
+    }
+    default: break;
+    }
+    if (a.op == A_ADDI || a.op == A_SUBI || a.op == A_ADDSI || a.op == A_SUBSI) {
+        a.imm = (int64_t)imm12 << (((w >> 22) & 1u) ? 12 : 0);
+        return a;
+    }
+    if (a.op == A_MOVZ || a.op == A_MOVN || a.op == A_MOVK) {
+        a.amount = (uint8_t)(((w >> 21) & 3u) * 16u);
+        a.imm = (int64_t)((w >> 5) & 0xffffu);
+        return a;
+    }
+
+    switch (w & 0xff200000u) {
+    case 0x8b000000u: a.op = A_ADD;  break;
+    case 0xab000000u: a.op = A_ADDS; break;
+    case 0xcb000000u: a.op = A_SUB;  break;
+    case 0xeb000000u: a.op = A_SUBS; break;
+    case 0x8a000000u: a.op = A_AND;  break;
+    case 0xaa000000u: a.op = A_ORR;  break;
+    case 0xca000000u: a.op = A_EOR;  break;
+    default: break;
+    }
+    if (a.op != A_BAD) {
+        a.shiftType = (uint8_t)((w >> 22) & 3u);
+        a.amount = (uint8_t)((w >> 10) & 63u);
+        if (a.shiftType == 3u) a.op = A_BAD;           /* ror: logical only */
+        if ((a.op == A_AND || a.op == A_ORR || a.op == A_EOR) &&
+            (a.shiftType != 0u || a.amount != 0u)) {
+            a.op = A_BAD;
+        }
+        return a;
+    }
+
+    switch (w & 0xffe00000u) {
+    case 0x8b200000u: a.op = A_ADDX;  break;
+    case 0xeb200000u: a.op = A_SUBSX; break;
+    default: break;
+    }
+    if (a.op != A_BAD) {
+        unsigned option = (w >> 13) & 7u, imm3 = (w >> 10) & 7u;
+        if (option != 2u || imm3 > 3u) { a.op = A_BAD; return a; }
+        a.amount = (uint8_t)imm3;
+        return a;
+    }
+
+    if ((w & 0xffc00000u) == 0xd3400000u || (w & 0xffc00000u) == 0x93400000u) {
+        bool sign = (w & 0xffc00000u) == 0x93400000u;
+        unsigned immr = (w >> 16) & 63u, imms = (w >> 10) & 63u;
+        if (imms == 63u) {
+            a.op = sign ? A_ASR : A_LSR;
+            a.amount = (uint8_t)immr;
+        } else if (!sign && imms + 1u == immr) {
+            a.op = A_LSL;
+            a.amount = (uint8_t)(63u - imms);
+        }
+        return a;
+    }
+
+    switch (w & 0xffe0fc00u) {
+    case 0x9ac00c00u: a.op = A_SDIV; return a;
+    case 0x9ac02000u: a.op = A_LSLV; return a;
+    case 0x9ac02400u: a.op = A_LSRV; return a;
+    case 0x9ac02800u: a.op = A_ASRV; return a;
+    case 0x1e600800u: a.op = A_FMUL; return a;
+    case 0x1e601800u: a.op = A_FDIV; return a;
+    case 0x1e602800u: a.op = A_FADD; return a;
+    case 0x1e603800u: a.op = A_FSUB; return a;
+    default: break;
+    }
+    switch (w & 0xffe08000u) {
+    case 0x9b000000u: a.op = A_MADD; return a;
+    case 0x9b008000u: a.op = A_MSUB; return a;
+    case 0x9b400000u:
+        if (a.ra == 31u) a.op = A_SMULH;
+        return a;
+    default: break;
+    }
+    switch (w & 0xfffffc00u) {
+    case 0x1e604000u: a.op = A_FMOVDD; return a;
+    case 0x1e614000u: a.op = A_FNEG;   return a;
+    case 0x1e61c000u: a.op = A_FSQRT;  return a;
+    case 0x9e670000u: a.op = A_FMOVDX; return a;
+    case 0x9e660000u: a.op = A_FMOVXD; return a;
+    case 0x9e620000u: a.op = A_SCVTF;  return a;
+    case 0x9e780000u: a.op = A_FCVTZS; return a;
+    default: break;
+    }
+    if ((w & 0xffe0fc1fu) == 0x1e602000u) { a.op = A_FCMP; return a; }
+    if ((w & 0xfffffc1fu) == 0x1e602008u) { a.op = A_FCMPZ; return a; }
+    if ((w & 0xffe01fe0u) == 0x1e601000u) {
+        a.op = A_FMOVDI;
+        a.imm = (int64_t)fpImm8Bits((w >> 13) & 0xffu);
+        return a;
+    }
+
+    switch (w & 0xffe00c00u) {
+    case 0x9a800000u: a.op = A_CSEL;  a.cond = (uint8_t)((w >> 12) & 15u); return a;
+    case 0x9a800400u: a.op = A_CSINC; a.cond = (uint8_t)((w >> 12) & 15u); return a;
+    default: break;
+    }
+
+    switch (w & 0xfc000000u) {
+    case 0x14000000u: a.op = A_B;  a.imm = (int64_t)at + sext(w & 0x3ffffffu, 26); return a;
+    case 0x94000000u: a.op = A_BL; a.imm = (int64_t)at + sext(w & 0x3ffffffu, 26); return a;
+    default: break;
+    }
+    if ((w & 0xff000010u) == 0x54000000u) {
+        a.op = A_BCOND;
+        a.cond = (uint8_t)(w & 15u);
+        a.imm = (int64_t)at + sext((w >> 5) & 0x7ffffu, 19);
+        return a;
+    }
+    if ((w & 0x7e000000u) == 0x36000000u) {
+        a.op = ((w >> 24) & 1u) ? A_TBNZ : A_TBZ;
+        a.amount = (uint8_t)(((w >> 31) << 5) | ((w >> 19) & 31u));
+        a.imm = (int64_t)at + sext((w >> 5) & 0x3fffu, 14);
+        return a;
+    }
+    if ((w & 0xfffffc1fu) == 0xd63f0000u) { a.op = A_BLR; return a; }
+    if (w == 0xd65f03c0u) { a.op = A_RET; return a; }
+    return a;
+}
+
+static bool isBranch(uint8_t op) {
+    return op == A_B || op == A_BCOND || op == A_BL || op == A_TBZ ||
+           op == A_TBNZ;
+}
+
+/* Whether control can reach the next word. */
+static bool fallsThrough(uint8_t op) {
+    return op != A_B && op != A_RET && op != A_DATA && op != A_BAD;
+}
+
+/* NZCV, as this vocabulary touches it. The x86 flags after `sub`/`cmp` carry
+ * the same N, Z and V; C is the inverse (borrow rather than not-borrow). After
+ * `add` the carry is not inverted. After `ucomisd` the flags are a different
+ * shape altogether, so every reader has to know which writer reached it. */
+enum { FK_SUB = 1, FK_ADD = 2, FK_FP = 4 };
+
+static int flagKind(uint8_t op) {
+    switch (op) {
+    case A_SUBSI: case A_SUBS: case A_SUBSX: return FK_SUB;
+    case A_ADDSI: case A_ADDS:               return FK_ADD;
+    case A_FCMP:  case A_FCMPZ:              return FK_FP;
+    default:                                 return 0;
+    }
+}
+
+static bool readsFlags(const A64 *a) {
+    return (a->op == A_BCOND || a->op == A_CSEL || a->op == A_CSINC) &&
+           a->cond < 14u;
+}
+
+/* Calls end any flag value: the callee is free to clobber NZCV, so arm64 code
+ * cannot be relying on it afterwards either. */
+static bool killsFlags(uint8_t op) {
+    return op == A_BL || op == A_BLR;
+}
+
+/* ------------------------------------------------------------------ */
+/* Conditions                                                           */
+/* ------------------------------------------------------------------ */
+
+/* Most arm64 conditions are one x86 condition. Four after a float compare are
+ * two: x86 reports unordered through PF, arm64 through C and V together, so
+ * "equal" is E-and-not-P and "not equal" is NE-or-P. */
+typedef enum { CD_NONE, CD_ALWAYS, CD_SIMPLE, CD_AND_NP, CD_OR_P } CondMode;
+
+typedef struct {
+    uint8_t mode;
+    uint8_t cc;
+} Cond;
+
+static Cond condFor(unsigned cond, int kind) {
+    Cond c = { CD_NONE, 0 };
+    if (cond >= 14u) { c.mode = CD_ALWAYS; return c; }
+    if (kind == FK_FP) {
+        static const uint8_t mode[14] = {
+            CD_AND_NP, CD_OR_P, CD_OR_P, CD_AND_NP, CD_AND_NP, CD_OR_P,
+            CD_SIMPLE, CD_SIMPLE, CD_OR_P, CD_AND_NP, CD_SIMPLE, CD_SIMPLE,
+            CD_SIMPLE, CD_SIMPLE };
+        static const uint8_t cc[14] = {
+            CC_E, CC_NE, CC_AE, CC_B, CC_B, CC_AE, CC_P, CC_NP,
+            CC_A, CC_BE, CC_AE, CC_B, CC_A, CC_BE };
+        c.mode = mode[cond];
+        c.cc = cc[cond];
+        return c;
+    }
+    static const uint8_t cc[14] = {
+        CC_E, CC_NE, CC_AE, CC_B, CC_S, CC_NS, CC_O, CC_NO,
+        CC_A, CC_BE, CC_GE, CC_L, CC_G, CC_LE };
+    c.mode = CD_SIMPLE;
+    c.cc = cc[cond];
+    if (kind == FK_ADD) {
+        if (cond == 2u) c.cc = CC_B;
+        else if (cond == 3u) c.cc = CC_AE;
+        else if (cond == 8u || cond == 9u) c.mode = CD_NONE;
+    }
+    return c;
+}
+
+/* The condition for a reader reached by the writers in `kinds`. Two writer
+ * shapes reaching one reader are fine when they agree on the reading (EQ is
+ * ZF whoever set it); otherwise there is no single x86 test, and the body
+ * declines. */
+static Cond condForKinds(unsigned cond, int kinds) {
+    Cond none = { CD_NONE, 0 };
+    /* No writer reaches: NZCV is as undefined on arm64, so any reading is as
+     * faithful as another. */
+    if (cond >= 14u || kinds == 0) return condFor(cond, FK_SUB);
+    Cond out = none;
+    bool first = true;
+    for (int k = FK_SUB; k <= FK_FP; k <<= 1) {
+        if (!(kinds & k)) continue;
+        Cond c = condFor(cond, k);
+        if (c.mode == CD_NONE) return none;
+        if (!first && (c.mode != out.mode || c.cc != out.cc)) return none;
+        out = c;
+        first = false;
+    }
+    return out;
+}
+
+/* ------------------------------------------------------------------ */
+/* Register plan                                                        */
+/* ------------------------------------------------------------------ */
+
+/* The register file, r15-relative. 16-aligned: xorpd's memory operand must
+ * be. */
+#define FILE_X      0     /* x0..x30 */
+#define FILE_D     256    /* d15..d31 */
+#define FILE_XMM   392    /* xmm8..xmm14 across a blr */
+#define FILE_ZERO  448    /* 0.0, for fcmp #0.0 */
+#define FILE_SIGN  464    /* the sign bit, 16 bytes for xorpd */
+#define FILE_TMP   480
+/* 8 mod 16, so that after the six pushes the file itself lands 16-aligned. */
+#define FILE_BYTES 488
+
+static const int8_t kHome[32] = {
+    RDI, RSI, -1, -1, -1, -1, -1, -1,   /* x0..x7 */
+    -1,  R8,  R9, R10, -1, -1, -1, -1,  /* x8..x15 */
+    -1,  -1,  -1, RBX, RBP, R12, R13, R14, /* x16..x23 */
+    -1,  -1,  -1, -1, -1, -1, -1, -1    /* x24..x31 */
+};
+
+#define FIRST_MEM_D 15u
+
+enum { L_REG, L_MEM, L_ZERO };
+
+typedef struct {
+    int     kind;
+    int     reg;
+    int32_t disp;
+} Loc;
+
+typedef struct {
+    unsigned at;        /* byte offset of the rel32 */
+    unsigned target;    /* word index it lands on */
+} Fixup;
+
+typedef struct {
+    X64 x;
+    const uint32_t *words;
+    unsigned count;
+    A64 *ins;
+    bool *target;       /* some branch lands here */
+    bool *live;         /* flags live out of this word */
+    uint8_t *kindIn;    /* which flag writers can reach this word */
+    size_t *map;        /* word index -> byte offset */
+    Fixup *fix;
+    unsigned nfix, capFix;
+    /* Extra displacement on every sp-relative access: 8 while a pushfq holds
+     * the flags on top of the arm64 frame. */
+    int32_t spBias;
+    /* d registers the body names, so a call spills only the xmm8..14 that
+     * hold something (d8..d15 are callee-saved on arm64, nothing is on
+     * SysV). */
+    uint32_t fpUsed;
+    const char *why;
+} Lower;
+
+static Loc xloc(unsigned n, bool sp) {
+    Loc l = { L_MEM, -1, (int32_t)(FILE_X + 8 * n) };
+    if (n == 31u) {
+        l.kind = sp ? L_REG : L_ZERO;
+        l.reg = RSP;
+        return l;
+    }
+    if (kHome[n] >= 0) { l.kind = L_REG; l.reg = kHome[n]; }
+    return l;
+}
+
+static Loc dloc(unsigned d) {
+    Loc l = { L_REG, (int)d, 0 };
+    if (d >= FIRST_MEM_D) {
+        l.kind = L_MEM;
+        l.disp = (int32_t)(FILE_D + 8 * (d - FIRST_MEM_D));
+    }
+    return l;
+}
+
+static RM fileAt(int32_t disp) { return rmMem(R15, disp); }
+
+static RM rmOf(Loc l) {
+    return l.kind == L_MEM ? fileAt(l.disp) : rmReg(l.reg);
+}
+
+/* Value of `l` into `reg`. */
+static void ld(Lower *L, int reg, Loc l) {
+    if (l.kind == L_ZERO) movImm(&L->x, reg, 0);
+    else if (l.kind == L_MEM) load(&L->x, reg, fileAt(l.disp));
+    else movRR(&L->x, reg, l.reg);
+}
+
+/* `reg` into `l`; a write to xzr goes nowhere. */
+static void st(Lower *L, Loc l, int reg) {
+    if (l.kind == L_MEM) store(&L->x, fileAt(l.disp), reg);
+    else if (l.kind == L_REG) movRR(&L->x, l.reg, reg);
+}
+
+/* `l` as a source operand; xzr has no register, so it is materialised. */
+static RM src(Lower *L, Loc l, int scratch) {
+    if (l.kind == L_ZERO) {
+        movImm(&L->x, scratch, 0);
+        return rmReg(scratch);
+    }
+    return rmOf(l);
+}
+
+/* Where a result is computed: the destination's own register when that is
+ * safe, rax otherwise. `avoid` is a source register the computation reads
+ * after writing the destination. */
+static int workReg(Loc d, Loc avoid) {
+    if (d.kind == L_REG && d.reg != RSP &&
+        !(avoid.kind == L_REG && avoid.reg == d.reg)) {
+        return d.reg;
+    }
+    return RAX;
+}
+
+/* [Xn + offset] for a load or store. A base with no register of its own goes
+ * through r11. */
+static RM memAt(Lower *L, unsigned rn, int64_t offset) {
+    if (rn == 31u) return rmMem(RSP, (int32_t)(offset + L->spBias));
+    Loc b = xloc(rn, false);
+    if (b.kind == L_REG) return rmMem(b.reg, (int32_t)offset);
+    load(&L->x, R11, fileAt(b.disp));
+    return rmMem(R11, (int32_t)offset);
+}
+
+/* Xn += delta, without touching the flags. */
+static void bump(Lower *L, unsigned rn, int64_t delta) {
+    if (delta == 0) return;
+    Loc b = xloc(rn, true);
+    if (b.kind == L_REG) {
+        lea(&L->x, b.reg, rmMem(b.reg, (int32_t)delta));
+        return;
+    }
+    load(&L->x, RAX, fileAt(b.disp));
+    lea(&L->x, RAX, rmMem(RAX, (int32_t)delta));
+    store(&L->x, fileAt(b.disp), RAX);
+}
+
+static bool addFixup(Lower *L, unsigned at, unsigned target) {
+    if (L->nfix == L->capFix) {
+        unsigned cap = L->capFix ? L->capFix * 2 : 256;
+        Fixup *grown = realloc(L->fix, cap * sizeof *grown);
+        if (grown == NULL) { L->why = "out of memory"; return false; }
+        L->fix = grown;
+        L->capFix = cap;
+    }
+    L->fix[L->nfix].at = at;
+    L->fix[L->nfix].target = target;
+    L->nfix++;
+    return true;
+}
+
+/* jmp/call/jcc rel32 to a word. */
+static bool farTo(Lower *L, int opcode, unsigned target) {
+    X64 *x = &L->x;
+    if (opcode >= 0x80 && opcode < 0x90) { put(x, 0x0f); put(x, (uint8_t)opcode); }
+    else put(x, (uint8_t)opcode);
+    put32(x, 0);
+    return addFixup(L, (unsigned)(x->len - 4), target);
+}
+
+static bool condFar(Lower *L, Cond c, unsigned target) {
+    X64 *x = &L->x;
+    switch (c.mode) {
+    case CD_ALWAYS:
+        return farTo(L, 0xe9, target);
+    case CD_SIMPLE:
+        return farTo(L, 0x80 + c.cc, target);
+    case CD_AND_NP:
+        put(x, 0x70 + CC_P);
+        put(x, 6);                        /* over the jcc rel32 */
+        return farTo(L, 0x80 + c.cc, target);
+    case CD_OR_P:
+        return farTo(L, 0x80 + CC_P, target) && farTo(L, 0x80 + c.cc, target);
+    default:
+        L->why = "a condition with no x86 test";
+        return false;
+    }
+}
+
+/* A short jump taken when `c` holds. Returns how many rel8s there are to land
+ * (two for the OR form). */
+static int condShort(Lower *L, Cond c, size_t at[2]) {
+    X64 *x = &L->x;
+    switch (c.mode) {
+    case CD_ALWAYS:
+        at[0] = jmpShort(x);
+        return 1;
+    case CD_SIMPLE:
+        at[0] = jccShort(x, c.cc);
+        return 1;
+    case CD_AND_NP: {
+        size_t skip = jccShort(x, CC_P);
+        at[0] = jccShort(x, c.cc);
+        landShort(x, skip);
+        return 1;
+    }
+    case CD_OR_P:
+        at[0] = jccShort(x, CC_P);
+        at[1] = jccShort(x, c.cc);
+        return 2;
+    default:
+        return 0;
+    }
+}
+
+static Cond readerCond(Lower *L, unsigned i, unsigned cond) {
+    Cond c = condForKinds(cond, L->kindIn[i]);
+    if (c.mode == CD_NONE) L->why = "flags whose reading depends on the writer";
+    return c;
+}
+
+/* ------------------------------------------------------------------ */
+/* Lowering, one arm64 instruction at a time                            */
+/* ------------------------------------------------------------------ */
+
+static void lowerConst(Lower *L, Loc d, int64_t v) {
+    if (d.kind == L_ZERO) return;
+    if (d.kind == L_REG) { movImm(&L->x, d.reg, v); return; }
+    if (v >= INT32_MIN && v <= INT32_MAX) {
+        op1(&L->x, 0, true, 0xc7, 0, fileAt(d.disp));
+        put32(&L->x, (uint32_t)v);
+        return;
+    }
+    movImm(&L->x, RAX, v);
+    store(&L->x, fileAt(d.disp), RAX);
+}
+
+/* movz/movn then its movk's is how emitConst64 spells a constant; lowered as
+ * one mov. A word some branch lands on ends the run, so the fold never hides
+ * a label. Returns how many words it consumed. */
+static unsigned lowerMov(Lower *L, unsigned i) {
+    const A64 *a = &L->ins[i];
+    uint64_t v = (uint64_t)a->imm << a->amount;
+    if (a->op == A_MOVN) v = ~v;
+    unsigned used = 1;
+    while (i + used < L->count && !L->target[i + used]) {
+        const A64 *k = &L->ins[i + used];
+        if (k->op != A_MOVK || k->rd != a->rd) break;
+        v = (v & ~(0xffffull << k->amount)) | ((uint64_t)k->imm << k->amount);
+        used++;
+    }
+    lowerConst(L, xloc(a->rd, false), (int64_t)v);
+    return used;
+}
+
+/* movk alone: replace 16 bits in place through memory, which writes no flags
+ * (and/or would). */
+static void lowerMovk(Lower *L, const A64 *a) {
+    Loc d = xloc(a->rd, false);
+    if (d.kind == L_ZERO) return;
+    int32_t at = d.kind == L_MEM ? d.disp : FILE_TMP;
+    if (d.kind == L_REG) store(&L->x, fileAt(FILE_TMP), d.reg);
+    op1(&L->x, 0x66, false, 0xc7, 0, fileAt(at + a->amount / 8));
+    put(&L->x, (uint8_t)a->imm);
+    put(&L->x, (uint8_t)(a->imm >> 8));
+    if (d.kind == L_REG) load(&L->x, d.reg, fileAt(FILE_TMP));
+}
+
+static void lowerLoadStore(Lower *L, const A64 *a) {
+    X64 *x = &L->x;
+    RM m = memAt(L, a->rn, a->imm);
+    if (a->op == A_LDRD || a->op == A_STRD) {
+        Loc d = dloc(a->rd);
+        if (a->op == A_LDRD) {
+            int r = d.kind == L_REG ? d.reg : XMM_SCRATCH;
+            sse(x, 0xf2, 0x10, r, m);
+            if (d.kind == L_MEM) sse(x, 0xf2, 0x11, r, fileAt(d.disp));
+        } else {
+            int r = d.reg;
+            if (d.kind == L_MEM) {
+                r = XMM_SCRATCH;
+                sse(x, 0xf2, 0x10, r, fileAt(d.disp));
+            }
+            sse(x, 0xf2, 0x11, r, m);
+        }
+        return;
+    }
+    Loc t = xloc(a->rd, false);
+    switch (a->op) {
+    case A_LDRX:
+    case A_LDRW:
+    case A_LDRB: {
+        if (t.kind == L_ZERO) return;
+        int r = t.kind == L_REG ? t.reg : RAX;
+        if (a->op == A_LDRX) load(x, r, m);
+        else if (a->op == A_LDRW) op1(x, 0, false, 0x8b, r, m);
+        else op2(x, 0, false, 0x0f, 0xb6, r, m);
+        if (t.kind == L_MEM) store(x, fileAt(t.disp), r);
+        return;
+    }
+    default:
+        break;
+    }
+    /* Stores. */
+    if (t.kind == L_ZERO) {
+        if (a->op == A_STRB) { op1(x, 0, false, 0xc6, 0, m); put(x, 0); return; }
+        op1(x, 0, a->op == A_STRX, 0xc7, 0, m);
+        put32(x, 0);
+        return;
+    }
+    int r = t.reg;
+    if (t.kind == L_MEM) { r = RAX; load(x, RAX, fileAt(t.disp)); }
+    if (a->op == A_STRX) store(x, m, r);
+    else if (a->op == A_STRW) op1(x, 0, false, 0x89, r, m);
+    else { const uint8_t op = 0x88; ins(x, 0, false, true, &op, 1, r, m); }
+}
+
+/* ldp/stp of two X registers. Pre-index moves the base first and post-index
+ * after, so the pair is only ever written above the stack pointer: a signal
+ * landing between the two steps must not find live data below rsp. */
+static void lowerPair(Lower *L, const A64 *a) {
+    X64 *x = &L->x;
+    int64_t off = a->mode == 2 ? a->imm : 0;
+    if (a->mode == 3) bump(L, a->rn, a->imm);
+    unsigned first = a->rd, second = a->ra;
+    int64_t firstOff = off, secondOff = off + 8;
+    /* Loading into the base register itself: load the other one first. */
+    if (a->op == A_LDP && first == a->rn && a->rn != 31u) {
+        first = a->ra; second = a->rd;
+        firstOff = off + 8; secondOff = off;
+    }
+    unsigned regs[2] = { first, second };
+    int64_t offs[2] = { firstOff, secondOff };
+    for (int k = 0; k < 2; k++) {
+        RM m = memAt(L, a->rn, offs[k]);
+        Loc t = xloc(regs[k], false);
+        if (a->op == A_LDP) {
+            if (t.kind == L_ZERO) continue;
+            int r = t.kind == L_REG ? t.reg : RAX;
+            load(x, r, m);
+            if (t.kind == L_MEM) store(x, fileAt(t.disp), r);
+        } else if (t.kind == L_ZERO) {
+            op1(x, 0, true, 0xc7, 0, m);
+            put32(x, 0);
+        } else {
+            int r = t.reg;
+            if (t.kind == L_MEM) { r = RAX; load(x, RAX, fileAt(t.disp)); }
+            store(x, m, r);
+        }
+    }
+    if (a->mode == 1) bump(L, a->rn, a->imm);
+}
+
+/* add/sub immediate without flags: a lea, with sp allowed on both sides. */
+static void lowerAddImm(Lower *L, const A64 *a) {
+    Loc d = xloc(a->rd, true), n = xloc(a->rn, true);
+    int64_t delta = a->op == A_SUBI ? -a->imm : a->imm;
+    int base = n.reg;
+    if (a->rn == 31u) delta += L->spBias;
+    if (n.kind == L_MEM) { base = RAX; load(&L->x, RAX, fileAt(n.disp)); }
+    if (d.kind == L_REG) {
+        if (delta == 0) movRR(&L->x, d.reg, base);
+        else lea(&L->x, d.reg, rmMem(base, (int32_t)delta));
+        return;
+    }
+    lea(&L->x, RAX, rmMem(base, (int32_t)delta));
+    st(L, d, RAX);
+}
+
+/* adds/subs immediate: Xd is xzr, not sp; Xn may be sp. */
+static void lowerAddsImm(Lower *L, const A64 *a) {
+    Loc d = xloc(a->rd, false), n = xloc(a->rn, true);
+    int ext = a->op == A_SUBSI ? 5 : 0;
+    if (d.kind == L_ZERO && a->op == A_SUBSI) {
+        aluImm(&L->x, 7, rmOf(n), (int32_t)a->imm);
+        return;
+    }
+    int t = workReg(d, n);
+    ld(L, t, n);
+    aluImm(&L->x, ext, rmReg(t), (int32_t)a->imm);
+    st(L, d, t);
+}
+
+static void shiftBy(Lower *L, int reg, unsigned type, unsigned amount) {
+    if (amount == 0) return;
+    static const int ext[3] = { 4, 5, 7 };
+    shiftImm(&L->x, ext[type], rmReg(reg), amount);
+}
+
+/* The shifted-register add/sub family. xzr, never sp, in every position. */
+static void lowerAddSub(Lower *L, const A64 *a) {
+    X64 *x = &L->x;
+    Loc d = xloc(a->rd, false), n = xloc(a->rn, false), m = xloc(a->rm, false);
+    bool sub = a->op == A_SUB || a->op == A_SUBS;
+    bool flags = a->op == A_ADDS || a->op == A_SUBS;
+
+    /* A plain add of a register scaled by up to 8 is one lea. */
+    if (a->op == A_ADD && a->shiftType == 0u && a->amount <= 3u &&
+        n.kind != L_ZERO && m.kind != L_ZERO) {
+        int b = n.kind == L_REG ? n.reg : RAX;
+        int i = m.kind == L_REG ? m.reg : RCX;
+        if (n.kind == L_MEM) load(x, RAX, fileAt(n.disp));
+        if (m.kind == L_MEM) load(x, RCX, fileAt(m.disp));
+        int r = d.kind == L_REG ? d.reg : RAX;
+        if (d.kind == L_ZERO) return;
+        lea(x, r, rmIdx(b, i, 1 << a->amount, 0));
+        st(L, d, r);
+        return;
+    }
+
+    Loc rhs = m;
+    if (a->amount != 0u || m.kind == L_ZERO) {
+        ld(L, RCX, m);
+        shiftBy(L, RCX, a->shiftType, a->amount);
+        rhs.kind = L_REG;
+        rhs.reg = RCX;
+    }
+    if (flags && sub && d.kind == L_ZERO) {
+        int lhs = n.kind == L_REG ? n.reg : RAX;
+        if (n.kind != L_REG) ld(L, RAX, n);
+        alu(x, 0x3b, lhs, rmOf(rhs));
+        return;
+    }
+    int t = workReg(d, rhs);
+    ld(L, t, n);
+    alu(x, sub ? 0x2b : 0x03, t, rmOf(rhs));
+    st(L, d, t);
+}
+
+/* add/subs with the second operand's low 32 bits zero-extended. Xn (and Xd,
+ * for the add) may be sp. */
+static void lowerExtended(Lower *L, const A64 *a) {
+    X64 *x = &L->x;
+    Loc m = xloc(a->rm, false);
+    if (m.kind == L_ZERO) movImm(x, RCX, 0);
+    else op1(x, 0, false, 0x8b, RCX, rmOf(m));   /* mov ecx, r/m32 */
+    if (a->op == A_ADDX) {
+        Loc d = xloc(a->rd, true), n = xloc(a->rn, true);
+        int base = n.reg;
+        int32_t disp = a->rn == 31u ? L->spBias : 0;
+        if (n.kind == L_MEM) { base = RAX; load(x, RAX, fileAt(n.disp)); }
+        int r = d.kind == L_REG ? d.reg : RAX;
+        lea(x, r, rmIdx(base, RCX, 1 << a->amount, disp));
+        st(L, d, r);
+        return;
+    }
+    shiftBy(L, RCX, 0, a->amount);
+    Loc d = xloc(a->rd, false), n = xloc(a->rn, true);
+    if (d.kind == L_ZERO) {
+        int lhs = n.kind == L_REG ? n.reg : RAX;
+        if (n.kind != L_REG) ld(L, RAX, n);
+        alu(x, 0x3b, lhs, rmReg(RCX));
+        return;
+    }
+    Loc rcx = { L_REG, RCX, 0 };
+    int t = workReg(d, rcx);
+    ld(L, t, n);
+    alu(x, 0x2b, t, rmReg(RCX));
+    st(L, d, t);
+}
+
+static void lowerLogical(Lower *L, const A64 *a) {
+    Loc d = xloc(a->rd, false), n = xloc(a->rn, false), m = xloc(a->rm, false);
+    if (d.kind == L_ZERO) return;
+    if (a->op == A_ORR && n.kind == L_ZERO) {     /* mov */
+        if (m.kind == L_REG && d.kind == L_REG) { movRR(&L->x, d.reg, m.reg); return; }
+        int r = d.kind == L_REG ? d.reg : RAX;
+        ld(L, r, m);
+        st(L, d, r);
+        return;
+    }
+    int t = workReg(d, m);
+    ld(L, t, n);
+    uint8_t opc = a->op == A_AND ? 0x23 : a->op == A_ORR ? 0x0b : 0x33;
+    alu(&L->x, opc, t, src(L, m, RCX));
+    st(L, d, t);
+}
+
+static void lowerAndImm(Lower *L, const A64 *a) {
+    X64 *x = &L->x;
+    if (a->rd == 31u) { L->why = "and to sp"; return; }
+    Loc d = xloc(a->rd, false), n = xloc(a->rn, false);
+    int t = workReg(d, d);
+    if (a->amount == 32u) {
+        if (n.kind == L_ZERO) movImm(x, t, 0);
+        else op1(x, 0, false, 0x8b, t, rmOf(n));   /* mov r32 zero-extends */
+    } else {
+        ld(L, t, n);
+        if (a->amount < 32u) {
+            aluImm(x, 4, rmReg(t), (int32_t)((1u << a->amount) - 1u));
+        } else {
+            movImm(x, RCX, (int64_t)((1ull << a->amount) - 1u));
+            alu(x, 0x23, t, rmReg(RCX));
+        }
+    }
+    st(L, d, t);
+}
+
+static void lowerShift(Lower *L, const A64 *a) {
+    Loc d = xloc(a->rd, false), n = xloc(a->rn, false);
+    if (d.kind == L_ZERO) return;
+    int t = workReg(d, d);
+    if (a->op == A_LSL || a->op == A_LSR || a->op == A_ASR) {
+        ld(L, t, n);
+        shiftBy(L, t, a->op == A_LSL ? 0u : a->op == A_LSR ? 1u : 2u, a->amount);
+        st(L, d, t);
+        return;
+    }
+    /* Register amounts: x86 masks a 64-bit shift count to six bits exactly as
+     * lslv/asrv do. */
+    ld(L, RCX, xloc(a->rm, false));
+    ld(L, t, n);
+    shiftCl(&L->x, a->op == A_LSLV ? 4 : a->op == A_LSRV ? 5 : 7, rmReg(t));
+    st(L, d, t);
+}
+
+static void lowerMul(Lower *L, const A64 *a) {
+    X64 *x = &L->x;
+    Loc d = xloc(a->rd, false), n = xloc(a->rn, false), m = xloc(a->rm, false);
+    if (a->op == A_SMULH) {
+        ld(L, RAX, n);
+        group3(x, 5, src(L, m, RCX));
+        st(L, d, RDX);
+        return;
+    }
+    ld(L, RAX, n);
+    imul(x, RAX, src(L, m, RCX));
+    if (a->ra != 31u) {
+        Loc acc = xloc(a->ra, false);
+        if (a->op == A_MADD) {
+            alu(x, 0x03, RAX, rmOf(acc));
+        } else {
+            ld(L, RCX, acc);
+            alu(x, 0x2b, RCX, rmReg(RAX));
+            movRR(x, RAX, RCX);
+        }
+    } else if (a->op == A_MSUB) {
+        group3(x, 3, rmReg(RAX));
+    }
+    st(L, d, RAX);
+}
+
+/* sdiv never traps: x/0 is 0 and INT64_MIN/-1 is INT64_MIN. idiv faults on
+ * both, so both are peeled off first. */
+static void lowerDiv(Lower *L, const A64 *a) {
+    X64 *x = &L->x;
+    ld(L, RAX, xloc(a->rn, false));
+    ld(L, RCX, xloc(a->rm, false));
+    op1(x, 0, true, 0x85, RCX, rmReg(RCX));               /* test rcx, rcx */
+    x->clobber = true;
+    size_t zero = jccShort(x, CC_E);
+    aluImm(x, 7, rmReg(RCX), -1);
+    size_t negate = jccShort(x, CC_E);
+    cqo(x);
+    group3(x, 7, rmReg(RCX));
+    size_t done1 = jmpShort(x);
+    landShort(x, negate);
+    group3(x, 3, rmReg(RAX));
+    size_t done2 = jmpShort(x);
+    landShort(x, zero);
+    movImm(x, RAX, 0);
+    landShort(x, done1);
+    landShort(x, done2);
+    st(L, xloc(a->rd, false), RAX);
+}
+
+/* csel/csinc. cmov where the condition is one x86 test; where it is two, a
+ * branch around the move, since and-ing two setcc results would write the
+ * very flags being read. */
+static void lowerSelect(Lower *L, unsigned i, const A64 *a) {
+    X64 *x = &L->x;
+    Loc d = xloc(a->rd, false), n = xloc(a->rn, false), m = xloc(a->rm, false);
+    if (a->cond >= 14u) {                                  /* always n */
+        ld(L, RAX, n);
+        st(L, d, RAX);
+        return;
+    }
+    Cond c = readerCond(L, i, a->cond);
+    if (c.mode == CD_NONE) return;
+
+    /* cset Xd, c' is csinc Xd, xzr, xzr, !c' -- one setcc when c' is one
+     * test. */
+    if (a->op == A_CSINC && n.kind == L_ZERO && m.kind == L_ZERO) {
+        Cond set = readerCond(L, i, a->cond ^ 1u);
+        if (set.mode == CD_NONE) return;
+        if (set.mode == CD_SIMPLE) {
+            op2(x, 0, false, 0x0f, (uint8_t)(0x90 + set.cc), 0, rmReg(RAX));
+            op2(x, 0, false, 0x0f, 0xb6, RAX, rmReg(RAX));   /* movzx eax, al */
+            st(L, d, RAX);
+            return;
+        }
+    }
+
+    ld(L, RAX, m);
+    if (a->op == A_CSINC) lea(x, RAX, rmMem(RAX, 1));
+    if (c.mode == CD_SIMPLE) {
+        cmov(x, c.cc, RAX, src(L, n, RCX));
+        st(L, d, RAX);
+        return;
+    }
+    /* Skip the move to n unless the condition holds. */
+    Cond inv = readerCond(L, i, a->cond ^ 1u);
+    if (inv.mode == CD_NONE) return;
+    size_t at[2];
+    int k = condShort(L, inv, at);
+    ld(L, RAX, n);
+    for (int j = 0; j < k; j++) landShort(x, at[j]);
+    st(L, d, RAX);
+}
+
+/* blr: a SysV call. Arguments x0..x7 go where SysV wants them (x0 and x1 are
+ * already in rdi and rsi), the stack is realigned, xmm8..14 are saved because
+ * arm64 promises d8..d15 survive a call and SysV promises no xmm does, and the
+ * two-register return comes back as x0:x1. */
+static void lowerCall(Lower *L, const A64 *a) {
+    X64 *x = &L->x;
+    ld(L, R11, xloc(a->rn, false));
+    for (unsigned r = 8; r < FIRST_MEM_D; r++) {
+        if (L->fpUsed & (1u << r)) sse(x, 0xf2, 0x11, (int)r, fileAt(FILE_XMM + 8 * (int32_t)(r - 8)));
+    }
+    movRR(x, RAX, RSP);
+    aluImm(x, 4, rmReg(RSP), -16);
+    pushReg(x, RAX);
+    pushReg(x, RAX);
+    /* Stack arguments 7 and 8, which keeps the 16-byte alignment. */
+    for (unsigned k = 7; k >= 6; k--) {
+        Loc l = xloc(k, false);
+        if (l.kind == L_REG) pushReg(x, l.reg);
+        else op1(x, 0, false, 0xff, 6, fileAt(l.disp));   /* push qword [m] */
+    }
+    /* x2..x5 have no register of their own, so filling rdx..r9 cannot clobber
+     * an argument not yet read -- r8 and r9 are x9's and x10's homes, dead at
+     * a call on arm64 too. */
+    static const int argReg[4] = { RDX, RCX, R8, R9 };
+    for (unsigned k = 2; k < 6; k++) ld(L, argReg[k - 2], xloc(k, false));
+    op1(x, 0, false, 0xff, 2, rmReg(R11));                   /* call r11 */
+    aluImm(x, 0, rmReg(RSP), 16);
+    load(x, RSP, rmMem(RSP, 0));
+    st(L, xloc(0, false), RAX);
+    st(L, xloc(1, false), RDX);
+    for (unsigned r = 8; r < FIRST_MEM_D; r++) {
+        if (L->fpUsed & (1u << r)) sse(x, 0xf2, 0x10, (int)r, fileAt(FILE_XMM + 8 * (int32_t)(r - 8)));
+    }
+}
+
+/* d operand as something an SSE instruction can read: a register or the
+ * file slot. */
+static RM fsrc(unsigned d) {
+    Loc l = dloc(d);
+    return l.kind == L_REG ? rmReg(l.reg) : fileAt(l.disp);
+}
+
+/* Loads d into a register: its own, or xmm15. */
+static int freg(Lower *L, unsigned d) {
+    Loc l = dloc(d);
+    if (l.kind == L_REG) return l.reg;
+    sse(&L->x, 0xf2, 0x10, XMM_SCRATCH, fileAt(l.disp));
+    return XMM_SCRATCH;
+}
+
+static void fstore(Lower *L, unsigned d, int reg) {
+    Loc l = dloc(d);
+    if (l.kind == L_REG) movapd(&L->x, l.reg, reg);
+    else sse(&L->x, 0xf2, 0x11, reg, fileAt(l.disp));
+}
+
+static void lowerFloat(Lower *L, const A64 *a) {
+    X64 *x = &L->x;
+    Loc d = dloc(a->rd);
+    switch (a->op) {
+    case A_FADD: case A_FSUB: case A_FMUL: case A_FDIV: {
+        Loc m = dloc(a->rm), n = dloc(a->rn);
+        int t = (d.kind == L_REG && !(m.kind == L_REG && m.reg == d.reg))
+                    ? d.reg : XMM_SCRATCH;
+        if (n.kind == L_REG) movapd(x, t, n.reg);
+        else sse(x, 0xf2, 0x10, t, fileAt(n.disp));
+        uint8_t opc = a->op == A_FADD ? 0x58 : a->op == A_FSUB ? 0x5c
+                    : a->op == A_FMUL ? 0x59 : 0x5e;
+        sse(x, 0xf2, opc, t, fsrc(a->rm));
+        if (t != d.reg || d.kind == L_MEM) fstore(L, a->rd, t);
+        return;
+    }
+    case A_FSQRT: {
+        int t = d.kind == L_REG ? d.reg : XMM_SCRATCH;
+        sse(x, 0xf2, 0x51, t, fsrc(a->rn));
+        if (d.kind == L_MEM) fstore(L, a->rd, t);
+        return;
+    }
+    case A_FNEG: {
+        int t = d.kind == L_REG ? d.reg : XMM_SCRATCH;
+        Loc n = dloc(a->rn);
+        if (n.kind == L_REG) movapd(x, t, n.reg);
+        else sse(x, 0xf2, 0x10, t, fileAt(n.disp));
+        sse(x, 0x66, 0x57, t, fileAt(FILE_SIGN));           /* xorpd */
+        if (d.kind == L_MEM) fstore(L, a->rd, t);
+        return;
+    }
+    case A_FMOVDD: {
+        Loc n = dloc(a->rn);
+        if (d.kind == L_REG) {
+            if (n.kind == L_REG) movapd(x, d.reg, n.reg);
+            else sse(x, 0xf2, 0x10, d.reg, fileAt(n.disp));
+        } else {
+            fstore(L, a->rd, freg(L, a->rn));
+        }
+        return;
+    }
+    case A_FCMP: {
+        int r = freg(L, a->rn);
+        sse(x, 0x66, 0x2e, r, fsrc(a->rm));
+        return;
+    }
+    case A_FCMPZ: {
+        int r = freg(L, a->rn);
+        sse(x, 0x66, 0x2e, r, fileAt(FILE_ZERO));
+        return;
+    }
+    case A_FMOVDI:
+        movImm(x, RAX, a->imm);
+        if (d.kind == L_REG) op2(x, 0x66, true, 0x0f, 0x6e, d.reg, rmReg(RAX));
+        else store(x, fileAt(d.disp), RAX);
+        return;
+    case A_FMOVDX: {
+        Loc n = xloc(a->rn, false);
+        if (d.kind == L_REG) {
+            op2(x, 0x66, true, 0x0f, 0x6e, d.reg, src(L, n, RAX));  /* movq */
+        } else {
+            ld(L, RAX, n);
+            store(x, fileAt(d.disp), RAX);
+        }
+        return;
+    }
+    case A_FMOVXD: {
+        Loc t = xloc(a->rd, false);
+        Loc n = dloc(a->rn);
+        if (t.kind == L_ZERO) return;
+        if (n.kind == L_REG) {
+            if (t.kind == L_REG) op2(x, 0x66, true, 0x0f, 0x7e, n.reg, rmReg(t.reg));
+            else sse(x, 0xf2, 0x11, n.reg, fileAt(t.disp));
+        } else {
+            int r = t.kind == L_REG ? t.reg : RAX;
+            load(x, r, fileAt(n.disp));
+            if (t.kind == L_MEM) store(x, fileAt(t.disp), r);
+        }
+        return;
+    }
+    case A_SCVTF: {
+        int t = d.kind == L_REG ? d.reg : XMM_SCRATCH;
+        RM s = src(L, xloc(a->rn, false), RAX);
+        sse(x, 0x66, 0x57, t, rmReg(t));   /* break the merge dependency */
+        op2(x, 0xf2, true, 0x0f, 0x2a, t, s);
+        if (d.kind == L_MEM) fstore(L, a->rd, t);
+        return;
+    }
+    case A_FCVTZS: {
+        /* cvttsd2si answers INT64_MIN for NaN and for anything out of range;
+         * fcvtzs saturates instead and gives 0 for NaN. */
+        int r = freg(L, a->rn);
+        op2(x, 0xf2, true, 0x0f, 0x2c, RAX, rmReg(r));
+        aluImm(x, 7, rmReg(RAX), 1);           /* OF only for INT64_MIN */
+        size_t fine = jccShort(x, CC_NO);
+        sse(x, 0x66, 0x2e, r, rmReg(r));
+        size_t nan = jccShort(x, CC_P);
+        sse(x, 0x66, 0x2e, r, fileAt(FILE_ZERO));
+        size_t negative = jccShort(x, CC_B);
+        movImm(x, RAX, INT64_MAX);
+        size_t done = jmpShort(x);
+        landShort(x, nan);
+        movImm(x, RAX, 0);
+        landShort(x, fine);
+        landShort(x, negative);
+        landShort(x, done);
+        st(L, xloc(a->rd, false), RAX);
+        return;
+    }
+    default:
+        L->why = "an unknown float instruction";
+        return;
+    }
+}
+
+static bool writesSp(const A64 *a) {
+    switch (a->op) {
+    case A_ADDI: case A_SUBI: case A_ADDX: return a->rd == 31u;
+    case A_LDP: case A_STP: return a->mode != 2 && a->rn == 31u;
+    default: return false;
+    }
+}
+
+/* Lowers word i; returns how many words it took (more than one only for a
+ * folded constant), or 0 on failure with L->why set. */
+static unsigned lowerOne(Lower *L, unsigned i) {
+    const A64 *a = &L->ins[i];
+    X64 *x = &L->x;
+    switch (a->op) {
+    case A_NOP: case A_DATA:
+        return 1;
+    case A_LDRX: case A_STRX: case A_LDRW: case A_STRW:
+    case A_LDRB: case A_STRB: case A_LDRD: case A_STRD:
+        lowerLoadStore(L, a);
+        return 1;
+    case A_LDP: case A_STP:
+        lowerPair(L, a);
+        return 1;
+    case A_LDRLIT: {
+        unsigned k = (unsigned)a->imm;
+        uint64_t v = (uint64_t)L->words[k] | ((uint64_t)L->words[k + 1] << 32);
+        lowerConst(L, xloc(a->rd, false), (int64_t)v);
+        return 1;
+    }
+    case A_ADDI: case A_SUBI:
+        lowerAddImm(L, a);
+        return 1;
+    case A_ADDSI: case A_SUBSI:
+        lowerAddsImm(L, a);
+        return 1;
+    case A_ADD: case A_ADDS: case A_SUB: case A_SUBS:
+        lowerAddSub(L, a);
+        return 1;
+    case A_ADDX: case A_SUBSX:
+        lowerExtended(L, a);
+        return 1;
+    case A_AND: case A_ORR: case A_EOR:
+        lowerLogical(L, a);
+        return 1;
+    case A_ANDI:
+        lowerAndImm(L, a);
+        return L->why ? 0 : 1;
+    case A_LSL: case A_LSR: case A_ASR: case A_LSLV: case A_LSRV: case A_ASRV:
+        lowerShift(L, a);
+        return 1;
+    case A_MADD: case A_MSUB: case A_SMULH:
+        lowerMul(L, a);
+        return 1;
+    case A_SDIV:
+        lowerDiv(L, a);
+        return 1;
+    case A_MOVZ: case A_MOVN:
+        return lowerMov(L, i);
+    case A_MOVK:
+        lowerMovk(L, a);
+        return 1;
+    case A_CSEL: case A_CSINC:
+        lowerSelect(L, i, a);
+        return L->why ? 0 : 1;
+    case A_B:
+        return farTo(L, 0xe9, (unsigned)a->imm) ? 1 : 0;
+    case A_BL:
+        return farTo(L, 0xe8, (unsigned)a->imm) ? 1 : 0;
+    case A_BCOND: {
+        Cond c = readerCond(L, i, a->cond);
+        if (c.mode == CD_NONE) return 0;
+        return condFar(L, c, (unsigned)a->imm) ? 1 : 0;
+    }
+    case A_TBZ: case A_TBNZ: {
+        Loc t = xloc(a->rd, false);
+        if (t.kind == L_ZERO) {
+            if (a->op == A_TBZ) return farTo(L, 0xe9, (unsigned)a->imm) ? 1 : 0;
+            return 1;
+        }
+        op2(x, 0, true, 0x0f, 0xba, 4, rmOf(t));           /* bt r/m64, imm8 */
+        put(x, a->amount);
+        x->clobber = true;
+        return farTo(L, 0x80 + (a->op == A_TBZ ? CC_AE : CC_B),
+                     (unsigned)a->imm) ? 1 : 0;
+    }
+    case A_BLR:
+        lowerCall(L, a);
+        return 1;
+    case A_RET:
+        ret(x);
+        return 1;
+    case A_FADD: case A_FSUB: case A_FMUL: case A_FDIV: case A_FNEG:
+    case A_FSQRT: case A_FMOVDD: case A_FCMP: case A_FCMPZ: case A_FMOVDX:
+    case A_FMOVXD: case A_FMOVDI: case A_SCVTF: case A_FCVTZS:
+        lowerFloat(L, a);
+        return L->why ? 0 : 1;
+    default:
+        L->why = "an instruction outside the lowered vocabulary";
+        return 0;
+    }
+}
+
+/* ------------------------------------------------------------------ */
+/* Analyses                                                             */
+/* ------------------------------------------------------------------ */
+
+/* Marks literal-pool words as data, branch targets as labels, and checks that
+ * every branch lands on an instruction. */
+static bool scan(Lower *L) {
+    for (unsigned i = 0; i < L->count; i++) L->ins[i] = decode(L->words[i], i);
+    /* The pool follows the code that loads from it, so marking in order never
+     * takes a literal's own bits for a load. */
+    for (unsigned i = 0; i < L->count; i++) {
+        const A64 *a = &L->ins[i];
+        if (a->op != A_LDRLIT) continue;
+        if (a->imm < 0 || (uint64_t)a->imm + 1u >= L->count) {
+            L->why = "a literal outside the body";
+            return false;
+        }
+        L->ins[a->imm].op = A_DATA;
+        L->ins[a->imm + 1].op = A_DATA;
+    }
+    for (unsigned i = 0; i < L->count; i++) {
+        const A64 *a = &L->ins[i];
+        if (a->op == A_BAD) {
+            L->why = "an instruction outside the lowered vocabulary";
+            return false;
+        }
+        if (a->op == A_DATA) continue;
+        if (isBranch(a->op)) {
+            if (a->imm < 0 || (uint64_t)a->imm > L->count ||
+                ((uint64_t)a->imm < L->count && L->ins[a->imm].op == A_DATA)) {
+                L->why = "a branch that lands outside the code";
+                return false;
+            }
+            if ((uint64_t)a->imm < L->count) L->target[a->imm] = true;
+        }
+        switch (a->op) {
+        case A_LDRD: case A_STRD: case A_FNEG: case A_FSQRT: case A_FMOVDD:
+        case A_FMOVDX: case A_FMOVDI: case A_SCVTF:
+            L->fpUsed |= 1u << a->rd;
+            break;
+        default:
+            break;
+        }
+        switch (a->op) {
+        case A_FADD: case A_FSUB: case A_FMUL: case A_FDIV:
+            L->fpUsed |= (1u << a->rd) | (1u << a->rn) | (1u << a->rm);
+            break;
+        case A_FNEG: case A_FSQRT: case A_FMOVDD: case A_FMOVXD:
+        case A_FCVTZS: case A_FCMPZ:
+            L->fpUsed |= 1u << a->rn;
+            break;
+        case A_FCMP:
+            L->fpUsed |= (1u << a->rn) | (1u << a->rm);
+            break;
+        default:
+            break;
+        }
+    }
+    return true;
+}
+
+static int successors(const A64 *a, unsigned i, unsigned count, unsigned out[2]) {
+    int n = 0;
+    if (fallsThrough(a->op) && i + 1 < count) out[n++] = i + 1;
+    if ((a->op == A_B || a->op == A_BCOND || a->op == A_TBZ ||
+         a->op == A_TBNZ) && (uint64_t)a->imm < count) {
+        out[n++] = (unsigned)a->imm;
+    }
+    return n;
+}
+
+/* Which words have the flags live on their way out (backward), and which
+ * writer shapes can reach each reader (forward). Both iterate to a fixpoint;
+ * loops are short and the lattices tiny, so a handful of sweeps settles. */
+static void flagAnalysis(Lower *L) {
+    unsigned n = L->count;
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (unsigned k = n; k-- > 0;) {
+            const A64 *a = &L->ins[k];
+            unsigned succ[2];
+            int s = successors(a, k, n, succ);
+            bool out = false;
+            for (int j = 0; j < s; j++) {
+                const A64 *b = &L->ins[succ[j]];
+                bool in = readsFlags(b) ||
+                          (!flagKind(b->op) && !killsFlags(b->op) && L->live[succ[j]]);
+                out = out || in;
+            }
+            if (out != L->live[k]) { L->live[k] = out; changed = true; }
+        }
+    }
+    changed = true;
+    while (changed) {
+        changed = false;
+        for (unsigned k = 0; k < n; k++) {
+            const A64 *a = &L->ins[k];
+            int kind = flagKind(a->op);
+            uint8_t out = kind ? (uint8_t)kind
+                        : killsFlags(a->op) ? 0 : L->kindIn[k];
+            unsigned succ[2];
+            int s = successors(a, k, n, succ);
+            for (int j = 0; j < s; j++) {
+                uint8_t merged = (uint8_t)(L->kindIn[succ[j]] | out);
+                if (merged != L->kindIn[succ[j]]) {
+                    L->kindIn[succ[j]] = merged;
+                    changed = true;
+                }
+            }
+        }
+    }
+}
+
+/* ------------------------------------------------------------------ */
+/* Entry stub and driver                                                */
+/* ------------------------------------------------------------------ */
+
+/* SysV in, arm64 register plan out and back. Saves what SysV makes callee-
+ * saved (rbx, rbp, r12..r15 -- the homes of x19..x23 and the file pointer),
+ * opens the file, and places arguments 3..8 in x2..x7's slots; the first two
+ * are already in x0's and x1's homes. */
+static bool emitStub(Lower *L) {
+    X64 *x = &L->x;
+    static const int saved[6] = { RBX, RBP, R12, R13, R14, R15 };
+    for (int k = 0; k < 6; k++) pushReg(x, saved[k]);
+    aluImm(x, 5, rmReg(RSP), FILE_BYTES);
+    movRR(x, R15, RSP);
+    static const int argReg[4] = { RDX, RCX, R8, R9 };
+    for (unsigned k = 0; k < 4; k++) store(x, fileAt(FILE_X + 8 * (int32_t)(k + 2)), argReg[k]);
+    for (unsigned k = 0; k < 2; k++) {
+        /* Past the file, the six saves and the return address. Read even when
+         * the caller passed fewer: it is the caller's frame either way. */
+        load(x, RAX, rmMem(RSP, FILE_BYTES + 48 + 8 + 8 * (int32_t)k));
+        store(x, fileAt(FILE_X + 8 * (int32_t)(k + 6)), RAX);
+    }
+    op1(x, 0, true, 0xc7, 0, fileAt(FILE_ZERO));
+    put32(x, 0);
+    movImm(x, RAX, INT64_MIN);
+    store(x, fileAt(FILE_SIGN), RAX);
+    op1(x, 0, true, 0xc7, 0, fileAt(FILE_SIGN + 8));
+    put32(x, 0);
+    if (!farTo(L, 0xe8, 0)) return false;
+    movRR(x, RAX, RDI);
+    movRR(x, RDX, RSI);
+    aluImm(x, 0, rmReg(RSP), FILE_BYTES);
+    for (int k = 6; k-- > 0;) popReg(x, saved[k]);
+    ret(x);
+    return true;
+}
+
+bool jaiX64Lower(const uint32_t *words, unsigned count, uint8_t **out,
+                 size_t *outLength, const char **why) {
+    return jaiX64LowerMapped(words, count, out, outLength, NULL, why);
+}
+
+bool jaiX64LowerMapped(const uint32_t *words, unsigned count, uint8_t **out,
+                       size_t *outLength, uint32_t *byteAt, const char **why) {
+    Lower L;
+    memset(&L, 0, sizeof L);
+    L.words = words;
+    L.count = count;
+    L.ins = calloc(count + 1, sizeof *L.ins);
+    L.target = calloc(count + 1, sizeof *L.target);
+    L.live = calloc(count + 1, sizeof *L.live);
+    L.kindIn = calloc(count + 1, sizeof *L.kindIn);
+    L.map = calloc(count + 1, sizeof *L.map);
+    bool ok = false;
+    if (L.ins == NULL || L.target == NULL || L.live == NULL ||
+        L.kindIn == NULL || L.map == NULL) {
+        L.why = "out of memory";
+        goto done;
+    }
+    if (count == 0) { L.why = "an empty body"; goto done; }
+    if (!scan(&L)) goto done;
+    flagAnalysis(&L);
+    if (!emitStub(&L)) goto done;
+
+    for (unsigned i = 0; i < count;) {
+        L.map[i] = L.x.len;
+        size_t pos = L.x.len;
+        unsigned fixes = L.nfix;
+        L.x.clobber = false;
+        unsigned used = lowerOne(&L, i);
+        if (used == 0) {
+            if (L.why == NULL) L.why = "an instruction that could not be lowered";
+            goto done;
+        }
+        /* Flags live across an instruction that leaves NZCV alone, lowered to
+         * x86 that does not: redo it inside pushfq/popfq. Never a branch, and
+         * never something that moves sp, which the pushed word sits on. */
+        if (L.x.clobber && L.live[i] && !flagKind(L.ins[i].op)) {
+            if (isBranch(L.ins[i].op) || L.ins[i].op == A_BLR ||
+                writesSp(&L.ins[i])) {
+                L.why = "flags live across an instruction that must clobber them";
+                goto done;
+            }
+            L.x.len = pos;
+            L.nfix = fixes;
+            put(&L.x, 0x9c);
+            L.spBias = 8;
+            used = lowerOne(&L, i);
+            L.spBias = 0;
+            put(&L.x, 0x9d);
+            if (used == 0) goto done;
+        }
+        for (unsigned k = 1; k < used; k++) L.map[i + k] = L.x.len;
+        i += used;
+    }
+    L.map[count] = L.x.len;
+    if (L.x.oom) { L.why = "out of memory"; goto done; }
+
+    for (unsigned f = 0; f < L.nfix; f++) {
+        const Fixup *fx = &L.fix[f];
+        int64_t rel = (int64_t)L.map[fx->target] - (int64_t)(fx->at + 4);
+        uint32_t v = (uint32_t)(int32_t)rel;
+        memcpy(L.x.buf + fx->at, &v, sizeof v);
+    }
+    if (byteAt != NULL) {
+        for (unsigned i = 0; i <= count; i++) byteAt[i] = (uint32_t)L.map[i];
+    }
+    *out = L.x.buf;
+    *outLength = L.x.len;
+    L.x.buf = NULL;
+    ok = true;
+
+done:
+    if (!ok && why != NULL) *why = L.why;
+    free(L.x.buf);
+    free(L.ins);
+    free(L.target);
+    free(L.live);
+    free(L.kindIn);
+    free(L.map);
+    free(L.fix);
+    return ok;
+}
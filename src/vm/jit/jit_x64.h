@@ -0,0 +1,44 @@
+#ifndef JAI_VM_JIT_X64_H
+#define JAI_VM_JIT_X64_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* The compiled tiers on x86-64. They do not get a second code generator: both
+ * tiers already build a complete, fixed-up arm64 word stream through the
+ * jaiA64* encoders, and that stream is a small, closed vocabulary -- every
+ * word in it came from one of about sixty encoder functions. This lowers each
+ * word to the x86-64 that does the same thing, so the register plan, the bail
+ * and deopt protocol, the stack guard and every callout stay exactly the code
+ * the arm64 build runs and has been tested against.
+ *
+ * What arm64 state has no x86 register lives in a register file the entry
+ * stub allocates on the stack, addressed from r15:
+ *
+ *   x0 rdi   x1 rsi   x9 r8   x10 r9   x11 r10
+ *   x19 rbx  x20 rbp  x21 r12  x22 r13  x23 r14     (SysV callee-saved, as
+ *                                                    x19.. are on arm64)
+ *   d0..d14 xmm0..xmm14; everything else in the file
+ *
+ * rax, rcx, rdx, r11 and xmm15 are the lowering's own scratch. The first byte
+ * of the result is a SysV-callable stub, so the typedefs jit_func.c calls
+ * through (JitResult in x0:x1 becomes rax:rdx, the same two-register struct
+ * return) need no change.
+ *
+ * Anything outside the vocabulary, or a flag use the lowering cannot prove
+ * right, declines: the body stays interpreted, which is always correct. */
+
+/* Lowers `count` words to x86-64. On success *out is a malloc'd buffer of
+ * *outLength position-independent bytes, entered at byte 0; the caller copies
+ * it into an arena and frees it. On failure returns false with *why naming the
+ * first thing that could not be lowered. */
+bool jaiX64Lower(const uint32_t *words, unsigned count, uint8_t **out,
+                 size_t *outLength, const char **why);
+/* The same, and when `byteAt` is not NULL it receives `count + 1` entries:
+ * the byte offset each word's x86-64 begins at, and the length at the end.
+ * It is how a source position recorded against a word finds its byte. */
+bool jaiX64LowerMapped(const uint32_t *words, unsigned count, uint8_t **out,
+                       size_t *outLength, uint32_t *byteAt, const char **why);
+
+#endif /* JAI_VM_JIT_X64_H */
@@ -43,6 +43,7 @@
 #endif
 
 #include "vm/gc.h"
+#include "vm/jit/jit.h"
 #include "vm/table.h"
 #include "vm/vm.h"
 
@@ -156,6 +157,7 @@ void jaiFreeObject(Obj *obj) {
     }
     case OBJ_FUNCTION: {
         ObjFunction *fn = (ObjFunction *)obj;
+        jaiJitForget(fn);
         jaiChunkFree(&fn->chunk);
         JAI_FREE_ARRAY(ObjString *, fn->paramNames, fn->paramCount);
         JAI_FREE_ARRAY(ExceptionEntry, fn->exceptions, fn->exceptionCount);
@@ -173,6 +175,10 @@ void jaiFreeObject(Obj *obj) {
         ObjClass *c = (ObjClass *)obj;
         JAI_FREE_ARRAY(FieldInfo, c->fields, c->fieldCount);
         JAI_FREE_ARRAY(ObjTrait *, c->traits, c->traitCount);
+        for (uint16_t i = 0; i < c->vtableCount; i++) {
+            JAI_FREE_ARRAY(Value, c->vtables[i].methods, c->vtables[i].count);
+        }
+        JAI_FREE_ARRAY(TraitVTable, c->vtables, c->vtableCount);
         jaiTableFree(&c->methods);
         jaiTableFree(&c->statics);
         jaiTableFree(&c->getters);
@@ -186,6 +192,7 @@ void jaiFreeObject(Obj *obj) {
         jaiTableFree(&t->required);
         jaiTableFree(&t->defaults);
         JAI_FREE_ARRAY(ObjTrait *, t->supers, t->superCount);
+        JAI_FREE_ARRAY(ObjString *, t->methodNames, t->methodCount);
         JAI_FREE(ObjTrait, obj);
         return;
     }
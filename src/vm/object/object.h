@@ -268,16 +268,38 @@ typedef enum {
     FN_INIT      = 1 << 8,
     FN_TRACE       = 1 << 9,
     FN_GPU_KERNEL  = 1 << 10,
+    /* A lambda written straight into a higher-order builtin call
+     * (`xs.map(|x| x * 2)`): OP_CLOSURE may hand back the closure it built
+     * last time. See ObjFunction.siteClosure. */
+    FN_SITE_CLOSURE = 1 << 11,
+    /* The variadic parameter is only indexed, iterated, measured or spread,
+     * so its arguments stay on the stack instead of becoming a list: the
+     * variadic slot holds their count and OP_REST_GET / OP_CALL_REST read
+     * them. Only ever set together with FN_VARIADIC. */
+    FN_REST_VIEW    = 1 << 12,
 } FunctionFlags;
 
-/* One entry of a function's exception table. */
+/* One entry of a function's exception table.
+ *
+ * Entering a `try` costs nothing: the unwinder searches these ranges by the
+ * faulting offset, and the narrowest matching region wins. `depth` is the
+ * operand stack the region was entered with -- an enclosing `for` keeps its
+ * iterator there -- so the handler resumes on exactly the stack the emitter
+ * generated it against, the way OP_PUSH_HANDLER's saved stackTop once did. */
 typedef struct {
     uint32_t start;       /* protected region, code offset, inclusive */
     uint32_t end;         /* exclusive */
     uint32_t handler;     /* code offset of the handler */
-    uint32_t typeConst;   /* constant index of the caught class, or UINT32_MAX for catch-all */
+    uint32_t typeConst;   /* constant index of the caught class, or a JAI_HANDLER_* sentinel */
+    uint32_t depth;       /* operand-stack entries above the frame window kept on entry */
 } ExceptionEntry;
 
+/* typeConst sentinels: no pool index can reach either. A `finally` matches
+ * everything like a catch-all, but leaves the exception in flight for
+ * OP_END_FINALLY to re-raise. */
+#define JAI_HANDLER_CATCH_ALL UINT32_MAX
+#define JAI_HANDLER_FINALLY   (UINT32_MAX - 1u)
+
 #define JAI_OSR_MAX 4
 /* Consecutive entry-guard failures on one loop head before it is left to
  * the interpreter. */
@@ -337,6 +359,13 @@ struct ObjFunction {
     uint32_t    flags;           /* FunctionFlags */
     uint16_t    maxSlots;
     uint16_t    upvalueCount;
+    /* FN_SITE_CLOSURE only: the closure OP_CLOSURE last built from this
+     * function, reused while everything it captured is what it would capture
+     * now -- the same open cells, the same outer cells, the same by-value
+     * snapshots. Such a closure is indistinguishable from a fresh one except by
+     * `is`, and the builtins it is written for only call it. Strong, so a site
+     * keeps its last closure (and what that captured) alive. */
+    ObjClosure *siteClosure;
     Chunk       chunk;
     ObjString **paramNames;      /* arity + variadic + kwrest entries */
     uint16_t    paramCount;
@@ -364,8 +393,9 @@ struct ObjFunction {
      * is precisely the recursive shape this exists for. */
     uint8_t     obsReturnKind;
     uint32_t    obsReturnShape;
-    /* Entry point of this function's compiled form, or NULL. Owned by the JIT's
-     * arena, which outlives every function, so this is not freed here. */
+    /* Entry point of this function's compiled form, or NULL. Lives in the JIT's
+     * code heap, which reclaims it once this function is freed; see
+     * jaiJitForget. */
     void       *jitCode;
     /* Which calling convention `jitCode` uses; see jit.c. */
     uint8_t     jitKind;
@@ -437,11 +467,20 @@ struct ObjFunction {
      * all. A decline has to be free after the first one, which is the same
      * lesson the loop back edge taught. */
     bool        jitRefused;
+    /* Where this function's background compile is (JAI_JIT_IDLE and friends in
+     * jit.h). Only the interpreter's thread reads or writes it: the compiler
+     * thread is handed a job, never the function. */
+    uint8_t     jitPending;
+    /* Compiled forms of this function retired so far, any tier. A retired
+     * form is compiled afresh when the function is next hot, and this is what
+     * stops a function whose module rebinds a global on every iteration from
+     * being compiled on every iteration too. See jit_reclaim.c. */
+    uint8_t     jitRetires;
     /* Sampling ticks that landed in this function, saturating once hot. */
     uint16_t    tickCount;
     /* A compiled form of one loop in this function, plus the two bytecode
      * offsets the tier hands back to the interpreter: where the loop exits and
-     * where it starts. Owned by the JIT arena, so not freed here. */
+     * where it starts. In the JIT's code heap, like jitCode. */
     void       *jitLoop;
     uint32_t    jitLoopExit;
     uint32_t    jitLoopTop;
@@ -451,6 +490,14 @@ struct ObjFunction {
     /* 0 = counted head (JUMP_IF_CMP_LOCAL_K), 1 = range head
      * (FOR_ITER_BIND over a 0-start unit-step range). */
     uint8_t     jitLoopKind;
+    /* Counted loops in this function that a compiled form hands to the block
+     * kernel, keyed by their OP_ITER_RANGE, misses included; see jit_vec.h.
+     * Compiled code holds pointers into this list, so it lives exactly as
+     * long as the function does. */
+    struct JaiVecPlan *jitVecPlans;
+    /* What an earlier run compiled this function for, when the module's
+     * .jaij had a record of it; see jit_warm.c. */
+    struct JaiJitWarm *jitWarm;
     /* Code offsets of the default-value thunks, indexed from arity-defaultCount. */
     uint32_t   *defaultOffsets;
     ObjModule  *module;          /* defining module, for globals resolution */
@@ -575,6 +622,22 @@ typedef struct {
     const ObjClass *owner;       /* declaring class, for the private test */
 } MethodInfo;
 
+/* One trait's methods as one class resolves them, in the trait's own numbering
+ * (ObjTrait.methodNames), so that an OP_INVOKE site which has learned "this is
+ * method 2 of trait Op" reaches the method with an index instead of a hash
+ * probe -- see IC_VTABLE in vm.c. Built on first use by jaiClassVTable and
+ * refilled whenever `klass->methods.version` moves on, so a method added or
+ * replaced after the fill is never missed. An entry is NULL_VAL for a method
+ * that is not public or not in `methods` at all (an abstract requirement, a
+ * default reached only by findTraitDefault): the caller takes the general
+ * path for it, which is where the visibility test and the error live. */
+typedef struct {
+    ObjTrait *trait;
+    uint32_t  version;       /* klass->methods.version at the fill */
+    uint16_t  count;
+    Value    *methods;
+} TraitVTable;
+
 struct ObjClass {
     Obj         obj;
     ObjString  *name;
@@ -598,6 +661,8 @@ struct ObjClass {
     JaiTable    restricted;
     ObjTrait  **traits;
     uint16_t    traitCount;
+    uint16_t    vtableCount;
+    TraitVTable *vtables;       /* one per trait a site has dispatched through */
     Value       initializer;    /* the `init` closure, or NULL_VAL */
     bool        isAbstract;
     /* Cached dunder lookups; NULL_VAL if absent. Filled at class creation. */
@@ -623,6 +688,14 @@ bool      jaiClassIsSubclassOf(const ObjClass *sub, const ObjClass *super);
 bool      jaiClassImplements(const ObjClass *c, const ObjTrait *t);
 /* Recomputes the dunder cache; call after any method mutation. */
 void      jaiClassRefreshDunders(ObjClass *c);
+/* The trait `c` implements that declares method `name`, taking the supertrait
+ * that first declared it over a subtrait that inherited the requirement, so
+ * that every implementor of the method shares one numbering. NULL when no
+ * trait of `c` names it. */
+ObjTrait *jaiClassTraitFor(const ObjClass *c, ObjString *name);
+/* `c`'s vtable for `t`, filled or refreshed as needed; NULL when `c` does not
+ * implement `t`. May allocate. */
+const TraitVTable *jaiClassVTable(ObjClass *c, ObjTrait *t);
 
 struct ObjTrait {
     Obj        obj;
@@ -631,9 +704,18 @@ struct ObjTrait {
     JaiTable   defaults;     /* name -> default method */
     ObjTrait **supers;
     uint16_t   superCount;
+    /* The vtable numbering: method i of every TraitVTable for this trait is
+     * methodNames[i]. Handed out on first ask and only ever appended to, so an
+     * index a call site has cached stays right for the life of the trait. */
+    uint16_t    methodCount;
+    ObjString **methodNames;
 };
 
 ObjTrait *jaiTraitNew(ObjString *name);
+/* `name`'s index in `t`'s vtable numbering, assigned now if it has none; -1
+ * when `t` neither requires nor defaults a method of that name. May
+ * allocate. */
+int       jaiTraitMethodIndex(ObjTrait *t, ObjString *name);
 
 struct ObjInstance {
     Obj       obj;
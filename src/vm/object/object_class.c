@@ -159,6 +159,7 @@ void jaiClassInherit(ObjClass *sub, ObjClass *super) {
 
     if (IS_NULL(sub->initializer))
         sub->initializer = super->initializer;
+    jaiGCBarrierAll((Obj *)sub);
 }
 
 void jaiClassAddMethod(ObjClass *c, ObjString *name, Value method,
@@ -180,6 +181,10 @@ void jaiClassAddMethod(ObjClass *c, ObjString *name, Value method,
     jaiGCPushRoot(method);
     pushObjRoot(name);
     (void)jaiTableSetInterned(target, name, method);
+    /* Also covers the initializer and dunder slots below: they only ever
+     * hold a value this table holds too. */
+    jaiGCBarrier((Obj *)c, OBJ_VAL(name));
+    jaiGCBarrier((Obj *)c, method);
 
     if (vis == VIS_PUBLIC || isDunder) {
         if (c->restricted.count > 0)
@@ -299,6 +304,80 @@ bool jaiClassImplements(const ObjClass *c, const ObjTrait *t) {
     return false;
 }
 
+/* The trait among `t` and its supertraits that declares `name` furthest up:
+ * `trait Sub: Super` copies Super's requirements into Sub, so both tables name
+ * the method, and a site that numbered it by Sub would miss every class that
+ * implements only Super. */
+static ObjTrait *rootDeclaring(ObjTrait *t, ObjString *name, int depth) {
+    if (t == NULL || depth > 32) return NULL;
+    for (uint16_t i = 0; i < t->superCount; i++) {
+        ObjTrait *up = rootDeclaring(t->supers[i], name, depth + 1);
+        if (up != NULL) return up;
+    }
+    Value ignored;
+    if (jaiTableGetInterned(&t->required, name, &ignored) ||
+        jaiTableGetInterned(&t->defaults, name, &ignored)) {
+        return t;
+    }
+    return NULL;
+}
+
+ObjTrait *jaiClassTraitFor(const ObjClass *c, ObjString *name) {
+    if (name == NULL) return NULL;
+    for (const ObjClass *k = c; k != NULL; k = k->superclass) {
+        for (uint16_t i = 0; i < k->traitCount; i++) {
+            ObjTrait *t = rootDeclaring(k->traits[i], name, 0);
+            if (t != NULL) return t;
+        }
+    }
+    return NULL;
+}
+
+const TraitVTable *jaiClassVTable(ObjClass *c, ObjTrait *t) {
+    if (c == NULL || t == NULL) return NULL;
+    TraitVTable *vt = NULL;
+    for (uint16_t i = 0; i < c->vtableCount; i++) {
+        if (c->vtables[i].trait == t) {
+            vt = &c->vtables[i];
+            break;
+        }
+    }
+    if (vt != NULL && vt->version == c->methods.version &&
+        vt->count == t->methodCount) {
+        return vt;
+    }
+    if (vt == NULL) {
+        if (!jaiClassImplements(c, t)) return NULL;
+        c->vtables = JAI_GROW_ARRAY(TraitVTable, c->vtables, c->vtableCount,
+                                    c->vtableCount + 1);
+        vt = &c->vtables[c->vtableCount++];
+        vt->trait = t;
+        vt->count = 0;
+        vt->methods = NULL;
+    }
+    /* The numbering only grows, so a refill after the trait gained a name is
+     * a resize; nothing here collects, so the half-filled table is never
+     * seen by the marker. */
+    if (vt->count != t->methodCount) {
+        vt->methods = JAI_GROW_ARRAY(Value, vt->methods, vt->count,
+                                     t->methodCount);
+        vt->count = t->methodCount;
+    }
+    for (uint16_t i = 0; i < vt->count; i++) {
+        ObjString *name = t->methodNames[i];
+        MethodInfo restricted;
+        Value m;
+        if (!jaiTableGetInterned(&c->methods, name, &m) ||
+            jaiClassRestrictedMethod(c, name, &restricted)) {
+            m = NULL_VAL;
+        }
+        vt->methods[i] = m;
+    }
+    jaiGCBarrierAll((Obj *)c);
+    vt->version = c->methods.version;
+    return vt;
+}
+
 void jaiClassRefreshDunders(ObjClass *c) {
     if (c == NULL) return;
     jaiGCPushRoot(OBJ_VAL(c));
@@ -336,6 +415,23 @@ ObjTrait *jaiTraitNew(ObjString *name) {
     return trait;
 }
 
+int jaiTraitMethodIndex(ObjTrait *t, ObjString *name) {
+    if (t == NULL || name == NULL) return -1;
+    for (uint16_t i = 0; i < t->methodCount; i++) {
+        if (t->methodNames[i] == name) return (int)i;
+    }
+    Value ignored;
+    if (!jaiTableGetInterned(&t->required, name, &ignored) &&
+        !jaiTableGetInterned(&t->defaults, name, &ignored)) {
+        return -1;
+    }
+    if (t->methodCount == UINT16_MAX) return -1;
+    t->methodNames = JAI_GROW_ARRAY(ObjString *, t->methodNames,
+                                    t->methodCount, t->methodCount + 1);
+    t->methodNames[t->methodCount] = name;
+    return (int)t->methodCount++;
+}
+
 /* ------------------------------------------------------------------ */
 /* Instances                                                            */
 /* ------------------------------------------------------------------ */
@@ -122,6 +122,7 @@ void jaiListPush(ObjList *list, Value v) {
 
     list->items[list->count++] = v;
     list->version++;
+    jaiGCBarrier((Obj *)list, v);
 }
 
 Value jaiListPop(ObjList *list) {
@@ -155,6 +156,7 @@ void jaiListInsert(ObjList *list, int idx, Value v) {
     list->items[idx] = v;
     list->count++;
     list->version++;
+    jaiGCBarrier((Obj *)list, v);
 }
 
 Value jaiListRemove(ObjList *list, int idx) {
@@ -311,7 +313,10 @@ bool jaiDictSet(ObjDict *d, Value key, Value value) {
     }
     uint64_t hash;
     if (!keyHash(key, "dict key", &hash)) return false;
-    return jaiTableSetHashed(&d->table, key, hash, value);
+    const bool added = jaiTableSetHashed(&d->table, key, hash, value);
+    jaiGCBarrier((Obj *)d, key);
+    jaiGCBarrier((Obj *)d, value);
+    return added;
 }
 
 bool jaiDictDelete(ObjDict *d, Value key) {
@@ -369,7 +374,9 @@ ObjSet *jaiSetNew(void) {
 bool jaiSetAdd(ObjSet *s, Value v) {
     uint64_t hash;
     if (!keyHash(v, "set element", &hash)) return false;
-    return jaiTableSetHashed(&s->table, v, hash, NULL_VAL);
+    const bool added = jaiTableSetHashed(&s->table, v, hash, NULL_VAL);
+    jaiGCBarrier((Obj *)s, v);
+    return added;
 }
 
 bool jaiSetHas(ObjSet *s, Value v) {
@@ -13,6 +13,7 @@
 #include "vm/object/object_internal.h"   /* pushObjRoot */
 
 #include "vm/gc.h"
+#include "vm/jit/jit.h"
 #include "vm/table.h"
 #include "vm/vm.h"
 
@@ -40,11 +41,19 @@ bool jaiModuleGet(ObjModule *m, ObjString *name, Value *out) {
 }
 
 void jaiModuleSet(ObjModule *m, ObjString *name, Value v) {
+    /* A new key can rehash the table a background compile is probing, so it
+     * waits for that compile. Overwriting moves nothing, and the compiler
+     * thread reads global values only from the copies its job took. */
+    const bool fresh = jaiTableFindEntryInterned(&m->globals, name) == NULL;
+    if (fresh) jaiJitHold();
     jaiGCPushRoot(OBJ_VAL(m));
     jaiGCPushRoot(v);
     Value prev = NULL_VAL;
     const bool added = jaiTableSetInternedPrev(&m->globals, name, v, &prev);
+    jaiGCBarrier((Obj *)m, OBJ_VAL(name));
+    jaiGCBarrier((Obj *)m, v);
     jaiGCPopRoots(2);
+    if (fresh) jaiJitRelease();
 
     /* ObjModule::version retires compiled code, and compiled code resolves a
      * global by VALUE exactly four ways -- globalClass, globalFunction,
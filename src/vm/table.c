@@ -5,7 +5,11 @@
 #include "vm/gc.h"
 #include "vm/object/object.h"
 
+#if defined(JAI_NANBOX)
+const Value JAI_TOMBSTONE = {JAI_NB_TOMBSTONE};
+#else
 const Value JAI_TOMBSTONE = {VAL_OBJ, {.obj = NULL}};
+#endif
 
 #define TABLE_LOAD_NUM 1
 #define TABLE_LOAD_DEN 2
@@ -551,6 +555,13 @@ void jaiTableRemoveWhite(JaiTable *t) {
         JaiEntry *const e = t->entries + slot;
         if (IS_OBJ(e->key) && !AS_OBJ(e->key)->isMarked)
             removeEntry(t, e);
+#if defined(JAI_NANBOX)
+        /* A survivor keeps its value, and the intern table's fingerprint
+         * (length in the top byte) never fits inline: mark its cell, which
+         * nothing else reaches, before the int boxes are swept. */
+        else if (JAI_NB_IS_INT_BOX(e->value))
+            jaiIntBoxMark(e->value);
+#endif
     }
 
     if (t->count >= (t->capacity >> 2)) return;
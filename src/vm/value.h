@@ -1,4 +1,5 @@
-/* value.h — the Jaithon value representation: a 16-byte {tag, payload} pair */
+/* value.h — the Jaithon value representation: a 16-byte {tag, payload} pair,
+ * or with JAI_NANBOX a single 8-byte word */
 #ifndef JAI_VALUE_H
 #define JAI_VALUE_H
 
@@ -35,6 +36,123 @@ typedef enum {
     VAL_OBJ,
 } ValueType;
 
+#if defined(JAI_NANBOX)
+
+/* JAI_NANBOX: the same five kinds in one 64-bit word. Build with
+ *
+ *     make EXTRA_CFLAGS=-DJAI_NANBOX BUILD_ROOT=build-nanbox TARGET=jaithon-nanbox
+ *
+ * It halves every list's items, every instance's fields, every table entry's
+ * key and value and the VM stack, and puts four values in a cache line where
+ * the pair puts two. The encoding is the offset form (JavaScriptCore's) rather
+ * than the NaN-space form, because it keeps all-zero bits meaning null, which
+ * is what every calloc'd field array, memset frame and fresh table relies on:
+ *
+ *     0x0000 0000 0000 0000             null
+ *     0x0000 0000 0000 0002 / 0003      false / true
+ *     0x0000 pppp pppp pppp             Obj * (a 48-bit address)
+ *     0x0001 0000 0000 0000             JAI_TOMBSTONE: an object that is NULL
+ *     0x0002 ... 0xfff2 ...             a double's bits plus 2^49
+ *     0xfffe pppp pppp pppp             an int that needs all 64 bits, boxed
+ *     0xffff iiii iiii iiii             an int in [-2^47, 2^47)
+ *
+ * Adding 2^49 moves every double clear of the pointer and int prefixes; the
+ * one double whose sum would wrap into them is a NaN with the sign bit set,
+ * so FLOAT_VAL folds every such NaN into the canonical quiet one. Nothing
+ * reads a NaN's payload.
+ *
+ * Ints are the language's full int64, and OverflowError is still about 64
+ * bits, so the rare one past 48 bits goes to the heap (intbox.c). A box is
+ * never made by a collection and never freed by one it is still live for:
+ * jaiGCMarkVal marks it wherever it is stored, and the collector scans the C
+ * stack conservatively for the ones only a local holds, since no native has
+ * ever had to root an int.
+ *
+ * The compiled tier reads and writes the pair layout directly, so a NANBOX
+ * build runs interpreted: jaiJitEnabled() is false and jit_func.c builds its
+ * stubs. */
+#if UINTPTR_MAX != 0xffffffffffffffffu
+#  error "JAI_NANBOX needs a 64-bit target"
+#endif
+
+typedef struct {
+    uint64_t bits;
+} Value;
+
+#define JAI_NB_FALSE      UINT64_C(0x0000000000000002)
+#define JAI_NB_TRUE       UINT64_C(0x0000000000000003)
+#define JAI_NB_TOMBSTONE  UINT64_C(0x0001000000000000)
+#define JAI_NB_PTR_MASK   UINT64_C(0x0000ffffffffffff)
+#define JAI_NB_OBJ_END    UINT64_C(0x0002000000000000)
+#define JAI_NB_DOUBLE     UINT64_C(0x0002000000000000)
+#define JAI_NB_INT_BOX    UINT64_C(0xfffe000000000000)
+#define JAI_NB_INT        UINT64_C(0xffff000000000000)
+#define JAI_NB_NAN        UINT64_C(0x7ff8000000000000)
+#define JAI_NB_NEG_INF    UINT64_C(0xfff0000000000000)
+
+/* intbox.c: a heap cell for an int outside the inline range. Never collects. */
+Value jaiIntBoxNew(int64_t i);
+
+JAI_INLINE Value jaiNbBits(uint64_t bits) { Value v; v.bits = bits; return v; }
+
+JAI_INLINE Value jaiNbInt(int64_t i) {
+    if (JAI_LIKELY(((int64_t)((uint64_t)i << 16) >> 16) == i)) {
+        return jaiNbBits(JAI_NB_INT | ((uint64_t)i & JAI_NB_PTR_MASK));
+    }
+    return jaiIntBoxNew(i);
+}
+
+JAI_INLINE int64_t jaiNbAsInt(Value v) {
+    if (JAI_LIKELY(v.bits >= JAI_NB_INT)) {
+        return (int64_t)(v.bits << 16) >> 16;
+    }
+    return *(const int64_t *)(uintptr_t)(v.bits & JAI_NB_PTR_MASK);
+}
+
+JAI_INLINE Value jaiNbFloat(double d) {
+    uint64_t bits;
+    memcpy(&bits, &d, sizeof bits);
+    if (JAI_UNLIKELY(bits > JAI_NB_NEG_INF)) bits = JAI_NB_NAN;
+    return jaiNbBits(bits + JAI_NB_DOUBLE);
+}
+
+JAI_INLINE double jaiNbAsFloat(Value v) {
+    uint64_t bits = v.bits - JAI_NB_DOUBLE;
+    double d;
+    memcpy(&d, &bits, sizeof d);
+    return d;
+}
+
+#define NULL_VAL          ((Value){0})
+#define BOOL_VAL(b)       ((Value){(b) ? JAI_NB_TRUE : JAI_NB_FALSE})
+#define INT_VAL(i)        (jaiNbInt((int64_t)(i)))
+#define FLOAT_VAL(d)      (jaiNbFloat((double)(d)))
+#define OBJ_VAL(o)        ((Value){(uint64_t)(uintptr_t)(o)})
+
+#define IS_NULL(v)        ((v).bits == 0)
+#define IS_BOOL(v)        (((v).bits | 1u) == JAI_NB_TRUE)
+#define IS_INT(v)         ((v).bits >= JAI_NB_INT_BOX)
+#define IS_FLOAT(v)       ((v).bits - JAI_NB_DOUBLE < JAI_NB_INT_BOX - JAI_NB_DOUBLE)
+#define IS_NUMBER(v)      ((v).bits >= JAI_NB_DOUBLE)
+#define IS_OBJ(v)         ((v).bits - 4u < JAI_NB_OBJ_END - 4u)
+
+#define AS_BOOL(v)        ((bool)((v).bits & 1u))
+#define AS_INT(v)         (jaiNbAsInt(v))
+#define AS_FLOAT(v)       (jaiNbAsFloat(v))
+#define AS_OBJ(v)         ((Obj *)(uintptr_t)((v).bits & JAI_NB_PTR_MASK))
+
+/* An int that is in a heap cell: what the collector has to keep alive. */
+#define JAI_NB_IS_INT_BOX(v) ((v).bits - JAI_NB_INT_BOX < JAI_NB_INT - JAI_NB_INT_BOX)
+
+JAI_INLINE ValueType jaiValueType(Value v) {
+    if (v.bits >= JAI_NB_INT_BOX) return VAL_INT;
+    if (v.bits >= JAI_NB_DOUBLE)  return VAL_FLOAT;
+    if (v.bits > JAI_NB_TRUE)     return VAL_OBJ;
+    return v.bits == 0 ? VAL_NULL : VAL_BOOL;
+}
+
+#else
+
 typedef struct {
     ValueType type;
     union {
@@ -65,6 +183,8 @@ typedef struct {
 
 JAI_INLINE ValueType jaiValueType(Value v) { return v.type; }
 
+#endif /* JAI_NANBOX */
+
 JAI_INLINE double jaiAsDouble(Value v) {
     return IS_INT(v) ? (double)AS_INT(v) : AS_FLOAT(v);
 }
@@ -81,6 +201,7 @@ struct Obj {
     bool     isMarked;
     bool     subFlag;
     bool     subFlag2;
+    uint8_t  gcBits;   /* generation state, gc.c's alone (JAI_GC_* in gc.h) */
     Obj     *next;
 };
 
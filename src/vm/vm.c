@@ -11,10 +11,25 @@
  *   3. No setjmp/longjmp: a raise sets vm.pendingException and jumps to
  *      `vmThrow`, which walks handlers and frames explicitly.
  */
+/* Feature macros must precede every include: MAP_ANON and MAP_NORESERVE are
+ * outside C11, and glibc hides them even under _POSIX_C_SOURCE, so Linux asks
+ * for the default set as well. */
+#if !defined(_POSIX_C_SOURCE)
+#  define _POSIX_C_SOURCE 200809L
+#endif
+#if defined(__APPLE__) && !defined(_DARWIN_C_SOURCE)
+#  define _DARWIN_C_SOURCE
+#endif
+#if defined(__linux__) && !defined(_DEFAULT_SOURCE)
+#  define _DEFAULT_SOURCE
+#endif
+
 #include <inttypes.h>
 #include <math.h>
 #include <signal.h>
 #include <stdlib.h>
+#include <sys/mman.h>
+#include <unistd.h>
 
 #include "vm/vm.h"
 #include "vm/jit/jit.h"
@@ -43,12 +58,6 @@ static int sFinallyPending;
  * nest strictly, so one saved index is enough. */
 static int sThunkFrame = -1;
 
-/* Handler sentinel for PUSH_FINALLY: matches every exception like a catch-all,
- * but does not consume it. UINT32_MAX is the catch-all constant index from
- * spec §3.8, so the finally marker sits one below it. */
-#define JAI_HANDLER_CATCH_ALL UINT32_MAX
-#define JAI_HANDLER_FINALLY   (UINT32_MAX - 1u)
-
 /* Set from SIGINT so a runaway program can be stopped at the LOOP safepoint. */
 /* 0 = nothing, 1 = Ctrl-C, 2 = a sampling tick from the JIT's timer.
  *
@@ -98,6 +107,15 @@ static InlineCache *cacheAt(Chunk *chunk, uint16_t index) {
     return &chunk->caches[index];
 }
 
+/* A cache line belongs to the running function's chunk -- only the
+ * interpreter fills one, and always for the frame on top -- so a value it
+ * keeps is a store into that function as far as the collector's generations
+ * go. Call after the store. */
+static inline void icRemember(Value cached) {
+    CallFrame *top = topFrame();
+    if (top != NULL) jaiGCBarrier((Obj *)top->closure->fn, cached);
+}
+
 /* Inline-cache key for a *builtin* receiver at an INVOKE site.
  *
  * A built-in method is a pure function of (receiver type, name), and the name
@@ -207,6 +225,65 @@ void jaiMethodCacheRemoveWhite(void) {
     }
 }
 
+/* Trait vtables, for the megamorphic site that calls a trait method.
+ *
+ * The shared table above costs a hash and a three-field compare per call, and
+ * when two hot (class, name) pairs share a slot it costs a full lookup for
+ * both. A site that ran out of ways on a method some trait declares knows
+ * something that table cannot: the receivers it sees are implementations of
+ * one trait, and the trait's numbering settles which method of each class the
+ * call means. So the site records (trait, index) once, at the overflow, and a
+ * call is left with finding its class's TraitVTable for that trait -- the
+ * first entry, for a class implementing one -- and loading a slot.
+ *
+ * Nothing here invalidates anything. The vtable carries the methods.version
+ * it was filled at and is refilled when that moves, the same contract as
+ * MegaEntry; the trait numbering only ever grows, so the index a site holds
+ * never comes to mean another method. A receiver the vtable has no answer for
+ * -- a class outside the trait that happens to share the name, a non-public
+ * method, a default the class never copied in -- gets NULL_VAL and the caller
+ * goes on to the shared table and the general path, as an IC_MEGA site
+ * would. */
+
+/* Out of ways at an OP_INVOKE site. The last way's prediction is folded into
+ * the first before the way is given over to the trait, so the merged result
+ * kind the compiled tier reads (siteInvokeResultKind) says what it said. */
+static void icGoMegamorphic(InlineCache *ic, ObjClass *klass, ObjString *name) {
+    ic->state = IC_MEGA;
+    ObjTrait *trait = jaiClassTraitFor(klass, name);
+    int index = jaiTraitMethodIndex(trait, name);
+    if (index < 0) return;
+    const int w = JAI_IC_VTABLE_WAY;
+    if (ic->resultKind[w] != JAI_FB_NONE) {
+        ic->resultKind[0] = jaiFeedbackMerge(ic->resultKind[0],
+                                             ic->resultKind[w]);
+    }
+    ic->shapeId[w]    = 0;          /* matches no receiver */
+    ic->resultKind[w] = JAI_FB_NONE;
+    ic->cached[w]     = OBJ_VAL(trait);
+    ic->payload[w]    = (uint32_t)index;
+    ic->state = IC_VTABLE;
+    icRemember(OBJ_VAL(trait));
+}
+
+/* The method an IC_VTABLE site reaches on `klass`, or NULL_VAL. May allocate,
+ * the first time `klass` is seen through this trait. */
+static inline Value vtableMethod(ObjClass *klass, const InlineCache *ic) {
+    ObjTrait *trait = AS_TRAIT(ic->cached[JAI_IC_VTABLE_WAY]);
+    const uint32_t index = ic->payload[JAI_IC_VTABLE_WAY];
+    const TraitVTable *vt = klass->vtables;
+    for (uint16_t i = 0; i < klass->vtableCount; i++, vt++) {
+        if (vt->trait != trait) continue;
+        if (JAI_LIKELY(vt->version == klass->methods.version) &&
+            index < vt->count) {
+            return vt->methods[index];
+        }
+        break;
+    }
+    vt = jaiClassVTable(klass, trait);
+    return vt != NULL && index < vt->count ? vt->methods[index] : NULL_VAL;
+}
+
 /* The key a receiver files its way under: a class's shape for an instance, a
  * type tag for a builtin. The two keyspaces are disjoint by IC_BUILTIN_TAG's
  * high bit, so one site holds both without either matching the other. */
@@ -331,11 +408,161 @@ static void describeValue(Value v, char *buf, size_t size) {
     snprintf(buf, size, "<%s>", jaiTypeNameStatic(v));
 }
 
-static bool ensureStack(int extra) {
+/* ------------------------------------------------------------------ */
+/* Stack reservation                                                    */
+/* ------------------------------------------------------------------ */
+
+/* The value stack and the frame array are each one reservation of address
+ * space, sized for vm.maxDepth, of which only a prefix is committed. A call
+ * that reaches past the committed end commits more -- at least double -- so a
+ * program that never recurses deeply holds a few pages, and one that does
+ * pays for the depth it reaches rather than the depth it might.
+ *
+ * Reserving rather than reallocating is what keeps growth invisible: nothing
+ * moves. Frame `slots` and `base`, open upvalues, handler restore points,
+ * runLoop's cached locals, a native's `args` and whatever compiled code holds
+ * all stay valid, where relocation would have to find and fix every one.
+ *
+ * The committed prefix is never given back; the limit, not the high-water
+ * mark, is what a deep recursion should be held to. */
+typedef struct {
+    uint8_t *base;
+    size_t   reserved;    /* bytes of address space */
+    size_t   committed;   /* bytes from `base` that are readable and writable */
+} StackRegion;
+
+static StackRegion sValueRegion;
+static StackRegion sFrameRegion;
+
+#define STACK_INITIAL_SLOTS  4096
+#define STACK_INITIAL_FRAMES 64
+
+static size_t roundToPage(size_t bytes) {
+    static size_t page;
+    if (page == 0) {
+        long p = sysconf(_SC_PAGESIZE);
+        page = p > 0 ? (size_t)p : 4096u;
+    }
+    return (bytes + page - 1) / page * page;
+}
+
+static bool regionReserve(StackRegion *r, size_t bytes) {
+    int flags = MAP_PRIVATE | MAP_ANON;
+#ifdef MAP_NORESERVE
+    flags |= MAP_NORESERVE;
+#endif
+    memset(r, 0, sizeof *r);
+    size_t size = roundToPage(bytes);
+    void *p = mmap(NULL, size, PROT_NONE, flags, -1, 0);
+    if (p == MAP_FAILED) return false;
+    r->base = (uint8_t *)p;
+    r->reserved = size;
+    return true;
+}
+
+/* Make at least the first `bytes` of the region usable. */
+static bool regionCommit(StackRegion *r, size_t bytes) {
+    if (bytes <= r->committed) return true;
+    if (bytes > r->reserved) return false;
+    size_t want = r->committed * 2;
+    if (want < bytes) want = bytes;
+    want = roundToPage(want);
+    if (want > r->reserved) want = r->reserved;
+    if (mprotect(r->base + r->committed, want - r->committed,
+                 PROT_READ | PROT_WRITE) != 0) {
+        return false;
+    }
+    r->committed = want;
+    return true;
+}
+
+static void regionRelease(StackRegion *r) {
+    if (r->base != NULL) munmap(r->base, r->reserved);
+    memset(r, 0, sizeof *r);
+}
+
+/* Reserve both regions for vm.maxDepth frames, halving the depth when the
+ * address space is not there (a `ulimit -v`, a 32-bit host). */
+static void reserveStacks(void) {
+    if (vm.maxDepth <= 0) vm.maxDepth = JAI_DEFAULT_MAX_DEPTH;
+    for (;;) {
+        size_t slots = (size_t)vm.maxDepth * JAI_SLOTS_PER_FRAME;
+        if (slots < STACK_INITIAL_SLOTS) slots = STACK_INITIAL_SLOTS;
+        if (regionReserve(&sValueRegion, slots * sizeof(Value))) {
+            if (regionReserve(&sFrameRegion,
+                              (size_t)vm.maxDepth * sizeof(CallFrame))) {
+                break;
+            }
+            regionRelease(&sValueRegion);
+        }
+        if (vm.maxDepth / 2 < JAI_MIN_DEPTH) {
+            JAI_PANIC("out of memory: cannot reserve a stack for %d frames",
+                      vm.maxDepth);
+        }
+        vm.maxDepth /= 2;
+    }
+    size_t frames = STACK_INITIAL_FRAMES < vm.maxDepth
+                  ? STACK_INITIAL_FRAMES : (size_t)vm.maxDepth;
+    if (!regionCommit(&sValueRegion, STACK_INITIAL_SLOTS * sizeof(Value)) ||
+        !regionCommit(&sFrameRegion, frames * sizeof(CallFrame))) {
+        JAI_PANIC("out of memory: cannot commit the initial VM stack");
+    }
+    vm.stack = (Value *)sValueRegion.base;
+    vm.stackLimit = (Value *)(sValueRegion.base + sValueRegion.committed);
+    vm.frames = (CallFrame *)sFrameRegion.base;
+    vm.frameCapacity = (int)(sFrameRegion.committed / sizeof(CallFrame));
+    if (vm.frameCapacity > vm.maxDepth) vm.frameCapacity = vm.maxDepth;
+}
+
+static void releaseStacks(void) {
+    regionRelease(&sValueRegion);
+    regionRelease(&sFrameRegion);
+    vm.stack = NULL;
+    vm.stackTop = NULL;
+    vm.stackLimit = NULL;
+    vm.frames = NULL;
+    vm.frameCapacity = 0;
+}
+
+/* Slow path of ensureRoom/ensureStack: `need` is past vm.stackLimit. */
+static JAI_NOINLINE bool growValueStack(const Value *need) {
     if (vm.stack == NULL) return false;
-    if (vm.stackTop + extra <= vm.stack + JAI_STACK_MAX) return true;
-    return jaiThrow(vm.cRuntimeError, "value stack overflow (%d slots)",
-                    JAI_STACK_MAX);
+    size_t slots = (size_t)(need - vm.stack);
+    if (slots > sValueRegion.reserved / sizeof(Value)) {
+        return jaiThrow(vm.cRuntimeError, "value stack overflow (%zu slots)",
+                        sValueRegion.reserved / sizeof(Value));
+    }
+    if (!regionCommit(&sValueRegion, slots * sizeof(Value))) {
+        return jaiThrow(vm.cRuntimeError,
+                        "out of memory growing the value stack to %zu slots",
+                        slots);
+    }
+    vm.stackLimit = (Value *)(sValueRegion.base + sValueRegion.committed);
+    return true;
+}
+
+/* Slow path of pushFrame: every committed frame is in use. */
+static JAI_NOINLINE bool growFrames(void) {
+    if (vm.frameCapacity >= vm.maxDepth) {
+        return jaiThrow(vm.cRecursionError,
+                        "maximum recursion depth exceeded (%d frames)",
+                        vm.maxDepth);
+    }
+    if (!regionCommit(&sFrameRegion,
+                      ((size_t)vm.frameCapacity + 1) * sizeof(CallFrame))) {
+        return jaiThrow(vm.cRuntimeError,
+                        "out of memory growing the call stack past %d frames",
+                        vm.frameCapacity);
+    }
+    size_t committed = sFrameRegion.committed / sizeof(CallFrame);
+    vm.frameCapacity = committed < (size_t)vm.maxDepth ? (int)committed
+                                                       : vm.maxDepth;
+    return true;
+}
+
+static bool ensureStack(int extra) {
+    if (JAI_LIKELY(vm.stackTop + extra <= vm.stackLimit)) return true;
+    return growValueStack(vm.stackTop + extra);
 }
 
 /* ------------------------------------------------------------------ */
@@ -350,36 +577,61 @@ void jaiPopRoots(int n)     { jaiGCPopRoots(n); }
 /* Tracebacks                                                           */
 /* ------------------------------------------------------------------ */
 
-/* A traceback captured at the moment an exception escaped, before the frames
- * that produced it were popped. The names are copied into `blob` because the
- * ObjStrings they came from may be collected before the report is printed. */
+/* The traceback of the exception in flight, recorded lazily.
+ *
+ * Most raises are caught, so the report is almost never printed. Copying every
+ * frame's names at the start of each unwind -- two allocations and a strlen
+ * per frame -- was most of what a caught raise cost beyond the unwind itself.
+ * Instead the unwinder records only the frames it discards, as the function,
+ * module and offset they were at, and the names and spans are looked up when
+ * a report actually asks for them. The functions and modules are marked by
+ * jaiVMMarkTraceback until then, so nothing they point at can be collected
+ * between the escape and the print.
+ *
+ * Newest frame first, the order the unwinder pops them. */
 typedef struct {
-    JaiFrameInfo *frames;
-    int           count;
-    char         *blob;
-    size_t        blobSize;
-} SavedTraceback;
+    ObjFunction *fn;
+    ObjModule   *module;
+    ptrdiff_t    ipOffset;   /* frame->ip - code, as frameSpan reads it */
+} UnwoundFrame;
 
-static SavedTraceback sSavedTb;
+static struct {
+    UnwoundFrame *frames;
+    int           count;
+    int           capacity;
+} sUnwound;
+
+static void recordUnwound(const CallFrame *frame) {
+    if (sUnwound.count == sUnwound.capacity) {
+        int grown = JAI_GROW_CAP(sUnwound.capacity);
+        sUnwound.frames = JAI_GROW_ARRAY(UnwoundFrame, sUnwound.frames,
+                                         sUnwound.capacity, grown);
+        sUnwound.capacity = grown;
+    }
+    UnwoundFrame *u = &sUnwound.frames[sUnwound.count++];
+    u->fn = frame->closure->fn;
+    u->module = frame->module;
+    u->ipOffset = frame->ip - frame->closure->fn->chunk.code;
+}
 
 static void freeSavedTraceback(void) {
-    JAI_FREE_ARRAY(JaiFrameInfo, sSavedTb.frames, sSavedTb.count);
-    JAI_FREE_ARRAY(char, sSavedTb.blob, sSavedTb.blobSize);
-    sSavedTb.frames = NULL;
-    sSavedTb.blob = NULL;
-    sSavedTb.count = 0;
-    sSavedTb.blobSize = 0;
+    sUnwound.count = 0;
 }
 
-/* Source span of the instruction a frame is currently executing. frame->ip
- * points just past the instruction, so step back one byte before looking the
- * span up. */
-static JaiSpan frameSpan(const CallFrame *frame) {
-    const Chunk *chunk = &frame->closure->fn->chunk;
+void jaiVMMarkTraceback(void) {
+    for (int i = 0; i < sUnwound.count; i++) {
+        jaiGCMark((Obj *)sUnwound.frames[i].fn);
+        jaiGCMark((Obj *)sUnwound.frames[i].module);
+    }
+}
+
+/* Source span of the instruction at `ipOffset`, which points just past it, so
+ * step back one byte before looking the span up. */
+static JaiSpan spanAt(const ObjFunction *fn, ptrdiff_t offset) {
+    const Chunk *chunk = &fn->chunk;
     JaiSpan span = JAI_SPAN_NONE;
     if (chunk->code == NULL) return span;
 
-    ptrdiff_t offset = frame->ip - chunk->code;
     if (offset > 0) offset--;
     if (offset < 0) offset = 0;
     if (offset > chunk->count) offset = chunk->count;
@@ -392,21 +644,20 @@ static JaiSpan frameSpan(const CallFrame *frame) {
     return span;
 }
 
-static const char *frameFunctionName(const CallFrame *frame) {
-    ObjFunction *fn = frame->closure->fn;
+static JaiSpan frameSpan(const CallFrame *frame) {
+    return spanAt(frame->closure->fn, frame->ip - frame->closure->fn->chunk.code);
+}
+
+static const char *functionName(const ObjFunction *fn) {
     if (fn == NULL) return "<script>";
     if (fn->qualifiedName != NULL) return fn->qualifiedName->chars;
     if (fn->name != NULL) return fn->name->chars;
     return "<script>";
 }
 
-static const char *frameModulePath(const CallFrame *frame) {
-    if (frame->module != NULL && frame->module->path != NULL) {
-        return frame->module->path->chars;
-    }
-    if (frame->module != NULL && frame->module->name != NULL) {
-        return frame->module->name->chars;
-    }
+static const char *modulePath(const ObjModule *module) {
+    if (module != NULL && module->path != NULL) return module->path->chars;
+    if (module != NULL && module->name != NULL) return module->name->chars;
     return "<unknown>";
 }
 
@@ -418,51 +669,28 @@ JaiFrameInfo *jaiBuildTraceback(int *outCount) {
     JaiFrameInfo *frames = JAI_ALLOC(JaiFrameInfo, n);
     for (int i = 0; i < n; i++) {
         const CallFrame *frame = &vm.frames[i];
-        frames[i].functionName = frameFunctionName(frame);
-        frames[i].modulePath = frameModulePath(frame);
+        frames[i].functionName = functionName(frame->closure->fn);
+        frames[i].modulePath = modulePath(frame->module);
         frames[i].span = frameSpan(frame);
     }
     return frames;
 }
 
-/* Snapshot the live frames with their names copied, so the report survives the
- * unwind that is about to discard them. */
-static void captureTraceback(void) {
-    freeSavedTraceback();
-    int n = vm.frameCount;
-    if (n <= 0) return;
-
-    size_t bytes = 0;
-    for (int i = 0; i < n; i++) {
-        bytes += strlen(frameFunctionName(&vm.frames[i])) + 1;
-        bytes += strlen(frameModulePath(&vm.frames[i])) + 1;
-    }
+/* The recorded traceback, outermost frame first, or NULL when nothing was
+ * recorded. The names point into functions jaiVMMarkTraceback keeps alive. */
+static JaiFrameInfo *buildSavedTraceback(int *outCount) {
+    int n = sUnwound.count;
+    *outCount = n;
+    if (n <= 0) return NULL;
 
-    char *blob = JAI_ALLOC(char, bytes);
     JaiFrameInfo *frames = JAI_ALLOC(JaiFrameInfo, n);
-    size_t at = 0;
     for (int i = 0; i < n; i++) {
-        const CallFrame *frame = &vm.frames[i];
-        const char *fnName = frameFunctionName(frame);
-        const char *modPath = frameModulePath(frame);
-
-        size_t fnLen = strlen(fnName) + 1;
-        memcpy(blob + at, fnName, fnLen);
-        frames[i].functionName = blob + at;
-        at += fnLen;
-
-        size_t modLen = strlen(modPath) + 1;
-        memcpy(blob + at, modPath, modLen);
-        frames[i].modulePath = blob + at;
-        at += modLen;
-
-        frames[i].span = frameSpan(frame);
+        const UnwoundFrame *u = &sUnwound.frames[n - 1 - i];
+        frames[i].functionName = functionName(u->fn);
+        frames[i].modulePath = modulePath(u->module);
+        frames[i].span = spanAt(u->fn, u->ipOffset);
     }
-
-    sSavedTb.frames = frames;
-    sSavedTb.count = n;
-    sSavedTb.blob = blob;
-    sSavedTb.blobSize = bytes;
+    return frames;
 }
 
 /* ------------------------------------------------------------------ */
@@ -537,18 +765,14 @@ void jaiReportUncaught(Value exception) {
         message = fallback;
     }
 
-    bool ownFrames = false;
-    JaiFrameInfo *frames = sSavedTb.frames;
-    int count = sSavedTb.count;
-    if (frames == NULL) {
-        frames = jaiBuildTraceback(&count);
-        ownFrames = true;
-    }
+    int count = 0;
+    JaiFrameInfo *frames = buildSavedTraceback(&count);
+    if (frames == NULL) frames = jaiBuildTraceback(&count);
 
     jaiPrintTraceback(stderr, frames, count, exceptionTypeName(exception),
                       message, gDiags.colorOutput);
 
-    if (ownFrames) JAI_FREE_ARRAY(JaiFrameInfo, frames, count);
+    JAI_FREE_ARRAY(JaiFrameInfo, frames, count);
     freeSavedTraceback();
 }
 
@@ -580,10 +804,37 @@ static void closeUpvalues(Value *last) {
         ObjUpvalue *upvalue = vm.openUpvalues;
         upvalue->closed = *upvalue->location;
         upvalue->location = &upvalue->closed;
+        jaiGCBarrier((Obj *)upvalue, upvalue->closed);
         vm.openUpvalues = upvalue->next;
     }
 }
 
+/* Would OP_CLOSURE, run now with these descriptors, capture exactly what
+ * `cached` holds? Then it may be pushed again instead of built (see
+ * FN_SITE_CLOSURE). A by-reference capture is the same cell only while that
+ * cell is still open on this frame's slot: closeUpvalues moves `location` off
+ * the stack, and captureUpvalue would then make a new one. A by-value capture
+ * is the same when the value is -- a `let` cannot change under a closure. */
+static bool siteClosureFits(const ObjClosure *cached, const CallFrame *frame,
+                            const uint8_t *desc) {
+    for (int i = 0; i < cached->upvalueCount; i++, desc += 3) {
+        uint8_t how = desc[0];
+        uint16_t index = jaiReadU16(desc + 1);
+        bool isLocal = (how & 1u) != 0;
+        const ObjUpvalue *have = cached->upvalues[i];
+        if ((how & 2u) != 0) {
+            Value now = isLocal ? frame->slots[index]
+                                : *frame->closure->upvalues[index]->location;
+            if (!jaiValuesIdentical(have->closed, now)) return false;
+        } else if (isLocal) {
+            if (have->location != frame->slots + index) return false;
+        } else if (have != frame->closure->upvalues[index]) {
+            return false;
+        }
+    }
+    return true;
+}
+
 /* ------------------------------------------------------------------ */
 /* Visibility                                                           */
 /*                                                                      */
@@ -714,11 +965,17 @@ static bool enumMember(ObjEnum *e, ObjString *name, Value *out) {
              * missing. The direct-call sites could special-case this, and one
              * of them did; a tail call could not, because the callee is a
              * value by then. */
-            if (v->ctor == NULL) v->ctor = jaiEnumCtorNew(e, i);
+            if (v->ctor == NULL) {
+                v->ctor = jaiEnumCtorNew(e, i);
+                jaiGCBarrier((Obj *)e, OBJ_VAL(v->ctor));
+            }
             *out = OBJ_VAL(v->ctor);
             return true;
         }
-        if (v->unit == NULL) v->unit = jaiEnumValNew(e, i, NULL, 0);
+        if (v->unit == NULL) {
+            v->unit = jaiEnumValNew(e, i, NULL, 0);
+            jaiGCBarrier((Obj *)e, OBJ_VAL(v->unit));
+        }
         *out = OBJ_VAL(v->unit);
         return true;
     }
@@ -746,7 +1003,7 @@ static bool getPropertyInto(Value receiver, ObjString *name, Value *out,
                             bool raise, InlineCache *ic) {
     if (name == NULL) return false;
 #ifdef JAI_PROP_STATS
-    { extern uint64_t jaiPropRecv[]; jaiPropRecv[IS_OBJ(receiver) ? 8 + (int)AS_OBJ(receiver)->type : (int)receiver.type]++; }
+    { extern uint64_t jaiPropRecv[]; jaiPropRecv[IS_OBJ(receiver) ? 8 + (int)AS_OBJ(receiver)->type : (int)jaiValueType(receiver)]++; }
 #endif
 
     if (IS_INSTANCE(receiver)) {
@@ -851,6 +1108,7 @@ static bool getPropertyInto(Value receiver, ObjString *name, Value *out,
                     ic->shapeId[ic->count] = AS_ENUM(receiver)->shapeId;
                     ic->payload[ic->count] = 0;
                     ic->cached[ic->count] = *out;
+                    icRemember(*out);
                     ic->count++;
                     ic->state = (ic->count == 1) ? IC_MONO : IC_POLY;
                 } else {
@@ -954,6 +1212,7 @@ bool jaiSetProperty(Value receiver, ObjString *name, Value value) {
             return throwFieldKind(info, value);
         }
         inst->fields[info->slot] = value;
+        jaiGCBarrier((Obj *)inst, value);
         return true;
     }
 
@@ -966,10 +1225,16 @@ bool jaiSetProperty(Value receiver, ObjString *name, Value value) {
                             klass->name != NULL ? klass->name->chars : "?",
                             name->chars);
         }
+        /* The compiler thread resolves statics in place, and a Value is two
+         * words: one that changes type waits for it. */
+        const bool retag = jaiValueType(existing) != jaiValueType(value);
+        if (retag) jaiJitHold();
         jaiGCPushRoot(receiver);
         jaiGCPushRoot(value);
         (void)jaiTableSetInterned(&klass->statics, name, value);
+        jaiGCBarrier((Obj *)klass, value);
         jaiGCPopRoots(2);
+        if (retag) jaiJitRelease();
         return true;
     }
 
@@ -1011,21 +1276,42 @@ static int kwRestSlotOf(const ObjFunction *fn) {
     return 1 + (int)fn->arity + ((fn->flags & FN_VARIADIC) ? 1 : 0);
 }
 
+/* The variadic arguments of an FN_REST_VIEW frame, which bindCallArgsSlow
+ * leaves just above its window instead of packing into a list. */
+static inline Value *restViewBase(const CallFrame *frame) {
+    return frame->slots + frameWindowSize(frame->closure->fn);
+}
+
+/* How many there are: the variadic slot's int. Zero for any other frame, and
+ * for a default thunk's, whose window is its own and was never bound. */
+static inline int restViewCount(const CallFrame *frame) {
+    const ObjFunction *fn = frame->closure->fn;
+    if (JAI_LIKELY(!(fn->flags & FN_REST_VIEW))) return 0;
+    Value count = frame->slots[1 + fn->arity];
+    return IS_INT(count) ? (int)AS_INT(count) : 0;
+}
+
 /* Headroom above a frame's window for expression temporaries. maxSlots counts
  * the register window; nested expressions push above it. */
 #define JAI_FRAME_SLACK 256
 
+/* Stack a frame can touch from its base. maxSlots is max_slot + max_depth, but
+ * stackTop starts at the END of the window and operands push from there, so
+ * the operand depth is paid twice. With a fixed-size stack the difference was
+ * absorbed by the rest of the array; a committed region must cover it, or a
+ * 17,000-element list literal runs off the end. */
+static inline int frameRoom(int window) {
+    return 2 * window + JAI_FRAME_SLACK;
+}
+
 static bool ensureRoom(const Value *from, int slots) {
-    if (vm.stack != NULL && from + slots <= vm.stack + JAI_STACK_MAX) return true;
-    return jaiThrow(vm.cRuntimeError, "value stack overflow (%d slots)",
-                    JAI_STACK_MAX);
+    if (JAI_LIKELY(from + slots <= vm.stackLimit)) return true;
+    return growValueStack(from + slots);
 }
 
 static bool pushFrame(ObjClosure *closure, Value *slotBase) {
-    if (vm.frameCount >= vm.frameCapacity) {
-        return jaiThrow(vm.cRecursionError,
-                        "maximum recursion depth exceeded (%d frames)",
-                        vm.frameCapacity);
+    if (JAI_UNLIKELY(vm.frameCount >= vm.frameCapacity) && !growFrames()) {
+        return false;
     }
     CallFrame *frame = &vm.frames[vm.frameCount++];
     frame->closure = closure;
@@ -1049,6 +1335,43 @@ static bool pushFrame(ObjClosure *closure, Value *slotBase) {
  * leaves a value on the stack and ends with OP_RETURN. Spec §6 requires this
  * to happen on every call, which is what keeps a mutable default from being
  * shared between calls. */
+/* A default that is one literal -- `= 0`, `= "relu"`, `= null`, `= true` --
+ * compiles to a two-instruction thunk: a push and OP_RETURN. Running it costs
+ * a frame and a nested run() per omitted argument per call, which was most of
+ * what `dense(10, activation: "tanh")` spent; reading the literal gives the
+ * same value, since nothing a constant push can produce is mutable. */
+static bool constantDefault(const ObjFunction *fn, uint32_t at, Value *out) {
+    const Chunk *chunk = &fn->chunk;
+    const uint8_t *code = chunk->code;
+    uint32_t n = (uint32_t)chunk->count;
+    Value value;
+    uint32_t next;
+    switch ((OpCode)code[at]) {
+    case OP_NULL:  value = NULL_VAL;       next = at + 1; break;
+    case OP_TRUE:  value = BOOL_VAL(true);  next = at + 1; break;
+    case OP_FALSE: value = BOOL_VAL(false); next = at + 1; break;
+    case OP_INT:
+        if (at + 3 > n) return false;
+        value = INT_VAL(jaiReadI16(code + at + 1));
+        next = at + 3;
+        break;
+    case OP_CONST: {
+        if (at + 4 > n) return false;
+        uint32_t k = jaiReadU24(code + at + 1);
+        if ((int)k >= chunk->constants.count) return false;
+        value = chunk->constants.data[k];
+        if (IS_FUNCTION(value)) return false;   /* a closure is built, not pushed */
+        next = at + 4;
+        break;
+    }
+    default:
+        return false;
+    }
+    if (next >= n || code[next] != OP_RETURN) return false;
+    *out = value;
+    return true;
+}
+
 static bool evalDefaultThunk(ObjClosure *closure, uint32_t codeOffset,
                              Value *out) {
     ObjFunction *fn = closure->fn;
@@ -1057,8 +1380,9 @@ static bool evalDefaultThunk(ObjClosure *closure, uint32_t codeOffset,
                         "corrupt default-value thunk in function '%s'",
                         fn->name != NULL ? fn->name->chars : "?");
     }
+    if (constantDefault(fn, codeOffset, out)) return true;
     int window = frameWindowSize(fn);
-    if (!ensureRoom(vm.stackTop, window + JAI_FRAME_SLACK)) return false;
+    if (!ensureRoom(vm.stackTop, frameRoom(window))) return false;
 
     Value *base = vm.stackTop;
     *vm.stackTop++ = OBJ_VAL(closure);
@@ -1118,25 +1442,36 @@ static bool bindCallArgsSlow(ObjClosure *closure, int argc, Value *slotBase) {
     }
 
     int window = frameWindowSize(fn);
-    if (!ensureRoom(slotBase, window + JAI_FRAME_SLACK)) return false;
+    int extra = variadic && argc > arity ? argc - arity : 0;
+    bool viewed = (fn->flags & FN_REST_VIEW) != 0;
+    if (!ensureRoom(slotBase, frameRoom(window) + (viewed ? extra : 0))) {
+        return false;
+    }
 
     /* Pack the variadic tail first, while the extra arguments are still live
-     * on the stack and therefore visible to a collection. */
+     * on the stack and therefore visible to a collection. A viewed tail is not
+     * packed at all: it moves up above the window, where the frame's locals
+     * cannot reach it and its own operands start after it. */
     ObjList *rest = NULL;
-    if (variadic) {
-        int extra = argc > arity ? argc - arity : 0;
+    if (variadic && viewed) {
+        memmove(slotBase + window, slotBase + 1 + arity,
+                sizeof(Value) * (size_t)extra);
+        argc -= extra;
+    } else if (variadic) {
         rest = jaiListNew(extra);
         for (int i = 0; i < extra; i++) rest->items[i] = slotBase[1 + arity + i];
         rest->count = extra;
-        if (argc > arity) argc = arity;
+        argc -= extra;
     }
+    if (!viewed) extra = 0;
 
     /* Every slot the frame owns must hold a real Value before anything can
      * allocate: the collector scans the whole window once stackTop is above it.
      * Nothing between jaiListNew above and this fill allocates. */
     for (int i = 1 + argc; i < window; i++) slotBase[i] = NULL_VAL;
     if (rest != NULL) slotBase[arity + 1] = OBJ_VAL(rest);
-    vm.stackTop = slotBase + window;
+    if (variadic && viewed) slotBase[arity + 1] = INT_VAL(extra);
+    vm.stackTop = slotBase + window + extra;
 
     for (int i = argc; i < arity; i++) {
         int thunk = i - required;
@@ -1154,7 +1489,7 @@ static bool bindCallArgsSlow(ObjClosure *closure, int argc, Value *slotBase) {
     if (fn->flags & FN_KWREST) {
         slotBase[kwRestSlotOf(fn)] = OBJ_VAL(jaiDictNew());
     }
-    vm.stackTop = slotBase + window;
+    vm.stackTop = slotBase + window + extra;
     return true;
 }
 
@@ -1174,7 +1509,7 @@ static inline bool bindCallArgs(ObjClosure *closure, int argc, Value *slotBase)
     if (JAI_LIKELY(argc == arity && fn->defaultCount == 0 &&
                    (fn->flags & (FN_VARIADIC | FN_KWREST)) == 0)) {
         int window = (int)fn->maxSlots > 1 + arity ? (int)fn->maxSlots : 1 + arity;
-        if (!ensureRoom(slotBase, window + JAI_FRAME_SLACK)) return false;
+        if (!ensureRoom(slotBase, frameRoom(window))) return false;
         /* The collector scans the whole window as soon as stackTop is above
          * it, so no slot may be left holding whatever the last frame did. */
         for (int i = 1 + argc; i < window; i++) slotBase[i] = NULL_VAL;
@@ -1547,7 +1882,7 @@ bool jaiCallValue(Value callee, int argc, Value *args, Value *out) {
 bool jaiJitFinishDeopt(ObjClosure *closure, Value *out) {
     ObjFunction *fn = closure->fn;
     int window = frameWindowSize(fn);
-    if (!ensureRoom(vm.stackTop, window + JAI_FRAME_SLACK)) return false;
+    if (!ensureRoom(vm.stackTop, frameRoom(window))) return false;
 
     Value *base = vm.stackTop;
     *vm.stackTop++ = OBJ_VAL(closure);
@@ -1747,13 +2082,21 @@ bool jaiInvokeMethod(Value receiver, ObjString *name, int argc, Value *args,
  *
  * Raises rather than returning a bare false for a missing method: the caller is
  * compiled code with no name or receiver left to build a message from. */
-bool jaiInvokeMethodByName(ObjString *name, Value *argsWithReceiver, int count,
-                           Value *out) {
+bool jaiInvokeMethodByName(ObjString *name, const InlineCache *site,
+                           Value *argsWithReceiver, int count, Value *out) {
     if (name == NULL || count < 1) return false;
     const Value receiver = argsWithReceiver[0];
 
     if (IS_INSTANCE(receiver)) {
         ObjClass *klass = AS_INSTANCE(receiver)->klass;
+        if (klass != NULL && site != NULL && site->state == IC_VTABLE) {
+            Value method = vtableMethod(klass, site);
+            if (!IS_NULL(method)) {
+                vm.icHits++;
+                return jaiCallMethodWithReceiver(method, argsWithReceiver,
+                                                 count, out);
+            }
+        }
         if (klass != NULL) {
             MegaEntry *me = &sMegaCache[megaSlot(klass, name)];
             if (me->klass == klass && me->name == name &&
@@ -2458,6 +2801,7 @@ static bool indexSet(Value container, Value index, Value value) {
         if (!jaiCheckKind(list->elemKind, value, "an element")) return false;
         list->items[at] = value;
         jaiListTouch(list);      /* the count is unchanged; only the version tells */
+        jaiGCBarrier((Obj *)list, value);
         return true;
     }
     if (IS_DICT(container)) {
@@ -2590,7 +2934,7 @@ static bool callDeferred(CallFrame *definer, Value deferred) {
 
     ObjClosure *thunk = AS_CLOSURE(deferred);
     Value *base = vm.stackTop;
-    if (!ensureRoom(base, (int)thunk->fn->maxSlots + JAI_FRAME_SLACK)) return false;
+    if (!ensureRoom(base, frameRoom((int)thunk->fn->maxSlots))) return false;
 
     int frameBase = vm.frameCount;
     if (!pushFrame(thunk, definer->slots)) return false;
@@ -2688,6 +3032,7 @@ static void popFrameForUnwind(void) {
     /* This call produced no value, and the chunk sResultSite points into is
      * kept alive only by the frames being discarded here. */
     sResultSite.ic = NULL;
+    recordUnwound(frame);
     (void)runFrameDefers(frame);
     closeUpvalues(frame->base);
     if (vm.handlers.count > frame->handlerBase) vm.handlers.count = frame->handlerBase;
@@ -2723,11 +3068,9 @@ static bool unwindToHandler(int base, uint32_t throwOffset) {
     Value exception = vm.pendingException;
     bool haveOffset = true;
 
-    /* Snapshot the call chain before any of it is discarded. Handlers are the
-     * common case, so this is thrown away more often than it is used — but an
-     * exception is already an exceptional cost, and a traceback assembled
-     * after the fact would be missing exactly the frames that matter. */
-    captureTraceback();
+    /* A fresh unwind starts a fresh traceback; popFrameForUnwind records each
+     * frame as it goes, and an escape adds the ones left standing. */
+    freeSavedTraceback();
 
     while (vm.frameCount > base) {
         int frameIndex = vm.frameCount - 1;
@@ -2742,7 +3085,9 @@ static bool unwindToHandler(int base, uint32_t throwOffset) {
         }
 
         /* Dynamic handlers first: they were pushed by the code actually
-         * executing and are strictly more precise than the static table. */
+         * executing and are strictly more precise than the static table. The
+         * emitter no longer pushes any -- every `try` is table rows -- but an
+         * image from before JAIC_VERSION_EXCDEPTH still does. */
         for (int i = vm.handlers.count - 1; i >= frame->handlerBase; i--) {
             ExcHandler *h = &vm.handlers.data[i];
             if (h->frameIndex != frameIndex) continue;
@@ -2757,7 +3102,10 @@ static bool unwindToHandler(int base, uint32_t throwOffset) {
         }
 
         /* Then the per-function exception table (spec §3.8): the narrowest
-         * region covering the faulting instruction wins. */
+         * region covering the faulting instruction wins. A nested `try` is
+         * strictly inside its parent, handlers and all, so narrowest is
+         * innermost; the clauses of one `try` share a region and are tried in
+         * the order written. */
         const ExceptionEntry *best = NULL;
         for (uint16_t i = 0; i < fn->exceptionCount; i++) {
             const ExceptionEntry *e = &fn->exceptions[i];
@@ -2768,11 +3116,14 @@ static bool unwindToHandler(int base, uint32_t throwOffset) {
             }
         }
         if (best != NULL) {
-            /* Temporaries are gone; locals survive. The handler code is
-             * generated against exactly this depth. */
-            Value *restore = frame->slots + frameWindowSize(fn);
+            /* Temporaries above the region's entry depth are gone; locals and
+             * whatever an enclosing loop keeps on the stack survive. The
+             * handler code is generated against exactly this depth. */
+            Value *restore = frame->slots + frameWindowSize(fn) +
+                             restViewCount(frame) + best->depth;
             vm.handlers.count = frame->handlerBase;
-            enterHandler(frameIndex, best->handler, restore, false);
+            enterHandler(frameIndex, best->handler, restore,
+                         best->typeConst == JAI_HANDLER_FINALLY);
             freeSavedTraceback();
             return true;
         }
@@ -2782,6 +3133,7 @@ static bool unwindToHandler(int base, uint32_t throwOffset) {
         exception = vm.pendingException;   /* a defer may have replaced it */
     }
 
+    for (int i = vm.frameCount - 1; i >= 0; i--) recordUnwound(&vm.frames[i]);
     vm.hasException = true;
     vm.pendingException = exception;
     sFinallyPending = 0;
@@ -2820,6 +3172,9 @@ static void removeInterruptHandler(void) {
 static bool safepoint(void) {
     if (JAI_UNLIKELY(jaiInterrupted == 2)) {
         jaiInterrupted = 0;
+        /* Bodies the compiler thread has finished go in here, between
+         * instructions, where no compiled frame is mid-flight. */
+        jaiJitInstallReady();
         if (vm.frameCount > 0) {
             CallFrame *top = &vm.frames[vm.frameCount - 1];
             if (!jaiJitSample(top->closure,
@@ -2957,18 +3312,115 @@ static const char *parameterName(const CalleeShape *shape, int index) {
     return declared != NULL ? declared : "?";
 }
 
+/* The closure whose default thunks a keyword call to `callee` runs, or NULL
+ * when there is none to run (a bare ObjFunction, a class with no initializer
+ * closure). */
+static ObjClosure *defaultClosureOf(Value callee) {
+    Value inner = callee;
+    while (IS_BOUND(inner)) inner = AS_BOUND(inner)->method;
+    if (IS_CLASS(inner)) inner = AS_CLASS(inner)->initializer;
+    return IS_CLOSURE(inner) ? AS_CLOSURE(inner) : NULL;
+}
+
+/* An OP_CALL_KW_IC cache line, laid over InlineCache. Monomorphic: a site
+ * that meets a second callee rebinds by name and takes the new one over.
+ *
+ *   cached[0]      the ObjFunction or ObjNative the names were bound against
+ *   payload        KW_CACHE_MAX_NAMES bytes: the parameter each name fills
+ *   shapeId[0..1]  the parameters the call leaves to their defaults, a bit each
+ *   shapeId[2]     the callee's arity, which is the argc the window ends at
+ *   shapeId[3]     1 when a native is reached through a bound receiver
+ *
+ * Only a call the slow path bound in full is recorded, so a hit cannot be an
+ * error: no name missed, none repeated a positional, every hole has a default.
+ * Keyword-rest callees and positional overflow are never recorded. */
+#define KW_CACHE_MAX_NAMES  ((int)sizeof(((InlineCache *)0)->payload))
+#define KW_CACHE_MAX_PARAMS 64
+
+static Value keywordTarget(Value callee, int *selfOffset) {
+    ObjFunction *fn = NULL;
+    *selfOffset = 0;
+    if (targetFunctionOf(callee, &fn)) return OBJ_VAL(fn);
+    ObjNative *native = targetNativeOf(callee);
+    if (native == NULL) return NULL_VAL;
+    *selfOffset = IS_BOUND(callee) ? 1 : 0;
+    return OBJ_VAL(native);
+}
+
+/* A repeat call at a cached site: the positional arguments are already where
+ * they belong, so the keyword values are permuted into their slots and the
+ * holes filled. Returns the argument count, -1 with an exception pending, or
+ * -2 when the line does not describe this callee. */
+static int keywordCacheHit(const InlineCache *ic, int posCount, int kwCount) {
+    Value callee = vm.stackTop[-posCount - kwCount - 1];
+    int selfOffset;
+    Value target = keywordTarget(callee, &selfOffset);
+    if (!IS_OBJ(target) || !IS_OBJ(ic->cached[0]) ||
+        AS_OBJ(target) != AS_OBJ(ic->cached[0]) ||
+        (uint32_t)selfOffset != ic->shapeId[3]) {
+        return -2;
+    }
+
+    int arity = (int)ic->shapeId[2];
+    uint64_t holes = (uint64_t)ic->shapeId[0] | ((uint64_t)ic->shapeId[1] << 32);
+    /* Resolved before anything moves: past the permutation there is no
+     * handing the call back to the slow path. */
+    ObjClosure *closure = NULL;
+    if (holes != 0 && IS_FUNCTION(target)) {
+        closure = defaultClosureOf(callee);
+        if (closure == NULL) return -2;   /* the slow path says why */
+    }
+
+    if (!ensureRoom(vm.stackTop, arity + JAI_FRAME_SLACK)) return -1;
+    Value *argBase = vm.stackTop - posCount - kwCount;
+    const uint8_t *slotOf = (const uint8_t *)ic->payload;
+
+    Value named[KW_CACHE_MAX_NAMES];
+    for (int i = 0; i < kwCount; i++) named[i] = argBase[posCount + i];
+    for (uint64_t h = holes; h != 0; h &= h - 1) {
+        argBase[__builtin_ctzll(h)] = NULL_VAL;
+    }
+    for (int i = 0; i < kwCount; i++) argBase[slotOf[i]] = named[i];
+    vm.stackTop = argBase + arity;
+
+    /* A native reads an omitted optional argument as null, which the holes
+     * already hold. */
+    if (holes == 0 || !IS_FUNCTION(target)) return arity;
+    ObjFunction *fn = AS_FUNCTION(target);
+    int required = (int)fn->arity - (int)fn->defaultCount;
+    for (uint64_t h = holes; h != 0; h &= h - 1) {
+        int slot = __builtin_ctzll(h);
+        /* The thunk runs above the window, which is all on the stack and so
+         * already visible to a collection. */
+        Value def;
+        if (!evalDefaultThunk(closure, fn->defaultOffsets[slot - required],
+                              &def)) {
+            return -1;
+        }
+        vm.stackTop[-arity + slot] = def;
+    }
+    return arity;
+}
+
 /* Turn `f(a, b, key: v)` into the flat positional window the frame protocol
  * wants. Missing middle parameters get their defaults here rather than in
  * bindCallArgs, which can only fill a contiguous trailing run.
  *
+ * `ic` is the site's cache line for OP_CALL_KW_IC, NULL for OP_CALL_KW: a hit
+ * skips the name matching entirely, and a full bind by name refills it.
+ *
  * Returns the new argument count, or -1 with an exception pending. */
-static int prepareKeywordCall(int posCount, ObjTuple *names,
+static int prepareKeywordCall(int posCount, ObjTuple *names, InlineCache *ic,
                               ObjDict **outKwRest) {
     int kwCount = (int)names->count;
     int total = posCount + kwCount;
+    *outKwRest = NULL;
+    if (ic != NULL && ic->state == IC_MONO) {
+        int argc = keywordCacheHit(ic, posCount, kwCount);
+        if (argc != -2) return argc;
+    }
     Value *argBase = vm.stackTop - total;
     Value callee = argBase[-1];
-    *outKwRest = NULL;
 
     CalleeShape shape;
     memset(&shape, 0, sizeof shape);
@@ -3025,6 +3477,7 @@ static int prepareKeywordCall(int posCount, ObjTuple *names,
         argBase = vm.stackTop - total;   /* the allocation may have collected */
     }
 
+    uint8_t slotOf[KW_CACHE_MAX_NAMES];
     for (int i = 0; i < kwCount; i++) {
         Value nameValue = names->items[i];
         Value argument = argBase[posCount + i];
@@ -3054,6 +3507,12 @@ static int prepareKeywordCall(int posCount, ObjTuple *names,
         }
         filled[index] = argument;
         present[index] = true;
+        if (i < KW_CACHE_MAX_NAMES) slotOf[i] = (uint8_t)index;
+    }
+
+    uint64_t holes = 0;
+    for (int i = 0; i < bound && i < KW_CACHE_MAX_PARAMS; i++) {
+        if (!present[i]) holes |= (uint64_t)1 << i;
     }
 
     int required = shape.required;
@@ -3082,13 +3541,7 @@ static int prepareKeywordCall(int posCount, ObjTuple *names,
             present[i] = true;
             continue;
         }
-        ObjClosure *closure = IS_CLOSURE(callee) ? AS_CLOSURE(callee) : NULL;
-        if (closure == NULL) {
-            Value inner = callee;
-            while (IS_BOUND(inner)) inner = AS_BOUND(inner)->method;
-            if (IS_CLASS(inner)) inner = AS_CLASS(inner)->initializer;
-            if (IS_CLOSURE(inner)) closure = AS_CLOSURE(inner);
-        }
+        ObjClosure *closure = defaultClosureOf(callee);
         if (closure == NULL) {
             vm.stackTop -= rooted;
             if (kwRest != NULL) jaiGCPopRoot();
@@ -3128,10 +3581,42 @@ static int prepareKeywordCall(int posCount, ObjTuple *names,
     if (kwRest != NULL) {
         jaiGCPopRoot();
         *outKwRest = kwRest;
+    } else if (ic != NULL && extra == 0 && kwCount <= KW_CACHE_MAX_NAMES &&
+               bound == arity && arity <= KW_CACHE_MAX_PARAMS) {
+        ic->state = IC_MONO;
+        ic->count = 1;
+        ic->cached[0] = shape.fn != NULL ? OBJ_VAL(shape.fn) : OBJ_VAL(shape.native);
+        icRemember(ic->cached[0]);
+        memcpy(ic->payload, slotOf, (size_t)kwCount);
+        ic->shapeId[0] = (uint32_t)holes;
+        ic->shapeId[1] = (uint32_t)(holes >> 32);
+        ic->shapeId[2] = (uint32_t)arity;
+        ic->shapeId[3] = (uint32_t)shape.selfOffset;
     }
     return bound + extra;
 }
 
+/* OP_CALL_KW and OP_CALL_KW_IC past their operands: bind the window, call, and
+ * hand a keyword-rest dict to the frame that declared one. */
+static CallOutcome callKeyword(int posCount, ObjTuple *names, InlineCache *ic) {
+    ObjDict *kwRest = NULL;
+    int argc = prepareKeywordCall(posCount, names, ic, &kwRest);
+    if (argc < 0) return CALL_ERROR;
+
+    Value callee = vm.stackTop[-argc - 1];
+    if (kwRest != NULL) jaiGCPushRoot(OBJ_VAL(kwRest));
+    CallOutcome outcome = invokeCallable(callee, argc);
+    if (kwRest != NULL) {
+        if (outcome == CALL_FRAME) {
+            CallFrame *calleeFrame = &vm.frames[vm.frameCount - 1];
+            int slot = kwRestSlotOf(calleeFrame->closure->fn);
+            calleeFrame->slots[slot] = OBJ_VAL(kwRest);
+        }
+        jaiGCPopRoot();
+    }
+    return outcome;
+}
+
 /* ------------------------------------------------------------------ */
 /* Type tests                                                           */
 /* ------------------------------------------------------------------ */
@@ -3279,6 +3764,7 @@ static bool classDeclareField(ObjClass *klass, ObjString *name, uint8_t info) {
     if (field->isStatic) {
         jaiGCPushRoot(OBJ_VAL(klass));
         (void)jaiTableSetInterned(&klass->statics, name, NULL_VAL);
+        jaiGCBarrier((Obj *)klass, OBJ_VAL(name));
         jaiGCPopRoot();
     }
     return true;
@@ -3336,6 +3822,7 @@ static Obj *classSpecInstantiate(Value spec) {
             }
             jaiTableSet(&trait->required, required->items[i],
                         required->items[i + 1]);
+            jaiGCBarrier((Obj *)trait, required->items[i]);
         }
         jaiGCPopRoot();
         return (Obj *)trait;
@@ -3398,7 +3885,17 @@ uint64_t jaiPropRecv[32];
 /* The interpreter loop                                                 */
 /* ------------------------------------------------------------------ */
 
-#if JAI_COMPUTED_GOTO
+#if JAI_INTERP_TAILCALL
+/* `make INTERP=tailcall`: every case below is cut out into a function of its
+ * own by scripts/gen_tailcall.py, and dispatch is the tail call each of those
+ * functions ends in (tcNext; see "Tail-call dispatch" above runLoop). There is
+ * nothing for a hint to buy here. The hint exists because computed goto shares
+ * one indirect branch between all opcodes, and in this build every handler has
+ * its own. */
+#  define VM_CASE(name)  L_##name
+#  define VM_NEXT()      goto tcNext
+#  define VM_NEXT_HINT(nextOp)  do { (void)(nextOp); VM_NEXT(); } while (0)
+#elif JAI_COMPUTED_GOTO
 #  define VM_CASE(name)  L_##name
 #  ifdef JAI_OPCODE_STATS
 #    define VM_NEXT()      do { DISPATCH_TRACE(); instStart = ip;                \
@@ -3698,16 +4195,19 @@ static bool formatViaUserStr(ObjModule *module, ObjString *name, int count,
 
 /* Ordered comparison of two same-typed numbers, decided in the dispatch arm.
  * The generic path calls jaiValueCompare, which was 7.2% of loop_sum's whole
- * run just to answer `int < int`. Falls through to BINARY on anything else.
+ * run just to answer `int < int`. Falls through to BINARY on anything else;
+ * what it does answer counts toward quickening the site to `op`'s _II or _FF
+ * form.
  * NaN is deliberately excluded: an unordered pair is a TypeError here (spec
  * §3.3), not a false, and compareDoubles is the one that reports it. */
-#define CMP_FAST(cop)                                                          \
+#define CMP_FAST(cop, op)                                                      \
     do {                                                                       \
         Value _b = stackTop[-1], _a = stackTop[-2];                            \
         if (JAI_LIKELY(IS_INT(_a) && IS_INT(_b))) {                            \
             bool _r = AS_INT(_a) cop AS_INT(_b);                               \
             DROP(1);                                                           \
             stackTop[-1] = BOOL_VAL(_r);                                       \
+            QUICKEN(op##_II);                                                  \
             VM_NEXT();                                                         \
         }                                                                      \
         if (IS_FLOAT(_a) && IS_FLOAT(_b)) {                                    \
@@ -3716,6 +4216,7 @@ static bool formatViaUserStr(ObjModule *module, ObjString *name, int count,
                 bool _r = _x cop _y;                                           \
                 DROP(1);                                                       \
                 stackTop[-1] = BOOL_VAL(_r);                                   \
+                QUICKEN(op##_FF);                                              \
                 VM_NEXT();                                                     \
             }                                                                  \
         }                                                                      \
@@ -3733,6 +4234,160 @@ static bool formatViaUserStr(ObjModule *module, ObjString *name, int count,
         }                                                                      \
     } while (0)
 
+/* ------------------------------------------------------------------ */
+/* Quickening                                                           */
+/* ------------------------------------------------------------------ */
+
+/* The checker knows that `i < n` compares two ints, and none of that reaches
+ * the bytecode: OP_LT tests both tags on every dispatch, OP_DIV and
+ * OP_SET_INDEX go through a call for the commonest case they have, and a
+ * float guard on a fused compare-and-branch takes the slow path every time.
+ * The JIT answers those questions once per compile; a function it declines,
+ * or a build without it, answered them per instruction forever.
+ *
+ * So the interpreter answers them per SITE. A generic handler whose fast path
+ * serves an instruction notes which quickened form (chunk.h) would have served
+ * it too; QUICKEN_AFTER sightings of the same form in a row and the opcode byte
+ * is rewritten in place. The quickened handler re-checks only what the
+ * sightings cannot promise. A tag that does not match puts the generic byte
+ * back -- a miss -- and runs the generic handler from the top; an overflow, a
+ * zero divisor, a NaN or an index out of range runs it without the rewrite,
+ * since those are the generic form's errors and not a change of kind. After
+ * QUICKEN_MAX_MISSES a site stays generic for the rest of the run.
+ *
+ * The per-site state cannot live in the chunk: the .jaic is the chunk's
+ * format, and the code there stays generic (jaiChunkCopyGeneric). It lives in
+ * a table hashed by instruction address instead. Two sites that share an
+ * entry only disturb each other's counting; neither can be rewritten into a
+ * form it did not run, because the rewrite is at the address that observed.
+ *
+ * The background compile reads code while this writes it, but reads every
+ * opcode through jaiOpGeneric, and a quickened byte and its generic form fold
+ * to the same thing -- so a single-byte store is all the care it needs. */
+#define QUICK_SITES         (1u << 15)
+#define QUICKEN_AFTER       8u
+#define QUICKEN_MAX_MISSES  4u
+
+/* Low byte: the quickened form last seen. Bits 8-11: sightings of it in a
+ * row. Bits 12-15: misses. A site that ran out of misses is all ones, which
+ * no live entry can be since QUICKEN_MAX_MISSES < 15. */
+#define QUICK_GAVE_UP       0xFFFFu
+
+static uint16_t sQuickSites[QUICK_SITES];
+
+JAI_INLINE uint16_t *quickSite(const uint8_t *at) {
+    uintptr_t h = (uintptr_t)at;
+    return &sQuickSites[(h ^ (h >> 15)) & (QUICK_SITES - 1u)];
+}
+
+JAI_INLINE void quickWrite(uint8_t *at, uint8_t op) {
+    __atomic_store_n(at, op, __ATOMIC_RELAXED);
+}
+
+static JAI_NOINLINE void quickenSeen(uint16_t *site, uint8_t *at,
+                                     uint8_t quick) {
+    unsigned seen = *site & 0xFFu;
+    unsigned run = (*site >> 8) & 0xFu;
+    unsigned misses = (unsigned)*site >> 12;
+    run = seen == quick ? run + 1u : 1u;
+    if (run >= QUICKEN_AFTER) {
+        quickWrite(at, quick);
+        run = 0;
+    }
+    *site = (uint16_t)(quick | run << 8 | misses << 12);
+}
+
+/* The kind changed under a quickened site: back to generic, and count it. */
+static JAI_NOINLINE void quickenMiss(uint8_t *at) {
+    uint16_t *site = quickSite(at);
+    unsigned misses = ((unsigned)*site >> 12) + 1u;
+    quickWrite(at, jaiOpGeneric(*at));
+    *site = misses >= QUICKEN_MAX_MISSES ? (uint16_t)QUICK_GAVE_UP
+                                         : (uint16_t)(misses << 12);
+}
+
+/* In a generic handler, after its fast path has served the instruction. */
+#define QUICKEN(quick)                                                         \
+    do {                                                                       \
+        uint16_t *_site = quickSite(instStart);                                \
+        if (*_site != QUICK_GAVE_UP) quickenSeen(_site, instStart, (quick));   \
+    } while (0)
+
+/* A generic handler a quickened one can fall back to. The second label is
+ * what makes that possible in the switch build, where a case label is not a
+ * goto target. */
+#define VM_GENERIC_CASE(name)  VM_CASE(name): G_##name
+
+/* In a quickened handler: a tag the site has not seen. Operand bytes already
+ * read must be given back first (ip = instStart + 1). */
+#define VM_DEQUICKEN(name)                                                     \
+    do {                                                                       \
+        quickenMiss(instStart);                                                \
+        goto G_##name;                                                         \
+    } while (0)
+
+#define QUICK_INT_ARITH(name, overflows)                                       \
+    do {                                                                       \
+        Value _b = stackTop[-1], _a = stackTop[-2];                            \
+        if (JAI_UNLIKELY(!IS_INT(_a) || !IS_INT(_b))) VM_DEQUICKEN(name);      \
+        int64_t _r;                                                            \
+        if (JAI_UNLIKELY(overflows(AS_INT(_a), AS_INT(_b), &_r))) {            \
+            goto G_##name;                                                     \
+        }                                                                      \
+        DROP(1);                                                               \
+        stackTop[-1] = INT_VAL(_r);                                            \
+        VM_NEXT();                                                             \
+    } while (0)
+
+#define QUICK_FLOAT_ARITH(name, cop)                                           \
+    do {                                                                       \
+        Value _b = stackTop[-1], _a = stackTop[-2];                            \
+        if (JAI_UNLIKELY(!IS_FLOAT(_a) || !IS_FLOAT(_b))) VM_DEQUICKEN(name);  \
+        double _r = AS_FLOAT(_a) cop AS_FLOAT(_b);                             \
+        DROP(1);                                                               \
+        stackTop[-1] = FLOAT_VAL(_r);                                          \
+        VM_NEXT();                                                             \
+    } while (0)
+
+#define QUICK_INT_CMP(name, cop)                                               \
+    do {                                                                       \
+        Value _b = stackTop[-1], _a = stackTop[-2];                            \
+        if (JAI_UNLIKELY(!IS_INT(_a) || !IS_INT(_b))) VM_DEQUICKEN(name);      \
+        bool _r = AS_INT(_a) cop AS_INT(_b);                                   \
+        DROP(1);                                                               \
+        stackTop[-1] = BOOL_VAL(_r);                                           \
+        VM_NEXT();                                                             \
+    } while (0)
+
+/* NaN is CMP_FAST's exclusion and for the same reason: compareOp raises. */
+#define QUICK_FLOAT_CMP(name, cop)                                             \
+    do {                                                                       \
+        Value _b = stackTop[-1], _a = stackTop[-2];                            \
+        if (JAI_UNLIKELY(!IS_FLOAT(_a) || !IS_FLOAT(_b))) VM_DEQUICKEN(name);  \
+        double _x = AS_FLOAT(_a), _y = AS_FLOAT(_b);                           \
+        if (JAI_UNLIKELY(isnan(_x) || isnan(_y))) goto G_##name;               \
+        bool _r = _x cop _y;                                                   \
+        DROP(1);                                                               \
+        stackTop[-1] = BOOL_VAL(_r);                                           \
+        VM_NEXT();                                                             \
+    } while (0)
+
+/* The six comparisons a fused compare-and-branch can carry, on two non-NaN
+ * doubles; false for a byte that is not one, which the generic handler
+ * reports. */
+JAI_INLINE bool quickFloatCmp(uint8_t cmp, double x, double y, bool *out) {
+    switch (cmp) {
+    case OP_EQ: *out = x == y; return true;
+    case OP_NE: *out = x != y; return true;
+    case OP_LT: *out = x <  y; return true;
+    case OP_LE: *out = x <= y; return true;
+    case OP_GT: *out = x >  y; return true;
+    case OP_GE: *out = x >= y; return true;
+    default:    return false;
+    }
+}
+
+#if !JAI_INTERP_TAILCALL
 static JaiRunResult runLoop(int baseFrameCount) {
 #if JAI_COMPUTED_GOTO
     static const void *const jaiDispatchTable[] = {
@@ -3864,6 +4519,10 @@ static JaiRunResult runLoop(int baseFrameCount) {
         [OP_MATCH_RANGE_POP]    = &&L_OP_MATCH_RANGE_POP,
         [OP_MATCH_SEQ_POP]      = &&L_OP_MATCH_SEQ_POP,
         [OP_MUL_INT_CONST]      = &&L_OP_MUL_INT_CONST,
+        [OP_SWITCH]             = &&L_OP_SWITCH,
+        [OP_CALL_KW_IC]         = &&L_OP_CALL_KW_IC,
+        [OP_REST_GET]           = &&L_OP_REST_GET,
+        [OP_CALL_REST]          = &&L_OP_CALL_REST,
         [OP_MATCH_RANGE]        = &&L_OP_MATCH_RANGE,
         [OP_MATCH_TYPE]         = &&L_OP_MATCH_TYPE,
         [OP_MATCH_SEQ]          = &&L_OP_MATCH_SEQ,
@@ -3881,6 +4540,26 @@ static JaiRunResult runLoop(int baseFrameCount) {
         [OP_FORMAT]             = &&L_OP_FORMAT,
         [OP_JUMP_IF_CMP_LOCAL_K] = &&L_OP_JUMP_IF_CMP_LOCAL_K,
         [OP_TO_FLOAT]           = &&L_OP_TO_FLOAT,
+        [OP_ADD_II]             = &&L_OP_ADD_II,
+        [OP_ADD_FF]             = &&L_OP_ADD_FF,
+        [OP_SUB_II]             = &&L_OP_SUB_II,
+        [OP_SUB_FF]             = &&L_OP_SUB_FF,
+        [OP_MUL_II]             = &&L_OP_MUL_II,
+        [OP_MUL_FF]             = &&L_OP_MUL_FF,
+        [OP_DIV_II]             = &&L_OP_DIV_II,
+        [OP_DIV_FF]             = &&L_OP_DIV_FF,
+        [OP_LT_II]              = &&L_OP_LT_II,
+        [OP_LT_FF]              = &&L_OP_LT_FF,
+        [OP_LE_II]              = &&L_OP_LE_II,
+        [OP_LE_FF]              = &&L_OP_LE_FF,
+        [OP_GT_II]              = &&L_OP_GT_II,
+        [OP_GT_FF]              = &&L_OP_GT_FF,
+        [OP_GE_II]              = &&L_OP_GE_II,
+        [OP_GE_FF]              = &&L_OP_GE_FF,
+        [OP_GET_INDEX_LIST_INT] = &&L_OP_GET_INDEX_LIST_INT,
+        [OP_SET_INDEX_LIST_INT] = &&L_OP_SET_INDEX_LIST_INT,
+        [OP_JUMP_IF_CMP_FALSE_FF] = &&L_OP_JUMP_IF_CMP_FALSE_FF,
+        [OP_JUMP_IF_CMP_LOCAL_K_FF] = &&L_OP_JUMP_IF_CMP_LOCAL_K_FF,
     };
     /* A designated initialiser leaves a hole as NULL rather than failing to
      * compile, so the count is what catches an opcode added without a case. */
@@ -3996,7 +4675,10 @@ static JaiRunResult runLoop(int baseFrameCount) {
     VM_CASE(OP_SET_UPVALUE): {
         uint8_t index = READ_BYTE();
         ObjUpvalue *upvalue = frame->closure->upvalues[index];
-        if (upvalue != NULL) *upvalue->location = PEEK(0);
+        if (upvalue != NULL) {
+            *upvalue->location = PEEK(0);
+            jaiGCBarrier((Obj *)upvalue, PEEK(0));
+        }
         VM_NEXT();
     }
 
@@ -4131,7 +4813,7 @@ static JaiRunResult runLoop(int baseFrameCount) {
 
     /* --- arithmetic and logic (spec §3.3) --- */
 
-    VM_CASE(OP_ADD): {
+    VM_GENERIC_CASE(OP_ADD): {
         if (IS_INT(stackTop[-1]) && IS_INT(stackTop[-2])) {
             int64_t r;
             if (JAI_UNLIKELY(__builtin_add_overflow(AS_INT(stackTop[-2]),
@@ -4141,18 +4823,20 @@ static JaiRunResult runLoop(int baseFrameCount) {
             }
             DROP(1);
             stackTop[-1] = INT_VAL(r);
+            QUICKEN(OP_ADD_II);
             VM_NEXT();
         }
         if (IS_FLOAT(stackTop[-1]) && IS_FLOAT(stackTop[-2])) {
             double r = AS_FLOAT(stackTop[-2]) + AS_FLOAT(stackTop[-1]);
             DROP(1);
             stackTop[-1] = FLOAT_VAL(r);
+            QUICKEN(OP_ADD_FF);
             VM_NEXT();
         }
         BINARY(arithmetic, OP_ADD);
     }
 
-    VM_CASE(OP_SUB): {
+    VM_GENERIC_CASE(OP_SUB): {
         if (IS_INT(stackTop[-1]) && IS_INT(stackTop[-2])) {
             int64_t r;
             if (JAI_UNLIKELY(__builtin_sub_overflow(AS_INT(stackTop[-2]),
@@ -4162,18 +4846,20 @@ static JaiRunResult runLoop(int baseFrameCount) {
             }
             DROP(1);
             stackTop[-1] = INT_VAL(r);
+            QUICKEN(OP_SUB_II);
             VM_NEXT();
         }
         if (IS_FLOAT(stackTop[-1]) && IS_FLOAT(stackTop[-2])) {
             double r = AS_FLOAT(stackTop[-2]) - AS_FLOAT(stackTop[-1]);
             DROP(1);
             stackTop[-1] = FLOAT_VAL(r);
+            QUICKEN(OP_SUB_FF);
             VM_NEXT();
         }
         BINARY(arithmetic, OP_SUB);
     }
 
-    VM_CASE(OP_MUL): {
+    VM_GENERIC_CASE(OP_MUL): {
         if (IS_INT(stackTop[-1]) && IS_INT(stackTop[-2])) {
             int64_t r;
             if (JAI_UNLIKELY(__builtin_mul_overflow(AS_INT(stackTop[-2]),
@@ -4183,18 +4869,39 @@ static JaiRunResult runLoop(int baseFrameCount) {
             }
             DROP(1);
             stackTop[-1] = INT_VAL(r);
+            QUICKEN(OP_MUL_II);
             VM_NEXT();
         }
         if (IS_FLOAT(stackTop[-1]) && IS_FLOAT(stackTop[-2])) {
             double r = AS_FLOAT(stackTop[-2]) * AS_FLOAT(stackTop[-1]);
             DROP(1);
             stackTop[-1] = FLOAT_VAL(r);
+            QUICKEN(OP_MUL_FF);
             VM_NEXT();
         }
         BINARY(arithmetic, OP_MUL);
     }
 
-    VM_CASE(OP_DIV):       BINARY(arithmetic, OP_DIV);
+    /* int / int is a float (spec §3.3). A zero divisor takes the slow way,
+     * which owns both division-by-zero messages. */
+    VM_GENERIC_CASE(OP_DIV): {
+        Value b = stackTop[-1], a = stackTop[-2];
+        if (IS_INT(a) && IS_INT(b) && AS_INT(b) != 0) {
+            double r = (double)AS_INT(a) / (double)AS_INT(b);
+            DROP(1);
+            stackTop[-1] = FLOAT_VAL(r);
+            QUICKEN(OP_DIV_II);
+            VM_NEXT();
+        }
+        if (IS_FLOAT(a) && IS_FLOAT(b) && AS_FLOAT(b) != 0.0) {
+            double r = AS_FLOAT(a) / AS_FLOAT(b);
+            DROP(1);
+            stackTop[-1] = FLOAT_VAL(r);
+            QUICKEN(OP_DIV_FF);
+            VM_NEXT();
+        }
+        BINARY(arithmetic, OP_DIV);
+    }
     VM_CASE(OP_FLOORDIV):  BINARY(arithmetic, OP_FLOORDIV);
 
     VM_CASE(OP_MOD): {
@@ -4225,10 +4932,10 @@ static JaiRunResult runLoop(int baseFrameCount) {
     VM_CASE(OP_BXOR):      BINARY(bitwise, OP_BXOR);
     VM_CASE(OP_SHL):       BINARY(bitwise, OP_SHL);
     VM_CASE(OP_SHR):       BINARY(bitwise, OP_SHR);
-    VM_CASE(OP_LT): CMP_FAST(<);  BINARY(compareOp, OP_LT);
-    VM_CASE(OP_LE): CMP_FAST(<=); BINARY(compareOp, OP_LE);
-    VM_CASE(OP_GT): CMP_FAST(>);  BINARY(compareOp, OP_GT);
-    VM_CASE(OP_GE): CMP_FAST(>=); BINARY(compareOp, OP_GE);
+    VM_GENERIC_CASE(OP_LT): CMP_FAST(<,  OP_LT);  BINARY(compareOp, OP_LT);
+    VM_GENERIC_CASE(OP_LE): CMP_FAST(<=, OP_LE);  BINARY(compareOp, OP_LE);
+    VM_GENERIC_CASE(OP_GT): CMP_FAST(>,  OP_GT);  BINARY(compareOp, OP_GT);
+    VM_GENERIC_CASE(OP_GE): CMP_FAST(>=, OP_GE);  BINARY(compareOp, OP_GE);
 
     VM_CASE(OP_NEG): {
         if (IS_INT(stackTop[-1]) && AS_INT(stackTop[-1]) != INT64_MIN) {
@@ -4613,7 +5320,7 @@ static JaiRunResult runLoop(int baseFrameCount) {
      * optimize.c already relies on to fold OP_NOT into a jump. Only int/int is
      * inlined; float and everything else take the identical slow path the
      * unfused pair would have, so NaN and __lt__ behave exactly as before. */
-    VM_CASE(OP_JUMP_IF_CMP_FALSE): {
+    VM_GENERIC_CASE(OP_JUMP_IF_CMP_FALSE): {
         uint8_t cmp = READ_BYTE();
         int16_t offset = READ_I16();
         Value a = stackTop[-2], b = stackTop[-1];
@@ -4646,6 +5353,7 @@ static JaiRunResult runLoop(int baseFrameCount) {
             }
         }
 
+        if (IS_FLOAT(a) && IS_FLOAT(b)) QUICKEN(OP_JUMP_IF_CMP_FALSE_FF);
         SAVE_STATE();
         bool condition;
         if (cmp == OP_EQ || cmp == OP_NE) {
@@ -4668,7 +5376,7 @@ static JaiRunResult runLoop(int baseFrameCount) {
      * ever pushed, so unlike JUMP_IF_CMP_FALSE there is no stack to unwind on
      * either path — but both are still rooted while the slow path runs, the
      * local by the frame it lives in and the constant by the chunk. */
-    VM_CASE(OP_JUMP_IF_CMP_LOCAL_K): {
+    VM_GENERIC_CASE(OP_JUMP_IF_CMP_LOCAL_K): {
         uint8_t cmp = READ_BYTE();
         Value a = slots[READ_U16()];
         Value b = constants[READ_U24()];
@@ -4700,6 +5408,7 @@ static JaiRunResult runLoop(int baseFrameCount) {
             }
         }
 
+        if (IS_FLOAT(a) && IS_FLOAT(b)) QUICKEN(OP_JUMP_IF_CMP_LOCAL_K_FF);
         SAVE_STATE();
         bool condition;
         if (cmp == OP_EQ || cmp == OP_NE) {
@@ -5031,24 +5740,25 @@ static JaiRunResult runLoop(int baseFrameCount) {
             THROW(vm.cRuntimeError,
                   "CALL_KW expected a tuple of keyword names");
         }
-        ObjDict *kwRest = NULL;
-        int argc = prepareKeywordCall(posCount, AS_TUPLE(nameTuple), &kwRest);
-        if (argc < 0) goto vmThrow;
-
-        Value callee = vm.stackTop[-argc - 1];
-        if (kwRest != NULL) jaiGCPushRoot(OBJ_VAL(kwRest));
-        CallOutcome outcome = invokeCallable(callee, argc);
-        if (outcome == CALL_ERROR) {
-            if (kwRest != NULL) jaiGCPopRoot();
+        if (callKeyword(posCount, AS_TUPLE(nameTuple), NULL) == CALL_ERROR) {
             goto vmThrow;
         }
-        if (kwRest != NULL) {
-            if (outcome == CALL_FRAME) {
-                CallFrame *calleeFrame = &vm.frames[vm.frameCount - 1];
-                int slot = kwRestSlotOf(calleeFrame->closure->fn);
-                calleeFrame->slots[slot] = OBJ_VAL(kwRest);
-            }
-            jaiGCPopRoot();
+        LOAD_STATE();
+        VM_NEXT();
+    }
+
+    VM_CASE(OP_CALL_KW_IC): {
+        int posCount = READ_BYTE();
+        Value nameTuple = READ_CONST();
+        uint16_t cacheIdx = READ_U16();
+        SAVE_STATE();
+        if (!IS_TUPLE(nameTuple)) {
+            THROW(vm.cRuntimeError,
+                  "CALL_KW expected a tuple of keyword names");
+        }
+        InlineCache *ic = cacheAt(frameChunk(frame), cacheIdx);
+        if (callKeyword(posCount, AS_TUPLE(nameTuple), ic) == CALL_ERROR) {
+            goto vmThrow;
         }
         LOAD_STATE();
         VM_NEXT();
@@ -5075,6 +5785,25 @@ static JaiRunResult runLoop(int baseFrameCount) {
         VM_NEXT();
     }
 
+    /* OP_CALL_SPREAD over the arguments an FN_REST_VIEW frame keeps above its
+     * window (bindCallArgsSlow), which were never a list to unpack. */
+    VM_CASE(OP_CALL_REST): {
+        int argc = READ_BYTE();
+        uint16_t slot = READ_U16();
+        SAVE_STATE();
+        if (JAI_UNLIKELY(!IS_INT(slots[slot]))) {
+            THROW(vm.cRuntimeError, "CALL_REST on a slot that views no arguments");
+        }
+        int count = (int)AS_INT(slots[slot]);
+        const Value *viewed = restViewBase(frame);
+        if (!ensureStack(count + 1)) goto vmThrow;
+        for (int i = 0; i < count; i++) PUSH(viewed[i]);
+        SAVE_STATE();
+        if (callValueOnStack(argc + count) == CALL_ERROR) goto vmThrow;
+        LOAD_STATE();
+        VM_NEXT();
+    }
+
     VM_CASE(OP_INVOKE): {
         uint32_t nameIdx = READ_U24();
         int argc = READ_BYTE();
@@ -5097,7 +5826,7 @@ static JaiRunResult runLoop(int baseFrameCount) {
             InlineCache *ic = cacheAt(frameChunk(frame), cacheIdx);
             ObjClass *klass = AS_INSTANCE(receiver)->klass;
             if (ic != NULL && klass != NULL && ic->state != IC_EMPTY &&
-                ic->state != IC_MEGA) {
+                ic->state < IC_MEGA) {
                 for (int w = 0; w < ic->count; w++) {
                     if (ic->shapeId[w] != klass->shapeId) continue;
                     vm.icHits++;
@@ -5133,7 +5862,19 @@ static JaiRunResult runLoop(int baseFrameCount) {
                     LOAD_STATE();
                     VM_NEXT();
                 }
-            } else if (ic != NULL && klass != NULL && ic->state == IC_MEGA) {
+            } else if (ic != NULL && klass != NULL && ic->state >= IC_MEGA) {
+                if (ic->state == IC_VTABLE) {
+                    SAVE_STATE();
+                    Value vmethod = vtableMethod(klass, ic);
+                    if (!IS_NULL(vmethod)) {
+                        vm.icHits++;
+                        if (invokeMethodOnStack(vmethod, argc) == CALL_ERROR) {
+                            goto vmThrow;
+                        }
+                        LOAD_STATE();
+                        VM_NEXT();
+                    }
+                }
                 /* Out of ways: the shared table above answers instead. */
                 ObjString *mname = AS_STRING(constants[nameIdx]);
                 MegaEntry *me = &sMegaCache[megaSlot(klass, mname)];
@@ -5176,7 +5917,7 @@ static JaiRunResult runLoop(int baseFrameCount) {
              * the callee slot, which is exactly where a built-in method wants
              * its args[0], so the call needs no intermediate object at all. */
             InlineCache *ic = cacheAt(frameChunk(frame), cacheIdx);
-            if (ic != NULL && ic->state != IC_EMPTY && ic->state != IC_MEGA) {
+            if (ic != NULL && ic->state != IC_EMPTY && ic->state < IC_MEGA) {
                 for (int w = 0; w < ic->count; w++) {
                     if (ic->shapeId[w] != builtinTag) continue;
                     vm.icHits++;
@@ -5257,7 +5998,7 @@ static JaiRunResult runLoop(int baseFrameCount) {
              * visibility test it cannot cache. */
             MethodInfo restricted;
             if (ic != NULL && klass != NULL && AS_OBJ(slotZero) == AS_OBJ(receiver) &&
-                ic->state != IC_MEGA) {
+                ic->state < IC_MEGA) {
                 /* Inside the guard, not above it: a site that has gone
                  * megamorphic reaches here on every call and has nothing to
                  * fill, so the walk was pure cost exactly where calls are
@@ -5268,6 +6009,7 @@ static JaiRunResult runLoop(int baseFrameCount) {
                     ic->shapeId[ic->count] = klass->shapeId;
                     ic->payload[ic->count] = recheck;
                     ic->cached[ic->count] = method;
+                    icRemember(method);
                     ic->resultKind[ic->count] = JAI_FB_NONE;
                     ic->count++;
                     ic->state = (ic->count == 1) ? IC_MONO : IC_POLY;
@@ -5283,7 +6025,7 @@ static JaiRunResult runLoop(int baseFrameCount) {
                         fbFromFrame = true;
                     }
                 } else {
-                    ic->state = IC_MEGA;
+                    icGoMegamorphic(ic, klass, name);
                 }
             }
         } else if (builtinTag != 0 && IS_BOUND(method) &&
@@ -5294,11 +6036,12 @@ static JaiRunResult runLoop(int baseFrameCount) {
              * tag does not cover) simply is not cached. */
             vm.icMisses++;
             InlineCache *ic = cacheAt(frameChunk(frame), cacheIdx);
-            if (ic != NULL && ic->state != IC_MEGA) {
+            if (ic != NULL && ic->state < IC_MEGA) {
                 if (ic->count < JAI_IC_WAYS) {
                     ic->shapeId[ic->count] = builtinTag;
                     ic->payload[ic->count] = 0;
                     ic->cached[ic->count] = AS_BOUND(method)->method;
+                    icRemember(AS_BOUND(method)->method);
                     ic->resultKind[ic->count] = JAI_FB_NONE;
                     ic->count++;
                     ic->state = (ic->count == 1) ? IC_MONO : IC_POLY;
@@ -5439,6 +6182,7 @@ static JaiRunResult runLoop(int baseFrameCount) {
             vm.stackTop = window + argc + 1;
 
             int newWindow = frameWindowSize(target->fn);
+            if (!ensureRoom(window, frameRoom(newWindow))) goto vmThrow;
             for (int i = argc + 1; i < newWindow; i++) window[i] = NULL_VAL;
             vm.stackTop = window + newWindow;
 
@@ -5542,6 +6286,12 @@ static JaiRunResult runLoop(int baseFrameCount) {
             THROW(vm.cRuntimeError, "CLOSURE operand is not a function");
         }
         ObjFunction *fn = AS_FUNCTION(fnValue);
+        if ((fn->flags & FN_SITE_CLOSURE) && fn->siteClosure != NULL &&
+            siteClosureFits(fn->siteClosure, frame, ip)) {
+            ip += 3 * (int)fn->upvalueCount;
+            PUSH(OBJ_VAL(fn->siteClosure));
+            VM_NEXT();
+        }
         ObjClosure *closure = jaiClosureNew(fn);
         LOAD_STATE();
         /* Read the upvalue descriptors before pushing: the closure is only
@@ -5570,6 +6320,10 @@ static JaiRunResult runLoop(int baseFrameCount) {
             }
         }
         jaiGCPopRoot();
+        if (fn->flags & FN_SITE_CLOSURE) {
+            fn->siteClosure = closure;
+            jaiGCBarrier((Obj *)fn, OBJ_VAL(closure));
+        }
         PUSH(OBJ_VAL(closure));
         VM_NEXT();
     }
@@ -5693,9 +6447,10 @@ static JaiRunResult runLoop(int baseFrameCount) {
         VM_NEXT();
     }
 
-    VM_CASE(OP_GET_INDEX): {
+    VM_GENERIC_CASE(OP_GET_INDEX): {
         Value result;
         if (JAI_LIKELY(indexGetFast(stackTop[-2], stackTop[-1], &result))) {
+            if (IS_LIST(stackTop[-2])) QUICKEN(OP_GET_INDEX_LIST_INT);
             DROP(2);
             PUSH(result);
             VM_NEXT();
@@ -5708,7 +6463,34 @@ static JaiRunResult runLoop(int baseFrameCount) {
         VM_NEXT();
     }
 
-    VM_CASE(OP_SET_INDEX): {
+    /* `rest[i]` for a variadic parameter the frame keeps as a view (see
+     * OP_CALL_REST): indexGet's list arm, over the arguments themselves. */
+    VM_CASE(OP_REST_GET): {
+        uint16_t slot = READ_U16();
+        Value index = stackTop[-1];
+        if (JAI_UNLIKELY(!IS_INT(slots[slot]))) {
+            THROW(vm.cRuntimeError, "REST_GET on a slot that views no arguments");
+        }
+        int count = (int)AS_INT(slots[slot]);
+        int at;
+        if (JAI_UNLIKELY(!IS_INT(index))) {
+            THROW(vm.cTypeError, "list indices must be int, not '%s'",
+                  jaiTypeNameStatic(index));
+        }
+        if (JAI_UNLIKELY(!jaiNormalizeIndex(AS_INT(index), count, &at))) {
+            THROW(vm.cIndexError,
+                  "list index %" PRId64 " out of range for length %d",
+                  AS_INT(index), count);
+        }
+        stackTop[-1] = restViewBase(frame)[at];
+        VM_NEXT();
+    }
+
+    VM_GENERIC_CASE(OP_SET_INDEX): {
+        /* Before the call: LOAD_STATE moves instStart past this instruction. */
+        if (IS_LIST(stackTop[-3]) && IS_INT(stackTop[-2])) {
+            QUICKEN(OP_SET_INDEX_LIST_INT);
+        }
         SAVE_STATE();
         if (!indexSet(stackTop[-3], stackTop[-2], stackTop[-1])) goto vmThrow;
         LOAD_STATE();
@@ -5798,7 +6580,10 @@ static JaiRunResult runLoop(int baseFrameCount) {
             if (i < 0 || i >= list->count) break;
             list->items[i] = source[written++];
         }
-        if (written > 0) jaiListTouch(list);
+        if (written > 0) {
+            jaiListTouch(list);
+            jaiGCBarrierAll((Obj *)list);
+        }
         LOAD_STATE();
         DROP(operands + 2);
         VM_NEXT();
@@ -5886,7 +6671,11 @@ static JaiRunResult runLoop(int baseFrameCount) {
                       ? AS_CLASS(subValue)->name->chars : "?");
         }
         SAVE_STATE();
+        /* Every class-shaping opcode below waits out a background compile:
+         * it reads the tables and field arrays these grow. */
+        jaiJitHold();
         jaiClassInherit(AS_CLASS(subValue), AS_CLASS(superValue));
+        jaiJitRelease();
         if (vm.hasException) goto vmThrow;
         LOAD_STATE();
         VM_NEXT();
@@ -5921,6 +6710,7 @@ static JaiRunResult runLoop(int baseFrameCount) {
                   jaiTypeNameStatic(implementor));
         }
 
+        jaiJitHold();
         if (klass == NULL) {
             /* `trait Sub: Super` — record the supertrait and inherit both its
              * requirements and its defaults, so a class implementing Sub is
@@ -5943,6 +6733,8 @@ static JaiRunResult runLoop(int baseFrameCount) {
                 if (!jaiTableGet(&sub->defaults, skey, &sexisting))
                     jaiTableSet(&sub->defaults, skey, svalue);
             }
+            jaiGCBarrierAll((Obj *)sub);
+            jaiJitRelease();
             LOAD_STATE();
             VM_NEXT();
         }
@@ -5967,6 +6759,8 @@ static JaiRunResult runLoop(int baseFrameCount) {
             jaiClassAddMethod(klass, AS_STRING(key), value, VIS_PUBLIC, 0);
         }
         jaiClassRefreshDunders(klass);
+        jaiGCBarrierAll((Obj *)klass);      /* klass->traits */
+        jaiJitRelease();
         LOAD_STATE();
         VM_NEXT();
     }
@@ -5990,24 +6784,32 @@ static JaiRunResult runLoop(int baseFrameCount) {
             ObjFunction *fn = IS_CLOSURE(method)    ? AS_CLOSURE(method)->fn
                               : IS_FUNCTION(method) ? AS_FUNCTION(method)
                                                     : NULL;
-            if (fn != NULL) fn->owner = AS_CLASS(owner);
+            if (fn != NULL) {
+                fn->owner = AS_CLASS(owner);
+                jaiGCBarrier((Obj *)fn, owner);
+            }
         }
+        jaiJitHold();
         if (IS_CLASS(owner)) {
             jaiClassAddMethod(AS_CLASS(owner), name, method, vis, flags);
         } else if (IS_TRAIT(owner)) {
             /* A trait's only bodied methods are its defaults; the requirements
              * travelled in the spec constant. */
             jaiTableSet(&AS_TRAIT(owner)->defaults, OBJ_VAL(name), method);
+            jaiGCBarrierAll(AS_OBJ(owner));
         } else if (IS_ENUM(owner)) {
             jaiTableSet(&AS_ENUM(owner)->methods, OBJ_VAL(name), method);
+            jaiGCBarrierAll(AS_OBJ(owner));
             /* A member cache keyed on the old id can no longer be reached, so
              * anything memoised before this method existed is stale by
              * construction. Only runs while the enum is being defined. */
             AS_ENUM(owner)->shapeId = jaiFreshShapeId();
         } else {
+            jaiJitRelease();
             THROW(vm.cTypeError,
                   "METHOD expected a class, trait, or enum under the closure");
         }
+        jaiJitRelease();
         LOAD_STATE();
         DROP(1);
         VM_NEXT();
@@ -6021,7 +6823,10 @@ static JaiRunResult runLoop(int baseFrameCount) {
         if (!IS_CLASS(classValue)) {
             THROW(vm.cTypeError, "FIELD_DEF expected a class on the stack");
         }
-        if (!classDeclareField(AS_CLASS(classValue), name, info)) goto vmThrow;
+        jaiJitHold();
+        bool declared = classDeclareField(AS_CLASS(classValue), name, info);
+        jaiJitRelease();
+        if (!declared) goto vmThrow;
         LOAD_STATE();
         VM_NEXT();
     }
@@ -6157,6 +6962,7 @@ static JaiRunResult runLoop(int baseFrameCount) {
                     }
                     vm.icHits++;
                     instance->fields[ic->payload[w]] = value;
+                    jaiGCBarrier((Obj *)instance, value);
                     DROP(2);
                     VM_NEXT();
                 }
@@ -6282,6 +7088,7 @@ static JaiRunResult runLoop(int baseFrameCount) {
         if (variant->arity == 0 && argc == 0) {
             if (variant->unit == NULL) {
                 variant->unit = jaiEnumValNew(enumType, (uint16_t)tag, NULL, 0);
+                jaiGCBarrier((Obj *)enumType, OBJ_VAL(variant->unit));
             }
             value = variant->unit;
         } else {
@@ -6454,6 +7261,47 @@ static JaiRunResult runLoop(int baseFrameCount) {
         VM_NEXT();
     }
 
+    VM_CASE(OP_SWITCH): {
+        Value table = READ_CONST();
+        int16_t offset = READ_I16();
+        bool slow;
+        int32_t rel = jaiSwitchFind(table, PEEK(0), &slow);
+        if (JAI_UNLIKELY(slow)) {
+            /* An instance with its own __eq__ may equal any key, so it asks
+             * each one, in the order the arms were written, exactly as the
+             * MATCH_CONST chain this replaces would have. */
+            int size = jaiSwitchSize(table);
+            Value subject = PEEK(0);
+            JaiSwitchCase c;
+            SAVE_STATE();
+            for (int32_t last = -1; rel < 0;) {
+                int32_t arm = INT32_MAX;
+                for (int i = 0; i < size; i++) {
+                    if (jaiSwitchCaseAt(table, i, &c) && c.rel > last &&
+                        c.rel < arm) {
+                        arm = c.rel;
+                    }
+                }
+                if (arm == INT32_MAX) break;
+                for (int i = 0; i < size && rel < 0; i++) {
+                    if (!jaiSwitchCaseAt(table, i, &c) || c.rel != arm) {
+                        continue;
+                    }
+                    Value key = c.isString ? OBJ_VAL(c.strKey)
+                                           : INT_VAL(c.intKey);
+                    bool equal = jaiValuesEqual(subject, key);
+                    if (vm.hasException) goto vmThrow;
+                    if (equal) rel = arm;
+                }
+                last = arm;
+            }
+            LOAD_STATE();
+        }
+        DROP(1);
+        ip += rel >= 0 ? rel : offset;
+        VM_NEXT();
+    }
+
     VM_CASE(OP_MATCH_RANGE): {
         Value low = READ_CONST();
         Value high = READ_CONST();
@@ -6659,6 +7507,7 @@ static JaiRunResult runLoop(int baseFrameCount) {
         }
         jaiGCPushRoot(OBJ_VAL(frame->module));
         (void)jaiTableSetInterned(&frame->module->exports, name, BOOL_VAL(true));
+        jaiGCBarrier((Obj *)frame->module, OBJ_VAL(name));
         jaiGCPopRoot();
         LOAD_STATE();
         VM_NEXT();
@@ -6697,6 +7546,123 @@ static JaiRunResult runLoop(int baseFrameCount) {
         VM_NEXT();
     }
 
+    /* --- quickened forms (see "Quickening" above) --- */
+
+    VM_CASE(OP_ADD_II): QUICK_INT_ARITH(OP_ADD, __builtin_add_overflow);
+    VM_CASE(OP_SUB_II): QUICK_INT_ARITH(OP_SUB, __builtin_sub_overflow);
+    VM_CASE(OP_MUL_II): QUICK_INT_ARITH(OP_MUL, __builtin_mul_overflow);
+    VM_CASE(OP_ADD_FF): QUICK_FLOAT_ARITH(OP_ADD, +);
+    VM_CASE(OP_SUB_FF): QUICK_FLOAT_ARITH(OP_SUB, -);
+    VM_CASE(OP_MUL_FF): QUICK_FLOAT_ARITH(OP_MUL, *);
+
+    VM_CASE(OP_DIV_II): {
+        Value b = stackTop[-1], a = stackTop[-2];
+        if (JAI_UNLIKELY(!IS_INT(a) || !IS_INT(b))) VM_DEQUICKEN(OP_DIV);
+        if (JAI_UNLIKELY(AS_INT(b) == 0)) goto G_OP_DIV;
+        double r = (double)AS_INT(a) / (double)AS_INT(b);
+        DROP(1);
+        stackTop[-1] = FLOAT_VAL(r);
+        VM_NEXT();
+    }
+
+    VM_CASE(OP_DIV_FF): {
+        Value b = stackTop[-1], a = stackTop[-2];
+        if (JAI_UNLIKELY(!IS_FLOAT(a) || !IS_FLOAT(b))) VM_DEQUICKEN(OP_DIV);
+        if (JAI_UNLIKELY(AS_FLOAT(b) == 0.0)) goto G_OP_DIV;
+        double r = AS_FLOAT(a) / AS_FLOAT(b);
+        DROP(1);
+        stackTop[-1] = FLOAT_VAL(r);
+        VM_NEXT();
+    }
+
+    VM_CASE(OP_LT_II): QUICK_INT_CMP(OP_LT, <);
+    VM_CASE(OP_LE_II): QUICK_INT_CMP(OP_LE, <=);
+    VM_CASE(OP_GT_II): QUICK_INT_CMP(OP_GT, >);
+    VM_CASE(OP_GE_II): QUICK_INT_CMP(OP_GE, >=);
+    VM_CASE(OP_LT_FF): QUICK_FLOAT_CMP(OP_LT, <);
+    VM_CASE(OP_LE_FF): QUICK_FLOAT_CMP(OP_LE, <=);
+    VM_CASE(OP_GT_FF): QUICK_FLOAT_CMP(OP_GT, >);
+    VM_CASE(OP_GE_FF): QUICK_FLOAT_CMP(OP_GE, >=);
+
+    /* An index out of range may still be a negative one in range, and is
+     * otherwise indexGet's error to raise. */
+    VM_CASE(OP_GET_INDEX_LIST_INT): {
+        Value container = stackTop[-2], index = stackTop[-1];
+        if (JAI_UNLIKELY(!IS_LIST(container) || !IS_INT(index))) {
+            VM_DEQUICKEN(OP_GET_INDEX);
+        }
+        ObjList *list = AS_LIST(container);
+        int at;
+        if (JAI_UNLIKELY(!jaiNormalizeIndex(AS_INT(index), list->count, &at))) {
+            goto G_OP_GET_INDEX;
+        }
+        DROP(1);
+        stackTop[-1] = list->items[at];
+        VM_NEXT();
+    }
+
+    /* indexSet's list arm without the call: a typed list's element check
+     * stays, and a value it refuses goes to indexSet to be reported. */
+    VM_CASE(OP_SET_INDEX_LIST_INT): {
+        Value container = stackTop[-3], index = stackTop[-2];
+        Value value = stackTop[-1];
+        if (JAI_UNLIKELY(!IS_LIST(container) || !IS_INT(index))) {
+            VM_DEQUICKEN(OP_SET_INDEX);
+        }
+        ObjList *list = AS_LIST(container);
+        int at;
+        if (JAI_UNLIKELY(!jaiNormalizeIndex(AS_INT(index), list->count, &at) ||
+                         (list->elemKind != FIELD_KIND_ANY &&
+                          !jaiKindAccepts(list->elemKind, value)))) {
+            goto G_OP_SET_INDEX;
+        }
+        list->items[at] = value;
+        jaiListTouch(list);
+        jaiGCBarrier((Obj *)list, value);
+        DROP(3);
+        VM_NEXT_HINT(OP_LOOP);
+    }
+
+    VM_CASE(OP_JUMP_IF_CMP_FALSE_FF): {
+        uint8_t cmp = READ_BYTE();
+        int16_t offset = READ_I16();
+        Value a = stackTop[-2], b = stackTop[-1];
+        if (JAI_UNLIKELY(!IS_FLOAT(a) || !IS_FLOAT(b))) {
+            ip = instStart + 1;
+            VM_DEQUICKEN(OP_JUMP_IF_CMP_FALSE);
+        }
+        double x = AS_FLOAT(a), y = AS_FLOAT(b);
+        bool taken;
+        if (JAI_UNLIKELY(isnan(x) || isnan(y) ||
+                         !quickFloatCmp(cmp, x, y, &taken))) {
+            ip = instStart + 1;
+            goto G_OP_JUMP_IF_CMP_FALSE;
+        }
+        stackTop -= 2;
+        if (!taken) ip += offset;
+        VM_NEXT();
+    }
+
+    VM_CASE(OP_JUMP_IF_CMP_LOCAL_K_FF): {
+        uint8_t cmp = READ_BYTE();
+        Value a = slots[READ_U16()];
+        Value b = constants[READ_U24()];
+        int16_t offset = READ_I16();
+        if (JAI_UNLIKELY(!IS_FLOAT(a) || !IS_FLOAT(b))) {
+            ip = instStart + 1;
+            VM_DEQUICKEN(OP_JUMP_IF_CMP_LOCAL_K);
+        }
+        double x = AS_FLOAT(a), y = AS_FLOAT(b);
+        bool taken;
+        if (JAI_UNLIKELY(isnan(x) || isnan(y) ||
+                         !quickFloatCmp(cmp, x, y, &taken))) {
+            ip = instStart + 1;
+            goto G_OP_JUMP_IF_CMP_LOCAL_K;
+        }
+        if (!taken) ip += offset;
+        VM_NEXT();
+    }
+
     VM_CASE(OP_HALT):
         SAVE_STATE();
         while (vm.frameCount > baseFrameCount) {
@@ -6740,6 +7706,126 @@ vmThrow: {
     }
 }
 
+#else   /* JAI_INTERP_TAILCALL */
+
+/* ------------------------------------------------------------------ */
+/* Tail-call dispatch                                                   */
+/*                                                                      */
+/* runLoop above, cut into one function per case by                     */
+/* scripts/gen_tailcall.py into $(BUILD_ROOT)/vm_tailcall.inc. Each     */
+/* handler takes the loop's five hot locals as arguments and hands them */
+/* on, so across a whole run they never leave argument registers -- in  */
+/* the 3,000-line loop the register allocator has to keep them live     */
+/* through every case at once, and spills them around the big ones.    */
+/* ------------------------------------------------------------------ */
+
+/* GCC before 15 has no musttail, but at -O2 it turns a call in tail position
+ * into a jump by itself whenever nothing the callee could read lives in the
+ * caller's frame -- which is why the generator puts the dispatch at the very
+ * end of each handler, after every block and every address-taken local has
+ * gone out of scope. scripts/tailcall_check.sh is what proves that it did:
+ * a dispatch left as a call costs a C frame per instruction and crashes. An
+ * unoptimised build makes no sibling calls at all, so refuse to build one. */
+#if defined(__has_attribute)
+#  if __has_attribute(musttail)
+#    define JAI_MUSTTAIL __attribute__((musttail))
+#  endif
+#endif
+#ifndef JAI_MUSTTAIL
+#  ifndef __OPTIMIZE__
+#    error "INTERP=tailcall needs __attribute__((musttail)) or an optimised build"
+#  endif
+#  define JAI_MUSTTAIL
+#endif
+
+/* What runLoop kept in locals and is not worth an argument register: read on
+ * the rare paths, or handed between two handlers that cannot recompute it. */
+typedef struct {
+    int      baseFrameCount;
+    bool     countInsts;
+    Value    retval;       /* into opReturn */
+    uint8_t *instStart;    /* into opReturn and vmThrow */
+} TcState;
+
+#define TC_PARAMS  CallFrame *frame, uint8_t *ip, Value *stackTop,              \
+                   Value *slots, Value *constants, TcState *tc
+#define TC_ARGS    frame, ip, stackTop, slots, constants, tc
+
+/* A handler entered by dispatch has just had its opcode byte consumed. So has
+ * one entered by a quickened handler's `goto G_...`: those give their operand
+ * bytes back first (VM_DEQUICKEN), which is what lets one entry serve both. */
+#define TC_ENTER()   uint8_t *instStart JAI_UNUSED = ip - 1
+/* opReturn and vmThrow are entered from the middle of another handler. */
+#define TC_RESUME()  uint8_t *instStart JAI_UNUSED = tc->instStart
+
+#define TC_JUMP(fn)                                                            \
+    do {                                                                       \
+        tc->instStart = instStart;                                             \
+        JAI_MUSTTAIL return fn(TC_ARGS);                                       \
+    } while (0)
+
+#ifdef JAI_OPCODE_STATS
+#  define TC_COUNT_OP()  (jaiOpCounts[*ip]++)
+#else
+#  define TC_COUNT_OP()  ((void)0)
+#endif
+
+/* The end of every handler: the dispatch VM_NEXT reaches, and the vmThrow that
+ * THROW and the helpers' `goto vmThrow` reach. --count and --trace leave by a
+ * tail call too, to tcTraced: a plain call to the tracer here is a call in
+ * every handler, and GCC then saves callee-saved registers on entry to all of
+ * them to keep the five arguments alive across it. */
+#define TC_EXIT()                                                              \
+    tcNext: JAI_UNUSED;                                                        \
+    if (JAI_UNLIKELY(countInsts)) {                                            \
+        JAI_MUSTTAIL return tcTraced(TC_ARGS);                                 \
+    }                                                                          \
+    TC_COUNT_OP();                                                             \
+    JAI_MUSTTAIL return tcHandlers[*ip](frame, ip + 1, stackTop, slots,        \
+                                        constants, tc);                        \
+    vmThrow: JAI_UNUSED;                                                       \
+    TC_JUMP(TC_vmThrow)
+
+#define baseFrameCount  (tc->baseFrameCount)
+#define countInsts      (tc->countInsts)
+#define retval          (tc->retval)
+
+static JaiRunResult tcTraced(TC_PARAMS);
+
+#include "vm_tailcall.inc"
+
+static JaiRunResult tcTraced(TC_PARAMS) {
+    DISPATCH_TRACE();
+    TC_COUNT_OP();
+    JAI_MUSTTAIL return tcHandlers[*ip](frame, ip + 1, stackTop, slots,
+                                        constants, tc);
+}
+
+static JaiRunResult runLoop(int firstFrame) {
+    /* In order, not designated: the field names are macros here. */
+    TcState state = { firstFrame, vm.countInstructions, NULL_VAL, NULL };
+    TcState *tc = &state;
+    CallFrame *frame;
+    uint8_t *ip;
+    uint8_t *instStart;
+    Value *stackTop;
+    Value *slots;
+    Value *constants;
+
+    LOAD_STATE();
+    (void)instStart;
+    DISPATCH_TRACE();
+    TC_COUNT_OP();
+    /* Not a tail call: `state` lives in this frame. */
+    return tcHandlers[*ip](frame, ip + 1, stackTop, slots, constants, tc);
+}
+
+#undef baseFrameCount
+#undef countInsts
+#undef retval
+
+#endif  /* JAI_INTERP_TAILCALL */
+
 static JaiRunResult run(int baseFrameCount) {
     if (sRunDepth >= JAI_MAX_NESTED_RUN) {
         (void)jaiThrow(vm.cRecursionError,
@@ -6801,9 +7887,7 @@ static void internWellKnownNames(void) {
 void jaiVMInit(void) {
     /* Flags may have been set from the command line before the VM came up, so
      * only the fields this function owns are reset. */
-    vm.stack = JAI_ALLOC(Value, JAI_STACK_MAX);
-    vm.frames = JAI_ALLOC(CallFrame, JAI_FRAMES_MAX);
-    vm.frameCapacity = JAI_FRAMES_MAX;
+    reserveStacks();
     vm.frameCount = 0;
     vm.stackTop = vm.stack;
     vm.openUpvalues = NULL;
@@ -6868,8 +7952,12 @@ void jaiVMInit(void) {
 }
 
 void jaiVMFree(void) {
+    jaiJitShutdown();
+    jaiJitWarmSave();
     removeInterruptHandler();
-    freeSavedTraceback();
+    JAI_FREE_ARRAY(UnwoundFrame, sUnwound.frames, sUnwound.capacity);
+    sUnwound.frames = NULL;
+    sUnwound.count = sUnwound.capacity = 0;
 
     jaiVMResetStack();
     vm.pendingException = NULL_VAL;
@@ -6908,12 +7996,7 @@ void jaiVMFree(void) {
     jaiAsciiCharsReset();
     jaiInternTableFree();
 
-    JAI_FREE_ARRAY(Value, vm.stack, JAI_STACK_MAX);
-    JAI_FREE_ARRAY(CallFrame, vm.frames, vm.frameCapacity);
-    vm.stack = NULL;
-    vm.stackTop = NULL;
-    vm.frames = NULL;
-    vm.frameCapacity = 0;
+    releaseStacks();
 }
 
 JaiRunResult jaiVMRunModule(ObjModule *module, ObjFunction *body) {
@@ -6923,15 +8006,16 @@ JaiRunResult jaiVMRunModule(ObjModule *module, ObjFunction *body) {
     jaiClearException();
 
     body->module = module;
+    jaiGCBarrier((Obj *)body, OBJ_VAL(module));
     ObjClosure *closure = jaiClosureNew(body);
     module->body = closure;
+    jaiGCBarrier((Obj *)module, OBJ_VAL(closure));
     if (vm.mainModule == NULL) vm.mainModule = module;
 
     Value *base = vm.stackTop;
     *vm.stackTop++ = OBJ_VAL(closure);
     int window = frameWindowSize(body);
-    if (base + window + 1 > vm.stack + JAI_STACK_MAX) {
-        (void)jaiThrow(vm.cRuntimeError, "module body needs too many slots");
+    if (!ensureRoom(base, frameRoom(window))) {
         jaiReportUncaught(vm.pendingException);
         jaiClearException();
         return JAI_RUN_RUNTIME_ERROR;
@@ -7007,4 +8091,5 @@ void jaiVMPrintStats(FILE *out) {
     fprintf(out, "inline caches: %" PRIu64 " hits, %" PRIu64 " misses (%.1f%%)\n",
             vm.icHits, vm.icMisses, hitRate);
     jaiGCPrintStats(out);
+    jaiJitPrintStats(out);
 }
@@ -37,11 +37,12 @@ typedef struct {
 /* ------------------------------------------------------------------ */
 
 typedef struct VM {
-    Value      *stack;         /* heap-allocated, JAI_STACK_MAX entries */
+    Value      *stack;         /* reserved, not allocated; see vm.c */
     Value      *stackTop;
+    Value      *stackLimit;    /* end of the committed part of `stack` */
     CallFrame  *frames;
     int         frameCount;
-    int         frameCapacity;
+    int         frameCapacity; /* frames committed; grows to maxDepth */
 
     JAI_VEC(ExcHandler) handlers;
     JAI_VEC(Value)      defers;
@@ -85,6 +86,7 @@ typedef struct VM {
     unsigned     gcStressEvery;   /* see GCState::stressEvery */
     bool         releaseMode;
     int          optLevel;
+    int          maxDepth;        /* frames; 0 until jaiVMInit applies the default */
 
     /* Statistics */
     uint64_t     instructionCount;
@@ -178,10 +180,11 @@ bool jaiInvokeMethod(Value receiver, ObjString *name, int argc, Value *args,
 
 /* The same call for a caller holding the receiver at args[0] and no idea what
  * class it is, which is what the compiled tier has at a site whose receiver
- * varies. Answers from the shared megamorphic table, and raises rather than
- * returning false when there is no such method. */
-bool jaiInvokeMethodByName(ObjString *name, Value *argsWithReceiver, int count,
-                           Value *out);
+ * varies. Answers from `site`'s trait vtable when the site is IC_VTABLE, from
+ * the shared megamorphic table otherwise, and raises rather than returning
+ * false when there is no such method. `site` may be NULL. */
+bool jaiInvokeMethodByName(ObjString *name, const InlineCache *site,
+                           Value *argsWithReceiver, int count, Value *out);
 
 /* Field access honouring visibility and properties. */
 bool jaiGetProperty(Value receiver, ObjString *name, Value *out);
@@ -199,6 +202,9 @@ void jaiClearException(void);
 /* Build the frame list for a traceback. Caller frees with jaiRealloc. */
 JaiFrameInfo *jaiBuildTraceback(int *outCount);
 void jaiReportUncaught(Value exception);
+/* Mark what the pending exception's recorded traceback names; the collector
+ * calls it from markRoots. */
+void jaiVMMarkTraceback(void);
 
 /* ------------------------------------------------------------------ */
 /* Roots for the GC                                                     */
@@ -1,16 +1,137 @@
-/* The code arena must execute what it was written.
+/* The code arena must execute what it was written, and the code heap built on
+ * it must grow, seal in batches, and give back only what nothing is running.
  *
  * A C test rather than a .jai one because there is nothing in the language that
  * can reach this yet, and because the failure being guarded against -- a stale
  * instruction cache on arm64 -- is invisible from above: the wrong code runs and
- * returns a plausible number.
+ * returns a plausible number. The heap's failures are the same kind: a body
+ * reclaimed while it was still running is overwritten by the next compile, and
+ * whatever that one computes comes back instead.
  */
 #include <stdio.h>
 #include <stdint.h>
+#include <string.h>
 #include "vm/jit/jit.h"
 
 typedef int (*Fn0)(void);
 
+static int fail(const char *what) {
+    fprintf(stderr, "jit_arena: %s\n", what);
+    return 1;
+}
+
+#if defined(__aarch64__) || defined(__arm64__) || defined(__x86_64__)
+/* `return k`, with a tail of nops so a body can be made any size. */
+static size_t returning(uint8_t *out, int k, size_t size) {
+#if defined(__aarch64__) || defined(__arm64__)
+    uint32_t w[2] = { 0x52800000u | ((uint32_t)k << 5), 0xd65f03c0u };
+    memcpy(out, w, sizeof w);
+    for (size_t at = sizeof w; at + 4 <= size; at += 4) {
+        uint32_t nop = 0xd503201fu;
+        memcpy(out + at, &nop, sizeof nop);
+    }
+#else
+    const uint8_t code[] = { 0xb8, (uint8_t)k, 0x00, 0x00, 0x00, 0xc3 };
+    memcpy(out, code, sizeof code);
+    memset(out + sizeof code, 0x90, size - sizeof code);
+#endif
+    return size;
+}
+
+static int heapChecks(void) {
+    JaiCodeHeap heap;
+    jaiCodeHeapInit(&heap, 4096);
+    uint8_t body[512];
+    uint32_t version = 1;
+
+    /* Growth: a chunk's worth and then some is still placed. */
+    uint8_t *entries[24];
+    for (int i = 0; i < 24; i++) {
+        returning(body, i, sizeof body);
+        entries[i] = jaiCodeHeapPlace(&heap, body, sizeof body, &version, 1);
+        if (entries[i] == NULL) return fail("heap refused a body it could grow for");
+        if (((uintptr_t)entries[i] % JAI_CODE_ALIGN) != 0) {
+            return fail("heap placed a body off its alignment");
+        }
+    }
+    if (heap.chunkCount < 3) return fail("heap did not chain chunks as it filled");
+    for (int i = 0; i < 24; i++) {
+        if (((Fn0)entries[i])() != i) return fail("a placed body returned the wrong value");
+    }
+
+    /* A body bigger than a chunk gets a chunk of its own. */
+    static uint8_t big[3 * 4096];
+    returning(big, 99, sizeof big);
+    uint8_t *large = jaiCodeHeapPlace(&heap, big, sizeof big, NULL, 0);
+    if (large == NULL || ((Fn0)large)() != 99) return fail("oversized body not placed");
+
+    /* A batch seals once, at its end, however many bodies it places. */
+    uint64_t seals = heap.seals;
+    jaiCodeHeapBeginBatch(&heap);
+    uint8_t *batched[4];
+    for (int i = 0; i < 4; i++) {
+        returning(body, 40 + i, 64);
+        batched[i] = jaiCodeHeapPlace(&heap, body, 64, NULL, 0);
+        if (batched[i] == NULL) return fail("heap refused a body inside a batch");
+    }
+    if (heap.seals != seals) return fail("a batch sealed before it ended");
+    if (!jaiCodeHeapEndBatch(&heap)) return fail("batch seal failed");
+    if (heap.seals == seals) return fail("a batch ended without sealing");
+    for (int i = 0; i < 4; i++) {
+        if (((Fn0)batched[i])() != 40 + i) return fail("batched body returned the wrong value");
+    }
+
+    /* A retired body that something on the stack points into is kept, and so
+     * is every other retired body. */
+    if (!jaiCodeHeapRetire(&heap, entries[3])) return fail("retire refused a live body");
+    if (jaiCodeHeapRetire(&heap, entries[3])) return fail("retired the same body twice");
+    if (!jaiCodeHeapRetire(&heap, entries[4])) return fail("retire refused a live body");
+    uintptr_t fakeStack[2] = { 0, (uintptr_t)entries[4] + 8 };
+    if (jaiCodeHeapReclaim(&heap, fakeStack, fakeStack + 2) != 0) {
+        return fail("reclaimed code the stack was still inside");
+    }
+    /* So is one a STALE body is running: it may call any of them. */
+    fakeStack[1] = (uintptr_t)entries[9] + 8;
+    version = 2;
+    if (jaiCodeHeapReclaim(&heap, fakeStack, fakeStack + 2) != 0) {
+        return fail("reclaimed code while a stale body was running");
+    }
+    /* But only the bodies built against the version it was: one pinned to
+     * another module, or another version of this one, it cannot have called. */
+    uint32_t other = 7;
+    returning(body, 55, 64);
+    uint8_t *elsewhere = jaiCodeHeapPlace(&heap, body, 64, &other, 7);
+    if (elsewhere == NULL || !jaiCodeHeapRetire(&heap, elsewhere)) {
+        return fail("could not place and retire a body under another guard");
+    }
+    if (jaiCodeHeapReclaim(&heap, fakeStack, fakeStack + 2) != 64) {
+        return fail("a stale body held back code it cannot have called");
+    }
+    version = 1;
+    size_t freed = jaiCodeHeapReclaim(&heap, fakeStack, fakeStack + 2);
+    if (freed != 2 * sizeof body) return fail("reclaim freed the wrong amount");
+    if (heap.retired != 0) return fail("retired bytes left after reclaim");
+
+    /* Freed space is reused before the heap grows again, and what is placed
+     * there runs -- the instruction cache forgot the body it replaced. */
+    size_t mapped = heap.mapped;
+    returning(body, 77, sizeof body);
+    uint8_t *reused = jaiCodeHeapPlace(&heap, body, sizeof body, NULL, 0);
+    if (reused != entries[3] && reused != entries[4]) return fail("freed block not reused");
+    if (heap.mapped != mapped) return fail("heap grew with a hole to fill");
+    if (((Fn0)reused)() != 77) return fail("body in a reused block returned stale code");
+
+    /* An emptied chunk goes back to the system. */
+    size_t chunks = heap.chunkCount;
+    if (!jaiCodeHeapRetire(&heap, large)) return fail("retire refused the oversized body");
+    jaiCodeHeapReclaim(&heap, fakeStack, fakeStack);
+    if (heap.chunkCount != chunks - 1) return fail("an empty chunk was kept");
+
+    jaiCodeHeapFree(&heap);
+    return 0;
+}
+#endif
+
 int main(void) {
     JaiCodeArena arena;
     if (!jaiCodeArenaInit(&arena, 4096)) {
@@ -55,6 +176,9 @@ int main(void) {
     }
 
     jaiCodeArenaFree(&arena);
+#if defined(__aarch64__) || defined(__arm64__) || defined(__x86_64__)
+    if (heapChecks() != 0) return 1;
+#endif
     printf("jit_arena: ok\n");
     return 0;
 }
@@ -11,27 +11,47 @@
 #include <string.h>
 #include "vm/jit/jit.h"
 #include "vm/jit/jit_arm64.h"
+#include "vm/jit/jit_x64.h"
 
-#if !(defined(__aarch64__) || defined(__arm64__))
-int main(void) { printf("jit_arm64: skipped (not arm64)\n"); return 0; }
+#if !(defined(__aarch64__) || defined(__arm64__) || defined(__x86_64__))
+int main(void) { printf("jit_arm64: skipped (not arm64 or x86-64)\n"); return 0; }
 #else
 
 static JaiCodeArena arena;
 
-/* Build a function from `words` and call it with one pointer argument. */
-static int64_t runWith(const uint32_t *words, size_t count, void *arg) {
+/* Place `words` in an arena of their own and return the entry. On x86-64 the
+ * words go through the same lowering the compiled tiers use, so every case
+ * here also checks that an instruction means the same thing after it. */
+typedef int64_t (*TestFn)(void *);
+
+static TestFn install(const uint32_t *words, size_t count) {
     JaiCodeArena a;
     if (!jaiCodeArenaInit(&a, 4096)) { fprintf(stderr, "mmap failed\n"); exit(1); }
+#if defined(__x86_64__)
+    uint8_t *bytes;
+    size_t length;
+    const char *why = NULL;
+    if (!jaiX64Lower(words, (unsigned)count, &bytes, &length, &why)) {
+        fprintf(stderr, "jit_arm64: lowering failed: %s\n", why ? why : "?");
+        exit(1);
+    }
+    if (jaiCodeArenaWrite(&a, bytes, length) == NULL) exit(1);
+    free(bytes);
+#else
     if (jaiCodeArenaWrite(&a, words, count * sizeof words[0]) == NULL) exit(1);
+#endif
     if (!jaiCodeArenaSeal(&a)) exit(1);
     /* mmap returns page-aligned memory, so this is sound; the cast goes
-     * through uintptr_t to say so rather than silencing -Wcast-align. */
-    int64_t (*fn)(void *) = (int64_t (*)(void *))(uintptr_t)a.code;
-    int64_t r = fn(arg);
-    /* Deliberately not freed: the mapping outlives the call and the process is
-     * about to end. Freeing here would be the only interesting thing that could
-     * go wrong in a test that is checking something else. */
-    return r;
+     * through uintptr_t to say so rather than silencing -Wcast-align.
+     * Deliberately not freed: the mapping outlives the call and the process
+     * is about to end. Freeing here would be the only interesting thing that
+     * could go wrong in a test that is checking something else. */
+    return (TestFn)(uintptr_t)a.code;
+}
+
+/* Build a function from `words` and call it with one pointer argument. */
+static int64_t runWith(const uint32_t *words, size_t count, void *arg) {
+    return install(words, count)(arg);
 }
 
 static int failures;
@@ -571,16 +591,24 @@ int main(void) {
           /* 6 */ jaiA64Ret(),
           /* 7 */ jaiA64AddXImm(0, 0, 22),         /* callee: x0 += 22   */
           /* 8 */ jaiA64Ret() };
+      int64_t cell2[4] = { 0, 0, 0, 0 };
+#if defined(__x86_64__)
+      /* A blr target on x86-64 is always a SysV function -- a C helper or
+       * another body's entry stub -- never a word inside the caller, so the
+       * callee is lowered as a body of its own. */
+      cell2[3] = (int64_t)(uintptr_t)install(w + 7, 2);
+      TestFn fn = install(w, 7);
+#else
       /* cell[3] is patched to the callee's address once the arena is known,
        * so the call target is genuinely a runtime value. */
       JaiCodeArena a;
       if (!jaiCodeArenaInit(&a, 4096)) { fprintf(stderr, "mmap failed\n"); exit(1); }
       uint8_t *base = jaiCodeArenaWrite(&a, w, sizeof w);
       if (base == NULL) exit(1);
-      int64_t cell2[4] = { 0, 0, 0, 0 };
       cell2[3] = (int64_t)(uintptr_t)(base + 7 * 4);
       if (!jaiCodeArenaSeal(&a)) exit(1);
       int64_t (*fn)(void *) = (int64_t (*)(void *))(uintptr_t)a.code;
+#endif
       check("blr", fn(cell2), 42); }
 
     /* cset turns a comparison into 0 or 1 without branching. Both directions
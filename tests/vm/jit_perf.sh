@@ -0,0 +1,159 @@
+#!/usr/bin/env bash
+# JAITHON_PERF_MAP=1 and JAITHON_JITDUMP=1: what perf is told about compiled
+# code. perf itself is not needed, or assumed to be installed; the files are
+# read here the way perf reads them.
+#
+#   1. The map names the whole-function form by its qualified name and the
+#      OSR form with an [osr@<offset>] suffix, in perf's format.
+#   2. The dump parses record by record to its last byte, every load carries
+#      its code, and the function's load is preceded by line info that points
+#      into the source file at the lines the function occupies.
+#   3. With neither variable set, no file is written.
+set -uo pipefail
+
+ROOT="$(cd "$(dirname "${BASH_SOURCE[0]}")/../.." && pwd)"
+export JAITHON_PATH="$ROOT/lib"
+JAITHON="${JAITHON:-$ROOT/jaithon}"
+export JAITHON_JIT_SYNC=1
+
+work=$(mktemp -d)
+pids=()
+trap 'rm -rf "$work"; for p in "${pids[@]}"; do rm -f "/tmp/perf-$p.map" "/tmp/jit-$p.dump"; done' EXIT
+
+cat > "$work/hot.jai" <<'EOF2'
+fn step(x: int, k: int) -> int {
+    var t = x
+    for i in 0..k {
+        t = (t * 31 + i) % 1000003
+    }
+    return t
+}
+
+fn spin(n: int) -> int {
+    var u = 0
+    for j in 0..n {
+        u = (u + j * 3) % 7919
+    }
+    return u
+}
+
+var s = 0
+for i in 0..500 { s = (s + step(i, 5)) % 1000003 }
+print(s, spin(2000000))
+EOF2
+
+fail=0
+note() { echo "$1 $2"; [ "$1" = "FAIL" ] && fail=1; return 0; }
+
+# A loop reaches OSR on a timer tick, so spin() runs long enough to be sure
+# of one. Compile the module first, so the runs below are of the program and not of
+# the self-hosted front end.
+"$JAITHON" run "$work/hot.jai" >/dev/null 2>&1
+
+"$JAITHON" run "$work/hot.jai" >/dev/null 2>&1 &
+pid=$!; pids+=("$pid"); wait "$pid"
+if [ -e "/tmp/perf-$pid.map" ] || [ -e "/tmp/jit-$pid.dump" ]; then
+    note FAIL "files written with neither variable set"
+else
+    note ok "nothing written by default"
+fi
+
+JAITHON_PERF_MAP=1 JAITHON_JITDUMP=1 "$JAITHON" run "$work/hot.jai" \
+    > "$work/out" 2>&1 &
+pid=$!; pids+=("$pid"); wait "$pid"
+map="/tmp/perf-$pid.map"
+dump="/tmp/jit-$pid.dump"
+
+if [ "$(cat "$work/out")" = "777777 2564" ]; then note ok "answers unchanged"
+else note FAIL "printed '$(cat "$work/out")'"; fi
+
+if [ ! -f "$map" ]; then
+    note FAIL "no $map"
+else
+    if grep -Eq '^[0-9a-f]+ [0-9a-f]+ step$' "$map"; then
+        note ok "perf map names the function"
+    else
+        note FAIL "no 'step' line in the map: $(head -3 "$map")"
+    fi
+    if grep -Eq '^[0-9a-f]+ [0-9a-f]+ spin\[osr@[0-9]+\]$' "$map"; then
+        note ok "perf map names the OSR form"
+    else
+        note FAIL "no OSR line in the map: $(grep osr "$map" | head -3)"
+    fi
+    bad=$(grep -Evc '^[0-9a-f]+ [0-9a-f]+ .+$' "$map")
+    if [ "$bad" = "0" ]; then note ok "every map line is <start> <size> <name>"
+    else note FAIL "$bad malformed map lines"; fi
+fi
+
+if [ ! -f "$dump" ]; then
+    note FAIL "no $dump"
+else
+    python3 - "$dump" "$work/hot.jai" <<'EOF2'
+import struct, sys
+
+path, source = sys.argv[1], sys.argv[2]
+data = open(path, "rb").read()
+magic, version, size, mach, _, pid, _, _ = struct.unpack_from("<IIIIIIQQ", data, 0)
+if magic != 0x4A695444 or version != 1 or size != 40:
+    print("FAIL jitdump header is", hex(magic), version, size)
+    sys.exit(0)
+print("ok jitdump header")
+
+off, loads, pending, found, ok = size, 0, None, {}, True
+while off < len(data):
+    rid, total, _ = struct.unpack_from("<IIQ", data, off)
+    if rid == 2:
+        addr, n = struct.unpack_from("<QQ", data, off + 16)
+        p, entries = off + 32, []
+        for _ in range(n):
+            a, line, _ = struct.unpack_from("<QII", data, p)
+            end = data.index(b"\0", p + 16)
+            entries.append((a, line, data[p + 16:end].decode()))
+            p = end + 1
+        ok = ok and p == off + total
+        pending = (addr, entries)
+    elif rid == 0:
+        _, _, vma, addr, length, _ = struct.unpack_from("<IIQQQQ", data, off + 16)
+        end = data.index(b"\0", off + 56)
+        name = data[off + 56:end].decode()
+        ok = ok and end + 1 + length == off + total and vma == addr
+        if pending is not None and pending[0] == addr:
+            found[name] = (addr, length, pending[1])
+        pending = None
+        loads += 1
+    else:
+        ok = False
+        break
+    off += total
+if ok and off == len(data) and loads > 0:
+    print("ok jitdump records parse to the end")
+else:
+    print("FAIL jitdump records do not parse:", off, len(data), loads)
+
+step = found.get("step")
+if step is None:
+    print("FAIL no line info before step's load:", sorted(found)[:5])
+else:
+    addr, length, entries = step
+    lines = [l for _, l, _ in entries]
+    inside = all(addr <= a < addr + length for a, _, _ in entries)
+    files = {f for _, _, f in entries}
+    if inside and files == {source} and min(lines) >= 1 and max(lines) <= 6 \
+            and entries[0][0] == addr and 4 in lines:
+        print("ok step's lines are its own")
+    else:
+        print("FAIL step's lines:", [(hex(a - addr), l) for a, l, _ in entries], files)
+if any(n.startswith("spin[osr@") for n in found):
+    print("ok the OSR form has lines too")
+else:
+    print("FAIL no line info for the OSR form")
+EOF2
+fi 2>&1 | while IFS= read -r line; do
+    case "$line" in
+        "FAIL "*) note FAIL "${line#FAIL }"; echo x > "$work/failed" ;;
+        *)        echo "$line" ;;
+    esac
+done
+[ -f "$work/failed" ] && fail=1
+
+exit $fail
@@ -0,0 +1,125 @@
+#!/usr/bin/env bash
+# The .jaij warm-start record: what compiled in one run is read back by the
+# next, so the same functions compile after a few calls instead of sixty-four.
+#
+# Four things have to hold:
+#   1. A run that compiles something leaves a .jaij, and it belongs to the
+#      MODULE: a different program importing that module is warmed by it.
+#   2. A warmed function entered with the arguments it was recorded for
+#      compiles early; one entered with others goes back to counting, and
+#      keeps its record for the callers it does fit. Both give the
+#      interpreter's answers.
+#   3. A corrupt, truncated or foreign record is ignored, never fatal.
+#   4. JAITHON_JIT_NO_WARM=1 reads nothing and writes nothing.
+set -uo pipefail
+
+ROOT="$(cd "$(dirname "${BASH_SOURCE[0]}")/../.." && pwd)"
+export JAITHON_PATH="$ROOT/lib"
+JAITHON="${JAITHON:-$ROOT/jaithon}"
+export JAITHON_JIT_SYNC=1
+
+work=$(mktemp -d)
+trap 'rm -rf "$work"' EXIT
+
+cat > "$work/kern.jai" <<'EOF'
+pub fn step(x: any, k: int) -> any {
+    var t = x
+    for i in 0..k { t = (t * 31 + i) % 1000003 }
+    return t
+}
+EOF
+
+cat > "$work/long.jai" <<'EOF'
+import .kern
+
+var s = 0
+for i in 0..300 { s = (s + kern.step(i, 5)) % 1000003 }
+print(s)
+EOF
+
+cat > "$work/short.jai" <<'EOF'
+import .kern
+
+var s = 0
+for i in 0..20 { s = (s + kern.step(i, 5)) % 1000003 }
+print(s)
+EOF
+
+cat > "$work/other.jai" <<'EOF'
+import .kern
+
+var f = 0.0
+for i in 0..20 { f = f + kern.step(float(i) + 0.5, 5) }
+print(f)
+EOF
+
+fail=0
+note() { echo "$1 $2"; [ "$1" = "FAIL" ] && fail=1; return 0; }
+
+expect_short=$(JAITHON_NO_JIT=1 "$JAITHON" run "$work/short.jai" 2>&1)
+expect_other=$(JAITHON_NO_JIT=1 "$JAITHON" run "$work/other.jai" 2>&1)
+rm -rf "$work/__jaicache__"
+
+JAITHON_JIT_NO_WARM=1 "$JAITHON" run "$work/long.jai" >/dev/null 2>&1
+jaij="$work/__jaicache__/kern.jaij"
+if [ -f "$jaij" ]; then note FAIL "JAITHON_JIT_NO_WARM=1 wrote a .jaij"; else
+    note ok "JAITHON_JIT_NO_WARM=1 writes nothing"
+fi
+
+"$JAITHON" run "$work/long.jai" >/dev/null 2>&1
+if [ -f "$jaij" ]; then note ok "a compiling run writes a .jaij"; else
+    note FAIL "no .jaij after a compiling run"; exit 1
+fi
+cp "$jaij" "$work/good.jaij"
+
+# Twenty calls are short of the threshold, so only a warm start compiles.
+why=$(JAI_JIT_WHY=1 "$JAITHON" run "$work/short.jai" 2>&1 >/dev/null)
+if grep -q 'warm: step: hot early' <<< "$why"; then
+    note ok "another program is warmed by the module's record"
+else
+    note FAIL "short.jai was not warmed: $(grep 'warm' <<< "$why" | head -3)"
+fi
+out=$("$JAITHON" run "$work/short.jai" 2>&1)
+if [ "$out" = "$expect_short" ]; then note ok "warm answers match the interpreter"
+else note FAIL "warm short.jai printed '$out', expected '$expect_short'"; fi
+
+cp "$work/good.jaij" "$jaij"
+why=$(JAI_JIT_WHY=1 "$JAITHON" run "$work/other.jai" 2>&1 >/dev/null)
+if grep -q 'warm: step: entered with other arguments' <<< "$why"; then
+    note ok "other arguments go back to counting"
+else
+    note FAIL "other.jai kept its warm start: $(grep 'warm' <<< "$why" | head -3)"
+fi
+out=$("$JAITHON" run "$work/other.jai" 2>&1)
+if [ "$out" = "$expect_other" ]; then note ok "and still answer as the interpreter does"
+else note FAIL "other.jai printed '$out', expected '$expect_other'"; fi
+why=$(JAI_JIT_WHY=1 "$JAITHON" run "$work/short.jai" 2>&1 >/dev/null)
+if grep -q 'warm: step: hot early' <<< "$why"; then
+    note ok "a mismatch does not discard the record"
+else
+    note FAIL "the record was lost to other.jai: $(grep 'warm' <<< "$why" | head -3)"
+fi
+
+check_ignored() {
+    local label="$1"
+    local out; out=$("$JAITHON" run "$work/short.jai" 2>&1)
+    if [ "$out" = "$expect_short" ]; then note ok "$label"
+    else note FAIL "$label: got '$out'"; fi
+}
+
+: > "$jaij";                                   check_ignored "empty record"
+head -c 30 "$work/good.jaij" > "$jaij";        check_ignored "truncated record"
+head -c 200 /dev/urandom > "$jaij";            check_ignored "garbage record"
+cp "$work/good.jaij" "$jaij"
+printf 'XXXX' | dd of="$jaij" bs=1 seek=0 conv=notrunc 2>/dev/null
+check_ignored "wrong magic"
+cp "$work/good.jaij" "$jaij"
+printf '\x00\x00\x00\x00' | dd of="$jaij" bs=1 seek=8 conv=notrunc 2>/dev/null
+why=$(JAI_JIT_WHY=1 "$JAITHON" run "$work/short.jai" 2>&1 >/dev/null)
+if grep -q 'hot early' <<< "$why"; then
+    note FAIL "a record from another build was applied"
+else
+    note ok "a record from another build is ignored"
+fi
+
+exit $fail
@@ -0,0 +1,267 @@
+/* The x86-64 lowering, checked by running what it produces.
+ *
+ * tests/vm/jit_arm64.c already drives every encoder through the lowering on
+ * this host. What it cannot see is where the lowering itself has choices to
+ * get wrong: an arm64 register with no x86 home lives in the stub's register
+ * file, rbp/r12/r13 as a base each take their own ModRM escape, a flag value
+ * has to survive x86 instructions that arm64 would not have let touch it, and
+ * sdiv/fcvtzs/fcmp differ from idiv/cvttsd2si/ucomisd at exactly the edges a
+ * test written on arm64 has no reason to try. Each case here is one of those.
+ */
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include "vm/jit/jit.h"
+#include "vm/jit/jit_arm64.h"
+#include "vm/jit/jit_x64.h"
+
+#if !defined(__x86_64__)
+int main(void) { printf("jit_x64: skipped (not x86-64)\n"); return 0; }
+#else
+
+typedef int64_t (*Fn1)(void *);
+typedef int64_t (*Fn8)(int64_t, int64_t, int64_t, int64_t, int64_t, int64_t,
+                       int64_t, int64_t);
+
+static void *install(const uint32_t *words, size_t count) {
+    uint8_t *bytes;
+    size_t length;
+    const char *why = NULL;
+    if (!jaiX64Lower(words, (unsigned)count, &bytes, &length, &why)) {
+        fprintf(stderr, "jit_x64: lowering failed: %s\n", why ? why : "?");
+        exit(1);
+    }
+    JaiCodeArena a;
+    if (!jaiCodeArenaInit(&a, (length + 4095u) & ~(size_t)4095u)) exit(1);
+    if (jaiCodeArenaWrite(&a, bytes, length) == NULL) exit(1);
+    free(bytes);
+    if (!jaiCodeArenaSeal(&a)) exit(1);
+    /* Never freed: the process ends right after the checks. */
+    return a.code;
+}
+
+static int64_t runWith(const uint32_t *words, size_t count, void *arg) {
+    return ((Fn1)(uintptr_t)install(words, count))(arg);
+}
+
+static bool declines(const uint32_t *words, size_t count) {
+    uint8_t *bytes = NULL;
+    size_t length;
+    const char *why = NULL;
+    bool ok = jaiX64Lower(words, (unsigned)count, &bytes, &length, &why);
+    free(bytes);
+    return !ok && why != NULL;
+}
+
+static int failures;
+
+static void check(const char *what, int64_t got, int64_t want) {
+    if (got != want) {
+        fprintf(stderr, "jit_x64: %s = %lld, want %lld\n", what,
+                (long long)got, (long long)want);
+        failures++;
+    }
+}
+
+static int64_t dbits(double d) {
+    int64_t b;
+    memcpy(&b, &d, sizeof b);
+    return b;
+}
+
+/* What a blr into C sees: all eight arguments, in order. */
+static int64_t weigh8(int64_t a, int64_t b, int64_t c, int64_t d, int64_t e,
+                      int64_t f, int64_t g, int64_t h) {
+    return a + 2 * b + 3 * c + 4 * d + 5 * e + 6 * f + 7 * g + 8 * h;
+}
+
+/* Loads a 64-bit constant the way jit_func.c's emitConst64 does. */
+static size_t const64(uint32_t *w, unsigned rd, uint64_t v) {
+    size_t n = 0;
+    w[n++] = jaiA64MovzX(rd, (unsigned)(v & 0xffffu), 0);
+    for (unsigned s = 1; s < 4; s++) {
+        unsigned part = (unsigned)((v >> (16 * s)) & 0xffffu);
+        if (part != 0) w[n++] = jaiA64MovkX(rd, part, s);
+    }
+    return n;
+}
+
+int main(void) {
+    int64_t cell[8] = { 11, 22, 33, 44, 55, 66, 77, 88 };
+
+    /* Every register as a load base and as a destination: x2..x8, x12..x18
+     * and x24..x30 have no x86 home, and rbx/rbp/r12/r13/r14 (x19..x23) each
+     * encode differently as a base. x0 holds the argument, so it seeds each
+     * one. */
+    for (unsigned r = 1; r < 31; r++) {
+        const uint32_t w[] = { jaiA64MovX(r, 0),
+                               jaiA64LdrX(r, r, 16),
+                               jaiA64MovX(0, r), jaiA64Ret() };
+        char what[48];
+        snprintf(what, sizeof what, "ldr x%u, [x%u, #16]", r, r);
+        check(what, runWith(w, 4, cell), 33);
+    }
+    /* And as a store base with a zero offset, which rbp and r13 cannot spell
+     * without a displacement byte. */
+    for (unsigned r = 1; r < 31; r++) {
+        int64_t out[2] = { 0, 0 };
+        const uint32_t w[] = { jaiA64MovX(r, 0),
+                               jaiA64MovzX(9, 42, 0),
+                               jaiA64StrX(9, r, 0),
+                               jaiA64MovzX(0, 0, 0), jaiA64Ret() };
+        if (r == 9) continue;
+        runWith(w, 5, out);
+        char what[48];
+        snprintf(what, sizeof what, "str x9, [x%u]", r);
+        check(what, out[0], 42);
+    }
+
+    /* Every d register through the file and back: d15..d31 have no xmm. */
+    for (unsigned d = 0; d < 32; d++) {
+        double in[2] = { 1.5, 0.0 };
+        const uint32_t w[] = { jaiA64LdrD(d, 0, 0),
+                               jaiA64FaddD(d, d, d),
+                               jaiA64StrD(d, 0, 8),
+                               jaiA64MovzX(0, 0, 0), jaiA64Ret() };
+        runWith(w, 5, in);
+        char what[32];
+        snprintf(what, sizeof what, "fadd d%u", d);
+        check(what, dbits(in[1]), dbits(3.0));
+    }
+
+    /* The stub hands SysV's eight integer arguments to x0..x7, two of them
+     * from the stack. */
+    { const uint32_t w[] = {
+          jaiA64AddX(0, 0, 1), jaiA64AddX(0, 0, 2), jaiA64AddX(0, 0, 3),
+          jaiA64AddX(0, 0, 4), jaiA64AddX(0, 0, 5), jaiA64AddX(0, 0, 6),
+          jaiA64AddXLsl(0, 0, 7, 4), jaiA64Ret() };
+      Fn8 fn = (Fn8)(uintptr_t)install(w, 8);
+      check("eight arguments in", fn(1, 2, 3, 4, 5, 6, 7, 8), 21 + 7 + 8 * 16); }
+
+    /* ... and blr hands x0..x7 back out to C, with x19 (callee-saved on both
+     * sides) surviving the call. */
+    { uint32_t w[64];
+      size_t n = 0;
+      w[n++] = jaiA64StpPre(29, 30, 31, -16);
+      w[n++] = jaiA64MovzX(19, 1000, 0);
+      for (unsigned k = 0; k < 8; k++) w[n++] = jaiA64MovzX(k, k + 1, 0);
+      n += const64(w + n, 9, (uint64_t)(uintptr_t)&weigh8);
+      w[n++] = jaiA64Blr(9);
+      w[n++] = jaiA64AddX(0, 0, 19);
+      w[n++] = jaiA64LdpPost(29, 30, 31, 16);
+      w[n++] = jaiA64Ret();
+      check("blr with eight arguments", runWith(w, n, cell), 204 + 1000); }
+
+    /* d8..d15 are callee-saved on arm64 and nothing is on SysV: the value in
+     * d8 and in d15 must outlive a call into C that is free to trash every
+     * xmm. */
+    { double io[2] = { 2.5, 0.0 };
+      uint32_t w[64];
+      size_t n = 0;
+      w[n++] = jaiA64StpPre(29, 30, 31, -16);
+      w[n++] = jaiA64LdrD(8, 0, 0);
+      w[n++] = jaiA64LdrD(15, 0, 0);
+      w[n++] = jaiA64MovX(19, 0);
+      n += const64(w + n, 9, (uint64_t)(uintptr_t)&weigh8);
+      w[n++] = jaiA64Blr(9);
+      w[n++] = jaiA64FaddD(8, 8, 15);
+      w[n++] = jaiA64StrD(8, 19, 8);
+      w[n++] = jaiA64LdpPost(29, 30, 31, 16);
+      w[n++] = jaiA64Ret();
+      runWith(w, n, io);
+      check("d8/d15 survive a call", dbits(io[1]), dbits(5.0)); }
+
+    /* Flags set before, read after, with instructions in between whose x86
+     * forms write RFLAGS (a shift, an and, a multiply) -- the lowering must
+     * keep the compare's answer, not the multiply's. */
+    { const uint32_t w[] = {
+          /* 0 */ jaiA64MovzX(1, 3, 0),
+          /* 1 */ jaiA64MovzX(2, 9, 0),
+          /* 2 */ jaiA64SubsXReg(31, 1, 2),            /* 3 < 9 */
+          /* 3 */ jaiA64LslX(3, 2, 60),                /* would set SF */
+          /* 4 */ jaiA64MulX(4, 2, 2),
+          /* 5 */ jaiA64AndXOnes(5, 2, 3),             /* would clear SF/ZF */
+          /* 6 */ jaiA64LdrX(6, 31, 0),                /* sp-relative inside */
+          /* 7 */ jaiA64BCond(JAI_A64_LT, 3),          /* -> 10 */
+          /* 8 */ jaiA64MovzX(0, 0, 0),
+          /* 9 */ jaiA64Ret(),
+          /* 10 */ jaiA64MovzX(0, 1, 0),
+          /* 11 */ jaiA64Ret() };
+      check("flags survive clobbering lowerings", runWith(w, 12, cell), 1); }
+
+    /* sdiv's edges, which idiv would fault on: x/0 is 0, INT64_MIN/-1 is
+     * INT64_MIN. And msub on top gives the remainder the tier computes. */
+    { int64_t io[4] = { 7, 0, INT64_MIN, -1 };
+      const uint32_t w[] = { jaiA64LdrX(1, 0, 0), jaiA64LdrX(2, 0, 8),
+                             jaiA64SdivX(0, 1, 2), jaiA64Ret() };
+      check("sdiv by zero", runWith(w, 4, io), 0);
+      const uint32_t w2[] = { jaiA64LdrX(1, 0, 16), jaiA64LdrX(2, 0, 24),
+                              jaiA64SdivX(0, 1, 2), jaiA64Ret() };
+      check("sdiv INT64_MIN by -1", runWith(w2, 4, io), INT64_MIN);
+      int64_t io2[2] = { -7, 2 };
+      const uint32_t w3[] = { jaiA64LdrX(1, 0, 0), jaiA64LdrX(2, 0, 8),
+                              jaiA64SdivX(3, 1, 2),
+                              jaiA64MsubX(0, 3, 2, 1), jaiA64Ret() };
+      check("msub remainder", runWith(w3, 5, io2), -1); }
+
+    /* fcvtzs saturates and sends NaN to 0; cvttsd2si answers INT64_MIN for
+     * all three. */
+    { static const struct { double in; int64_t want; } cases[] = {
+          { 1e300, INT64_MAX }, { -1e300, INT64_MIN }, { -3.75, -3 },
+          { 9.2233720368547758e18, INT64_MAX }, { -9.2233720368547758e18, INT64_MIN } };
+      for (size_t k = 0; k < sizeof cases / sizeof cases[0]; k++) {
+          double in = cases[k].in;
+          const uint32_t w[] = { jaiA64LdrD(20, 0, 0), jaiA64FcvtzsXD(0, 20),
+                                 jaiA64Ret() };
+          char what[48];
+          snprintf(what, sizeof what, "fcvtzs %g", in);
+          check(what, runWith(w, 3, &in), cases[k].want);
+      }
+      double nan = NAN;
+      const uint32_t w[] = { jaiA64LdrD(3, 0, 0), jaiA64FcvtzsXD(0, 3), jaiA64Ret() };
+      check("fcvtzs NaN", runWith(w, 3, &nan), 0); }
+
+    /* An unordered compare through cset and csel: x86 reports it in PF, so
+     * EQ has to be E-and-not-P and NE has to be NE-or-P. */
+    { static const unsigned conds[] = { JAI_A64_EQ, JAI_A64_NE, JAI_A64_MI,
+                                        JAI_A64_LS, JAI_A64_GE, JAI_A64_VS };
+      static const int64_t wantNan[] = { 0, 1, 0, 0, 0, 1 };
+      static const int64_t wantEq[]  = { 1, 0, 0, 1, 1, 0 };
+      for (size_t k = 0; k < sizeof conds / sizeof conds[0]; k++) {
+          double nan2[2] = { NAN, 1.0 }, eq2[2] = { 1.0, 1.0 };
+          const uint32_t w[] = { jaiA64LdrD(0, 0, 0), jaiA64LdrD(1, 0, 8),
+                                 jaiA64FcmpD(0, 1),
+                                 jaiA64CsetX(0, conds[k]), jaiA64Ret() };
+          const uint32_t s[] = { jaiA64LdrD(0, 0, 0), jaiA64LdrD(1, 0, 8),
+                                 jaiA64MovzX(2, 1, 0), jaiA64MovzX(3, 0, 0),
+                                 jaiA64FcmpD(0, 1),
+                                 jaiA64CselX(0, 2, 3, conds[k]), jaiA64Ret() };
+          char what[40];
+          snprintf(what, sizeof what, "cset %u unordered", conds[k]);
+          check(what, runWith(w, 5, nan2), wantNan[k]);
+          snprintf(what, sizeof what, "cset %u equal", conds[k]);
+          check(what, runWith(w, 5, eq2), wantEq[k]);
+          snprintf(what, sizeof what, "csel %u unordered", conds[k]);
+          check(what, runWith(s, 7, nan2), wantNan[k]);
+          snprintf(what, sizeof what, "csel %u equal", conds[k]);
+          check(what, runWith(s, 7, eq2), wantEq[k]);
+      } }
+
+    /* A carry read after adds is the opposite x86 flag from one read after
+     * subs: UINT64_MAX + 1 carries. */
+    { const uint32_t w[] = { jaiA64MovnX(1, 0), jaiA64AddsXImm(2, 1, 1),
+                             jaiA64CsetX(0, JAI_A64_HS), jaiA64Ret() };
+      check("adds carry", runWith(w, 4, cell), 1); }
+
+    /* A word outside the vocabulary is a decline, never a guess. */
+    { const uint32_t w[] = { 0xd4200000u /* brk #0 */, jaiA64Ret() };
+      check("unknown word declines", declines(w, 2), 1); }
+
+    if (failures) return 1;
+    printf("jit_x64: ok\n");
+    return 0;
+}
+
+#endif
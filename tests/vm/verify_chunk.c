@@ -254,6 +254,41 @@ static void caseBadExceptionEntry(void) {
                    "handler");
 }
 
+/* The depth an exception entry resumes at. A `try` inside a loop resumes over
+ * the loop's iterator, and the union clause gives its handler two rows, which
+ * have to agree with each other and fit the frame. */
+static void caseExceptionEntryDepth(void) {
+    ObjFunction *body =
+        compile("fn g(xs: list[int]) -> int {\n"
+                "    var n = 0\n"
+                "    for x in xs {\n"
+                "        try {\n"
+                "            n += 10 // x\n"
+                "        } catch _e: ValueError | DivisionByZeroError {\n"
+                "            n += 1\n"
+                "        }\n"
+                "    }\n"
+                "    return n\n"
+                "}\n"
+                "print(g([1, 0]))\n");
+    ObjFunction *fn = nestedFunction(body, "g");
+    expectValid(fn, "entry-depth baseline");
+    if (fn->exceptionCount < 2 || fn->exceptions[0].depth == 0) {
+        printf("  SKIP no union clause inside a loop\n");
+        return;
+    }
+
+    uint32_t depth = fn->exceptions[1].depth;
+    fn->exceptions[1].depth = 0;
+    expectRejected(fn, "two rows resume one handler at different depths",
+                   "another entry resumes it");
+    fn->exceptions[1].depth = depth;
+
+    fn->exceptions[0].depth = (uint32_t)fn->maxSlots + 1;
+    fn->exceptions[1].depth = (uint32_t)fn->maxSlots + 1;
+    expectRejected(fn, "entry depth past the frame", "past the frame");
+}
+
 /* An upvalue index the closure does not have. */
 static void caseBadUpvalue(void) {
     ObjFunction *body =
@@ -446,6 +481,45 @@ static void caseMatchSeqPopBaseline(void) {
     expectOpCount(fn, OP_MATCH_SEQ_POP, 1, "one MATCH_SEQ_POP for the list-shape arm");
 }
 
+/* OP_SWITCH names its arms in a table constant, not in its operands, so the
+ * verifier has to read them out of the pool: a table it cannot parse, and an
+ * arm that lands inside an instruction, must both be refused. The tuple is
+ * patched in place -- the chunk is the only thing that holds it. */
+static const char *kSwitchSource =
+    "let n = 2\n"
+    "print(match n { 0 => \"a\", 1 => \"b\", 2 => \"c\", 3 => \"d\", _ => \"e\" })\n";
+
+static ObjTuple *switchTable(ObjFunction *fn) {
+    int at = findOp(&fn->chunk, OP_SWITCH, 0);
+    if (at < 0) return NULL;
+    return AS_TUPLE(fn->chunk.constants.data[jaiReadU24(fn->chunk.code + at + 1)]);
+}
+
+static void caseSwitchBaseline(void) {
+    ObjFunction *fn = compile(kSwitchSource);
+    expectValid(fn, "match lowered to a jump table");
+    expectOpCount(fn, OP_SWITCH, 1, "one OP_SWITCH for four literal keys");
+}
+
+static void caseSwitchTableMalformed(void) {
+    ObjFunction *fn = compile(kSwitchSource);
+    ObjTuple *table = switchTable(fn);
+    if (table == NULL) { printf("  SKIP no OP_SWITCH emitted\n"); return; }
+    table->items[0] = INT_VAL(7);   /* neither JAI_SWITCH_DENSE nor _HASH */
+    expectRejected(fn, "OP_SWITCH table of an unknown kind", "malformed");
+}
+
+static void caseSwitchArmMidInstruction(void) {
+    ObjFunction *fn = compile(kSwitchSource);
+    ObjTuple *table = switchTable(fn);
+    if (table == NULL) { printf("  SKIP no OP_SWITCH emitted\n"); return; }
+    /* Dense: items[2] is the first key's arm, which starts with a multi-byte
+     * instruction, so one byte further is inside it. */
+    table->items[2] = INT_VAL(AS_INT(table->items[2]) + 1);
+    expectRejected(fn, "OP_SWITCH arm one byte into an instruction",
+                   "not an instruction boundary");
+}
+
 /* `slotOperands` (verify.c) once had no case for OP_ADD_BIND/OP_SUB_BIND/
  * OP_MUL_BIND -- their own u16 slot operand went unchecked, so a malformed
  * `.jaic` naming a slot past `maxSlots` passed verification and the VM would
@@ -471,6 +545,28 @@ static void caseSubBindSlotOutOfRange(void) {
     expectRejected(fn, "sub-bind slot equal to maxSlots", "local slot");
 }
 
+/* OP_REST_GET reads the arguments above the frame window, which only a call
+ * into a function flagged FN_REST_VIEW leaves there. Clearing the flag on a
+ * chunk that uses the view is what a `.jaic` with a stale flag word looks like;
+ * the VM would read whatever sits above the window as arguments. */
+static void caseRestGetWithoutView(void) {
+    ObjFunction *body =
+        compile("fn second(...rest) {\n"
+                "    return rest[1]\n"
+                "}\n"
+                "print(second(1, 2, 3))\n");
+    ObjFunction *fn = nestedFunction(body, "second");
+    expectValid(fn, "viewed-variadic baseline");
+
+    if (findOp(&fn->chunk, OP_REST_GET, 0) < 0) {
+        printf("  SKIP no OP_REST_GET emitted\n");
+        return;
+    }
+    fn->flags &= ~FN_REST_VIEW;
+    expectRejected(fn, "OP_REST_GET without FN_REST_VIEW",
+                   "viewed variadic parameter");
+}
+
 int main(void) {
     jaiDiagInit(&gDiags);
     gDiags.colorOutput = false;
@@ -490,6 +586,7 @@ int main(void) {
     caseUnbalancedJoin();
     caseStackUnderflow();
     caseBadExceptionEntry();
+    caseExceptionEntryDepth();
     caseBadUpvalue();
     caseBlockCloseShape();
     caseMatchConstPopBaseline();
@@ -498,7 +595,11 @@ int main(void) {
     caseMatchTypePopEdgesDisagree();
     caseMatchRangePopBaseline();
     caseMatchSeqPopBaseline();
+    caseSwitchBaseline();
+    caseSwitchTableMalformed();
+    caseSwitchArmMidInstruction();
     caseSubBindSlotOutOfRange();
+    caseRestGetWithoutView();
 
     printf("%d checks, %d failures\n", gChecks, gFailures);
     return gFailures == 0 ? 0 : 1;